@@ -0,0 +1,124 @@
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+/**
+ * @file BenchUtils.h
+ * @brief Shared timing and workload helpers for the micro-benchmarks.
+ */
+
+#include "Camera.h"
+#include "Ray.h"
+#include "RenderConfig.h"
+#include "Scene.h"
+#include "Utils.h"
+#include "Vec3.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace bench {
+
+/**
+ * Run `body` `repetitions` times and return the best wall time in milliseconds.
+ * Taking the minimum filters out scheduler noise on shared machines.
+ */
+template <typename Body>
+double best_time_ms(int repetitions, Body&& body) {
+    double best = 0.0;
+    for (int run = 0; run < repetitions; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        const auto stop = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+/**
+ * Jittered primary rays covering the whole image plane.
+ */
+inline std::vector<Ray> make_primary_rays(const RenderConfig& config, const Camera& camera) {
+    std::vector<Ray> rays;
+    rays.reserve(static_cast<std::size_t>(config.image_width) * static_cast<std::size_t>(config.image_height));
+    for (int row = 0; row < config.image_height; ++row) {
+        for (int col = 0; col < config.image_width; ++col) {
+            const double u = (col + random_double()) / (config.image_width - 1);
+            const double v = (row + random_double()) / (config.image_height - 1);
+            rays.emplace_back(camera.origin,
+                              camera.lower_left_corner + u * camera.horizontal + v * camera.vertical - camera.origin);
+        }
+    }
+    return rays;
+}
+
+/**
+ * Incoherent rays starting at random points inside the room, mimicking
+ * secondary bounces.
+ */
+inline std::vector<Ray> make_room_rays(const RoomLayout& layout, std::size_t count) {
+    std::vector<Ray> rays;
+    rays.reserve(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        const Point3 origin(
+            random_double(-layout.half_width, layout.half_width),
+            random_double(layout.floor_y, layout.ceiling_y),
+            random_double(layout.back_wall_z, layout.front_opening_z)
+        );
+        rays.emplace_back(origin, random_unit_vector());
+    }
+    return rays;
+}
+
+/**
+ * The demo room `scale` times wider and deeper, with scale x scale furniture
+ * sets spread over the floor (on top of the furniture create_scene places).
+ */
+inline Scene furnished_room(int scale) {
+    const RoomLayout demo = default_room_layout();
+    const double cell_width = 2.0 * demo.half_width;
+    const double cell_depth = demo.front_opening_z - demo.back_wall_z;
+    RoomLayout layout = demo;
+    layout.half_width *= scale;
+    layout.half_depth *= scale;
+    layout.back_wall_z = layout.front_opening_z - scale * cell_depth;
+    Scene scene = create_scene(layout);
+    if (scale == 1) {
+        return scene;
+    }
+
+    auto wood = std::make_shared<Matte>(Color(0.58, 0.44, 0.33));
+    auto fabric = std::make_shared<Matte>(Color(0.55, 0.22, 0.22));
+    auto metal = std::make_shared<Reflective>(Color(0.8, 0.8, 0.8), 0.15);
+    const double floor_y = layout.floor_y;
+    for (int row = 0; row < scale; ++row) {
+        for (int col = 0; col < scale; ++col) {
+            const double x = -layout.half_width + (col + 0.5) * cell_width;
+            const double z = layout.back_wall_z + (row + 0.5) * cell_depth;
+            scene.objects.add(std::make_shared<Box>(Point3(x - 1.6, floor_y + 0.98, z - 1.2),
+                                                    Point3(x + 1.6, floor_y + 1.1, z + 1.2), wood));
+            for (const double dx : {-1.35, 1.13}) {
+                for (const double dz : {-0.95, 0.73}) {
+                    scene.objects.add(std::make_shared<Box>(Point3(x + dx, floor_y, z + dz),
+                                                            Point3(x + dx + 0.22, floor_y + 0.98, z + dz + 0.22),
+                                                            wood));
+                }
+            }
+            scene.objects.add(std::make_shared<Box>(Point3(x - 4.5, floor_y, z - 4.5),
+                                                    Point3(x - 2.6, floor_y + 2.0, z - 2.5), fabric));
+            scene.objects.add(std::make_shared<Box>(Point3(x + 2.0, floor_y, z - 2.0),
+                                                    Point3(x + 4.6, floor_y + 0.9, z + 1.0), fabric));
+            scene.objects.add(std::make_shared<Sphere>(Point3(x, floor_y + 1.45, z + 0.2), 0.35, metal));
+        }
+    }
+    scene.commit();
+    return scene;
+}
+
+} // namespace bench
+
+#endif
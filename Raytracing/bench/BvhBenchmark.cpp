@@ -0,0 +1,176 @@
+/**
+ * @file BvhBenchmark.cpp
+ * @brief Quantized vs full wide-BVH nodes: memory per primitive and trace speed.
+ *
+ * For the demo room and larger furnished rooms (see bench::furnished_room)
+ * the benchmark
+ * - builds the 8-wide BVH in both node formats and reports node count,
+ *   depth, build time and bytes per primitive (nodes, and nodes plus the
+ *   leaf index list),
+ * - times closest-hit queries for camera rays and for incoherent rays from
+ *   random points in the room through both formats and the uniform grid,
+ * - checks every query against the full table scan (on a subset of the rays
+ *   for the large rooms, where the scan is slow).
+ * Finally it renders the demo room with and without the quantized BVH and
+ * checks the images are identical.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "UniformGrid.h"
+#include "WideBvh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 3;
+constexpr int kMaxDepth = 20;
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+constexpr std::size_t kRays = 100'000;
+constexpr std::size_t kScanBudget = 400'000'000;  // Primitive tests spent on the reference scan per ray set
+
+struct Query {
+    std::vector<HitCandidate> candidates;
+    std::vector<char> hits;
+};
+
+/**
+ * Time `rays` through `accelerator`, keeping the results of the last run.
+ */
+double time_queries(const Scene& scene, const Accelerator& accelerator, const std::vector<Ray>& rays,
+                    Query& query) {
+    query.candidates.assign(rays.size(), HitCandidate());
+    query.hits.assign(rays.size(), 0);
+    return 1e6 / static_cast<double>(rays.size()) * bench::best_time_ms(kRepetitions, [&] {
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            query.hits[index] = accelerator.intersect(scene.dispatch_table, rays[index], kMinDistance, kMaxDistance,
+                                                      query.candidates[index]);
+        }
+    });
+}
+
+/**
+ * Disagreements with the table scan over the first `checked` rays.
+ */
+std::size_t mismatches(const Query& reference, const Query& query, std::size_t checked) {
+    std::size_t count = 0;
+    for (std::size_t index = 0; index < checked; ++index) {
+        if (reference.hits[index] != query.hits[index]
+            || (reference.hits[index]
+                && (reference.candidates[index].primitive_index != query.candidates[index].primitive_index
+                    || reference.candidates[index].distance_from_ray
+                           != query.candidates[index].distance_from_ray))) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+/**
+ * Compare the grid and both BVH formats on one ray set; return the number of
+ * queries that disagree with the table scan.
+ */
+std::size_t compare(const char* label, const Scene& scene, const UniformGrid& grid, const WideBvh& full,
+                    const WideBvh& quantized, const std::vector<Ray>& rays) {
+    const std::size_t checked = std::min(rays.size(),
+                                         std::max<std::size_t>(kScanBudget / scene.dispatch_table.primitive_count(),
+                                                               1'000));
+    Query reference{std::vector<HitCandidate>(checked), std::vector<char>(checked)};
+    for (std::size_t index = 0; index < checked; ++index) {
+        reference.hits[index] = scene.dispatch_table.intersect(rays[index], kMinDistance, kMaxDistance,
+                                                               reference.candidates[index]);
+    }
+
+    Query query;
+    const double grid_ns = time_queries(scene, grid, rays, query);
+    std::size_t differing = mismatches(reference, query, checked);
+    const double full_ns = time_queries(scene, full, rays, query);
+    differing += mismatches(reference, query, checked);
+    const double quantized_ns = time_queries(scene, quantized, rays, query);
+    differing += mismatches(reference, query, checked);
+    std::cout << "  " << label << ": grid " << std::fixed << std::setprecision(1) << grid_ns << " ns, full BVH "
+              << full_ns << " ns, quantized BVH " << quantized_ns << " ns per ray (" << std::setprecision(2)
+              << full_ns / quantized_ns << "x full), " << differing << " mismatches in " << checked
+              << " checked\n";
+    return differing;
+}
+
+} // namespace
+
+int main() {
+    const RenderConfig camera_config(16.0 / 9.0, 320, 1);
+    const Camera camera(camera_config.aspect_ratio);
+    std::size_t total_mismatches = 0;
+
+    for (const int scale : {1, 8, 32, 64}) {
+        const Scene scene = bench::furnished_room(scale);
+        const std::size_t primitives = scene.dispatch_table.primitive_count();
+        WideBvhSettings settings;
+        settings.format = BvhNodeFormat::Full;
+        WideBvh full;
+        const double full_ms = bench::best_time_ms(1, [&] { full.build(scene.dispatch_table, settings); });
+        settings.format = BvhNodeFormat::Quantized;
+        WideBvh quantized;
+        const double quantized_ms = bench::best_time_ms(1, [&] { quantized.build(scene.dispatch_table, settings); });
+        UniformGrid grid;
+        grid.build(scene.dispatch_table);
+
+        const double per_primitive = 1.0 / static_cast<double>(std::max<std::size_t>(quantized.bounded_count(), 1));
+        std::cout << "Room x" << scale << ": " << primitives << " primitives, " << quantized.node_count()
+                  << " nodes, depth " << quantized.depth() << ", built in " << std::fixed << std::setprecision(1)
+                  << full_ms << " / " << quantized_ms << " ms (full / quantized)\n"
+                  << "  bytes per primitive: full " << static_cast<double>(full.node_bytes()) * per_primitive
+                  << " nodes + " << static_cast<double>(full.index_bytes()) * per_primitive
+                  << " index, quantized " << static_cast<double>(quantized.node_bytes()) * per_primitive
+                  << " nodes + " << static_cast<double>(quantized.index_bytes()) * per_primitive << " index ("
+                  << std::setprecision(2)
+                  << static_cast<double>(full.node_bytes() + full.index_bytes())
+                         / static_cast<double>(quantized.node_bytes() + quantized.index_bytes())
+                  << "x smaller)\n";
+
+        const std::vector<Ray> all_camera_rays = bench::make_primary_rays(camera_config, camera);
+        std::vector<Ray> camera_rays;
+        const std::size_t stride = std::max<std::size_t>(all_camera_rays.size() / kRays, 1);
+        for (std::size_t index = 0; index < all_camera_rays.size(); index += stride) {
+            camera_rays.push_back(all_camera_rays[index]);
+        }
+        const std::vector<Ray> room_rays = bench::make_room_rays(scene.layout, kRays);
+        total_mismatches += compare("camera rays", scene, grid, full, quantized, camera_rays);
+        total_mismatches += compare("room rays  ", scene, grid, full, quantized, room_rays);
+    }
+
+    // Full renders: same seed, so identical images prove the BVH is exact
+    Scene scene = create_scene();
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.caustics.enabled = false;
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<std::vector<float>> images;
+    std::vector<double> times;
+    for (const bool use_bvh : {false, true}) {
+        if (use_bvh) {
+            scene.build_wide_bvh();
+        }
+        times.push_back(bench::best_time_ms(1, [&] {
+            seed_thread_uniforms(1);
+            images.push_back(render_framebuffer(config, camera, scene, kMaxDepth).pixels);
+        }));
+    }
+    std::cerr.rdbuf(previous);
+    const bool identical = images[0] == images[1];
+    std::cout << "\nrender 160x90, 16 spp: " << std::setprecision(0) << times[0] << " ms linear, " << times[1]
+              << " ms quantized BVH (" << std::setprecision(2) << times[0] / times[1] << "x), images "
+              << (identical ? "identical" : "DIFFER") << "\n";
+    return identical && total_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/**
+ * @file CacheBenchmark.cpp
+ * @brief Cost and reuse of the content-addressed render cache.
+ *
+ * - Key: time to hash a large furnished room (see bench::furnished_room)
+ *   and the demo room, and which changes move the key: the same scene built
+ *   twice, more samples or a BVH must not; a light, a material, the
+ *   resolution or the camera must.
+ * - Hit: a 160x90, 32 spp render through RenderEngine against storing it
+ *   and reading it back from the cache.
+ * - Continuation: 8 spp stored, then 32 spp asked for; the job renders the
+ *   missing 24 from the stored samples. Time against 32 spp from scratch,
+ *   and the image must match it: every sample has its own random stream, so
+ *   the continued samples are new ones, not repeats of the stored ones.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Material.h"
+#include "RenderCache.h"
+#include "RenderConfig.h"
+#include "RenderEngine.h"
+#include "Scene.h"
+#include "Sphere.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr int kScale = 64;
+constexpr int kMaxDepth = 20;
+
+double mean(const Framebuffer& framebuffer) {
+    double sum = 0.0;
+    for (const float value : framebuffer.pixels) {
+        sum += value;
+    }
+    return framebuffer.pixels.empty() ? 0.0 : sum / static_cast<double>(framebuffer.pixels.size());
+}
+
+/**
+ * Largest difference between two images of one size, relative to the value.
+ */
+double max_relative_difference(const Framebuffer& a, const Framebuffer& b) {
+    double largest = 0.0;
+    for (std::size_t index = 0; index < a.pixels.size(); ++index) {
+        const double difference = std::abs(static_cast<double>(a.pixels[index]) - b.pixels[index]);
+        largest = std::max(largest, difference / std::max(1.0, std::abs(static_cast<double>(b.pixels[index]))));
+    }
+    return largest;
+}
+
+std::string key_of(const Scene& scene, const Camera& camera, const RenderConfig& config) {
+    std::string key;
+    RenderCache::key(scene, camera, config, kMaxDepth, key);
+    return key;
+}
+
+Scene scene_with_ball(const Color& albedo) {
+    Scene scene = create_scene();
+    scene.objects.add(std::make_shared<Sphere>(Point3(0.0, -0.5, -3.0), 0.3, std::make_shared<Matte>(albedo)));
+    scene.commit();
+    return scene;
+}
+
+/**
+ * Render `config` through the engine, optionally on top of `start`.
+ */
+FrameSamples render(RenderEngine& engine, const std::shared_ptr<const Scene>& scene, const RenderConfig& config,
+                    const std::shared_ptr<const FrameSamples>& start) {
+    RenderJob job;
+    job.scene = scene;
+    job.config = config;
+    job.camera = Camera(config.aspect_ratio);
+    job.max_depth = kMaxDepth;
+    job.start_from = start;
+    const std::shared_ptr<RenderHandle> handle = engine.submit(std::move(job));
+    handle->wait();
+    return FrameSamples{handle->framebuffer(), handle->sample_counts()};
+}
+
+bool check(const char* label, bool holds) {
+    std::cout << "  " << label << ": " << (holds ? "yes" : "NO") << "\n";
+    return holds;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    const RenderConfig config(16.0 / 9.0, 160, 32);
+    const Camera camera(config.aspect_ratio);
+
+    {
+        const Scene large = bench::furnished_room(kScale);
+        std::string key;
+        const double large_ms = bench::best_time_ms(5, [&] {
+            RenderCache::key(large, camera, config, kMaxDepth, key);
+        });
+        const Scene demo = create_scene();
+        const double demo_ms = bench::best_time_ms(5, [&] {
+            RenderCache::key(demo, camera, config, kMaxDepth, key);
+        });
+        std::cout << "Key of the room x" << kScale << " (" << large.dispatch_table.primitive_count()
+                  << " primitives): " << std::fixed << std::setprecision(2) << large_ms << " ms; demo room ("
+                  << demo.dispatch_table.primitive_count() << " primitives): " << std::setprecision(4) << demo_ms
+                  << " ms\n";
+    }
+
+    const std::string base = key_of(scene_with_ball(Color(0.5, 0.5, 0.5)), camera, config);
+    std::cout << "Key changes, base " << base << "\n";
+    ok &= check("same scene built twice keeps the key",
+                key_of(scene_with_ball(Color(0.5, 0.5, 0.5)), camera, config) == base);
+    RenderConfig more_samples = config;
+    more_samples.samples_per_pixel = 256;
+    more_samples.wide_bvh.enabled = true;
+    ok &= check("more samples and a BVH keep the key",
+                key_of(scene_with_ball(Color(0.5, 0.5, 0.5)), camera, more_samples) == base);
+    ok &= check("a material's albedo changes it", key_of(scene_with_ball(Color(0.5, 0.5, 0.6)), camera, config) != base);
+    Scene brighter = scene_with_ball(Color(0.5, 0.5, 0.5));
+    brighter.lights[0].intensity = brighter.lights[0].intensity * 1.01;
+    ok &= check("a light's intensity changes it", key_of(brighter, camera, config) != base);
+    const RenderConfig wider(16.0 / 9.0, 320, 32);
+    ok &= check("the resolution changes it", key_of(scene_with_ball(Color(0.5, 0.5, 0.5)), camera, wider) != base);
+    ok &= check("the camera changes it",
+                key_of(scene_with_ball(Color(0.5, 0.5, 0.5)), Camera(2.0), config) != base);
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "raytracer_bench_cache";
+    std::filesystem::remove_all(directory);
+    const RenderCache cache(directory.string());
+    const std::shared_ptr<const Scene> scene = std::make_shared<Scene>(create_scene());
+    const std::string key = key_of(*scene, camera, config);
+    RenderEngine engine;
+
+    FrameSamples full;
+    const double render_ms = bench::best_time_ms(1, [&] {
+        full = render(engine, scene, config, nullptr);
+    });
+    const double store_ms = bench::best_time_ms(5, [&] {
+        cache.store(key, full);
+    });
+    FrameSamples loaded;
+    CacheLookup found = CacheLookup::Miss;
+    const double lookup_ms = bench::best_time_ms(5, [&] {
+        found = cache.lookup(key, config.samples_per_pixel, loaded);
+    });
+    std::cout << "\n160x90, 32 spp: render " << std::setprecision(0) << render_ms << " ms; store "
+              << std::setprecision(3) << store_ms << " ms, hit " << lookup_ms << " ms ("
+              << std::setprecision(0) << render_ms / lookup_ms << "x faster than rendering)\n";
+    ok &= check("hit returns the stored image",
+                found == CacheLookup::Hit && loaded.image.pixels == full.image.pixels && loaded.counts == full.counts);
+
+    RenderConfig preview = config;
+    preview.samples_per_pixel = 8;
+    cache.store(key, render(engine, scene, preview, nullptr));
+    const std::shared_ptr<FrameSamples> partial = std::make_shared<FrameSamples>();
+    found = cache.lookup(key, config.samples_per_pixel, *partial);
+    FrameSamples continued;
+    const double continue_ms = bench::best_time_ms(1, [&] {
+        continued = render(engine, scene, config, partial);
+    });
+    bool every_pixel_complete = true;
+    for (const std::uint32_t count : continued.counts) {
+        every_pixel_complete = every_pixel_complete && count == static_cast<std::uint32_t>(config.samples_per_pixel);
+    }
+    const double continued_difference = max_relative_difference(continued.image, full.image);
+    std::cout << "8 spp stored, 32 asked for: continuing takes " << continue_ms << " ms against " << render_ms
+              << " ms from scratch; mean " << std::setprecision(4) << mean(continued.image) << " (from scratch "
+              << mean(full.image) << "), largest difference " << std::scientific << std::setprecision(1)
+              << continued_difference << std::fixed << "\n";
+    ok &= check("stored entry reads as partial", found == CacheLookup::Partial);
+    ok &= check("every pixel ends with 32 samples", every_pixel_complete);
+    // Only the stored averages' float rounding may differ
+    ok &= check("continued image matches 32 spp from scratch", continued_difference < 1e-5);
+
+    RenderConfig two = config;
+    two.samples_per_pixel = 2;
+    RenderConfig four = config;
+    four.samples_per_pixel = 4;
+    const std::shared_ptr<const FrameSamples> two_stored =
+        std::make_shared<FrameSamples>(render(engine, scene, two, nullptr));
+    const FrameSamples two_then_four = render(engine, scene, four, two_stored);
+    const FrameSamples fresh_four = render(engine, scene, four, nullptr);
+    ok &= check("2 spp stored then 4 asked for matches 4 spp from scratch",
+                max_relative_difference(two_then_four.image, fresh_four.image) < 1e-5);
+    ok &= check("and differs from the stored 2 spp",
+                max_relative_difference(two_then_four.image, two_stored->image) > 1e-3);
+
+    std::filesystem::remove_all(directory);
+    return ok ? 0 : 1;
+}
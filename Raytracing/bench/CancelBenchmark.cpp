@@ -0,0 +1,172 @@
+/**
+ * @file CancelBenchmark.cpp
+ * @brief How fast RenderEngine jobs stop, and what they keep.
+ *
+ * - Cancel latency: a 1280x720, 64 spp job cancelled at varying points after
+ *   it starts rendering; time from cancel() to wait() returning, and the
+ *   share of samples kept in the partial framebuffer, checked against the
+ *   pixels that hold any light.
+ * - Shared token: two jobs given one CancellationToken, cancelled together
+ *   once both have built their caches.
+ * - Pause and resume: a 320x180, 16 spp job paused at about a third; time
+ *   until a preview submitted behind it gets a worker, then the job resumed
+ *   to the end. Every pixel must end with all its samples, and the mean must
+ *   match an uninterrupted render of the same job up to noise.
+ */
+
+#include "CancellationToken.h"
+#include "Camera.h"
+#include "RenderConfig.h"
+#include "RenderEngine.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kMaxDepth = 20;
+constexpr int kCancelRuns = 8;
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double mean(const Framebuffer& framebuffer) {
+    double sum = 0.0;
+    for (const float value : framebuffer.pixels) {
+        sum += value;
+    }
+    return framebuffer.pixels.empty() ? 0.0 : sum / static_cast<double>(framebuffer.pixels.size());
+}
+
+RenderJob make_job(const std::shared_ptr<const Scene>& scene, int width, int samples) {
+    RenderJob job;
+    job.scene = scene;
+    job.config = RenderConfig(16.0 / 9.0, width, samples);
+    job.camera = Camera(job.config.aspect_ratio);
+    job.max_depth = kMaxDepth;
+    return job;
+}
+
+void wait_until_running(const RenderHandle& handle) {
+    while (handle.progress().worker_ms == 0.0 && handle.status() != RenderStatus::Completed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool cancel_latency(RenderEngine& engine, const std::shared_ptr<const Scene>& scene) {
+    std::cout << "Cancel: 1280x720, 64 spp, cancelled after its setup plus a delay\n";
+    bool consistent = true;
+    double worst_ms = 0.0;
+    for (int run = 0; run < kCancelRuns; ++run) {
+        const RenderJob job = make_job(scene, 1280, 64);
+        const std::shared_ptr<RenderHandle> handle = engine.submit(job);
+        wait_until_running(*handle);
+        std::this_thread::sleep_for(std::chrono::milliseconds(37 * run));
+
+        const Clock::time_point cancelled_at = Clock::now();
+        handle->cancel();
+        handle->wait();
+        const double stop_ms = ms_since(cancelled_at);
+        worst_ms = std::max(worst_ms, stop_ms);
+
+        // A pixel is lit only if it has samples; the counts never pass the target
+        const std::vector<std::uint32_t>& counts = handle->sample_counts();
+        const Framebuffer& image = handle->framebuffer();
+        std::uint64_t samples = 0;
+        std::size_t sampled_pixels = 0;
+        for (std::size_t pixel = 0; pixel < counts.size(); ++pixel) {
+            samples += counts[pixel];
+            sampled_pixels += counts[pixel] > 0 ? 1 : 0;
+            const bool lit = image.pixels[3 * pixel] + image.pixels[3 * pixel + 1] + image.pixels[3 * pixel + 2] > 0.0f;
+            consistent = consistent && counts[pixel] <= 64 && (counts[pixel] > 0 || !lit);
+        }
+        consistent = consistent && handle->status() == RenderStatus::Cancelled;
+        std::cout << "  after " << std::setw(3) << 37 * run << " ms: stopped in " << std::fixed
+                  << std::setprecision(3) << stop_ms << " ms, kept " << samples << " samples over "
+                  << sampled_pixels << " pixels\n";
+    }
+    std::cout << "  worst " << std::setprecision(3) << worst_ms << " ms from cancel() to wait() returning, counts "
+              << (consistent ? "consistent" : "INCONSISTENT") << "\n";
+    return consistent;
+}
+
+bool shared_token(RenderEngine& engine, const std::shared_ptr<const Scene>& scene) {
+    const std::shared_ptr<CancellationToken> token = std::make_shared<CancellationToken>();
+    RenderJob job = make_job(scene, 640, 64);
+    job.cancel_token = token;
+    const std::shared_ptr<RenderHandle> first = engine.submit(job);
+    const std::shared_ptr<RenderHandle> second = engine.submit(job);
+    // Past both setups, which run to the end once started
+    wait_until_running(*first);
+    wait_until_running(*second);
+
+    const Clock::time_point cancelled_at = Clock::now();
+    token->cancel();
+    first->wait();
+    second->wait();
+    const double stop_ms = ms_since(cancelled_at);
+    const bool both = first->status() == RenderStatus::Cancelled && second->status() == RenderStatus::Cancelled;
+    std::cout << "\nShared token: two running 640x360 jobs " << (both ? "both" : "NOT both")
+              << " cancelled in " << std::setprecision(3) << stop_ms << " ms\n";
+    return both;
+}
+
+bool pause_resume(RenderEngine& engine, const std::shared_ptr<const Scene>& scene) {
+    const RenderJob job = make_job(scene, 320, 16);
+    const std::shared_ptr<RenderHandle> reference = engine.submit(job);
+    reference->wait();
+
+    const std::shared_ptr<RenderHandle> handle = engine.submit(job);
+    while (handle->progress().fraction() < 0.33) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const Clock::time_point paused_at = Clock::now();
+    handle->pause();
+    const std::shared_ptr<RenderHandle> preview = engine.submit(make_job(scene, 80, 4));
+    preview->wait();
+    const double preview_queued_ms = preview->progress().queued_ms;
+    const double preview_done_ms = ms_since(paused_at);
+    const RenderProgress paused = handle->progress();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const bool idle = handle->progress().worker_ms == paused.worker_ms;
+    handle->resume();
+    handle->wait();
+
+    const std::vector<std::uint32_t>& counts = handle->sample_counts();
+    const bool complete = handle->status() == RenderStatus::Completed
+        && std::all_of(counts.begin(), counts.end(), [](std::uint32_t count) { return count == 16; });
+    std::cout << "\nPause: 320x180, 16 spp paused at " << paused.tiles_done << "/" << paused.tile_count
+              << " tiles; an 80x45 preview then waited " << std::setprecision(3) << preview_queued_ms
+              << " ms for a worker and was done after " << std::setprecision(0) << preview_done_ms << " ms; "
+              << (idle ? "no" : "SOME") << " work while paused\n"
+              << "  resumed: " << (complete ? "every pixel has 16 samples" : "MISSING SAMPLES") << ", mean "
+              << std::setprecision(4) << mean(handle->framebuffer()) << " (uninterrupted "
+              << mean(reference->framebuffer()) << "), " << std::setprecision(0) << handle->progress().worker_ms
+              << " worker ms (uninterrupted " << reference->progress().worker_ms << ")\n";
+    return complete && idle;
+}
+
+} // namespace
+
+int main() {
+    const std::shared_ptr<const Scene> scene = std::make_shared<Scene>(create_scene());
+    RenderEngine engine;
+    std::cout << "Render engine with " << engine.thread_count() << " worker threads\n";
+
+    const bool consistent = cancel_latency(engine, scene);
+    const bool both = shared_token(engine, scene);
+    const bool resumed = pause_resume(engine, scene);
+    return consistent && both && resumed ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file CausticsBenchmark.cpp
+ * @brief Caustic photon map: build cost, lookup cost and convergence.
+ *
+ * Adds a glass sphere to the demo room, then
+ * - times PhotonMap::build for several photon budgets,
+ * - times irradiance lookups on the floor around the sphere,
+ * - renders the room with and without caustics at a normal spp budget and
+ *   reports how much light the photons add and how noisy that added light
+ *   is (RMS difference between two renders with independently traced maps
+ *   and camera samples).
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Material.h"
+#include "Parallel.h"
+#include "PhotonMap.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Sphere.h"
+
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 3;
+constexpr int kMaxDepth = 20;
+constexpr std::size_t kLookups = 1'000'000;
+constexpr double kCausticThreshold = 0.02;
+
+std::vector<double> render_luminance(const RenderConfig& config, const Camera& camera, const Scene& scene,
+                                     const IntegratorCaches& caches, std::uint64_t seed) {
+    seed_thread_uniforms(seed);
+    std::vector<double> luminance;
+    luminance.reserve(static_cast<std::size_t>(config.image_width) * static_cast<std::size_t>(config.image_height));
+    for (int row = 0; row < config.image_height; ++row) {
+        for (int col = 0; col < config.image_width; ++col) {
+            const Color color = render_pixel(col, row, config, camera, scene, kMaxDepth, caches);
+            luminance.push_back(0.2126 * color.x() + 0.7152 * color.y() + 0.0722 * color.z());
+        }
+    }
+    return luminance;
+}
+
+} // namespace
+
+int main() {
+    Scene scene = create_scene();
+    const Point3 glass_center(1.6, scene.layout.floor_y + 0.7, -6.2);
+    const double glass_radius = 0.7;
+    scene.objects.add(std::make_shared<Sphere>(glass_center, glass_radius, std::make_shared<Transparent>(1.5)));
+    scene.commit();
+
+    std::cout << "Scene: demo room + glass sphere, " << scene.light_count() << " lights, "
+              << worker_count() << " worker thread(s)\n\n";
+
+    PhotonMapSettings settings;
+    for (const std::size_t budget : {std::size_t{50'000}, std::size_t{200'000}, std::size_t{1'000'000}}) {
+        settings.photon_count = budget;
+        PhotonMap map;
+        const double build_ms = bench::best_time_ms(kRepetitions, [&] { map.build(scene, settings); });
+        std::cout << "build " << std::setw(8) << budget << " photons: " << std::fixed << std::setprecision(1)
+                  << std::setw(8) << build_ms << " ms, " << map.photon_count() << " stored\n";
+    }
+
+    // Two independently traced maps, so the noise figure below includes photon noise
+    settings.photon_count = PhotonMapSettings().photon_count;
+    PhotonMap caustics;
+    seed_thread_uniforms(11);
+    caustics.build(scene, settings);
+    PhotonMap caustics_b;
+    seed_thread_uniforms(12);
+    caustics_b.build(scene, settings);
+
+    std::vector<Point3> floor_points;
+    floor_points.reserve(kLookups);
+    for (std::size_t index = 0; index < kLookups; ++index) {
+        floor_points.emplace_back(glass_center.x() + random_double(-1.5, 1.5), scene.layout.floor_y,
+                                  glass_center.z() + random_double(-1.5, 1.5));
+    }
+    const Vec3 up(0.0, 1.0, 0.0);
+    Color lookup_sum(0.0, 0.0, 0.0);
+    const double lookup_ms = bench::best_time_ms(kRepetitions, [&] {
+        lookup_sum = Color(0.0, 0.0, 0.0);
+        for (const Point3& point : floor_points) {
+            lookup_sum += caustics.irradiance(point, up);
+        }
+    });
+    std::cout << "lookups: " << std::setprecision(1) << lookup_ms * 1e6 / static_cast<double>(kLookups)
+              << " ns each (checksum " << std::setprecision(3) << lookup_sum.x() << ")\n\n";
+
+    for (const int samples : {16, 64}) {
+        const RenderConfig config(16.0 / 9.0, 160, samples);
+        const Camera camera(config.aspect_ratio);
+        IntegratorCaches with_caustics;
+        with_caustics.caustics = &caustics;
+        IntegratorCaches with_caustics_b;
+        with_caustics_b.caustics = &caustics_b;
+
+        // Lookups draw no random numbers, so renders with equal seeds trace
+        // identical paths and on - off is exactly the caustic contribution
+        std::vector<double> off_a;
+        const double off_ms = bench::best_time_ms(1, [&] {
+            off_a = render_luminance(config, camera, scene, IntegratorCaches(), 1);
+        });
+        std::vector<double> on_a;
+        const double on_ms = bench::best_time_ms(1, [&] {
+            on_a = render_luminance(config, camera, scene, with_caustics, 1);
+        });
+        const std::vector<double> off_b = render_luminance(config, camera, scene, IntegratorCaches(), 2);
+        const std::vector<double> on_b = render_luminance(config, camera, scene, with_caustics_b, 2);
+
+        // Caustic region: pixels the photons brighten noticeably
+        std::size_t region = 0;
+        double added = 0.0;
+        double squared_difference = 0.0;
+        for (std::size_t index = 0; index < off_a.size(); ++index) {
+            const double caustic_a = on_a[index] - off_a[index];
+            const double caustic_b = on_b[index] - off_b[index];
+            const double gain = 0.5 * (caustic_a + caustic_b);
+            if (gain > kCausticThreshold) {
+                ++region;
+                added += gain;
+                squared_difference += (caustic_a - caustic_b) * (caustic_a - caustic_b);
+            }
+        }
+        const double count = static_cast<double>(std::max<std::size_t>(region, 1));
+        // The difference of two independent estimates has twice the variance of one
+        const double relative_noise = std::sqrt(squared_difference / count / 2.0) / std::max(added / count, 1e-9);
+
+        std::cout << samples << " spp, 160x90: render " << std::setprecision(0) << off_ms << " ms without, "
+                  << on_ms << " ms with caustics\n"
+                  << "  caustic region " << region << " px, mean luminance added " << std::setprecision(3)
+                  << added / count << " (path tracing alone: 0, point lights are unreachable)\n"
+                  << "  relative RMS noise of the caustic term " << std::setprecision(1) << 100.0 * relative_noise << "%\n";
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file DispatchBenchmark.cpp
+ * @brief Virtual vs tagged-union dispatch cost on the demo room.
+ *
+ * Traces the same ray set through the polymorphic HittableList and through
+ * the scene's PrimitiveTable, then scatters the resulting hits through the
+ * virtual Material API and through the packed material switch.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Hittable.h"
+#include "Material.h"
+#include "PackedMaterial.h"
+#include "RenderConfig.h"
+#include "Scene.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+constexpr int kRepetitions = 5;
+
+void report(const char* label, double milliseconds, std::size_t operations) {
+    std::cout << std::left << std::setw(28) << label
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2) << milliseconds << " ms"
+              << std::setw(10) << std::setprecision(1) << (milliseconds * 1e6 / static_cast<double>(operations))
+              << " ns/op\n";
+}
+
+} // namespace
+
+int main() {
+    const RenderConfig config(16.0 / 9.0, 400, 1);
+    const Camera camera(config.aspect_ratio);
+    const Scene scene = create_scene();
+
+    std::vector<Ray> rays = bench::make_primary_rays(config, camera);
+    const std::vector<Ray> room_rays = bench::make_room_rays(scene.layout, rays.size());
+    rays.insert(rays.end(), room_rays.begin(), room_rays.end());
+
+    std::cout << "Scene: " << scene.object_count() << " objects -> "
+              << scene.dispatch_table.primitive_count() << " packed primitives, "
+              << scene.dispatch_table.material_count() << " packed materials\n";
+    std::cout << "Rays: " << rays.size() << " (half primary, half in-room)\n\n";
+
+    std::size_t virtual_hits = 0;
+    const double virtual_hit_ms = bench::best_time_ms(kRepetitions, [&] {
+        virtual_hits = 0;
+        HitRecord record;
+        for (const Ray& ray : rays) {
+            virtual_hits += scene.objects.hit(ray, kMinDistance, kMaxDistance, record) ? 1 : 0;
+        }
+    });
+
+    std::size_t packed_hits = 0;
+    std::vector<HitRecord> records(rays.size());
+    std::vector<char> did_hit(rays.size());
+    const double packed_hit_ms = bench::best_time_ms(kRepetitions, [&] {
+        packed_hits = 0;
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            did_hit[index] = scene.hit(rays[index], kMinDistance, kMaxDistance, records[index]) ? 1 : 0;
+            packed_hits += static_cast<std::size_t>(did_hit[index]);
+        }
+    });
+
+    double checksum = 0.0;
+    const double virtual_scatter_ms = bench::best_time_ms(kRepetitions, [&] {
+        ScatterRecord scatter_record;
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            if (!did_hit[index]) {
+                continue;
+            }
+            const Material& material = *records[index].material_ptr;
+            if (material.is_diffuse()) {
+                checksum += material.base_color().x();
+            }
+            if (material.scatter(rays[index], records[index], scatter_record)) {
+                checksum += scatter_record.attenuation.y();
+            }
+        }
+    });
+
+    const double packed_scatter_ms = bench::best_time_ms(kRepetitions, [&] {
+        ScatterRecord scatter_record;
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            if (!did_hit[index]) {
+                continue;
+            }
+            if (surface_is_diffuse(records[index])) {
+                checksum += surface_base_color(records[index]).x();
+            }
+            if (surface_scatter(rays[index], records[index], scatter_record)) {
+                checksum += scatter_record.attenuation.y();
+            }
+        }
+    });
+
+    report("closest hit, virtual", virtual_hit_ms, rays.size());
+    report("closest hit, packed", packed_hit_ms, rays.size());
+    report("material, virtual", virtual_scatter_ms, packed_hits);
+    report("material, packed", packed_scatter_ms, packed_hits);
+
+    std::cout << "\nHits: virtual " << virtual_hits << ", packed " << packed_hits
+              << (virtual_hits == packed_hits ? " (match)" : " (MISMATCH)") << "\n";
+    std::cout << "Checksum: " << checksum << "\n";
+    return virtual_hits == packed_hits ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file EnclosureBenchmark.cpp
+ * @brief Room enclosure primitive vs the five wall rectangles it replaces.
+ *
+ * The demo room is built twice: as create_scene makes it (one
+ * RoomEnclosure) and with the shell as five rectangles (floor, ceiling,
+ * side walls, back wall), the way create_scene used to. The benchmark
+ * - times the traversal phase for the shell alone, one enclosure test
+ *   against five rectangle tests,
+ *   for rays from inside the room and camera rays arriving from outside,
+ * - times full closest-hit queries through the table scan and the uniform
+ *   grid for both scenes, and checks every ray finds the same distance,
+ *   normal and material,
+ * - renders both scenes and checks the images are identical.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 5;
+constexpr int kMaxDepth = 20;
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+constexpr std::size_t kRoomRays = 500'000;
+
+/**
+ * `demo` with its enclosure swapped for the five rectangles (same materials).
+ */
+Scene rectangle_shell_scene(const Scene& demo) {
+    Scene scene = demo;
+    const auto enclosure = std::dynamic_pointer_cast<RoomEnclosure>(scene.objects.objects.front());
+    const RoomLayout& layout = scene.layout;
+    const double hw = layout.half_width;
+    std::vector<std::shared_ptr<Hittable>> shell = {
+        std::make_shared<XZRect>(-hw, hw, layout.back_wall_z, layout.front_opening_z, layout.floor_y,
+                                 enclosure->face_material(2)),
+        std::make_shared<XZRect>(-hw, hw, layout.back_wall_z, layout.front_opening_z, layout.ceiling_y,
+                                 enclosure->face_material(3), true),
+        std::make_shared<YZRect>(layout.floor_y, layout.ceiling_y, layout.back_wall_z, layout.front_opening_z, -hw,
+                                 enclosure->face_material(0)),
+        std::make_shared<YZRect>(layout.floor_y, layout.ceiling_y, layout.back_wall_z, layout.front_opening_z, hw,
+                                 enclosure->face_material(1), true),
+        std::make_shared<XYRect>(-hw, hw, layout.floor_y, layout.ceiling_y, layout.back_wall_z,
+                                 enclosure->face_material(4))
+    };
+    std::vector<std::shared_ptr<Hittable>>& objects = scene.objects.objects;
+    objects.erase(objects.begin());
+    objects.insert(objects.begin(), shell.begin(), shell.end());
+    scene.commit();
+    return scene;
+}
+
+/**
+ * A scene holding only the room shell of `source` (its first `count` objects).
+ */
+Scene shell_only(const Scene& source, std::size_t count) {
+    Scene scene;
+    scene.layout = source.layout;
+    for (std::size_t index = 0; index < count; ++index) {
+        scene.objects.add(source.objects.objects[index]);
+    }
+    scene.commit();
+    return scene;
+}
+
+struct Sweep {
+    double ns_per_ray;
+    std::vector<HitRecord> records;
+    std::vector<char> hits;
+};
+
+/**
+ * Time the traversal phase (closest distance and primitive), then resolve
+ * every hit once for the comparison.
+ */
+Sweep sweep(const Scene& scene, const std::vector<Ray>& rays) {
+    Sweep result{0.0, std::vector<HitRecord>(rays.size()), std::vector<char>(rays.size())};
+    std::vector<HitCandidate> candidates(rays.size());
+    result.ns_per_ray = 1e6 / static_cast<double>(rays.size()) * bench::best_time_ms(kRepetitions, [&] {
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            result.hits[index] = scene.intersect(rays[index], kMinDistance, kMaxDistance, candidates[index]);
+        }
+    });
+    for (std::size_t index = 0; index < rays.size(); ++index) {
+        result.hits[index] = scene.hit(rays[index], kMinDistance, kMaxDistance, result.records[index]);
+    }
+    return result;
+}
+
+std::size_t mismatches(const Sweep& a, const Sweep& b) {
+    std::size_t count = 0;
+    for (std::size_t index = 0; index < a.hits.size(); ++index) {
+        const HitRecord& x = a.records[index];
+        const HitRecord& y = b.records[index];
+        if (a.hits[index] != b.hits[index]
+            || (a.hits[index]
+                && (x.distance_from_ray != y.distance_from_ray || x.material_ptr != y.material_ptr
+                    || x.surface_normal.x() != y.surface_normal.x() || x.surface_normal.y() != y.surface_normal.y()
+                    || x.surface_normal.z() != y.surface_normal.z() || x.is_front_face != y.is_front_face))) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+std::size_t compare(const char* label, const Scene& rects, const Scene& enclosed, const std::vector<Ray>& rays) {
+    const Sweep before = sweep(rects, rays);
+    const Sweep after = sweep(enclosed, rays);
+    const std::size_t differing = mismatches(before, after);
+    std::cout << "  " << label << ": " << std::fixed << std::setprecision(1) << before.ns_per_ray << " ns -> "
+              << after.ns_per_ray << " ns per ray (" << std::setprecision(2) << before.ns_per_ray / after.ns_per_ray
+              << "x), " << differing << " of " << rays.size() << " hits differ\n";
+    return differing;
+}
+
+} // namespace
+
+int main() {
+    Scene enclosed = create_scene();
+    Scene rects = rectangle_shell_scene(enclosed);
+    const std::vector<Ray> room_rays = bench::make_room_rays(enclosed.layout, kRoomRays);
+    const RenderConfig camera_config(16.0 / 9.0, 640, 1);
+    const Camera camera(camera_config.aspect_ratio);
+    const std::vector<Ray> camera_rays = bench::make_primary_rays(camera_config, camera);
+    std::size_t differing = 0;
+
+    std::cout << "Room shell only (5 rectangles -> 1 enclosure):\n";
+    const Scene rect_shell = shell_only(rects, 5);
+    const Scene enclosure_shell = shell_only(enclosed, 1);
+    differing += compare("bounce rays", rect_shell, enclosure_shell, room_rays);
+    differing += compare("camera rays", rect_shell, enclosure_shell, camera_rays);
+
+    std::cout << "Demo room, table scan (" << rects.dispatch_table.primitive_count() << " -> "
+              << enclosed.dispatch_table.primitive_count() << " primitives):\n";
+    differing += compare("bounce rays", rects, enclosed, room_rays);
+    differing += compare("camera rays", rects, enclosed, camera_rays);
+
+    std::cout << "Demo room, uniform grid:\n";
+    rects.build_uniform_grid();
+    enclosed.build_uniform_grid();
+    differing += compare("bounce rays", rects, enclosed, room_rays);
+    differing += compare("camera rays", rects, enclosed, camera_rays);
+
+    // Full renders with the same seed
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.caustics.enabled = false;
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<std::vector<float>> images;
+    std::vector<double> times;
+    for (Scene* scene : {&rects, &enclosed}) {
+        scene->accelerator.reset();
+        times.push_back(bench::best_time_ms(1, [&] {
+            seed_thread_uniforms(1);
+            images.push_back(render_framebuffer(config, camera, *scene, kMaxDepth).pixels);
+        }));
+    }
+    std::cerr.rdbuf(previous);
+    std::size_t differing_values = 0;
+    for (std::size_t index = 0; index < images[0].size(); ++index) {
+        differing_values += images[0][index] != images[1][index] ? 1 : 0;
+    }
+    std::cout << "\nrender 160x90, 16 spp: " << std::setprecision(0) << times[0] << " ms rectangles, " << times[1]
+              << " ms enclosure (" << std::setprecision(2) << times[0] / times[1] << "x), " << differing_values
+              << " of " << images[0].size() << " framebuffer values differ\n";
+    return differing == 0 && differing_values == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file EncodeBenchmark.cpp
+ * @brief Encoding throughput and size of the PNG, QOI and JPEG writers.
+ *
+ * Two 8-bit images, quantized from linear floats as the renderer does:
+ * - a smooth 1920x1080 test pattern (gradients and rings), and
+ * - a noisy 480x270, 4 spp render of the demo room, the usual preview.
+ *
+ * Each is written through image_writer::write_rgb() to a temporary .png,
+ * .qoi and .jpg file; the report gives MB/s of RGB input (best of several
+ * runs, file write included) and the file size. The JPEG encoder is then
+ * timed in memory at every ISA level the CPU has (see CpuFeatures.h), and
+ * every level must produce the same bytes.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "CpuFeatures.h"
+#include "Framebuffer.h"
+#include "ImageWriter.h"
+#include "JpegWriter.h"
+#include "Quantize.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 5;
+constexpr int kMaxDepth = 20;
+
+using cpu_features::IsaLevel;
+
+struct Image {
+    const char* label;
+    int width;
+    int height;
+    std::vector<unsigned char> rgb;
+};
+
+Image test_pattern() {
+    const int width = 1920;
+    const int height = 1080;
+    Framebuffer linear(width, height);
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            const double u = static_cast<double>(col) / width;
+            const double v = static_cast<double>(row) / height;
+            const double ring = 0.5 + 0.5 * std::sin(0.05 * std::hypot(col - 0.5 * width, row - 0.5 * height));
+            linear.set(col, row, Color(1.2 * u * ring, v, 0.25 + 0.5 * ring * (1.0 - u)));
+        }
+    }
+    return Image{"1920x1080 test pattern", width, height, quantize_framebuffer(linear, DitherMode::None)};
+}
+
+Image preview_render() {
+    RenderConfig config(16.0 / 9.0, 480, 4);
+    const Camera camera(config.aspect_ratio);
+    const Scene scene = create_scene();
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    const Framebuffer linear = render_framebuffer(config, camera, scene, kMaxDepth);
+    std::cerr.rdbuf(previous);
+    return Image{"480x270, 4 spp render", config.image_width, config.image_height,
+                 quantize_framebuffer(linear, DitherMode::None)};
+}
+
+double megabytes_per_second(const Image& image, double milliseconds) {
+    return static_cast<double>(image.rgb.size()) / (milliseconds * 1e3);
+}
+
+bool benchmark(const Image& image) {
+    std::cout << image.label << " (" << std::fixed << std::setprecision(2)
+              << static_cast<double>(image.rgb.size()) / 1e6 << " MB of RGB)\n";
+    bool ok = true;
+    for (const char* extension : {"png", "qoi", "jpg"}) {
+        const std::filesystem::path path =
+            std::filesystem::temp_directory_path() / (std::string("raytracer_bench_encode.") + extension);
+        bool written = true;
+        const double milliseconds = bench::best_time_ms(kRepetitions, [&] {
+            written = image_writer::write_rgb(path.string(), image.width, image.height, image.rgb) && written;
+        });
+        const double bytes = written ? static_cast<double>(std::filesystem::file_size(path)) : 0.0;
+        std::cout << "  " << extension << ": " << std::setw(7) << std::setprecision(0)
+                  << megabytes_per_second(image, milliseconds) << " MB/s, " << std::setw(9)
+                  << static_cast<std::size_t>(bytes) << " bytes (" << std::setprecision(1)
+                  << 100.0 * bytes / static_cast<double>(image.rgb.size()) << "% of the input)\n";
+        std::filesystem::remove(path);
+        ok = ok && written;
+    }
+
+    std::vector<unsigned char> reference;
+    for (const IsaLevel level : {IsaLevel::Scalar, IsaLevel::Sse42, IsaLevel::Avx2, IsaLevel::Avx512}) {
+        if (level > cpu_features::detected_isa()) {
+            continue;
+        }
+        cpu_features::force_isa(level);
+        std::vector<unsigned char> jpeg;
+        const double milliseconds = bench::best_time_ms(kRepetitions, [&] {
+            jpeg_writer::encode_rgb(image.width, image.height, image.rgb, jpeg_writer::kDefaultQuality, jpeg);
+        });
+        if (reference.empty()) {
+            reference = jpeg;
+        }
+        const bool same = jpeg == reference;
+        ok = ok && same;
+        std::cout << "  jpg in memory, " << std::left << std::setw(6) << cpu_features::isa_name(level) << std::right
+                  << ": " << std::setw(5) << std::setprecision(0) << megabytes_per_second(image, milliseconds)
+                  << " MB/s" << (same ? "" : ", bytes DIFFER from scalar") << "\n";
+    }
+    cpu_features::clear_forced_isa();
+    return ok;
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Detected ISA: " << cpu_features::isa_name(cpu_features::detected_isa()) << "\n\n";
+    const bool pattern_ok = benchmark(test_pattern());
+    std::cout << "\n";
+    const bool render_ok = benchmark(preview_render());
+    return pattern_ok && render_ok ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file EngineBenchmark.cpp
+ * @brief Latency of in-process render jobs through RenderEngine.
+ *
+ * - Small preview jobs (80x45, 4 spp) submitted and waited for one after
+ *   another: end-to-end latency per job against calling render_framebuffer()
+ *   directly, i.e. the engine's own overhead.
+ * - A 320x180, 16 spp job: time to the first progress callback, the cost of
+ *   snapshot() while it runs, and the mean pixel value against
+ *   render_framebuffer() (tiles change the noise, not the mean).
+ * - Cancellation: a large job cancelled once its first tile is done; time
+ *   from cancel() to wait() returning and how many tiles were rendered.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "RenderConfig.h"
+#include "RenderEngine.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kMaxDepth = 20;
+constexpr int kPreviewJobs = 20;
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+double mean(const Framebuffer& framebuffer) {
+    double sum = 0.0;
+    for (const float value : framebuffer.pixels) {
+        sum += value;
+    }
+    return framebuffer.pixels.empty() ? 0.0 : sum / static_cast<double>(framebuffer.pixels.size());
+}
+
+RenderJob make_job(const std::shared_ptr<const Scene>& scene, int width, int samples) {
+    RenderJob job;
+    job.scene = scene;
+    job.config = RenderConfig(16.0 / 9.0, width, samples);
+    job.camera = Camera(job.config.aspect_ratio);
+    job.max_depth = kMaxDepth;
+    return job;
+}
+
+} // namespace
+
+int main() {
+    const std::shared_ptr<const Scene> scene = std::make_shared<Scene>(create_scene());
+    RenderEngine engine;
+    std::cout << "Render engine with " << engine.thread_count() << " worker threads\n";
+
+    // Keep render_framebuffer's progress output out of the report
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+
+    const RenderJob preview = make_job(scene, 80, 4);
+    const double direct_ms = bench::best_time_ms(kPreviewJobs, [&] {
+        render_framebuffer(preview.config, preview.camera, *scene, kMaxDepth);
+    });
+    const double engine_ms = bench::best_time_ms(kPreviewJobs, [&] {
+        engine.submit(preview)->wait();
+    });
+    std::cout << "80x45, 4 spp previews: render_framebuffer " << std::fixed << std::setprecision(2) << direct_ms
+              << " ms, engine job (submit to wait) " << engine_ms << " ms, best of " << kPreviewJobs << "\n";
+
+    RenderJob medium = make_job(scene, 320, 16);
+    std::atomic<bool> first_progress{false};
+    std::atomic<double> first_progress_ms{0.0};
+    const Clock::time_point submitted = Clock::now();
+    medium.on_progress = [&](const RenderProgress&) {
+        if (!first_progress.exchange(true)) {
+            first_progress_ms.store(ms_since(submitted));
+        }
+    };
+    const std::shared_ptr<RenderHandle> handle = engine.submit(medium);
+    std::size_t snapshots = 0;
+    double snapshot_ms = 0.0;
+    while (!handle->wait_for(std::chrono::milliseconds(20))) {
+        const Clock::time_point start = Clock::now();
+        const Framebuffer partial = handle->snapshot();
+        snapshot_ms += ms_since(start);
+        snapshots += partial.pixels.empty() ? 0 : 1;
+    }
+    const RenderProgress done = handle->progress();
+    const Framebuffer reference = render_framebuffer(medium.config, medium.camera, *scene, kMaxDepth);
+    std::cout << "320x180, 16 spp: " << done.tile_count << " tiles in " << std::setprecision(0) << done.elapsed_ms
+              << " ms, first progress after " << first_progress_ms.load() << " ms, " << snapshots
+              << " snapshots at " << std::setprecision(3) << (snapshots > 0 ? snapshot_ms / snapshots : 0.0)
+              << " ms each, mean " << std::setprecision(4) << mean(handle->framebuffer())
+              << " (render_framebuffer " << mean(reference) << ")\n";
+
+    const std::shared_ptr<RenderHandle> doomed = engine.submit(make_job(scene, 1280, 64));
+    while (doomed->progress().tiles_done == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    const Clock::time_point cancelled_at = Clock::now();
+    doomed->cancel();
+    doomed->wait();
+    const double cancel_ms = ms_since(cancelled_at);
+    const RenderProgress stopped = doomed->progress();
+    std::cerr.rdbuf(previous);
+    std::cout << "1280x720, 64 spp cancelled after its first tile: ended "
+              << (stopped.status == RenderStatus::Cancelled ? "Cancelled" : "Completed") << " with "
+              << stopped.tiles_done << " of " << stopped.tile_count << " tiles, " << std::setprecision(2)
+              << cancel_ms << " ms after cancel()\n";
+    return stopped.status == RenderStatus::Cancelled ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file GridBenchmark.cpp
+ * @brief Uniform grid vs linear table scan on the demo room and larger rooms.
+ *
+ * The demo room is scaled up by widening and deepening it and filling the
+ * floor with copies of its furniture (table, legs, cabinet, sofa, lamp), so
+ * object density stays about the same while the object count grows. For
+ * each room the benchmark
+ * - builds the grid at the automatic resolution and reports build time,
+ *   resolution, voxels per primitive and empty voxels,
+ * - times closest-hit queries for camera rays and for incoherent rays from
+ *   random points in the room (like bounces), against the full table scan,
+ *   and checks both find the same primitive at the same distance,
+ * - sweeps cells_per_primitive on the largest room.
+ * Finally it renders the demo room with and without the grid and checks the
+ * images are identical.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "UniformGrid.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 3;
+constexpr int kMaxDepth = 20;
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+constexpr std::size_t kRayBudget = 200'000'000;  // Primitive tests per timed linear pass
+
+struct QueryResult {
+    double ns_per_ray;
+    std::size_t mismatches;
+};
+
+/**
+ * Time `rays` through the grid and through the table; count disagreements.
+ */
+void compare(const Scene& scene, const UniformGrid& grid, const std::vector<Ray>& rays, QueryResult& linear,
+             QueryResult& gridded) {
+    const PrimitiveTable& table = scene.dispatch_table;
+    std::vector<HitCandidate> reference(rays.size());
+    std::vector<char> reference_hit(rays.size());
+    std::vector<HitCandidate> found(rays.size());
+    std::vector<char> found_hit(rays.size());
+    const double per_ray = 1e6 / static_cast<double>(rays.size());
+    linear.ns_per_ray = per_ray * bench::best_time_ms(kRepetitions, [&] {
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            reference_hit[index] = table.intersect(rays[index], kMinDistance, kMaxDistance, reference[index]);
+        }
+    });
+    gridded.ns_per_ray = per_ray * bench::best_time_ms(kRepetitions, [&] {
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            found_hit[index] = grid.intersect(table, rays[index], kMinDistance, kMaxDistance, found[index]);
+        }
+    });
+    linear.mismatches = 0;
+    gridded.mismatches = 0;
+    for (std::size_t index = 0; index < rays.size(); ++index) {
+        if (reference_hit[index] != found_hit[index]
+            || (reference_hit[index]
+                && (reference[index].primitive_index != found[index].primitive_index
+                    || reference[index].distance_from_ray != found[index].distance_from_ray))) {
+            ++gridded.mismatches;
+        }
+    }
+}
+
+void print_queries(const char* label, const QueryResult& linear, const QueryResult& gridded) {
+    std::cout << "  " << label << ": linear " << std::fixed << std::setprecision(1) << linear.ns_per_ray
+              << " ns, grid " << gridded.ns_per_ray << " ns per ray (" << std::setprecision(2)
+              << linear.ns_per_ray / gridded.ns_per_ray << "x), " << gridded.mismatches << " mismatches\n";
+}
+
+} // namespace
+
+int main() {
+    const RenderConfig camera_config(16.0 / 9.0, 320, 1);
+    const Camera camera(camera_config.aspect_ratio);
+    std::size_t total_mismatches = 0;
+
+    for (const int scale : {1, 2, 4, 8}) {
+        const Scene scene = bench::furnished_room(scale);
+        const std::size_t primitives = scene.dispatch_table.primitive_count();
+        UniformGrid grid;
+        const double build_ms = bench::best_time_ms(kRepetitions, [&] { grid.build(scene.dispatch_table); });
+        std::cout << "Room x" << scale << ": " << scene.object_count() << " objects, " << primitives
+                  << " primitives; grid " << grid.dimensions()[0] << "x" << grid.dimensions()[1] << "x"
+                  << grid.dimensions()[2] << ", " << std::fixed << std::setprecision(2)
+                  << static_cast<double>(grid.reference_count()) / static_cast<double>(primitives)
+                  << " voxels per primitive, " << std::setprecision(1) << 100.0 * grid.empty_fraction()
+                  << "% empty, built in " << std::setprecision(3) << build_ms << " ms\n";
+
+        // Keep each timed linear pass to a similar number of primitive tests
+        const std::size_t ray_count = std::max<std::size_t>(kRayBudget / primitives / 10, 5'000);
+        const std::vector<Ray> all_camera_rays = bench::make_primary_rays(camera_config, camera);
+        std::vector<Ray> camera_rays;
+        const std::size_t stride = std::max<std::size_t>(all_camera_rays.size() / ray_count, 1);
+        for (std::size_t index = 0; index < all_camera_rays.size(); index += stride) {
+            camera_rays.push_back(all_camera_rays[index]);
+        }
+        const std::vector<Ray> room_rays = bench::make_room_rays(scene.layout, ray_count);
+
+        QueryResult linear;
+        QueryResult gridded;
+        compare(scene, grid, camera_rays, linear, gridded);
+        print_queries("camera rays", linear, gridded);
+        total_mismatches += gridded.mismatches;
+        compare(scene, grid, room_rays, linear, gridded);
+        print_queries("room rays  ", linear, gridded);
+        total_mismatches += gridded.mismatches;
+
+        if (scale == 8) {
+            std::cout << "  cells_per_primitive sweep (room rays):";
+            for (const double density : {0.5, 1.0, 2.0, 4.0, 8.0, 16.0}) {
+                UniformGridSettings settings;
+                settings.cells_per_primitive = density;
+                UniformGrid swept;
+                swept.build(scene.dispatch_table, settings);
+                compare(scene, swept, room_rays, linear, gridded);
+                total_mismatches += gridded.mismatches;
+                std::cout << " " << std::setprecision(1) << density << " -> " << gridded.ns_per_ray << " ns";
+            }
+            std::cout << "\n";
+        }
+    }
+
+    // Full renders: same seed, so identical images prove the grid is exact
+    Scene scene = create_scene();
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.caustics.enabled = false;
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<std::vector<float>> images;
+    std::vector<double> times;
+    for (const bool use_grid : {false, true}) {
+        if (use_grid) {
+            scene.build_uniform_grid();
+        }
+        times.push_back(bench::best_time_ms(1, [&] {
+            seed_thread_uniforms(1);
+            images.push_back(render_framebuffer(config, camera, scene, kMaxDepth).pixels);
+        }));
+    }
+    std::cerr.rdbuf(previous);
+    const bool identical = images[0] == images[1];
+    std::cout << "\nrender 160x90, 16 spp: " << std::setprecision(0) << times[0] << " ms linear, " << times[1]
+              << " ms grid (" << std::setprecision(2) << times[0] / times[1] << "x), images "
+              << (identical ? "identical" : "DIFFER") << "\n";
+    return identical && total_mismatches == 0 ? 0 : 1;
+}
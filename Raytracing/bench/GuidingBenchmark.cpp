@@ -0,0 +1,193 @@
+/**
+ * @file GuidingBenchmark.cpp
+ * @brief Path guiding: variance at equal time on a hard indirect-lighting room.
+ *
+ * The demo room is closed behind the camera and lit by a single lamp in an
+ * open-topped shade, so direct light only reaches a patch of ceiling about
+ * a metre across and everything else is lit by that patch. The benchmark
+ * - renders the room several times with cosine sampling and with path
+ *   guiding (independent seeds) and reports time, mean luminance (which
+ *   must agree) and relative MSE: per-pixel variance over squared mean,
+ *   averaged over the image,
+ * - scales each relative MSE by its render time to compare at equal time,
+ * - times concurrent GuidingField::record calls from every worker and
+ *   checks that no record was lost.
+ */
+
+#include "AxisAlignedRect.h"
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Material.h"
+#include "Parallel.h"
+#include "PathGuiding.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kMaxDepth = 20;
+constexpr int kWidth = 80;
+constexpr int kSamplesPerPixel = 64;
+constexpr int kRenders = 4;
+// Keeps near-black pixels from dominating the relative error
+constexpr double kRelativeEpsilon = 1e-3;
+constexpr std::size_t kRecords = 4'000'000;
+constexpr std::size_t kRecordGrain = 1 << 14;
+
+/**
+ * Demo room, closed off behind the camera, lit by one lamp in a dark shade
+ * that is open only at the top. (A bright shade lining, lit from 25 cm
+ * away, would add fireflies that swamp both estimates.)
+ */
+Scene create_shaded_lamp_scene() {
+    const RoomLayout layout = default_room_layout();
+    const Point3 lamp(0.0, layout.ceiling_y - 1.0, -7.0);
+    Scene scene = create_scene(layout, {Light(lamp, Color(18.0, 18.0, 17.0))});
+
+    auto shade = std::make_shared<Matte>(Color(0.08, 0.08, 0.08));
+    const double half_width = 0.25;
+    const double bottom = lamp.y() - 0.3;
+    const double top = lamp.y() + 0.5;
+    const double x0 = lamp.x() - half_width;
+    const double x1 = lamp.x() + half_width;
+    const double z0 = lamp.z() - half_width;
+    const double z1 = lamp.z() + half_width;
+    scene.objects.add(std::make_shared<XZRect>(x0, x1, z0, z1, bottom, shade));
+    scene.objects.add(std::make_shared<XYRect>(x0, x1, bottom, top, z0, shade));
+    scene.objects.add(std::make_shared<XYRect>(x0, x1, bottom, top, z1, shade));
+    scene.objects.add(std::make_shared<YZRect>(bottom, top, z0, z1, x0, shade));
+    scene.objects.add(std::make_shared<YZRect>(bottom, top, z0, z1, x1, shade));
+
+    // Extend the room past the camera and close it, so no sky light gets in
+    auto wall = std::make_shared<Matte>(Color(0.75, 0.75, 0.72));
+    const double closed_z = 0.5;
+    const double half_room_width = layout.half_width;
+    scene.objects.add(std::make_shared<XZRect>(-half_room_width, half_room_width, layout.front_opening_z, closed_z,
+                                               layout.floor_y, wall));
+    scene.objects.add(std::make_shared<XZRect>(-half_room_width, half_room_width, layout.front_opening_z, closed_z,
+                                               layout.ceiling_y, wall));
+    scene.objects.add(std::make_shared<YZRect>(layout.floor_y, layout.ceiling_y, layout.front_opening_z, closed_z,
+                                               -half_room_width, wall));
+    scene.objects.add(std::make_shared<YZRect>(layout.floor_y, layout.ceiling_y, layout.front_opening_z, closed_z,
+                                               half_room_width, wall));
+    scene.objects.add(std::make_shared<XYRect>(-half_room_width, half_room_width, layout.floor_y, layout.ceiling_y,
+                                               closed_z, wall));
+    scene.commit();
+    return scene;
+}
+
+std::vector<double> luminance_of(const Framebuffer& framebuffer) {
+    std::vector<double> luminance(framebuffer.pixel_count());
+    for (std::size_t index = 0; index < luminance.size(); ++index) {
+        const float* pixel = framebuffer.pixels.data() + index * 3;
+        luminance[index] = 0.2126 * pixel[0] + 0.7152 * pixel[1] + 0.0722 * pixel[2];
+    }
+    return luminance;
+}
+
+struct ModeResult {
+    double milliseconds;  ///< Mean time per render
+    double mean;
+    double relative_mse;
+};
+
+ModeResult measure(const RenderConfig& config, const Camera& camera, const Scene& scene) {
+    // The renderer's progress output would drown the report
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+
+    std::vector<std::vector<double>> renders;
+    double milliseconds = 0.0;
+    RenderConfig seeded = config;
+    for (int render = 0; render < kRenders; ++render) {
+        seeded.sample_seed = static_cast<std::uint64_t>(render + 1) * 7919;
+        milliseconds += bench::best_time_ms(1, [&] {
+            renders.push_back(luminance_of(render_framebuffer(seeded, camera, scene, kMaxDepth)));
+        });
+    }
+    std::cerr.rdbuf(previous);
+
+    const std::size_t pixels = renders[0].size();
+    double image_sum = 0.0;
+    double relative_sum = 0.0;
+    for (std::size_t index = 0; index < pixels; ++index) {
+        double mean = 0.0;
+        for (const std::vector<double>& luminance : renders) {
+            mean += luminance[index];
+        }
+        mean /= kRenders;
+        double variance = 0.0;
+        for (const std::vector<double>& luminance : renders) {
+            variance += (luminance[index] - mean) * (luminance[index] - mean);
+        }
+        variance /= kRenders - 1;
+        image_sum += mean;
+        relative_sum += variance / (mean * mean + kRelativeEpsilon);
+    }
+    return ModeResult{milliseconds / kRenders, image_sum / static_cast<double>(pixels),
+                      relative_sum / static_cast<double>(pixels)};
+}
+
+} // namespace
+
+int main() {
+    const Scene scene = create_shaded_lamp_scene();
+    RenderConfig config(16.0 / 9.0, kWidth, kSamplesPerPixel);
+    config.caustics.enabled = false;
+    const Camera camera(config.aspect_ratio);
+
+    std::cout << "Scene: closed demo room, one lamp in an open-topped shade; " << config.image_width << "x"
+              << config.image_height << ", " << config.samples_per_pixel << " spp, depth " << kMaxDepth
+              << ", " << kRenders << " renders per mode\n\n";
+
+    const ModeResult cosine = measure(config, camera, scene);
+    config.path_guiding.enabled = true;
+    const ModeResult guided = measure(config, camera, scene);
+
+    std::cout << std::fixed;
+    for (const auto& [label, result] : {std::make_pair("cosine sampling", cosine), std::make_pair("path guiding", guided)}) {
+        std::cout << std::left << std::setw(16) << label << std::right
+                  << std::setprecision(0) << std::setw(8) << result.milliseconds << " ms"
+                  << "   mean " << std::setprecision(4) << result.mean
+                  << "   relative MSE " << std::setprecision(4) << result.relative_mse << "\n";
+    }
+    const double equal_time_ratio = (guided.relative_mse * guided.milliseconds)
+                                  / (cosine.relative_mse * cosine.milliseconds);
+    std::cout << "variance at equal time: " << std::setprecision(2) << equal_time_ratio
+              << "x of cosine sampling (" << std::setprecision(1) << 100.0 * (1.0 - equal_time_ratio)
+              << "% reduction)\n\n";
+
+    // Concurrent training: every worker records into the same region
+    GuidingField field(config.path_guiding, Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
+    GuidingRegion& region = field.region(Point3(0.0, 0.0, 0.0), Vec3(0.0, 1.0, 0.0));
+    const ShadingFrame frame = ShadingFrame::from_normal(Vec3(0.0, 1.0, 0.0));
+    const double record_ms = bench::best_time_ms(1, [&] {
+        parallel_for(0, kRecords, kRecordGrain, [&](std::size_t first, std::size_t last) {
+            GuidedDirection sampled;
+            for (std::size_t index = first; index < last; ++index) {
+                if (field.sample(region, frame, sampled)) {
+                    // Unit energy per record: luminance = pdf
+                    field.record(region, sampled, sampled.pdf);
+                }
+            }
+        });
+    });
+    const std::uint32_t records = region.record_count.load();
+    const double energy = region.building.total();
+    const bool none_lost = std::fabs(energy - records) < 0.5;
+    std::cout << "record: " << worker_count() << " worker(s), " << std::setprecision(1)
+              << static_cast<double>(records) / (record_ms * 1e-3) / 1e6 << " M records/s, energy "
+              << std::setprecision(0) << energy << " of " << records << " recorded ("
+              << (none_lost ? "none lost" : "LOST UPDATES") << ")\n";
+    return none_lost ? 0 : 1;
+}
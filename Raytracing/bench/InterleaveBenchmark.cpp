@@ -0,0 +1,177 @@
+/**
+ * @file InterleaveBenchmark.cpp
+ * @brief One-ray-at-a-time vs interleaved wide-BVH traversal, in and out of cache.
+ *
+ * Usage: raytracer_bench_interleave [scale]
+ *
+ * Builds the furnished room (see bench::furnished_room) at a scale whose
+ * primitive table and BVH together exceed the last-level cache (or at
+ * `scale`), plus a small cache-resident room for comparison. For both node
+ * formats it times incoherent room rays through WideBvh::intersect() one
+ * ray at a time and through WideBvh::intersect_interleaved() with 1 to 16
+ * rays in flight, and reports time-stamp-counter cycles and nanoseconds per
+ * ray. Every interleaved result is checked against intersect().
+ */
+
+#include "BenchUtils.h"
+#include "Scene.h"
+#include "WideBvh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__unix__)
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int kRepetitions = 3;
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+constexpr std::size_t kRays = 200'000;
+constexpr int kCacheResidentScale = 8;
+// Table entry plus BVH share per primitive, and primitives per furniture set
+constexpr double kBytesPerPrimitive = 140.0;
+constexpr double kPrimitivesPerSet = 43.0;
+
+std::uint64_t cycle_counter() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+std::size_t last_level_cache_bytes() {
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    const long bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (bytes > 0) {
+        return static_cast<std::size_t>(bytes);
+    }
+#endif
+    return std::size_t{32} << 20;
+}
+
+struct Cost {
+    double cycles = 0.0;
+    double nanoseconds = 0.0;
+};
+
+/**
+ * Best per-ray cost of `body` over kRepetitions runs of `rays` queries.
+ */
+template <typename Body>
+Cost per_ray(std::size_t rays, Body&& body) {
+    Cost best;
+    for (int run = 0; run < kRepetitions; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t start_cycles = cycle_counter();
+        body();
+        const std::uint64_t stop_cycles = cycle_counter();
+        const auto stop = std::chrono::steady_clock::now();
+        const double nanoseconds =
+            std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(rays);
+        if (run == 0 || nanoseconds < best.nanoseconds) {
+            best.nanoseconds = nanoseconds;
+            best.cycles = static_cast<double>(stop_cycles - start_cycles) / static_cast<double>(rays);
+        }
+    }
+    return best;
+}
+
+bool same_result(const HitCandidate& a, const HitCandidate& b) {
+    return a.primitive == b.primitive
+        && (a.primitive == nullptr
+            || (a.primitive_index == b.primitive_index && a.distance_from_ray == b.distance_from_ray));
+}
+
+/**
+ * Sequential vs interleaved traversal of one BVH; return the number of
+ * results that differ from intersect().
+ */
+std::size_t compare(const char* label, const Scene& scene, const WideBvh& bvh, const std::vector<Ray>& rays) {
+    std::vector<HitCandidate> reference(rays.size());
+    const Cost sequential = per_ray(rays.size(), [&] {
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            reference[index] = HitCandidate();
+            bvh.intersect(scene.dispatch_table, rays[index], kMinDistance, kMaxDistance, reference[index]);
+        }
+    });
+    std::cout << "  " << label << ": one at a time " << std::fixed << std::setprecision(0) << sequential.cycles
+              << " cycles (" << sequential.nanoseconds << " ns) per ray\n";
+
+    std::size_t differing = 0;
+    std::vector<HitCandidate> candidates(rays.size());
+    for (const int group : {1, 2, 4, 8, 16}) {
+        const Cost interleaved = per_ray(rays.size(), [&] {
+            bvh.intersect_interleaved(scene.dispatch_table, rays.data(), rays.size(), kMinDistance, kMaxDistance,
+                                      candidates.data(), group);
+        });
+        std::size_t group_differing = 0;
+        for (std::size_t index = 0; index < rays.size(); ++index) {
+            group_differing += same_result(reference[index], candidates[index]) ? 0 : 1;
+        }
+        differing += group_differing;
+        std::cout << "    " << std::setw(2) << group << " in flight: " << std::setprecision(0)
+                  << interleaved.cycles << " cycles (" << interleaved.nanoseconds << " ns) per ray, "
+                  << std::setprecision(2) << sequential.nanoseconds / interleaved.nanoseconds << "x, "
+                  << group_differing << " mismatches\n";
+    }
+    return differing;
+}
+
+std::size_t run_room(int scale, std::size_t cache_bytes) {
+    const Scene scene = bench::furnished_room(scale);
+    const std::vector<Ray> rays = bench::make_room_rays(scene.layout, kRays);
+    const std::size_t table_bytes = scene.dispatch_table.primitive_count() * sizeof(PackedPrimitive);
+    std::size_t differing = 0;
+    for (const BvhNodeFormat format : {BvhNodeFormat::Full, BvhNodeFormat::Quantized}) {
+        WideBvhSettings settings;
+        settings.format = format;
+        WideBvh bvh;
+        bvh.build(scene.dispatch_table, settings);
+        const std::size_t bytes = table_bytes + bvh.node_bytes() + bvh.index_bytes();
+        std::cout << "Room x" << scale << ", " << (format == BvhNodeFormat::Full ? "full" : "quantized")
+                  << " nodes: " << scene.dispatch_table.primitive_count() << " primitives, " << std::fixed
+                  << std::setprecision(1) << static_cast<double>(bytes) / 1048576.0 << " MiB of table and BVH ("
+                  << std::setprecision(2) << static_cast<double>(bytes) / static_cast<double>(cache_bytes)
+                  << "x the last-level cache)\n";
+        differing += compare("room rays", scene, bvh, rays);
+    }
+    return differing;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t cache_bytes = last_level_cache_bytes();
+    int scale = 0;
+    if (argc > 1) {
+        scale = std::atoi(argv[1]);
+        if (scale < 1) {
+            std::cerr << "Usage: raytracer_bench_interleave [scale]\n";
+            return 2;
+        }
+    } else {
+        // Smallest room whose table and tree hold 1.5x the cache
+        const double sets = 1.5 * static_cast<double>(cache_bytes) / (kBytesPerPrimitive * kPrimitivesPerSet);
+        scale = std::max(kCacheResidentScale, static_cast<int>(std::ceil(std::sqrt(sets))));
+    }
+    std::cout << "Last-level cache: " << cache_bytes / 1048576 << " MiB; cycles are time-stamp-counter ticks\n\n";
+
+    std::size_t differing = run_room(kCacheResidentScale, cache_bytes);
+    std::cout << "\n";
+    differing += run_room(scale, cache_bytes);
+    return differing == 0 ? 0 : 1;
+}
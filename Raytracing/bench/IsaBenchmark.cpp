@@ -0,0 +1,190 @@
+/**
+ * @file IsaBenchmark.cpp
+ * @brief Per-ISA throughput of the runtime-dispatched kernels.
+ *
+ * Forces every level up to the detected one in turn (the same switch as
+ * `raytracer --isa=` / RAYTRACER_ISA) and times primitive intersection, the
+ * xoshiro fill, framebuffer quantization and both checksums. Each variant's
+ * output is compared against the scalar one, and CRC-32 / Adler-32 against
+ * bitwise reference implementations.
+ *
+ * Usage: raytracer_bench_isa [level]   (only that level when given)
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Checksum.h"
+#include "CpuFeatures.h"
+#include "Framebuffer.h"
+#include "Hittable.h"
+#include "Quantize.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Scene.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using cpu_features::IsaLevel;
+
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+constexpr int kRepetitions = 5;
+constexpr int kFrameWidth = 3840;
+constexpr int kFrameHeight = 2160;
+constexpr std::size_t kRandomCount = std::size_t{1} << 24;
+constexpr std::size_t kChecksumBytes = std::size_t{64} << 20;
+
+std::uint32_t reference_crc32(const std::vector<unsigned char>& data) {
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (const unsigned char byte : data) {
+        crc ^= byte;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320u & static_cast<std::uint32_t>(-(crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+std::uint32_t reference_adler32(const std::vector<unsigned char>& data) {
+    std::uint32_t a = 1;
+    std::uint32_t b = 0;
+    for (const unsigned char byte : data) {
+        a = (a + byte) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    return (b << 16) | a;
+}
+
+struct LevelResult {
+    double intersect_ms;
+    double random_ms;
+    double quantize_ms;
+    double crc_ms;
+    double adler_ms;
+    std::vector<double> hit_distances;
+    std::vector<double> randoms;
+    std::vector<unsigned char> pixels;
+    std::uint32_t crc;
+    std::uint32_t adler;
+    std::uint32_t short_crc_mix;
+};
+
+void report(const char* label, double milliseconds, double units, const char* unit) {
+    std::cout << "  " << std::left << std::setw(22) << label
+              << std::right << std::setw(10) << std::fixed << std::setprecision(2) << milliseconds << " ms"
+              << std::setw(10) << std::setprecision(1) << units / (milliseconds * 1e-3) / 1e6 << ' ' << unit << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    IsaLevel only_level = IsaLevel::Scalar;
+    const bool single_level = argc > 1;
+    if (single_level && !cpu_features::parse_isa(argv[1], only_level)) {
+        std::cerr << "Usage: raytracer_bench_isa [scalar|sse4.2|avx2|avx512]\n";
+        return 2;
+    }
+
+    const RenderConfig config(16.0 / 9.0, 400, 1);
+    const Camera camera(config.aspect_ratio);
+    const Scene scene = create_scene();
+    std::vector<Ray> rays = bench::make_primary_rays(config, camera);
+    const std::vector<Ray> room_rays = bench::make_room_rays(scene.layout, rays.size());
+    rays.insert(rays.end(), room_rays.begin(), room_rays.end());
+
+    Framebuffer frame(kFrameWidth, kFrameHeight);
+    for (int row = 0; row < kFrameHeight; ++row) {
+        for (int col = 0; col < kFrameWidth; ++col) {
+            const double t = static_cast<double>(row) / kFrameHeight;
+            frame.set(col, row, Color(1.0 - 0.5 * t, 1.0 - 0.3 * t, 1.0) * random_double(0.2, 1.0));
+        }
+    }
+
+    std::vector<unsigned char> bytes(kChecksumBytes);
+    for (unsigned char& byte : bytes) {
+        byte = static_cast<unsigned char>(random_double() * 256.0);
+    }
+    const std::uint32_t expected_crc = reference_crc32(bytes);
+    const std::uint32_t expected_adler = reference_adler32(bytes);
+
+    std::cout << "Detected ISA: " << cpu_features::isa_name(cpu_features::detected_isa()) << "\n";
+    std::cout << "Workloads: " << rays.size() << " rays, " << kRandomCount << " uniforms, "
+              << kFrameWidth << "x" << kFrameHeight << " quantize, "
+              << (kChecksumBytes >> 20) << " MiB checksums\n";
+
+    bool all_match = true;
+    LevelResult baseline;
+    bool have_baseline = false;
+    for (const IsaLevel level : {IsaLevel::Scalar, IsaLevel::Sse42, IsaLevel::Avx2, IsaLevel::Avx512}) {
+        if (level > cpu_features::detected_isa() || (single_level && level != only_level)) {
+            continue;
+        }
+        cpu_features::force_isa(level);
+
+        LevelResult result;
+        result.hit_distances.resize(rays.size());
+        result.intersect_ms = bench::best_time_ms(kRepetitions, [&] {
+            HitCandidate candidate;
+            for (std::size_t index = 0; index < rays.size(); ++index) {
+                const bool hit = scene.intersect(rays[index], kMinDistance, kMaxDistance, candidate);
+                result.hit_distances[index] = hit ? candidate.distance_from_ray : -1.0;
+            }
+        });
+
+        result.randoms.resize(kRandomCount);
+        result.random_ms = bench::best_time_ms(kRepetitions, [&] {
+            XoshiroLanes lanes(42);
+            lanes.fill_uniform(result.randoms.data(), result.randoms.size());
+        });
+
+        result.quantize_ms = bench::best_time_ms(kRepetitions, [&] {
+            result.pixels = quantize_framebuffer(frame, DitherMode::BlueNoise);
+        });
+
+        result.crc_ms = bench::best_time_ms(kRepetitions, [&] {
+            result.crc = checksum::crc32(bytes.data(), bytes.size());
+        });
+        result.adler_ms = bench::best_time_ms(kRepetitions, [&] {
+            result.adler = checksum::adler32(bytes.data(), bytes.size());
+        });
+
+        // Odd lengths and split calls exercise the fold/table hand-over
+        result.short_crc_mix = 0;
+        for (std::size_t length = 0; length < 300; ++length) {
+            const std::uint32_t head = checksum::crc32(bytes.data(), length / 3);
+            result.short_crc_mix ^= checksum::crc32(bytes.data() + length / 3, length - length / 3, head)
+                                    + static_cast<std::uint32_t>(length);
+        }
+
+        std::cout << "\n" << cpu_features::isa_name(level) << ":\n";
+        report("intersect", result.intersect_ms, static_cast<double>(rays.size()), "Mrays/s");
+        report("xoshiro fill", result.random_ms, static_cast<double>(kRandomCount), "M/s");
+        report("quantize (blue noise)", result.quantize_ms, static_cast<double>(frame.pixel_count()), "Mpix/s");
+        report("crc32", result.crc_ms, static_cast<double>(kChecksumBytes), "MB/s");
+        report("adler32", result.adler_ms, static_cast<double>(kChecksumBytes), "MB/s");
+
+        bool match = result.crc == expected_crc && result.adler == expected_adler;
+        if (have_baseline) {
+            match = match
+                && result.hit_distances == baseline.hit_distances
+                && result.randoms == baseline.randoms
+                && result.pixels == baseline.pixels
+                && result.short_crc_mix == baseline.short_crc_mix;
+        } else {
+            baseline = std::move(result);
+            have_baseline = true;
+        }
+        std::cout << "  outputs " << (match ? "match" : "DIFFER from") << " reference\n";
+        all_match = all_match && match;
+    }
+
+    cpu_features::clear_forced_isa();
+    return all_match ? 0 : 1;
+}
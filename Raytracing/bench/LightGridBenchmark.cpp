@@ -0,0 +1,126 @@
+/**
+ * @file LightGridBenchmark.cpp
+ * @brief Light-visibility grid: build cost, coverage and shadow-ray savings.
+ *
+ * On the demo room the benchmark
+ * - builds the grid at several voxel sizes and reports build time and the
+ *   share of (voxel, light) pairs classified visible or occluded,
+ * - times compute_diffuse_lighting over the camera's first diffuse hits with
+ *   and without the grid (occluder cache on in both) and reports how many
+ *   shadow rays the grid removed,
+ * - renders the room both ways and checks the images are identical, since
+ *   the grid only answers where every shadow ray would agree.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "LightVisibilityGrid.h"
+#include "Parallel.h"
+#include "RayStatistics.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 5;
+constexpr int kMaxDepth = 20;
+
+struct SweepResult {
+    double milliseconds;
+    Color sum;
+    RayStatistics statistics;
+};
+
+SweepResult sweep(const Scene& scene, const std::vector<HitRecord>& hits) {
+    SweepResult result{0.0, Color(0.0, 0.0, 0.0), RayStatistics()};
+    result.milliseconds = bench::best_time_ms(kRepetitions, [&] {
+        ray_statistics::reset();
+        result.sum = Color(0.0, 0.0, 0.0);
+        for (const HitRecord& hit : hits) {
+            result.sum += compute_diffuse_lighting(scene, hit);
+        }
+    });
+    result.statistics = ray_statistics::snapshot();
+    return result;
+}
+
+} // namespace
+
+int main() {
+    Scene scene = create_scene();
+    std::cout << "Scene: demo room, " << scene.dispatch_table.primitive_count() << " primitives, "
+              << scene.light_count() << " lights, " << worker_count() << " worker thread(s)\n\n";
+
+    LightVisibilitySettings settings;
+    for (const double cell_size : {0.5, 0.25, 0.125}) {
+        settings.cell_size = cell_size;
+        LightVisibilityGrid grid;
+        const double build_ms = bench::best_time_ms(kRepetitions, [&] {
+            grid.build(scene.dispatch_table, scene.lights, settings);
+        });
+        const double pairs = static_cast<double>(grid.cell_count() * grid.light_count());
+        std::cout << "cell " << std::fixed << std::setprecision(3) << cell_size << ": " << grid.dimensions()[0]
+                  << "x" << grid.dimensions()[1] << "x" << grid.dimensions()[2] << " cells, build "
+                  << std::setprecision(1) << build_ms << " ms, " << 100.0 * grid.count(LightVisibility::Visible) / pairs
+                  << "% visible, " << 100.0 * grid.count(LightVisibility::Occluded) / pairs << "% occluded\n";
+    }
+
+    const RenderConfig sweep_config(16.0 / 9.0, 640, 1);
+    const Camera camera(sweep_config.aspect_ratio);
+    std::vector<HitRecord> diffuse_hits;
+    for (const Ray& ray : bench::make_primary_rays(sweep_config, camera)) {
+        HitRecord hit;
+        if (scene.hit(ray, 0.001, 1'000'000.0, hit) && surface_is_diffuse(hit)) {
+            diffuse_hits.push_back(hit);
+        }
+    }
+
+    const SweepResult without = sweep(scene, diffuse_hits);
+    scene.build_light_visibility();
+    const SweepResult with = sweep(scene, diffuse_hits);
+    const double per_hit = 1e6 / static_cast<double>(diffuse_hits.size());
+    const bool same_lighting = without.sum.x() == with.sum.x() && without.sum.y() == with.sum.y()
+                            && without.sum.z() == with.sum.z();
+    std::cout << "\nfirst diffuse hits of " << sweep_config.image_width << "x" << sweep_config.image_height
+              << " camera rays (" << diffuse_hits.size() << "): " << std::setprecision(1)
+              << without.milliseconds * per_hit << " ns -> " << with.milliseconds * per_hit << " ns per hit ("
+              << std::setprecision(2) << without.milliseconds / with.milliseconds << "x)\n"
+              << "  shadow rays traced " << without.statistics.shadow_rays << " -> " << with.statistics.shadow_rays
+              << " (skipped " << with.statistics.light_grid_visible << " visible, "
+              << with.statistics.light_grid_occluded << " occluded), "
+              << (same_lighting ? "lighting identical" : "LIGHTING DIFFERS") << "\n";
+
+    // Full renders with equal seeds; identical images show the grid is exact
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.caustics.enabled = false;
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<std::vector<float>> images;
+    std::vector<double> times;
+    for (const bool use_grid : {false, true}) {
+        if (use_grid) {
+            scene.build_light_visibility();
+        } else {
+            scene.light_visibility.reset();
+        }
+        times.push_back(bench::best_time_ms(1, [&] {
+            seed_thread_uniforms(1);
+            images.push_back(render_framebuffer(config, camera, scene, kMaxDepth).pixels);
+        }));
+    }
+    std::cerr.rdbuf(previous);
+    const bool identical = images[0] == images[1];
+    std::cout << "\nrender 160x90, 16 spp: " << std::setprecision(0) << times[0] << " ms without, " << times[1]
+              << " ms with the grid (" << std::setprecision(2) << times[0] / times[1] << "x), images "
+              << (identical ? "identical" : "DIFFER") << "\n";
+    return identical && same_lighting ? 0 : 1;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file MathBenchmark.cpp
+ * @brief Accuracy, throughput and image impact of the FastMath.h kernels.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "FastMath.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kCount = 1 << 21;
+constexpr double kPi = 3.14159265358979323846;
+constexpr int kRepetitions = 5;
+
+struct ErrorStats {
+    double max_abs = 0.0;
+    double max_rel = 0.0;
+
+    void add(double approx, double exact) {
+        const double abs_error = std::fabs(approx - exact);
+        max_abs = std::max(max_abs, abs_error);
+        if (exact != 0.0) {
+            max_rel = std::max(max_rel, abs_error / std::fabs(exact));
+        }
+    }
+};
+
+std::vector<double> linspace(double lo, double hi, std::size_t count) {
+    std::vector<double> values(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        values[i] = lo + (hi - lo) * (static_cast<double>(i) + 0.5) / static_cast<double>(count);
+    }
+    return values;
+}
+
+void report_error(const char* label, const ErrorStats& stats) {
+    std::cout << std::left << std::setw(30) << label << std::right << std::scientific << std::setprecision(2)
+              << "  max abs " << stats.max_abs << "  max rel " << stats.max_rel << "\n";
+}
+
+void report_speed(const char* label, double precise_ms, double fast_ms) {
+    std::cout << std::left << std::setw(30) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(9) << precise_ms * 1e6 / kCount << " ns  ->"
+              << std::setw(7) << fast_ms * 1e6 / kCount << " ns  (x"
+              << std::setprecision(1) << precise_ms / fast_ms << ")\n";
+}
+
+std::vector<unsigned char> render_with(unsigned kernels, const Scene& scene) {
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.fast_math_kernels = kernels;
+    const Camera camera(config.aspect_ratio);
+    return render_image(config, camera, scene, 8);
+}
+
+void report_image(const char* label, const std::vector<unsigned char>& reference,
+                  const std::vector<unsigned char>& image) {
+    double squared_sum = 0.0;
+    double absolute_sum = 0.0;
+    int max_difference = 0;
+    std::size_t changed = 0;
+    for (std::size_t i = 0; i < reference.size(); ++i) {
+        const int difference = std::abs(static_cast<int>(reference[i]) - static_cast<int>(image[i]));
+        absolute_sum += difference;
+        squared_sum += static_cast<double>(difference) * difference;
+        max_difference = std::max(max_difference, difference);
+        changed += difference != 0 ? 1 : 0;
+    }
+    const double mse = squared_sum / static_cast<double>(reference.size());
+    std::cout << std::left << std::setw(30) << label << std::right << std::fixed << std::setprecision(3)
+              << "  mean |d| " << absolute_sum / static_cast<double>(reference.size())
+              << "  max |d| " << max_difference
+              << "  changed " << std::setprecision(2)
+              << 100.0 * static_cast<double>(changed) / static_cast<double>(reference.size()) << "%"
+              << "  PSNR ";
+    if (mse == 0.0) {
+        std::cout << "inf\n";
+    } else {
+        std::cout << std::setprecision(1) << 10.0 * std::log10(255.0 * 255.0 / mse) << " dB\n";
+    }
+}
+
+} // namespace
+
+int main() {
+    // ---------- Accuracy ----------
+    std::cout << "== Accuracy ==\n";
+    {
+        ErrorStats sine_stats;
+        ErrorStats cosine_stats;
+        for (double x : linspace(-2.0 * kPi, 2.0 * kPi, kCount)) {
+            double s, c;
+            fast_math::sincos(x, s, c);
+            sine_stats.add(s, std::sin(x));
+            cosine_stats.add(c, std::cos(x));
+        }
+        report_error("sin, |x| <= 2pi", sine_stats);
+        report_error("cos, |x| <= 2pi", cosine_stats);
+
+        ErrorStats wide_stats;
+        for (double x : linspace(-1000.0, 1000.0, kCount)) {
+            double s, c;
+            fast_math::sincos(x, s, c);
+            wide_stats.add(s, std::sin(x));
+            wide_stats.add(c, std::cos(x));
+        }
+        report_error("sincos, |x| <= 1000", wide_stats);
+
+        ErrorStats pow_stats;
+        for (double x : linspace(0.0, 1.0, kCount)) {
+            pow_stats.add(fast_math::pow5(x), std::pow(x, 5));
+        }
+        report_error("pow5, [0, 1]", pow_stats);
+
+        ErrorStats rsqrt1, rsqrt2, rsqrt3, rsqrt4, sqrt_stats;
+        for (double exponent : linspace(-12.0, 12.0, kCount)) {
+            const double x = std::pow(10.0, exponent);
+            const double exact = 1.0 / std::sqrt(x);
+            rsqrt1.add(fast_math::rsqrt<1>(x), exact);
+            rsqrt2.add(fast_math::rsqrt<2>(x), exact);
+            rsqrt3.add(fast_math::rsqrt<3>(x), exact);
+            rsqrt4.add(fast_math::rsqrt<4>(x), exact);
+            sqrt_stats.add(fast_math::sqrt(x), std::sqrt(x));
+        }
+        report_error("rsqrt<1>, [1e-12, 1e12]", rsqrt1);
+        report_error("rsqrt<2>, [1e-12, 1e12]", rsqrt2);
+        report_error("rsqrt<3>, [1e-12, 1e12]", rsqrt3);
+        report_error("rsqrt<4>, [1e-12, 1e12]", rsqrt4);
+        report_error("sqrt, [1e-12, 1e12]", sqrt_stats);
+
+        ErrorStats gamma_stats;
+        std::size_t byte_changes = 0;
+        const std::vector<double> linear = linspace(0.0, 1.0, kCount);
+        for (double x : linear) {
+            const double fast = fast_math::gamma_encode(x);
+            const double exact = std::sqrt(x);
+            gamma_stats.add(fast, exact);
+            const auto fast_byte = static_cast<int>(std::clamp(fast, 0.0, 0.999) * 256.0);
+            const auto exact_byte = static_cast<int>(std::clamp(exact, 0.0, 0.999) * 256.0);
+            byte_changes += fast_byte != exact_byte ? 1 : 0;
+        }
+        report_error("gamma_encode, [0, 1]", gamma_stats);
+        std::cout << "  gamma_encode 8-bit outputs changed: " << byte_changes << " of " << kCount << "\n";
+    }
+
+    // ---------- Throughput ----------
+    std::cout << "\n== Throughput (per element, precise -> fast) ==\n";
+    {
+        const std::vector<double> angles = linspace(0.0, 2.0 * kPi, kCount);
+        const std::vector<double> unit = linspace(0.0, 1.0, kCount);
+        std::vector<double> out_a(kCount);
+        std::vector<double> out_b(kCount);
+
+        const double sincos_precise = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = std::sin(angles[i]);
+                out_b[i] = std::cos(angles[i]);
+            }
+        });
+        const double sincos_fast = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                fast_math::sincos(angles[i], out_a[i], out_b[i]);
+            }
+        });
+        report_speed("sincos", sincos_precise, sincos_fast);
+
+        const double pow_precise = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = std::pow(unit[i], 5);
+            }
+        });
+        const double pow_fast = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = fast_math::pow5(unit[i]);
+            }
+        });
+        report_speed("pow5", pow_precise, pow_fast);
+
+        const double rsqrt_precise = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = 1.0 / std::sqrt(unit[i]);
+            }
+        });
+        const double rsqrt_fast = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = fast_math::rsqrt<3>(unit[i]);
+            }
+        });
+        report_speed("rsqrt<3>", rsqrt_precise, rsqrt_fast);
+
+        const double sqrt_precise = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = std::sqrt(unit[i]);
+            }
+        });
+        const double sqrt_fast = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = fast_math::sqrt(unit[i]);
+            }
+        });
+        report_speed("sqrt", sqrt_precise, sqrt_fast);
+
+        const double gamma_fast = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t i = 0; i < kCount; ++i) {
+                out_a[i] = fast_math::gamma_encode(unit[i]);
+            }
+        });
+        report_speed("gamma_encode (vs sqrt)", sqrt_precise, gamma_fast);
+        std::cout << "  (sink " << out_a[kCount / 3] + out_b[kCount / 3] << ")\n";
+    }
+
+    // ---------- Image impact ----------
+    std::cout << "\n== Image difference vs precise (160x90, 16 spp, depth 8, same seed) ==\n";
+    {
+        const Scene scene = create_scene();
+        const std::vector<unsigned char> reference = render_with(fast_math::kPrecise, scene);
+        report_image("sincos only", reference, render_with(fast_math::SinCos, scene));
+        report_image("sqrt only", reference, render_with(fast_math::Sqrt, scene));
+        report_image("gamma only", reference, render_with(fast_math::Gamma, scene));
+        report_image("all fast kernels", reference, render_with(fast_math::kFast, scene));
+        report_image("precise, other seed (noise)", reference, [&] {
+            RenderConfig config(16.0 / 9.0, 160, 16);
+            config.fast_math_kernels = fast_math::kPrecise;
+            config.sample_seed = 54321;
+            return render_image(config, Camera(config.aspect_ratio), scene, 8);
+        }());
+    }
+    return 0;
+}
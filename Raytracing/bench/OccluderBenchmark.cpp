@@ -0,0 +1,121 @@
+/**
+ * @file OccluderBenchmark.cpp
+ * @brief Shadow occluder cache: hit rate and direct-lighting speedup.
+ *
+ * On the demo room the benchmark
+ * - collects the camera's first hits on diffuse surfaces in scanline order
+ *   (the order the renderer shades them) and times compute_diffuse_lighting
+ *   over them with and without the occluder cache, overall and for hits
+ *   shadowed from at least one light,
+ * - renders the room both ways and checks the images are identical, since
+ *   the cache only changes which primitive proves a shadow ray blocked.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "OccluderCache.h"
+#include "RayStatistics.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 5;
+constexpr int kMaxDepth = 20;
+
+struct SweepResult {
+    double milliseconds;
+    Color sum;
+    RayStatistics statistics;
+};
+
+SweepResult sweep(const Scene& scene, const std::vector<HitRecord>& hits, bool use_cache) {
+    occluder_cache::set_enabled(use_cache);
+    SweepResult result{0.0, Color(0.0, 0.0, 0.0), RayStatistics()};
+    result.milliseconds = bench::best_time_ms(kRepetitions, [&] {
+        ray_statistics::reset();
+        result.sum = Color(0.0, 0.0, 0.0);
+        for (const HitRecord& hit : hits) {
+            result.sum += compute_diffuse_lighting(scene, hit);
+        }
+    });
+    result.statistics = ray_statistics::snapshot();
+    return result;
+}
+
+void print_sweep(const char* label, std::size_t count, const SweepResult& off, const SweepResult& on) {
+    const double per_hit = 1e6 / static_cast<double>(count);
+    std::cout << label << " (" << count << " hits): " << std::fixed << std::setprecision(1)
+              << off.milliseconds * per_hit << " ns -> " << on.milliseconds * per_hit << " ns per hit ("
+              << std::setprecision(2) << off.milliseconds / on.milliseconds << "x), cache hit rate "
+              << std::setprecision(1) << 100.0 * on.statistics.occluder_cache_hit_rate() << "% of "
+              << on.statistics.occluder_cache_tests << " tests, "
+              << (off.sum.x() == on.sum.x() && off.sum.y() == on.sum.y() && off.sum.z() == on.sum.z()
+                      ? "lighting identical" : "LIGHTING DIFFERS")
+              << "\n";
+}
+
+} // namespace
+
+int main() {
+    const Scene scene = create_scene();
+    const RenderConfig sweep_config(16.0 / 9.0, 640, 1);
+    const Camera camera(sweep_config.aspect_ratio);
+
+    std::vector<HitRecord> diffuse_hits;
+    std::vector<HitRecord> shadowed_hits;
+    for (const Ray& ray : bench::make_primary_rays(sweep_config, camera)) {
+        HitRecord hit;
+        if (!scene.hit(ray, 0.001, 1'000'000.0, hit) || !surface_is_diffuse(hit)) {
+            continue;
+        }
+        diffuse_hits.push_back(hit);
+    }
+    occluder_cache::set_enabled(false);
+    for (const HitRecord& hit : diffuse_hits) {
+        ray_statistics::reset();
+        compute_diffuse_lighting(scene, hit);
+        if (ray_statistics::snapshot().shadow_rays_occluded > 0) {
+            shadowed_hits.push_back(hit);
+        }
+    }
+
+    std::cout << "Scene: demo room, " << scene.object_count() << " objects ("
+              << scene.dispatch_table.primitive_count() << " primitives), " << scene.light_count()
+              << " lights; first diffuse hits of " << sweep_config.image_width << "x"
+              << sweep_config.image_height << " camera rays\n\n";
+
+    print_sweep("all diffuse hits", diffuse_hits.size(), sweep(scene, diffuse_hits, false),
+                sweep(scene, diffuse_hits, true));
+    print_sweep("shadowed hits   ", shadowed_hits.size(), sweep(scene, shadowed_hits, false),
+                sweep(scene, shadowed_hits, true));
+
+    // Full renders: same seed, so identical images prove the cache is exact
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.caustics.enabled = false;
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<std::vector<float>> images;
+    std::vector<double> times;
+    for (const bool use_cache : {false, true}) {
+        config.occluder_cache = use_cache;
+        times.push_back(bench::best_time_ms(1, [&] {
+            seed_thread_uniforms(1);
+            images.push_back(render_framebuffer(config, camera, scene, kMaxDepth).pixels);
+        }));
+    }
+    std::cerr.rdbuf(previous);
+    const bool identical = images[0] == images[1];
+    std::cout << "\nrender 160x90, 16 spp: " << std::setprecision(0) << times[0] << " ms without, " << times[1]
+              << " ms with the cache (" << std::setprecision(2) << times[0] / times[1] << "x), images "
+              << (identical ? "identical" : "DIFFER") << "\n";
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file PagedBenchmark.cpp
+ * @brief Paged BVH vs the in-memory BVH under shrinking page budgets.
+ *
+ * Writes the paged BVH of a large furnished room (see bench::furnished_room)
+ * to a temporary file, then for page-cache budgets from the whole file down
+ * to a tenth of it traces incoherent room rays
+ * - one at a time through PagedBvh::intersect(), which loads pages on the
+ *   spot, and
+ * - in batches through PagedBvh::intersect_batch(), which queues rays on
+ *   pages that are not resident and loads each queued page once per batch,
+ * and reports time per ray, page cache hits, misses and evictions, the peak
+ * of mapped bytes and deferred page visits. Every result is checked against
+ * the in-memory quantized WideBvh. Finally it renders the demo room through
+ * a paged BVH whose cache holds about two pages and checks the image matches
+ * the linear scan.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "PagedBvh.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "WideBvh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kScale = 64;
+constexpr int kMaxDepth = 20;
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+constexpr std::size_t kRays = 100'000;
+constexpr std::size_t kBatch = 16'384;
+constexpr std::size_t kPagePrimitives = 4096;
+
+std::size_t mismatches(const std::vector<HitCandidate>& reference, const std::vector<HitCandidate>& candidates) {
+    std::size_t count = 0;
+    for (std::size_t index = 0; index < reference.size(); ++index) {
+        const HitCandidate& a = reference[index];
+        const HitCandidate& b = candidates[index];
+        if (a.primitive != b.primitive
+            || (a.primitive != nullptr
+                && (a.primitive_index != b.primitive_index || a.distance_from_ray != b.distance_from_ray))) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void report(const char* label, double ns_per_ray, const PagedBvh& bvh, std::size_t differing) {
+    const PageCacheStats stats = bvh.cache_stats();
+    std::cout << "    " << label << ": " << std::fixed << std::setprecision(0) << ns_per_ray << " ns per ray, "
+              << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions, peak "
+              << std::setprecision(1) << static_cast<double>(stats.peak_bytes) / 1048576.0 << " MiB mapped, "
+              << bvh.deferred_visits() << " deferred visits, " << differing << " mismatches\n";
+}
+
+} // namespace
+
+int main() {
+    const std::string path = (std::filesystem::temp_directory_path() / "raytracer_bench_paged.pbvh").string();
+    std::size_t total_mismatches = 0;
+
+    {
+        const Scene scene = bench::furnished_room(kScale);
+        const std::vector<Ray> rays = bench::make_room_rays(scene.layout, kRays);
+        WideBvh in_memory;
+        in_memory.build(scene.dispatch_table);
+        std::vector<HitCandidate> reference(rays.size());
+        const double memory_ns = 1e6 / static_cast<double>(rays.size()) * bench::best_time_ms(3, [&] {
+            for (std::size_t index = 0; index < rays.size(); ++index) {
+                reference[index] = HitCandidate();
+                in_memory.intersect(scene.dispatch_table, rays[index], kMinDistance, kMaxDistance, reference[index]);
+            }
+        });
+
+        const double write_ms = bench::best_time_ms(1, [&] {
+            PagedBvh::write(scene.dispatch_table, path, kPagePrimitives);
+        });
+        PagedBvh paged;
+        if (!paged.open(scene.dispatch_table, path, 0)) {
+            std::cerr << "Cannot write or open " << path << "\n";
+            return 1;
+        }
+        const std::size_t file_bytes = static_cast<std::size_t>(paged.file_bytes());
+        std::cout << "Room x" << kScale << ": " << scene.dispatch_table.primitive_count() << " primitives, "
+                  << paged.page_count() << " pages of up to " << kPagePrimitives << ", " << std::fixed
+                  << std::setprecision(1) << static_cast<double>(file_bytes) / 1048576.0 << " MiB written in "
+                  << write_ms << " ms\n"
+                  << "  in-memory quantized BVH: " << std::setprecision(0) << memory_ns << " ns per ray\n";
+
+        std::vector<HitCandidate> candidates(rays.size());
+        for (const double share : {1.0, 0.5, 0.25, 0.1}) {
+            const std::size_t budget = static_cast<std::size_t>(share * static_cast<double>(file_bytes));
+            std::cout << "  budget " << std::setprecision(0) << 100.0 * share << "% ("
+                      << std::setprecision(1) << static_cast<double>(budget) / 1048576.0 << " MiB)\n";
+
+            paged.open(scene.dispatch_table, path, budget);
+            const double single_ns = 1e6 / static_cast<double>(rays.size()) * bench::best_time_ms(1, [&] {
+                for (std::size_t index = 0; index < rays.size(); ++index) {
+                    candidates[index] = HitCandidate();
+                    paged.intersect(scene.dispatch_table, rays[index], kMinDistance, kMaxDistance,
+                                    candidates[index]);
+                }
+            });
+            std::size_t differing = mismatches(reference, candidates);
+            total_mismatches += differing;
+            report("one at a time", single_ns, paged, differing);
+
+            paged.open(scene.dispatch_table, path, budget);
+            const double batch_ns = 1e6 / static_cast<double>(rays.size()) * bench::best_time_ms(1, [&] {
+                for (std::size_t first = 0; first < rays.size(); first += kBatch) {
+                    const std::size_t count = std::min(kBatch, rays.size() - first);
+                    paged.intersect_batch(scene.dispatch_table, rays.data() + first, count, kMinDistance,
+                                          kMaxDistance, candidates.data() + first);
+                }
+            });
+            differing = mismatches(reference, candidates);
+            total_mismatches += differing;
+            report("batches of 16k", batch_ns, paged, differing);
+        }
+    }
+
+    // Full renders: same seed, so identical images prove the paged BVH is exact
+    Scene scene = create_scene();
+    const Camera camera(16.0 / 9.0);
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.caustics.enabled = false;
+    config.paged_bvh.path = path;
+    config.paged_bvh.page_primitives = 8;
+    config.paged_bvh.cache_bytes = 3000;  // About two pages
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<std::vector<float>> images;
+    std::shared_ptr<const PagedBvh> paged;
+    for (const bool use_paged : {false, true}) {
+        if (use_paged) {
+            paged = scene.build_paged_bvh(config.paged_bvh);
+        }
+        seed_thread_uniforms(1);
+        images.push_back(render_framebuffer(config, camera, scene, kMaxDepth).pixels);
+    }
+    std::cerr.rdbuf(previous);
+    std::remove(path.c_str());
+    if (!paged) {
+        std::cerr << "Cannot write or open " << path << "\n";
+        return 1;
+    }
+    const bool identical = images[0] == images[1];
+    const PageCacheStats stats = paged->cache_stats();
+    std::cout << "\nrender 160x90, 16 spp through " << paged->page_count() << " pages ("
+              << paged->file_bytes() << " bytes) with a " << config.paged_bvh.cache_bytes << "-byte cache: "
+              << stats.misses << " page loads, " << stats.evictions << " evictions, peak " << stats.peak_bytes
+              << " bytes mapped, images " << (identical ? "identical" : "DIFFER") << "\n";
+    return identical && total_mismatches == 0 ? 0 : 1;
+}
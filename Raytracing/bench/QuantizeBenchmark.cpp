@@ -0,0 +1,91 @@
+/**
+ * @file QuantizeBenchmark.cpp
+ * @brief 8K framebuffer quantization: legacy write_color vs the LUT stage.
+ */
+
+#include "BenchUtils.h"
+#include "Color.h"
+#include "FastMath.h"
+#include "Framebuffer.h"
+#include "Parallel.h"
+#include "Quantize.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+constexpr int kWidth = 7680;
+constexpr int kHeight = 4320;
+constexpr int kRepetitions = 3;
+
+void report(const char* label, double milliseconds, std::size_t pixels) {
+    std::cout << std::left << std::setw(34) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << milliseconds << " ms"
+              << std::setw(9) << static_cast<double>(pixels) / (milliseconds * 1e3) << " Mpix/s\n";
+}
+
+} // namespace
+
+int main() {
+    // Sky-like vertical gradient plus a little per-pixel variation
+    Framebuffer framebuffer(kWidth, kHeight);
+    for (int row = 0; row < kHeight; ++row) {
+        const double blend = static_cast<double>(row) / (kHeight - 1);
+        for (int col = 0; col < kWidth; ++col) {
+            const double jitter = 0.002 * random_double();
+            framebuffer.set(col, row, Color(0.25 + 0.5 * blend + jitter,
+                                            0.49 + 0.3 * blend + jitter,
+                                            1.0 - 0.2 * blend + jitter));
+        }
+    }
+    const std::size_t pixels = framebuffer.pixel_count();
+    std::cout << "Frame: " << kWidth << "x" << kHeight << ", " << worker_count() << " worker thread(s)\n\n";
+
+    std::vector<unsigned char> legacy;
+    report("legacy write_color (push_back)", bench::best_time_ms(kRepetitions, [&] {
+        legacy.clear();
+        legacy.reserve(pixels * 3);
+        for (std::size_t i = 0; i < pixels; ++i) {
+            const float* pixel = framebuffer.pixels.data() + i * 3;
+            write_color(legacy, Color(pixel[0], pixel[1], pixel[2]));
+        }
+    }), pixels);
+
+    std::vector<unsigned char> quantized;
+    fast_math::set_enabled_kernels(fast_math::kPrecise);
+    report("stage, LUT, no dither", bench::best_time_ms(kRepetitions, [&] {
+        quantized = quantize_framebuffer(framebuffer, DitherMode::None);
+    }), pixels);
+
+    std::size_t mismatches = 0;
+    int max_difference = 0;
+    for (std::size_t i = 0; i < legacy.size(); ++i) {
+        const int difference = std::abs(static_cast<int>(legacy[i]) - static_cast<int>(quantized[i]));
+        mismatches += difference != 0 ? 1 : 0;
+        max_difference = std::max(max_difference, difference);
+    }
+
+    report("stage, LUT, ordered dither", bench::best_time_ms(kRepetitions, [&] {
+        quantized = quantize_framebuffer(framebuffer, DitherMode::Ordered);
+    }), pixels);
+    report("stage, LUT, blue-noise dither", bench::best_time_ms(kRepetitions, [&] {
+        quantized = quantize_framebuffer(framebuffer, DitherMode::BlueNoise);
+    }), pixels);
+
+    fast_math::set_enabled_kernels(fast_math::Gamma);
+    report("stage, fast gamma, no dither", bench::best_time_ms(kRepetitions, [&] {
+        quantized = quantize_framebuffer(framebuffer, DitherMode::None);
+    }), pixels);
+    report("stage, fast gamma, blue noise", bench::best_time_ms(kRepetitions, [&] {
+        quantized = quantize_framebuffer(framebuffer, DitherMode::BlueNoise);
+    }), pixels);
+
+    std::cout << "\nLUT vs legacy: " << mismatches << " of " << legacy.size()
+              << " channel values differ, max difference " << max_difference << "\n";
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**
+ * @file RasterBenchmark.cpp
+ * @brief Rasterized first-hit visibility against ray-traced camera rays.
+ *
+ * For several resolutions on the demo room the benchmark
+ * - builds the visibility buffer and traces the very same subsample rays
+ *   through the full primitive table and through the tile-culled lists,
+ * - reports the time of each and checks that every buffer entry names the
+ *   primitive and depth the full scan returns,
+ * - renders the room with traced and with rasterized first hits and
+ *   compares time and mean image luminance (sample positions differ, so
+ *   only the means must agree).
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Parallel.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "TileCulling.h"
+#include "VisibilityBuffer.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 3;
+constexpr int kSubsamples = 4;
+constexpr int kMaxDepth = 20;
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+
+double mean_luminance(const Framebuffer& framebuffer) {
+    double sum = 0.0;
+    for (std::size_t index = 0; index < framebuffer.pixel_count(); ++index) {
+        const float* pixel = framebuffer.pixels.data() + index * 3;
+        sum += 0.2126 * pixel[0] + 0.7152 * pixel[1] + 0.0722 * pixel[2];
+    }
+    return sum / static_cast<double>(framebuffer.pixel_count());
+}
+
+} // namespace
+
+int main() {
+    const Scene scene = create_scene();
+    const PrimitiveTable& table = scene.dispatch_table;
+    std::cout << "Scene: demo room, " << table.primitive_count() << " primitives, " << kSubsamples
+              << " subsamples per pixel, " << worker_count() << " worker thread(s)\n\n";
+
+    int exit_code = 0;
+    for (const int width : {400, 1600}) {
+        const RenderConfig config(16.0 / 9.0, width, kSubsamples);
+        const Camera camera(config.aspect_ratio);
+        const int height = config.image_height;
+        const double per_sample = 1e6 / (static_cast<double>(width) * height * kSubsamples);
+
+        VisibilityBuffer buffer;
+        const double raster_ms = bench::best_time_ms(kRepetitions, [&] {
+            buffer.build(table, camera, width, height, kSubsamples, kMinDistance, kMaxDistance);
+        });
+
+        std::vector<HitCandidate> traced(static_cast<std::size_t>(width) * height * kSubsamples);
+        std::vector<char> traced_hit(traced.size());
+        const double full_ms = bench::best_time_ms(kRepetitions, [&] {
+            std::size_t slot = 0;
+            for (int row = 0; row < height; ++row) {
+                for (int col = 0; col < width; ++col) {
+                    for (int subsample = 0; subsample < kSubsamples; ++subsample, ++slot) {
+                        traced_hit[slot] = table.intersect(buffer.camera_ray(col, row, subsample), kMinDistance,
+                                                           kMaxDistance, traced[slot]);
+                    }
+                }
+            }
+        });
+
+        TileCulling culling;
+        culling.build(table, camera, width, height, 16);
+        const double culled_ms = bench::best_time_ms(kRepetitions, [&] {
+            for (int row = 0; row < height; ++row) {
+                for (int col = 0; col < width; ++col) {
+                    const PrimitiveSubset visible = culling.tile_primitives(col, row);
+                    for (int subsample = 0; subsample < kSubsamples; ++subsample) {
+                        HitCandidate candidate;
+                        table.intersect_subset(visible.indices, visible.count, buffer.camera_ray(col, row, subsample),
+                                               kMinDistance, kMaxDistance, candidate);
+                    }
+                }
+            }
+        });
+
+        std::size_t mismatches = 0;
+        std::size_t slot = 0;
+        for (int row = 0; row < height; ++row) {
+            for (int col = 0; col < width; ++col) {
+                for (int subsample = 0; subsample < kSubsamples; ++subsample, ++slot) {
+                    const VisibilitySample& entry = buffer.at(col, row, subsample);
+                    const bool same = traced_hit[slot]
+                        ? entry.primitive == traced[slot].primitive_index && entry.depth == traced[slot].distance_from_ray
+                        : entry.primitive == VisibilityBuffer::kNoPrimitive;
+                    mismatches += same ? 0 : 1;
+                }
+            }
+        }
+        exit_code |= mismatches == 0 ? 0 : 1;
+
+        std::cout << width << "x" << height << ": rasterized " << std::fixed << std::setprecision(1)
+                  << raster_ms * per_sample << " ns per subsample ("
+                  << static_cast<double>(buffer.fragment_count()) / (static_cast<double>(width) * height * kSubsamples)
+                  << " fragments each), traced " << full_ms * per_sample << " ns full table / "
+                  << culled_ms * per_sample << " ns tile-culled; " << mismatches << " of " << traced.size()
+                  << " entries differ from the full scan\n";
+    }
+
+    RenderConfig config(16.0 / 9.0, 160, 64);
+    config.caustics.enabled = false;
+    const Camera camera(config.aspect_ratio);
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<double> means;
+    std::vector<double> times;
+    for (const bool raster : {false, true}) {
+        config.raster_primary.enabled = raster;
+        times.push_back(bench::best_time_ms(1, [&] {
+            seed_thread_uniforms(1);
+            means.push_back(mean_luminance(render_framebuffer(config, camera, scene, kMaxDepth)));
+        }));
+    }
+    std::cerr.rdbuf(previous);
+    std::cout << "\nrender 160x90, 64 spp: traced " << std::setprecision(0) << times[0] << " ms, mean "
+              << std::setprecision(4) << means[0] << "; rasterized " << std::setprecision(0) << times[1]
+              << " ms, mean " << std::setprecision(4) << means[1] << "\n";
+    return exit_code;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file SamplingBenchmark.cpp
+ * @brief Scalar mt19937 / rejection sampling vs batched xoshiro lanes and warps.
+ */
+
+#include "BenchUtils.h"
+#include "Random.h"
+#include "SampleWarps.h"
+
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t kCount = 1 << 22;
+constexpr int kRepetitions = 5;
+
+void report(const char* label, double milliseconds) {
+    std::cout << std::left << std::setw(36) << label
+              << std::right << std::setw(9) << std::fixed << std::setprecision(2) << milliseconds << " ms"
+              << std::setw(9) << std::setprecision(2) << (milliseconds * 1e6 / static_cast<double>(kCount))
+              << " ns/sample\n";
+}
+
+} // namespace
+
+int main() {
+    std::vector<double> u1(kCount);
+    std::vector<double> u2(kCount);
+    std::vector<double> u3(kCount);
+    std::vector<double> x(kCount);
+    std::vector<double> y(kCount);
+    std::vector<double> z(kCount);
+    double sink = 0.0;
+
+    std::mt19937 reference_generator;
+    std::uniform_real_distribution<double> reference_distribution(0.0, 1.0);
+    report("uniform: mt19937 one at a time", bench::best_time_ms(kRepetitions, [&] {
+        for (std::size_t i = 0; i < kCount; ++i) {
+            u1[i] = reference_distribution(reference_generator);
+        }
+    }));
+
+    UniformBuffer buffer(1);
+    report("uniform: buffered next()", bench::best_time_ms(kRepetitions, [&] {
+        for (std::size_t i = 0; i < kCount; ++i) {
+            u1[i] = buffer.next();
+        }
+    }));
+
+    XoshiroLanes lanes(2);
+    report("uniform: xoshiro lanes fill", bench::best_time_ms(kRepetitions, [&] {
+        lanes.fill_uniform(u1.data(), kCount);
+        lanes.fill_uniform(u2.data(), kCount);
+        lanes.fill_uniform(u3.data(), kCount);
+    }) / 3.0);
+
+    report("ball: rejection loop", bench::best_time_ms(kRepetitions, [&] {
+        std::size_t cursor = 0;
+        for (std::size_t i = 0; i < kCount; ++i) {
+            double px, py, pz;
+            do {
+                px = 2.0 * u1[cursor % kCount] - 1.0;
+                py = 2.0 * u2[cursor % kCount] - 1.0;
+                pz = 2.0 * u3[cursor % kCount] - 1.0;
+                ++cursor;
+            } while (px * px + py * py + pz * pz >= 1.0);
+            x[i] = px;
+            y[i] = py;
+            z[i] = pz;
+        }
+    }));
+    sink += x[kCount / 2];
+
+    report("ball: batched warp", bench::best_time_ms(kRepetitions, [&] {
+        sample_warps::uniform_ball(u1.data(), u2.data(), u3.data(), x.data(), y.data(), z.data(), kCount);
+    }));
+    sink += x[kCount / 2];
+
+    report("cosine: polar map, scalar", bench::best_time_ms(kRepetitions, [&] {
+        for (std::size_t i = 0; i < kCount; ++i) {
+            const double r = std::sqrt(u1[i]);
+            const double theta = 2.0 * sample_warps::kPi * u2[i];
+            x[i] = r * std::cos(theta);
+            y[i] = r * std::sin(theta);
+            z[i] = std::sqrt(1.0 - r * r);
+        }
+    }));
+    sink += z[kCount / 2];
+
+    report("cosine: batched concentric warp", bench::best_time_ms(kRepetitions, [&] {
+        sample_warps::cosine_hemisphere(u1.data(), u2.data(), x.data(), y.data(), z.data(), kCount);
+    }));
+    sink += z[kCount / 2];
+
+    report("disk: batched concentric warp", bench::best_time_ms(kRepetitions, [&] {
+        sample_warps::concentric_disk(u1.data(), u2.data(), x.data(), y.data(), kCount);
+    }));
+    sink += x[kCount / 2];
+
+    // Sanity check: cosine-weighted mean of z is 2/3
+    double mean_z = 0.0;
+    sample_warps::cosine_hemisphere(u1.data(), u2.data(), x.data(), y.data(), z.data(), kCount);
+    for (std::size_t i = 0; i < kCount; ++i) {
+        mean_z += z[i];
+    }
+    mean_z /= static_cast<double>(kCount);
+    std::cout << "\nCosine hemisphere mean z: " << mean_z << " (expected 0.6667)\n";
+    std::cout << "Sink: " << sink << "\n";
+    return 0;
+}
@@ -0,0 +1,163 @@
+/**
+ * @file SchedulerBenchmark.cpp
+ * @brief Concurrent jobs on one RenderEngine under the TileScheduler.
+ *
+ * - Fair share: two equal batch jobs with weights 1 and 3 submitted
+ *   together; the worker time each has received when the first one ends.
+ * - Preemption: a small job submitted while a large batch job is rendering,
+ *   once as a preview and once as a batch job of equal weight, with a
+ *   deadline of 1.5 times its time alone; its queueing latency, time to
+ *   completion and whether it met the deadline. A first-come-first-served
+ *   queue would have made it wait for the rest of the large job.
+ * - Deadlines: four previews submitted latest deadline first behind a batch
+ *   job; the order in which they complete.
+ */
+
+#include "Camera.h"
+#include "RenderConfig.h"
+#include "RenderEngine.h"
+#include "Scene.h"
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kMaxDepth = 20;
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+RenderJob make_job(const std::shared_ptr<const Scene>& scene, int width, int samples, JobPriority priority) {
+    RenderJob job;
+    job.scene = scene;
+    job.config = RenderConfig(16.0 / 9.0, width, samples);
+    job.camera = Camera(job.config.aspect_ratio);
+    job.max_depth = kMaxDepth;
+    job.schedule.priority = priority;
+    return job;
+}
+
+void wait_for_tiles(const RenderHandle& handle, std::size_t tiles) {
+    while (handle.progress().tiles_done < tiles && handle.progress().status != RenderStatus::Completed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void fair_share(RenderEngine& engine, const std::shared_ptr<const Scene>& scene) {
+    RenderJob light = make_job(scene, 320, 8, JobPriority::Batch);
+    RenderJob heavy = light;
+    heavy.schedule.weight = 3.0;
+    const std::shared_ptr<RenderHandle> first = engine.submit(light);
+    const std::shared_ptr<RenderHandle> second = engine.submit(heavy);
+    while (first->progress().status != RenderStatus::Completed
+           && second->progress().status != RenderStatus::Completed) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const RenderProgress a = first->progress();
+    const RenderProgress b = second->progress();
+    std::cout << "Fair share, two 320x180, 8 spp batch jobs, weights 1 and 3, when the first ends:\n"
+              << "  weight 1: " << std::fixed << std::setprecision(0) << a.worker_ms << " worker ms, "
+              << a.tiles_done << "/" << a.tile_count << " tiles\n"
+              << "  weight 3: " << b.worker_ms << " worker ms, " << b.tiles_done << "/" << b.tile_count
+              << " tiles\n"
+              << "  share ratio " << std::setprecision(2) << (a.worker_ms > 0.0 ? b.worker_ms / a.worker_ms : 0.0)
+              << " (3 expected)\n";
+    first->wait();
+    second->wait();
+}
+
+bool preemption(RenderEngine& engine, const std::shared_ptr<const Scene>& scene) {
+    const RenderJob large = make_job(scene, 320, 16, JobPriority::Batch);
+    const std::shared_ptr<RenderHandle> alone = engine.submit(make_job(scene, 160, 4, JobPriority::Batch));
+    alone->wait();
+    const double small_ms = alone->progress().elapsed_ms;
+    const auto deadline = std::chrono::milliseconds(static_cast<long>(1.5 * small_ms));
+    std::cout << "\nPreemption: a 160x90, 4 spp job (" << std::setprecision(0) << small_ms
+              << " ms alone) submitted while a 320x180, 16 spp batch job renders, due in " << deadline.count()
+              << " ms\n";
+
+    bool met = true;
+    for (const JobPriority priority : {JobPriority::Preview, JobPriority::Batch}) {
+        const std::shared_ptr<RenderHandle> background = engine.submit(large);
+        wait_for_tiles(*background, 4);
+
+        RenderJob small = make_job(scene, 160, 4, priority);
+        const Clock::time_point submitted = Clock::now();
+        small.schedule.deadline = submitted + deadline;
+        const std::shared_ptr<RenderHandle> handle = engine.submit(small);
+        handle->wait();
+        const double done_ms = ms_since(submitted);
+        const bool on_time = Clock::now() <= small.schedule.deadline;
+        const RenderProgress progress = handle->progress();
+        const RenderProgress large_progress = background->progress();
+        background->cancel();
+        background->wait();
+
+        std::cout << "  as " << (priority == JobPriority::Preview ? "preview" : "batch  ") << ": queued "
+                  << std::setprecision(2) << progress.queued_ms << " ms, done after " << std::setprecision(0)
+                  << done_ms << " ms, deadline " << (on_time ? "met" : "missed") << "; large job at "
+                  << large_progress.tiles_done << "/" << large_progress.tile_count << " tiles\n";
+        if (priority == JobPriority::Preview) {
+            met = on_time;
+        }
+    }
+    return met;
+}
+
+bool deadline_order(RenderEngine& engine, const std::shared_ptr<const Scene>& scene) {
+    const std::shared_ptr<RenderHandle> background = engine.submit(make_job(scene, 320, 16, JobPriority::Batch));
+    wait_for_tiles(*background, 1);
+
+    std::mutex mutex;
+    std::vector<int> finished;
+    std::vector<std::shared_ptr<RenderHandle>> previews;
+    const Clock::time_point now = Clock::now();
+    for (int index = 3; index >= 0; --index) {
+        RenderJob preview = make_job(scene, 80, 4, JobPriority::Preview);
+        preview.schedule.deadline = now + std::chrono::seconds(1 + index);
+        preview.on_progress = [&mutex, &finished, index](const RenderProgress& progress) {
+            if (progress.status == RenderStatus::Completed) {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.push_back(index);
+            }
+        };
+        previews.push_back(engine.submit(preview));
+    }
+    for (const std::shared_ptr<RenderHandle>& preview : previews) {
+        preview->wait();
+    }
+    background->cancel();
+    background->wait();
+
+    bool ordered = finished.size() == 4;
+    std::cout << "\nDeadlines: four 80x45 previews due in 4, 3, 2, 1 s, submitted in that order, completed:";
+    for (std::size_t position = 0; position < finished.size(); ++position) {
+        std::cout << " " << finished[position] + 1 << " s";
+        ordered = ordered && finished[position] == static_cast<int>(position);
+    }
+    std::cout << (ordered ? " (earliest deadline first)" : " (OUT OF ORDER)") << "\n";
+    return ordered;
+}
+
+} // namespace
+
+int main() {
+    const std::shared_ptr<const Scene> scene = std::make_shared<Scene>(create_scene());
+    RenderEngine engine;
+    std::cout << "Render engine with " << engine.thread_count() << " worker threads\n";
+
+    fair_share(engine, scene);
+    const bool met = preemption(engine, scene);
+    const bool ordered = deadline_order(engine, scene);
+    return met && ordered ? 0 : 1;
+}
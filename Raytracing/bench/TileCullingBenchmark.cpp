@@ -0,0 +1,129 @@
+/**
+ * @file TileCullingBenchmark.cpp
+ * @brief Tile frustum culling: list lengths and camera-ray closest-hit cost.
+ *
+ * For several resolutions and tile sizes on the demo room the benchmark
+ * - builds the per-tile primitive lists and reports build time and the mean
+ *   list length against the full table,
+ * - casts one jittered camera ray per pixel and times the closest-hit query
+ *   against the full table and against the pixel's tile list, checking that
+ *   both find the same primitive at the same distance,
+ * - renders the room with and without culling and checks the images match.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Random.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "TileCulling.h"
+
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr int kRepetitions = 3;
+constexpr int kMaxDepth = 20;
+constexpr double kMinDistance = 0.001;
+constexpr double kMaxDistance = 1'000'000.0;
+
+struct CameraRay {
+    Ray ray;
+    int col;
+    int row;
+};
+
+std::vector<CameraRay> camera_rays(const RenderConfig& config, const Camera& camera) {
+    std::vector<CameraRay> rays;
+    rays.reserve(static_cast<std::size_t>(config.image_width) * static_cast<std::size_t>(config.image_height));
+    for (int row = 0; row < config.image_height; ++row) {
+        for (int col = 0; col < config.image_width; ++col) {
+            const double u = (col + random_double()) / (config.image_width - 1);
+            const double v = (row + random_double()) / (config.image_height - 1);
+            rays.push_back(CameraRay{
+                Ray(camera.origin, camera.lower_left_corner + u * camera.horizontal + v * camera.vertical - camera.origin),
+                col, row});
+        }
+    }
+    return rays;
+}
+
+} // namespace
+
+int main() {
+    const Scene scene = create_scene();
+    const PrimitiveTable& table = scene.dispatch_table;
+    std::cout << "Scene: demo room, " << table.primitive_count() << " primitives; one jittered camera ray per pixel\n\n";
+
+    for (const int width : {400, 1600, 3840}) {
+        const RenderConfig config(16.0 / 9.0, width, 1);
+        const Camera camera(config.aspect_ratio);
+        const std::vector<CameraRay> rays = camera_rays(config, camera);
+
+        std::vector<HitCandidate> reference(rays.size());
+        std::vector<char> reference_hit(rays.size());
+        const double full_ms = bench::best_time_ms(kRepetitions, [&] {
+            for (std::size_t index = 0; index < rays.size(); ++index) {
+                reference_hit[index] = table.intersect(rays[index].ray, kMinDistance, kMaxDistance, reference[index]);
+            }
+        });
+        const double per_ray = 1e6 / static_cast<double>(rays.size());
+        std::cout << width << "x" << config.image_height << ": full table " << std::fixed << std::setprecision(1)
+                  << full_ms * per_ray << " ns per ray\n";
+
+        for (const int tile_size : {8, 16, 32, 64}) {
+            TileCulling culling;
+            const double build_ms = bench::best_time_ms(kRepetitions, [&] {
+                culling.build(table, camera, config.image_width, config.image_height, tile_size);
+            });
+
+            std::size_t mismatches = 0;
+            std::vector<HitCandidate> culled(rays.size());
+            const double culled_ms = bench::best_time_ms(kRepetitions, [&] {
+                mismatches = 0;
+                for (std::size_t index = 0; index < rays.size(); ++index) {
+                    const PrimitiveSubset visible = culling.tile_primitives(rays[index].col, rays[index].row);
+                    const bool hit = table.intersect_subset(visible.indices, visible.count, rays[index].ray,
+                                                            kMinDistance, kMaxDistance, culled[index]);
+                    if (hit != static_cast<bool>(reference_hit[index])
+                        || (hit && (culled[index].primitive_index != reference[index].primitive_index
+                                    || culled[index].distance_from_ray != reference[index].distance_from_ray))) {
+                        ++mismatches;
+                    }
+                }
+            });
+            std::cout << "  tile " << std::setw(2) << tile_size << ": " << std::setw(6) << culling.tile_count()
+                      << " tiles, build " << std::setprecision(2) << std::setw(6) << build_ms << " ms, "
+                      << std::setprecision(1) << std::setw(5) << culling.mean_primitives() << " primitives per tile, "
+                      << std::setw(6) << culled_ms * per_ray << " ns per ray (" << std::setprecision(2)
+                      << full_ms / culled_ms << "x), " << mismatches << " mismatched hits\n";
+        }
+    }
+
+    // Full renders with equal seeds; culling must not change a single pixel
+    RenderConfig config(16.0 / 9.0, 160, 16);
+    config.caustics.enabled = false;
+    const Camera camera(config.aspect_ratio);
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    std::vector<std::vector<float>> images;
+    std::vector<double> times;
+    for (const int tile_size : {0, 16}) {
+        config.primary_tile_size = tile_size;
+        times.push_back(bench::best_time_ms(1, [&] {
+            seed_thread_uniforms(1);
+            images.push_back(render_framebuffer(config, camera, scene, kMaxDepth).pixels);
+        }));
+    }
+    std::cerr.rdbuf(previous);
+    const bool identical = images[0] == images[1];
+    std::cout << "\nrender 160x90, 16 spp: " << std::setprecision(0) << times[0] << " ms without, " << times[1]
+              << " ms with 16 px tiles (" << std::setprecision(2) << times[0] / times[1] << "x), images "
+              << (identical ? "identical" : "DIFFER") << "\n";
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file TiledBenchmark.cpp
+ * @brief Memory footprint and throughput of the tiled, file-backed
+ * framebuffer and the banded PNG encoder.
+ *
+ * Usage: raytracer_bench_tiled [width height]
+ *
+ * - Encoder check: a 1920x1080 test image is written once through
+ *   quantize_framebuffer() + png_writer::write_rgb() and once from a
+ *   TiledFramebuffer through write_png(); the two files must be identical.
+ * - Large frame: a width x height (default 20000x10000) TiledFramebuffer is
+ *   filled band by band with a test pattern, as render_tiled() would, and
+ *   encoded to PNG. Peak resident memory is reported per phase next to the
+ *   size of the linear image, which never needs to fit.
+ * - Render: render_tiled() of the demo room at 2000x1000, 1 spp, with its
+ *   peak resident memory and the mean pixel value next to render_framebuffer()'s.
+ *
+ * Peak memory comes from VmHWM in /proc/self/status, reset between phases
+ * through /proc/self/clear_refs; elsewhere it reads as 0.
+ */
+
+#include "BenchUtils.h"
+#include "Camera.h"
+#include "Framebuffer.h"
+#include "PngWriter.h"
+#include "Quantize.h"
+#include "RenderConfig.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "TiledFramebuffer.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kTileSize = 64;
+constexpr int kMaxDepth = 8;
+
+std::filesystem::path scratch(const char* name) {
+    return std::filesystem::temp_directory_path() / name;
+}
+
+double mib(double bytes) {
+    return bytes / 1048576.0;
+}
+
+/**
+ * Peak resident set since the last reset_peak_memory(), in bytes.
+ */
+double peak_memory() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return 1024.0 * std::strtod(line.c_str() + 6, nullptr);
+        }
+    }
+    return 0.0;
+}
+
+void reset_peak_memory() {
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+}
+
+/**
+ * Linear test pattern: a diagonal gradient with rings, above 1 in places to
+ * exercise clamping.
+ */
+Color pattern(int col, int row, int width, int height) {
+    const double u = static_cast<double>(col) / width;
+    const double v = static_cast<double>(row) / height;
+    const double ring = 0.5 + 0.5 * std::sin(0.05 * std::hypot(col - 0.5 * width, row - 0.5 * height));
+    return Color(1.2 * u * ring, v, 0.25 + 0.5 * ring * (1.0 - u));
+}
+
+std::vector<char> file_bytes(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+bool check_encoder() {
+    const int width = 1920;
+    const int height = 1080;
+    Framebuffer image(width, height);
+    TiledFramebuffer tiled;
+    if (!tiled.create(scratch("raytracer_bench_tiled_check.tiles").string(), width, height, kTileSize)) {
+        std::cerr << "Cannot create the tiled framebuffer\n";
+        return false;
+    }
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            const Color color = pattern(col, row, width, height);
+            image.set(col, row, color);
+            tiled.set(col, row, color);
+        }
+    }
+
+    bool identical = true;
+    const double megabytes = mib(static_cast<double>(image.pixel_count()) * 3.0);
+    for (const DitherMode dither : {DitherMode::None, DitherMode::BlueNoise}) {
+        const std::filesystem::path whole = scratch("raytracer_bench_tiled_whole.png");
+        const std::filesystem::path banded = scratch("raytracer_bench_tiled_banded.png");
+        const double whole_ms = bench::best_time_ms(3, [&] {
+            png_writer::write_rgb(whole.string(), width, height, quantize_framebuffer(image, dither));
+        });
+        const double banded_ms = bench::best_time_ms(3, [&] {
+            tiled.write_png(banded.string(), dither);
+        });
+        const bool same = file_bytes(whole) == file_bytes(banded);
+        identical = identical && same;
+        std::cout << "  " << (dither == DitherMode::None ? "no dither" : "blue noise") << ": whole image "
+                  << std::fixed << std::setprecision(0) << megabytes / (whole_ms / 1000.0) << " MB/s, banded "
+                  << megabytes / (banded_ms / 1000.0) << " MB/s, files " << (same ? "identical" : "DIFFER")
+                  << "\n";
+        std::filesystem::remove(whole);
+        std::filesystem::remove(banded);
+    }
+    tiled.close();
+    std::filesystem::remove(scratch("raytracer_bench_tiled_check.tiles"));
+    return identical;
+}
+
+bool large_frame(int width, int height) {
+    const std::filesystem::path tiles = scratch("raytracer_bench_tiled_large.tiles");
+    const std::filesystem::path png = scratch("raytracer_bench_tiled_large.png");
+    const double linear_bytes = static_cast<double>(width) * height * 3.0 * sizeof(float);
+    std::cout << "\n" << width << "x" << height << " frame (" << std::setprecision(1) << mib(linear_bytes)
+              << " MiB of linear floats, " << mib(static_cast<double>(width) * height * 3.0)
+              << " MiB of 8-bit RGB), tiles of " << kTileSize << " px\n";
+
+    reset_peak_memory();
+    const double baseline = peak_memory();
+    TiledFramebuffer tiled;
+    if (!tiled.create(tiles.string(), width, height, kTileSize)) {
+        std::cerr << "Cannot create " << tiles << "\n";
+        return false;
+    }
+    const double fill_ms = bench::best_time_ms(1, [&] {
+        for (int band = 0; band < tiled.bands(); ++band) {
+            const int last_row = std::min((band + 1) * kTileSize, height);
+            for (int row = band * kTileSize; row < last_row; ++row) {
+                for (int col = 0; col < width; ++col) {
+                    tiled.set(col, row, pattern(col, row, width, height));
+                }
+            }
+            tiled.release_band(band);
+        }
+    });
+    const double fill_peak = peak_memory();
+    std::cout << "  fill band by band: " << std::setprecision(0) << fill_ms << " ms, peak resident "
+              << std::setprecision(1) << mib(fill_peak) << " MiB (" << mib(fill_peak - baseline)
+              << " MiB above the " << mib(baseline) << " MiB baseline)\n";
+
+    reset_peak_memory();
+    bool written = false;
+    const double encode_ms = bench::best_time_ms(1, [&] {
+        written = tiled.write_png(png.string(), DitherMode::BlueNoise);
+    });
+    const double encode_peak = peak_memory();
+    const double png_bytes = written ? static_cast<double>(std::filesystem::file_size(png)) : 0.0;
+    std::cout << "  banded PNG: " << std::setprecision(0) << encode_ms << " ms ("
+              << mib(static_cast<double>(width) * height * 3.0) / (encode_ms / 1000.0) << " MB/s), "
+              << std::setprecision(1) << mib(png_bytes) << " MiB written, peak resident " << mib(encode_peak)
+              << " MiB\n";
+
+    tiled.close();
+    std::filesystem::remove(tiles);
+    std::filesystem::remove(png);
+    return written;
+}
+
+void render_comparison() {
+    Scene scene = create_scene();
+    RenderConfig config(2.0, 2000, 1);
+    config.caustics.enabled = false;
+    config.primary_tile_size = 0;
+    const Camera camera(config.aspect_ratio);
+    const std::filesystem::path tiles = scratch("raytracer_bench_tiled_render.tiles");
+
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    TiledFramebuffer tiled;
+    tiled.create(tiles.string(), config.image_width, config.image_height, kTileSize);
+    reset_peak_memory();
+    const double tiled_ms = bench::best_time_ms(1, [&] {
+        render_tiled(config, camera, scene, kMaxDepth, tiled);
+    });
+    const double tiled_peak = peak_memory();
+    double tiled_sum = 0.0;
+    std::vector<float> row(static_cast<std::size_t>(config.image_width) * 3);
+    for (int index = 0; index < config.image_height; ++index) {
+        tiled.read_row(index, row.data());
+        for (const float value : row) {
+            tiled_sum += value;
+        }
+    }
+
+    reset_peak_memory();
+    Framebuffer whole;
+    const double whole_ms = bench::best_time_ms(1, [&] {
+        whole = render_framebuffer(config, camera, scene, kMaxDepth);
+    });
+    const double whole_peak = peak_memory();
+    std::cerr.rdbuf(previous);
+    double whole_sum = 0.0;
+    for (const float value : whole.pixels) {
+        whole_sum += value;
+    }
+
+    const double values = static_cast<double>(whole.pixels.size());
+    std::cout << "\nrender " << config.image_width << "x" << config.image_height << ", 1 spp, depth " << kMaxDepth
+              << " (tile culling off in both)\n"
+              << "  render_tiled:       " << std::setprecision(0) << tiled_ms << " ms, peak resident "
+              << std::setprecision(1) << mib(tiled_peak) << " MiB, mean value " << std::setprecision(4)
+              << tiled_sum / values << "\n"
+              << "  render_framebuffer: " << std::setprecision(0) << whole_ms << " ms, peak resident "
+              << std::setprecision(1) << mib(whole_peak) << " MiB, mean value " << std::setprecision(4)
+              << whole_sum / values << "\n";
+    tiled.close();
+    std::filesystem::remove(tiles);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int width = 20000;
+    int height = 10000;
+    if (argc == 3) {
+        width = std::atoi(argv[1]);
+        height = std::atoi(argv[2]);
+    }
+    if (width <= 0 || height <= 0) {
+        std::cerr << "Usage: raytracer_bench_tiled [width height]\n";
+        return 2;
+    }
+
+    std::cout << "Encoder check, 1920x1080\n";
+    const bool identical = check_encoder();
+    const bool written = large_frame(width, height);
+    render_comparison();
+    return identical && written ? 0 : 1;
+}
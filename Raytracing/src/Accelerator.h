@@ -0,0 +1,45 @@
+#ifndef ACCELERATOR_H
+#define ACCELERATOR_H
+
+/**
+ * @file Accelerator.h
+ * @brief Interface of the ray acceleration structures built over a PrimitiveTable.
+ */
+
+#include "Hittable.h"
+#include "Ray.h"
+
+class PrimitiveTable;
+
+/**
+ * Spatial index over the primitives of one PrimitiveTable. Every
+ * implementation returns exactly what the full table scan returns, including
+ * which primitive wins a tie at equal distance (the later one in the table);
+ * only the cost of the query changes.
+ */
+class Accelerator {
+public:
+    virtual ~Accelerator() = default;
+
+    /**
+     * Closest-hit query against `table`, which must be the table the
+     * structure was built from.
+     */
+    virtual bool intersect(const PrimitiveTable& table, const Ray& ray, double min_distance, double max_distance,
+                           HitCandidate& candidate) const = 0;
+
+    /**
+     * Both phases of intersect(), like Hittable::hit().
+     */
+    bool hit(const PrimitiveTable& table, const Ray& ray, double min_distance, double max_distance,
+             HitRecord& record) const {
+        HitCandidate candidate;
+        if (!intersect(table, ray, min_distance, max_distance, candidate)) {
+            return false;
+        }
+        candidate.primitive->fill_hit_record(ray, candidate, record);
+        return true;
+    }
+};
+
+#endif
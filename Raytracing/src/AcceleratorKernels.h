@@ -0,0 +1,129 @@
+#ifndef ACCELERATOR_KERNELS_H
+#define ACCELERATOR_KERNELS_H
+
+/**
+ * @file AcceleratorKernels.h
+ * @brief Primitive bounds and closest-hit bookkeeping shared by the accelerators.
+ *
+ * Accelerators visit primitives out of table order, so they cannot rely on
+ * the scan's "replace when not farther" rule; ClosestHit reproduces its
+ * result (ties go to the higher table index) whatever the visiting order.
+ */
+
+#include "CpuFeatures.h"
+#include "Hittable.h"
+#include "PrimitiveTable.h"
+#include "Ray.h"
+#include "Sphere.h"
+
+#include <array>
+#include <cstdint>
+#include <variant>
+
+/**
+ * Bounds to index a primitive by. Room enclosures are left out on purpose:
+ * their box would hold every other primitive, and testing them first gives
+ * the traversal a tight end (the wall the ray leaves through). Extension
+ * primitives have no known bounds.
+ *
+ * @return false for primitives every query must test
+ */
+inline bool accelerator_primitive_bounds(const PackedPrimitive& primitive, std::array<double, 3>& lo,
+                                         std::array<double, 3>& hi) {
+    if (const auto* sphere = std::get_if<SpherePrimitive>(&primitive.shape)) {
+        const double center[3] = {sphere->center.x(), sphere->center.y(), sphere->center.z()};
+        for (int axis = 0; axis < 3; ++axis) {
+            lo[axis] = center[axis] - sphere->radius;
+            hi[axis] = center[axis] + sphere->radius;
+        }
+        return true;
+    }
+    if (const auto* rect = std::get_if<RectPrimitive>(&primitive.shape)) {
+        const int a = static_cast<int>(rect->orientation.normal_axis);
+        const int u = static_cast<int>(rect->orientation.tangent_u);
+        const int v = static_cast<int>(rect->orientation.tangent_v);
+        lo[a] = hi[a] = rect->k;
+        lo[u] = rect->u0;
+        hi[u] = rect->u1;
+        lo[v] = rect->v0;
+        hi[v] = rect->v1;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Closest hit so far. Ties at equal distance go to the higher table index,
+ * which is what the full scan's "replace when not farther" rule yields.
+ */
+struct ClosestHit {
+    double distance;
+    bool found = false;
+    HitCandidate* candidate;
+
+    void offer(const PrimitiveTable* table, std::uint32_t index, double t, double u, double v) {
+        if (found && !(t < distance || index > candidate->primitive_index)) {
+            return;
+        }
+        found = true;
+        distance = t;
+        candidate->distance_from_ray = t;
+        candidate->primitive = table;
+        candidate->primitive_index = index;
+        candidate->u = u;
+        candidate->v = v;
+    }
+};
+
+/**
+ * Test one primitive with the same kernels and limits as the table scan.
+ */
+RAYTRACER_FORCE_INLINE void test_accelerated_primitive(const PrimitiveTable* table, const PackedPrimitive& primitive,
+                                                       std::uint32_t index, const Ray& ray, double min_distance,
+                                                       ClosestHit& closest) {
+    double t = 0.0;
+    double u_coord = 0.0;
+    double v_coord = 0.0;
+    switch (primitive_kind(primitive.shape)) {
+    case PrimitiveKind::Sphere: {
+        const auto& sphere = *std::get_if<SpherePrimitive>(&primitive.shape);
+        if (intersect_sphere(sphere.center, sphere.radius, ray, min_distance, closest.distance, t)) {
+            closest.offer(table, index, t, u_coord, v_coord);
+        }
+        return;
+    }
+    case PrimitiveKind::Rect: {
+        const auto& rect = *std::get_if<RectPrimitive>(&primitive.shape);
+        if (intersect_axis_aligned_rect(rect.orientation, rect.u0, rect.u1, rect.v0, rect.v1, rect.k, ray,
+                                        min_distance, closest.distance, t, u_coord, v_coord)) {
+            closest.offer(table, index, t, u_coord, v_coord);
+        }
+        return;
+    }
+    case PrimitiveKind::Enclosure: {
+        const auto& enclosure = *std::get_if<EnclosurePrimitive>(&primitive.shape);
+        int face = 0;
+        if (intersect_room_enclosure(enclosure.lo, enclosure.hi, enclosure.open_faces, ray, min_distance,
+                                     closest.distance, t, face)) {
+            closest.offer(table, index, t, face, v_coord);
+        }
+        return;
+    }
+    case PrimitiveKind::Extension: {
+        const auto& extension = *std::get_if<ExtensionPrimitive>(&primitive.shape);
+        HitCandidate extension_candidate;
+        if (extension.object->intersect(ray, min_distance, closest.distance, extension_candidate)
+            && (!closest.found || extension_candidate.distance_from_ray < closest.distance
+                || index > closest.candidate->primitive_index)) {
+            // Extensions fill the candidate themselves (primitive = their leaf)
+            extension_candidate.primitive_index = index;
+            *closest.candidate = extension_candidate;
+            closest.found = true;
+            closest.distance = extension_candidate.distance_from_ray;
+        }
+        return;
+    }
+    }
+}
+
+#endif
@@ -35,32 +35,29 @@ const RectOrientation YZRect::kOrientation{Axis::Y, Axis::Z, Axis::X, Vec3(1, 0,
 #if defined(__clang__)
 [[clang::noinline]]
 #endif
-bool AxisAlignedRect::hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const {
-    const Point3 origin = ray.origin();
-    const Vec3 direction = ray.direction();
-
-    const double denominator = direction.component(orientation.normal_axis);
-    if (std::fabs(denominator) < 1e-8) {
+bool AxisAlignedRect::intersect(const Ray& ray, double min_distance, double max_distance,
+                                HitCandidate& candidate) const {
+    double t;
+    double u_coord;
+    double v_coord;
+    if (!intersect_axis_aligned_rect(orientation, u0, u1, v0, v1, k, ray, min_distance, max_distance,
+                                     t, u_coord, v_coord)) {
         return false;
     }
 
-    const double offset_along_normal = k - origin.component(orientation.normal_axis);
-    const double t = offset_along_normal / denominator;
-    if (t < min_distance || t > max_distance) {
-        return false;
-    }
-
-    const double u_coord = origin.component(orientation.tangent_u) + t * direction.component(orientation.tangent_u);
-    const double v_coord = origin.component(orientation.tangent_v) + t * direction.component(orientation.tangent_v);
-    if (u_coord < u0 || u_coord > u1 || v_coord < v0 || v_coord > v1) {
-        return false;
-    }
+    candidate.distance_from_ray = t;
+    candidate.primitive = this;
+    candidate.u = u_coord;
+    candidate.v = v_coord;
+    return true;
+}
 
-    record.distance_from_ray = t;
-    record.hit_point = ray.at(t);
-    record.material_ptr = material_ptr;
+void AxisAlignedRect::fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                                      HitRecord& record) const {
+    record.distance_from_ray = candidate.distance_from_ray;
+    record.hit_point = ray.at(candidate.distance_from_ray);
+    record.material_ptr = material_ptr.get();
 
     const Vec3 outward_normal = orientation.outward_normal(flip_normal);
     record.set_face_normal(ray, outward_normal);
-    return true;
 }
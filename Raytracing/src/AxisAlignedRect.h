@@ -30,6 +30,52 @@ struct RectOrientation {
     }
 };
 
+/**
+ * Ray-rectangle intersection kernel shared by AxisAlignedRect and the packed
+ * primitive table.
+ *
+ * @param orientation Axes spanning the rectangle and its normal axis
+ * @param u0 Lower bound along the first tangent axis
+ * @param u1 Upper bound along the first tangent axis
+ * @param v0 Lower bound along the second tangent axis
+ * @param v1 Upper bound along the second tangent axis
+ * @param k Plane offset along the normal axis
+ * @param ray The ray to test
+ * @param min_distance Ignore hits closer than this
+ * @param max_distance Ignore hits farther than this
+ * @param distance Output: ray parameter of the hit
+ * @param u_coord Output: hit coordinate along the first tangent axis
+ * @param v_coord Output: hit coordinate along the second tangent axis
+ * @return true if the ray crosses the rectangle inside the distance range
+ */
+inline bool intersect_axis_aligned_rect(const RectOrientation& orientation,
+                                        double u0, double u1, double v0, double v1, double k,
+                                        const Ray& ray, double min_distance, double max_distance,
+                                        double& distance, double& u_coord, double& v_coord) {
+    const Point3 origin = ray.origin();
+    const Vec3 direction = ray.direction();
+
+    const double denominator = direction.component(orientation.normal_axis);
+    if (std::fabs(denominator) < 1e-8) {
+        return false;
+    }
+
+    const double offset_along_normal = k - origin.component(orientation.normal_axis);
+    const double t = offset_along_normal / denominator;
+    if (t < min_distance || t > max_distance) {
+        return false;
+    }
+
+    u_coord = origin.component(orientation.tangent_u) + t * direction.component(orientation.tangent_u);
+    v_coord = origin.component(orientation.tangent_v) + t * direction.component(orientation.tangent_v);
+    if (u_coord < u0 || u_coord > u1 || v_coord < v0 || v_coord > v1) {
+        return false;
+    }
+
+    distance = t;
+    return true;
+}
+
 /**
  * Generic axis-aligned rectangle that supports any orientation.
  */
@@ -44,9 +90,15 @@ public:
                     std::shared_ptr<Material> material,
                     bool flip = false);
 
-    bool hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const override;
+    bool intersect(const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override;
+
+    void fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                         HitRecord& record) const override;
 
 protected:
+    friend class PrimitiveTable;
+
     const RectOrientation orientation;
     const double u0;
     const double u1;
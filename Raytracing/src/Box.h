@@ -62,8 +62,14 @@ public:
         ));
     }
 
-    bool hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const override {
-        return sides.hit(ray, min_distance, max_distance, record);
+    bool intersect(const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override {
+        return sides.intersect(ray, min_distance, max_distance, candidate);
+    }
+
+    void fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                         HitRecord& record) const override {
+        sides.fill_hit_record(ray, candidate, record);
     }
 };
 
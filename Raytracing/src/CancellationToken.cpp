@@ -0,0 +1,40 @@
+#include "CancellationToken.h"
+
+#include <utility>
+#include <vector>
+
+void CancellationToken::cancel() {
+    std::vector<std::function<void()>> calls;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (flag.exchange(true, std::memory_order_relaxed)) {
+            return;
+        }
+        for (const auto& entry : listeners) {
+            calls.push_back(entry.second);
+        }
+    }
+    // Outside the lock, so listeners may take locks of their own
+    for (const std::function<void()>& call : calls) {
+        call();
+    }
+}
+
+std::size_t CancellationToken::subscribe(std::function<void()> listener) {
+    std::size_t key = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        key = next_key++;
+        if (!flag.load(std::memory_order_relaxed)) {
+            listeners.emplace(key, std::move(listener));
+            return key;
+        }
+    }
+    listener();
+    return key;
+}
+
+void CancellationToken::unsubscribe(std::size_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    listeners.erase(key);
+}
@@ -0,0 +1,53 @@
+#ifndef CANCELLATION_TOKEN_H
+#define CANCELLATION_TOKEN_H
+
+/**
+ * @file CancellationToken.h
+ * @brief Flag that asks running work to stop at its next sample, shared
+ * by whoever may want to stop it.
+ *
+ * Render loops poll cancelled() between samples, which costs one relaxed
+ * load. Code that waits rather than polls (the RenderEngine's idle workers)
+ * subscribes a listener, which cancel() runs once on the calling thread.
+ * One token can be given to several jobs to stop them together, e.g. every
+ * render of a view the user has just moved away from.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+
+class CancellationToken {
+public:
+    /**
+     * Set the flag and run the listeners; later calls do nothing until reset().
+     */
+    void cancel();
+
+    bool cancelled() const { return flag.load(std::memory_order_relaxed); }
+
+    /**
+     * Clear the flag so the token can stop work again; listeners stay.
+     */
+    void reset() { flag.store(false, std::memory_order_relaxed); }
+
+    /**
+     * Run `listener` on cancel(), at once if the token is already cancelled.
+     * It must not call back into this token.
+     *
+     * @return Key for unsubscribe()
+     */
+    std::size_t subscribe(std::function<void()> listener);
+
+    void unsubscribe(std::size_t key);
+
+private:
+    std::atomic<bool> flag{false};
+    std::mutex mutex;
+    std::map<std::size_t, std::function<void()>> listeners;
+    std::size_t next_key = 0;
+};
+
+#endif
@@ -0,0 +1,218 @@
+#include "Checksum.h"
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <array>
+
+#if RAYTRACER_HAS_ISA_VARIANTS
+#include <immintrin.h>
+#endif
+
+namespace checksum {
+namespace {
+
+// ---------- CRC-32 ----------
+
+constexpr std::uint32_t kCrcPolynomial = 0xEDB88320u;
+
+using CrcTables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+// tables[k][byte] = CRC of `byte` followed by k zero bytes, for slicing-by-8
+const CrcTables& crc_tables() {
+    static const CrcTables tables = [] {
+        CrcTables result{};
+        for (std::uint32_t byte = 0; byte < 256; ++byte) {
+            std::uint32_t crc = byte;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (kCrcPolynomial & static_cast<std::uint32_t>(-(crc & 1u)));
+            }
+            result[0][byte] = crc;
+        }
+        for (std::size_t k = 1; k < result.size(); ++k) {
+            for (std::size_t byte = 0; byte < 256; ++byte) {
+                const std::uint32_t previous = result[k - 1][byte];
+                result[k][byte] = (previous >> 8) ^ result[0][previous & 0xFFu];
+            }
+        }
+        return result;
+    }();
+    return tables;
+}
+
+RAYTRACER_FORCE_INLINE std::uint32_t load_le32(const unsigned char* data) {
+    return static_cast<std::uint32_t>(data[0])
+        | (static_cast<std::uint32_t>(data[1]) << 8)
+        | (static_cast<std::uint32_t>(data[2]) << 16)
+        | (static_cast<std::uint32_t>(data[3]) << 24);
+}
+
+// `state` is the inverted running CRC throughout the internal kernels
+std::uint32_t crc32_tables(const unsigned char* data, std::size_t length, std::uint32_t state) {
+    const CrcTables& t = crc_tables();
+    while (length >= 8) {
+        const std::uint32_t low = state ^ load_le32(data);
+        const std::uint32_t high = load_le32(data + 4);
+        state = t[7][low & 0xFFu] ^ t[6][(low >> 8) & 0xFFu] ^ t[5][(low >> 16) & 0xFFu] ^ t[4][low >> 24]
+              ^ t[3][high & 0xFFu] ^ t[2][(high >> 8) & 0xFFu] ^ t[1][(high >> 16) & 0xFFu] ^ t[0][high >> 24];
+        data += 8;
+        length -= 8;
+    }
+    while (length > 0) {
+        state = (state >> 8) ^ t[0][(state ^ *data) & 0xFFu];
+        ++data;
+        --length;
+    }
+    return state;
+}
+
+#if RAYTRACER_HAS_ISA_VARIANTS
+RAYTRACER_TARGET_SSE42 RAYTRACER_FORCE_INLINE __m128i load(const unsigned char* data) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+// x * k (both 64-bit halves, carry-less) + next
+RAYTRACER_TARGET_SSE42 RAYTRACER_FORCE_INLINE __m128i fold(__m128i x, __m128i k, __m128i next) {
+    const __m128i low = _mm_clmulepi64_si128(x, k, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(high, low), next);
+}
+
+// Carry-less multiply folding (Gopal et al., "Fast CRC Computation for
+// Generic Polynomials Using PCLMULQDQ"): four 128-bit lanes are folded 64
+// bytes at a time, reduced to 128 bits, then Barrett-reduced to 32 bits.
+// Requires length >= 64 and a multiple of 16.
+RAYTRACER_TARGET_SSE42 RAYTRACER_FORCE_INLINE std::uint32_t crc32_fold(const unsigned char* data,
+                                                                       std::size_t length,
+                                                                       std::uint32_t state) {
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+    const __m128i k5 = _mm_set_epi64x(0, 0x0163CD6124);
+    const __m128i barrett = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+    const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    __m128i x1 = _mm_xor_si128(load(data), _mm_cvtsi32_si128(static_cast<int>(state)));
+    __m128i x2 = load(data + 16);
+    __m128i x3 = load(data + 32);
+    __m128i x4 = load(data + 48);
+    data += 64;
+    length -= 64;
+
+    while (length >= 64) {
+        x1 = fold(x1, k1k2, load(data));
+        x2 = fold(x2, k1k2, load(data + 16));
+        x3 = fold(x3, k1k2, load(data + 32));
+        x4 = fold(x4, k1k2, load(data + 48));
+        data += 64;
+        length -= 64;
+    }
+
+    x1 = fold(x1, k3k4, x2);
+    x1 = fold(x1, k3k4, x3);
+    x1 = fold(x1, k3k4, x4);
+    while (length >= 16) {
+        x1 = fold(x1, k3k4, load(data));
+        data += 16;
+        length -= 16;
+    }
+
+    // 128 -> 64 bits
+    __m128i reduced = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), reduced);
+    reduced = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), k5, 0x00);
+    x1 = _mm_xor_si128(x1, reduced);
+
+    // Barrett reduction to 32 bits
+    reduced = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), barrett, 0x10);
+    reduced = _mm_clmulepi64_si128(_mm_and_si128(reduced, low32), barrett, 0x00);
+    x1 = _mm_xor_si128(x1, reduced);
+    return static_cast<std::uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+RAYTRACER_TARGET_SSE42 RAYTRACER_FORCE_INLINE std::uint32_t crc32_folded_body(const unsigned char* data,
+                                                                              std::size_t length,
+                                                                              std::uint32_t state) {
+    if (length >= 64) {
+        const std::size_t folded = length & ~static_cast<std::size_t>(15);
+        state = crc32_fold(data, folded, state);
+        data += folded;
+        length -= folded;
+    }
+    return crc32_tables(data, length, state);
+}
+
+std::uint32_t crc32_kernel_scalar(const unsigned char* data, std::size_t length, std::uint32_t state) {
+    return crc32_tables(data, length, state);
+}
+RAYTRACER_TARGET_SSE42 std::uint32_t crc32_kernel_sse42(const unsigned char* data, std::size_t length,
+                                                        std::uint32_t state) {
+    return crc32_folded_body(data, length, state);
+}
+RAYTRACER_TARGET_AVX2 std::uint32_t crc32_kernel_avx2(const unsigned char* data, std::size_t length,
+                                                      std::uint32_t state) {
+    return crc32_folded_body(data, length, state);
+}
+RAYTRACER_TARGET_AVX512 std::uint32_t crc32_kernel_avx512(const unsigned char* data, std::size_t length,
+                                                          std::uint32_t state) {
+    return crc32_folded_body(data, length, state);
+}
+#else
+RAYTRACER_DEFINE_ISA_VARIANTS(std::uint32_t, crc32_kernel, crc32_tables,
+                              (const unsigned char* data, std::size_t length, std::uint32_t state),
+                              (data, length, state))
+#endif
+
+using CrcKernel = std::uint32_t (*)(const unsigned char*, std::size_t, std::uint32_t);
+
+const cpu_features::IsaVariants<CrcKernel> crc_kernels = RAYTRACER_ISA_VARIANT_TABLE(crc32_kernel);
+
+// ---------- Adler-32 ----------
+
+constexpr std::uint32_t kAdlerModulus = 65521u;
+// b + n * a + sum((n - i) * byte) stays below 2.5e9 for n = 4096, so 32-bit sums suffice
+constexpr std::size_t kAdlerBlock = 4096;
+
+// Per block: a += sum(bytes), b += n * a + sum((n - i) * bytes[i]). The
+// weighted sum has no loop-carried dependency besides the two reductions,
+// so it vectorizes, unlike the textbook byte-at-a-time recurrence.
+RAYTRACER_FORCE_INLINE std::uint32_t adler32_body(const unsigned char* data, std::size_t length,
+                                                  std::uint32_t adler) {
+    std::uint32_t a = adler & 0xFFFFu;
+    std::uint32_t b = adler >> 16;
+    while (length > 0) {
+        const std::size_t block = std::min(length, kAdlerBlock);
+        const auto block_length = static_cast<std::uint32_t>(block);
+        std::uint32_t sum = 0;
+        std::uint32_t weighted = 0;
+        for (std::uint32_t i = 0; i < block_length; ++i) {
+            sum += data[i];
+            weighted += (block_length - i) * data[i];
+        }
+        b = (b + block_length * a + weighted) % kAdlerModulus;
+        a = (a + sum) % kAdlerModulus;
+        data += block;
+        length -= block;
+    }
+    return (b << 16) | a;
+}
+
+RAYTRACER_DEFINE_ISA_VARIANTS(std::uint32_t, adler32_kernel, adler32_body,
+                              (const unsigned char* data, std::size_t length, std::uint32_t adler),
+                              (data, length, adler))
+
+using AdlerKernel = std::uint32_t (*)(const unsigned char*, std::size_t, std::uint32_t);
+
+const cpu_features::IsaVariants<AdlerKernel> adler_kernels = RAYTRACER_ISA_VARIANT_TABLE(adler32_kernel);
+
+} // namespace
+
+std::uint32_t crc32(const unsigned char* data, std::size_t length, std::uint32_t crc) {
+    return ~crc_kernels.active()(data, length, ~crc);
+}
+
+std::uint32_t adler32(const unsigned char* data, std::size_t length, std::uint32_t adler) {
+    return adler_kernels.active()(data, length, adler);
+}
+
+} // namespace checksum
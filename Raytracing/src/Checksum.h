@@ -0,0 +1,39 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+/**
+ * @file Checksum.h
+ * @brief CRC-32 and Adler-32 used by the PNG/zlib container.
+ *
+ * Both dispatch on cpu_features::active_isa(): CRC-32 folds 64 bytes per
+ * step with carry-less multiplies on SSE4.2 and up (slicing-by-8 tables on
+ * the scalar path), Adler-32 uses a blocked weighted-sum form the compiler
+ * vectorizes for each ISA. Every variant returns the same value.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace checksum {
+
+/**
+ * CRC-32 (ISO-HDLC polynomial 0xEDB88320, as in PNG chunks and gzip).
+ *
+ * @param data Bytes to hash
+ * @param length Number of bytes
+ * @param crc Result of a previous call to continue a running checksum
+ */
+std::uint32_t crc32(const unsigned char* data, std::size_t length, std::uint32_t crc = 0);
+
+/**
+ * Adler-32 as used in zlib stream trailers.
+ *
+ * @param data Bytes to hash
+ * @param length Number of bytes
+ * @param adler Result of a previous call to continue a running checksum
+ */
+std::uint32_t adler32(const unsigned char* data, std::size_t length, std::uint32_t adler = 1);
+
+} // namespace checksum
+
+#endif
@@ -1,9 +1,15 @@
 #include "Color.h"
 
+#include "FastMath.h"
+
+#include <cmath>
+
 unsigned char convert_to_byte(double color_value) {
     // Apply gamma correction (gamma = 2.0, i.e., square root)
     // This fixes the dark/grainy appearance by converting from linear to sRGB-like space
-    const double gamma_corrected = std::sqrt(color_value);
+    const double gamma_corrected = fast_math::enabled(fast_math::Gamma)
+        ? fast_math::gamma_encode(color_value)
+        : std::sqrt(color_value);
     const double clamped_value = std::clamp(gamma_corrected, 0.0, 0.999);
     return static_cast<unsigned char>(clamped_value * 256.0);
 }
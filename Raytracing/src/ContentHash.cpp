@@ -0,0 +1,55 @@
+#include "ContentHash.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t kPrime = 0x100000001b3ull;
+
+std::uint64_t finalize(std::uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+} // namespace
+
+ContentHash& ContentHash::add(std::uint64_t value) {
+    lanes[0] = (lanes[0] ^ value) * kPrime;
+    lanes[1] = (lanes[1] ^ (value + 0x9e3779b97f4a7c15ull)) * kPrime;
+    lanes[1] ^= lanes[1] >> 29;
+    return *this;
+}
+
+ContentHash& ContentHash::add(double value) {
+    const double folded = value == 0.0 ? 0.0 : value;
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &folded, sizeof(bits));
+    return add(bits);
+}
+
+ContentHash& ContentHash::add(const std::string& value) {
+    add(static_cast<std::uint64_t>(value.size()));
+    for (std::size_t offset = 0; offset < value.size(); offset += 8) {
+        std::uint64_t word = 0;
+        for (std::size_t byte = offset; byte < value.size() && byte < offset + 8; ++byte) {
+            word |= static_cast<std::uint64_t>(static_cast<unsigned char>(value[byte])) << (8 * (byte - offset));
+        }
+        add(word);
+    }
+    return *this;
+}
+
+std::string ContentHash::hex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    for (const std::uint64_t lane : lanes) {
+        const std::uint64_t mixed = finalize(lane);
+        for (int shift = 60; shift >= 0; shift -= 4) {
+            text.push_back(digits[(mixed >> shift) & 0xF]);
+        }
+    }
+    return text;
+}
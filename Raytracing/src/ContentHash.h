@@ -0,0 +1,43 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+/**
+ * @file ContentHash.h
+ * @brief 128-bit hash of values fed in one by one, stable across runs,
+ * builds and machines.
+ *
+ * Values are hashed by meaning, never by memory layout: integers as 64-bit
+ * words, doubles by their bit patterns (with -0 folded into +0, so equal
+ * numbers hash alike), strings by length and bytes. Two FNV-1a style lanes
+ * with different seeds mix one 64-bit word at a time; a splitmix64
+ * finalizer avalanches each lane. Not cryptographic: it addresses a local
+ * cache, where accidental collisions are what matters, and at 128 bits
+ * those do not happen in practice.
+ */
+
+#include "Vec3.h"
+
+#include <cstdint>
+#include <string>
+
+class ContentHash {
+public:
+    ContentHash& add(std::uint64_t value);
+    ContentHash& add(std::int64_t value) { return add(static_cast<std::uint64_t>(value)); }
+    ContentHash& add(int value) { return add(static_cast<std::uint64_t>(static_cast<std::int64_t>(value))); }
+    ContentHash& add(unsigned value) { return add(static_cast<std::uint64_t>(value)); }
+    ContentHash& add(bool value) { return add(static_cast<std::uint64_t>(value ? 1 : 0)); }
+    ContentHash& add(double value);
+    ContentHash& add(const Vec3& value) { return add(value.x()).add(value.y()).add(value.z()); }
+    ContentHash& add(const std::string& value);
+
+    /**
+     * 32 lowercase hex digits; feeding more values afterwards continues the hash.
+     */
+    std::string hex() const;
+
+private:
+    std::uint64_t lanes[2] = {0xcbf29ce484222325ull, 0x84222325cbf29ce4ull};
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "CpuFeatures.h"
+
+#include <cstdlib>
+
+namespace cpu_features {
+namespace {
+
+constexpr unsigned kNotForced = ~0u;
+
+std::atomic<unsigned> forced_level{kNotForced};
+
+IsaLevel query_cpu() {
+#if RAYTRACER_HAS_ISA_VARIANTS
+    __builtin_cpu_init();
+    // __builtin_cpu_supports also checks that the OS saves the wide registers
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl")
+        && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("pclmul")) {
+        return IsaLevel::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("pclmul")) {
+        return IsaLevel::Avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")
+        && __builtin_cpu_supports("pclmul")) {
+        return IsaLevel::Sse42;
+    }
+#endif
+    return IsaLevel::Scalar;
+}
+
+} // namespace
+
+IsaLevel detected_isa() {
+    static const IsaLevel level = query_cpu();
+    return level;
+}
+
+IsaLevel active_isa() {
+    const unsigned forced = forced_level.load(std::memory_order_relaxed);
+    return forced == kNotForced ? detected_isa() : static_cast<IsaLevel>(forced);
+}
+
+IsaLevel force_isa(IsaLevel level) {
+    const IsaLevel effective = level < detected_isa() ? level : detected_isa();
+    forced_level.store(static_cast<unsigned>(effective), std::memory_order_relaxed);
+    return effective;
+}
+
+void clear_forced_isa() {
+    forced_level.store(kNotForced, std::memory_order_relaxed);
+}
+
+bool apply_isa_from_environment() {
+    const char* value = std::getenv("RAYTRACER_ISA");
+    if (value == nullptr || *value == '\0') {
+        return true;
+    }
+    IsaLevel level;
+    if (!parse_isa(value, level)) {
+        return false;
+    }
+    force_isa(level);
+    return true;
+}
+
+bool parse_isa(const std::string& name, IsaLevel& level) {
+    for (const IsaLevel candidate : {IsaLevel::Scalar, IsaLevel::Sse42, IsaLevel::Avx2, IsaLevel::Avx512}) {
+        if (name == isa_name(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* isa_name(IsaLevel level) {
+    switch (level) {
+    case IsaLevel::Scalar: return "scalar";
+    case IsaLevel::Sse42: return "sse4.2";
+    case IsaLevel::Avx2: return "avx2";
+    case IsaLevel::Avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+} // namespace cpu_features
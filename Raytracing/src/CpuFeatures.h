@@ -0,0 +1,144 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/**
+ * @file CpuFeatures.h
+ * @brief Runtime ISA detection and per-kernel variant dispatch.
+ *
+ * Release binaries are built for the baseline ISA so they run on every node;
+ * hot kernels (primitive intersection, RNG fill, quantization, checksums) are
+ * additionally compiled for SSE4.2, AVX2 and AVX-512 via target attributes
+ * and picked at call time from active_isa(). All variants share one source
+ * body and produce bit-identical results (no FMA contraction is enabled).
+ *
+ * The highest supported level is detected once with cpuid; force_isa() or
+ * the RAYTRACER_ISA environment variable (`scalar`, `sse4.2`, `avx2`,
+ * `avx512`) pins a lower level for benchmarking.
+ */
+
+#include <atomic>
+#include <string>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RAYTRACER_HAS_ISA_VARIANTS 1
+#define RAYTRACER_TARGET_SSE42 __attribute__((target("sse4.2,popcnt,pclmul")))
+#define RAYTRACER_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,popcnt,pclmul")))
+#define RAYTRACER_TARGET_AVX512 \
+    __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,bmi,bmi2,popcnt,pclmul")))
+#define RAYTRACER_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define RAYTRACER_HAS_ISA_VARIANTS 0
+#define RAYTRACER_TARGET_SSE42
+#define RAYTRACER_TARGET_AVX2
+#define RAYTRACER_TARGET_AVX512
+#define RAYTRACER_FORCE_INLINE inline
+#endif
+
+// Cache-line prefetch hint (read, keep in all levels); a no-op elsewhere
+#if defined(__GNUC__) || defined(__clang__)
+#define RAYTRACER_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define RAYTRACER_PREFETCH(address) static_cast<void>(address)
+#endif
+
+namespace cpu_features {
+
+/**
+ * Instruction set levels with dedicated kernel variants, in increasing order.
+ */
+enum class IsaLevel : unsigned {
+    Scalar = 0,  ///< Baseline build flags
+    Sse42 = 1,   ///< SSE4.2 + POPCNT + PCLMULQDQ
+    Avx2 = 2,    ///< AVX2 + BMI1/2
+    Avx512 = 3   ///< AVX-512 F/BW/DQ/VL
+};
+
+/**
+ * Highest level supported by this CPU and OS (cpuid, cached after first call).
+ * Always Scalar when the compiler cannot emit the variants.
+ */
+IsaLevel detected_isa();
+
+/**
+ * Level kernels dispatch to: the forced level if any, else detected_isa().
+ */
+IsaLevel active_isa();
+
+/**
+ * Pin dispatch to `level`, clamped to detected_isa() so an unsupported
+ * variant can never run.
+ *
+ * @return The level actually in effect
+ */
+IsaLevel force_isa(IsaLevel level);
+
+/**
+ * Drop a previous force_isa() and return to the detected level.
+ */
+void clear_forced_isa();
+
+/**
+ * Apply RAYTRACER_ISA from the environment, if set.
+ *
+ * @return false if the variable is set but not a recognised level
+ */
+bool apply_isa_from_environment();
+
+/**
+ * Parse `scalar`, `sse4.2`, `avx2` or `avx512` (case-sensitive).
+ *
+ * @return false if `name` is not a level
+ */
+bool parse_isa(const std::string& name, IsaLevel& level);
+
+/**
+ * Display name of a level, as accepted by parse_isa().
+ */
+const char* isa_name(IsaLevel level);
+
+/**
+ * One function pointer per ISA level for a single kernel.
+ * Levels without a compiled variant repeat the next lower one.
+ */
+template <typename Fn>
+struct IsaVariants {
+    Fn scalar;
+    Fn sse42;
+    Fn avx2;
+    Fn avx512;
+
+    Fn select(IsaLevel level) const {
+        switch (level) {
+        case IsaLevel::Avx512: return avx512;
+        case IsaLevel::Avx2: return avx2;
+        case IsaLevel::Sse42: return sse42;
+        case IsaLevel::Scalar: break;
+        }
+        return scalar;
+    }
+
+    Fn active() const {
+        return select(active_isa());
+    }
+};
+
+} // namespace cpu_features
+
+/**
+ * Define `name##_scalar/_sse42/_avx2/_avx512` forwarding to the force-inlined
+ * `body`, so each copy is compiled and vectorized for its own ISA.
+ * `params` and `args` are parenthesised parameter and argument lists.
+ */
+#define RAYTRACER_DEFINE_ISA_VARIANTS(ret, name, body, params, args) \
+    ret name##_scalar params { return body args; }                    \
+    RAYTRACER_TARGET_SSE42 ret name##_sse42 params { return body args; } \
+    RAYTRACER_TARGET_AVX2 ret name##_avx2 params { return body args; }   \
+    RAYTRACER_TARGET_AVX512 ret name##_avx512 params { return body args; }
+
+/**
+ * Brace initializer for an IsaVariants from RAYTRACER_DEFINE_ISA_VARIANTS functions.
+ */
+#define RAYTRACER_ISA_VARIANT_TABLE(name) \
+    { &name##_scalar, &name##_sse42, &name##_avx2, &name##_avx512 }
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+/**
+ * @file FastMath.h
+ * @brief Polynomial / Newton approximations for hot-path math with a
+ *        runtime-selectable accuracy mode.
+ *
+ * Every kernel is branch-free inline code using only +, *, bit casts and
+ * selects, so loops over them vectorize. The `math_*` wrappers pick the
+ * approximation or the libm function depending on which kernels are enabled
+ * (RenderConfig::fast_math_kernels, default set by the
+ * RAYTRACER_FAST_MATH_DEFAULT build option). A render applies its config's
+ * mask to its own threads with ScopedKernels; the process-wide mask is only
+ * the default for threads outside any render. Measured error bounds are
+ * listed per kernel; raytracer_bench_math reproduces them together with
+ * throughput and an image-difference report.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace fast_math {
+
+/**
+ * Kernels that can be switched to their approximate form.
+ */
+enum Kernel : unsigned {
+    SinCos = 1u << 0,  ///< sincos() instead of std::sin / std::cos
+    Sqrt = 1u << 1,    ///< sqrt() (rsqrt + Newton) instead of std::sqrt
+    Gamma = 1u << 2    ///< gamma_encode() in 8-bit quantization
+};
+
+constexpr unsigned kPrecise = 0u;
+constexpr unsigned kFast = SinCos | Sqrt | Gamma;
+
+#ifdef RAYTRACER_FAST_MATH_DEFAULT
+constexpr unsigned kDefaultKernels = kFast;
+#else
+constexpr unsigned kDefaultKernels = kPrecise;
+#endif
+
+/**
+ * Process-wide default of enabled approximate kernels (bitmask of Kernel).
+ */
+inline std::atomic<unsigned> enabled_kernel_mask{kDefaultKernels};
+
+/// thread_kernel_mask value meaning "use the process-wide mask"
+constexpr unsigned kNoThreadKernels = ~0u;
+
+/**
+ * This thread's kernels while a ScopedKernels is alive, else kNoThreadKernels.
+ */
+inline thread_local unsigned thread_kernel_mask = kNoThreadKernels;
+
+inline void set_enabled_kernels(unsigned mask) {
+    enabled_kernel_mask.store(mask, std::memory_order_relaxed);
+}
+
+/**
+ * Kernels in effect on the calling thread.
+ */
+inline unsigned enabled_kernels() {
+    const unsigned local = thread_kernel_mask;
+    return local != kNoThreadKernels ? local : enabled_kernel_mask.load(std::memory_order_relaxed);
+}
+
+/**
+ * Enables `mask` on the calling thread only, for the object's lifetime;
+ * nests, restoring the previous setting on destruction.
+ */
+class ScopedKernels {
+public:
+    explicit ScopedKernels(unsigned mask)
+        : previous(thread_kernel_mask) {
+        thread_kernel_mask = mask;
+    }
+    ~ScopedKernels() { thread_kernel_mask = previous; }
+
+    ScopedKernels(const ScopedKernels&) = delete;
+    ScopedKernels& operator=(const ScopedKernels&) = delete;
+
+private:
+    unsigned previous;
+};
+
+inline bool enabled(Kernel kernel) {
+    return (enabled_kernels() & kernel) != 0u;
+}
+
+// ========== Approximations ==========
+
+/**
+ * sin and cos of any finite angle.
+ *
+ * Cody-Waite reduction to r in [-pi/4, pi/4] with quadrant q, then
+ * degree-11 (sin) / degree-12 (cos) Taylor polynomials in Horner form; the
+ * quadrant swaps and negates the results with selects.
+ * Max abs error: 7e-12 (sin truncation term at r = pi/4), unchanged up to
+ * |x| = 1e3 thanks to the two-part reduction.
+ */
+inline void sincos(double x, double& sine, double& cosine) {
+    constexpr double kTwoOverPi = 0.63661977236758134308;
+    constexpr double kPiOver2High = 1.57079632673412561417;     // first 33 bits of pi/2
+    constexpr double kPiOver2Low = 6.07710050650619224932e-11;  // remainder
+
+    const double quadrant = std::nearbyint(x * kTwoOverPi);
+    const double r = (x - quadrant * kPiOver2High) - quadrant * kPiOver2Low;
+    const double r2 = r * r;
+
+    const double s = r * (1.0 + r2 * (-1.0 / 6.0 + r2 * (1.0 / 120.0 + r2 * (-1.0 / 5040.0
+                   + r2 * (1.0 / 362880.0 + r2 * (-1.0 / 39916800.0))))));
+    const double c = 1.0 + r2 * (-0.5 + r2 * (1.0 / 24.0 + r2 * (-1.0 / 720.0
+                   + r2 * (1.0 / 40320.0 + r2 * (-1.0 / 3628800.0 + r2 * (1.0 / 479001600.0))))));
+
+    const auto q = static_cast<std::int64_t>(quadrant);
+    const bool swap = (q & 1) != 0;
+    const double sin_value = swap ? c : s;
+    const double cos_value = swap ? s : c;
+    sine = ((q & 2) != 0) ? -sin_value : sin_value;
+    cosine = (((q + 1) & 2) != 0) ? -cos_value : cos_value;
+}
+
+/**
+ * x^5 by three multiplications (replaces std::pow(x, 5)).
+ * Matches std::pow bit-for-bit on [0, 1] in practice (3 roundings at most),
+ * so it is used unconditionally; there is nothing to trade.
+ */
+inline double pow5(double x) {
+    const double x2 = x * x;
+    return x2 * x2 * x;
+}
+
+/**
+ * 1/sqrt(x) for x > 0: bit-trick seed (3.4% error) refined by Newton steps.
+ * Max rel error: Steps=1: 1.8e-3, Steps=2: 4.6e-6, Steps=3: 3.2e-11,
+ * Steps=4: 3e-16.
+ */
+template <int Steps = 3>
+inline double rsqrt(double x) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5FE6EB50C7B537A9ull - (bits >> 1);
+    double y;
+    std::memcpy(&y, &bits, sizeof(y));
+    const double half_x = 0.5 * x;
+    for (int step = 0; step < Steps; ++step) {
+        y = y * (1.5 - half_x * y * y);
+    }
+    return y;
+}
+
+/**
+ * sqrt(x) as x * rsqrt(x); returns 0 for x <= 0 (std::sqrt would give NaN
+ * for negatives, which callers already guard against).
+ * Max rel error: 4.4e-16, i.e. 2 ulp (four Newton steps).
+ */
+inline double sqrt(double x) {
+    const double safe = std::max(x, 1e-300);
+    const double root = safe * rsqrt<4>(safe);
+    return x > 0.0 ? root : 0.0;
+}
+
+/**
+ * Gamma-2 encode (sqrt) for values headed to 8-bit output.
+ * Input is clamped to [0, 1]. Two Newton steps: max rel error 4.6e-6; about
+ * 0.03% of 8-bit outputs land one step away from the exact sqrt.
+ */
+inline double gamma_encode(double linear) {
+    const double clamped = std::min(std::max(linear, 1e-12), 1.0);
+    return clamped * rsqrt<2>(clamped);
+}
+
+} // namespace fast_math
+
+// ========== Accuracy-Selected Wrappers ==========
+// Hot-path code calls these; the mode check is a single relaxed load.
+
+inline void math_sincos(double x, double& sine, double& cosine) {
+    if (fast_math::enabled(fast_math::SinCos)) {
+        fast_math::sincos(x, sine, cosine);
+    } else {
+        sine = std::sin(x);
+        cosine = std::cos(x);
+    }
+}
+
+inline double math_sqrt(double x) {
+    return fast_math::enabled(fast_math::Sqrt) ? fast_math::sqrt(x) : std::sqrt(x);
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+/**
+ * @file Framebuffer.h
+ * @brief Linear floating-point image produced by the renderer.
+ */
+
+#include "Vec3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Interleaved RGB float image, rows stored top to bottom (PNG order).
+ * Values are linear radiance averages; quantization to bytes happens in a
+ * separate post-processing stage (see Quantize.h).
+ */
+struct Framebuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<float> pixels;
+
+    Framebuffer() = default;
+
+    Framebuffer(int width_in, int height_in)
+        : width(width_in)
+        , height(height_in)
+        , pixels(static_cast<std::size_t>(width_in) * static_cast<std::size_t>(height_in) * 3, 0.0f)
+    {}
+
+    std::size_t pixel_count() const {
+        return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    }
+
+    /**
+     * Store a pixel; `row` counts from the top of the image.
+     */
+    void set(int col, int row, const Color& color) {
+        float* pixel = pixels.data() + (static_cast<std::size_t>(row) * static_cast<std::size_t>(width)
+                                        + static_cast<std::size_t>(col)) * 3;
+        pixel[0] = static_cast<float>(color.x());
+        pixel[1] = static_cast<float>(color.y());
+        pixel[2] = static_cast<float>(color.z());
+    }
+};
+
+/**
+ * Samples taken so far for a frame: each pixel's average in `image` and
+ * the number of samples behind it in `counts` (same order), which is what a
+ * render needs to carry on where another stopped.
+ */
+struct FrameSamples {
+    Framebuffer image;
+    std::vector<std::uint32_t> counts;
+};
+
+#endif
@@ -7,11 +7,28 @@
  */
 
 #include "Ray.h"
+#include "ShadingFrame.h"
 #include "Vec3.h"
+#include <cstdint>
 #include <memory>
 
-// Forward declaration
+// Forward declarations
+class Hittable;
 class Material;
+struct PackedMaterial;
+
+/**
+ * Minimal result of the traversal phase.
+ * Only what is needed to pick the closest hit is recorded here; the full
+ * surface attributes are resolved once for the winner (see HitRecord).
+ */
+struct HitCandidate {
+    double distance_from_ray = 0.0;        // How far along the ray the hit occurred
+    const Hittable* primitive = nullptr;   // Leaf primitive that produced the hit
+    std::uint32_t primitive_index = 0;     // Slot in the scene's PrimitiveTable
+    double u = 0.0;                        // Primitive-specific scratch coordinates
+    double v = 0.0;                        // (e.g. rectangle uv), reused when resolving
+};
 
 /**
  * Stores information about where a ray hit an object.
@@ -20,15 +37,17 @@ class Material;
 struct HitRecord {
     Point3 hit_point;           // Where the ray hit the object
     Vec3 surface_normal;        // Direction perpendicular to the surface at hit point
+    ShadingFrame shading_frame; // Tangent frame around surface_normal (normal = +Z locally)
     double distance_from_ray;   // How far along the ray the hit occurred
     bool is_front_face;         // Did we hit the front or back of the object?
-    Color object_color;         // The color of the object that was hit
-    std::shared_ptr<Material> material_ptr;  // Pointer to the material
+    const Material* material_ptr = nullptr;  // Material owned by the primitive
+    const PackedMaterial* packed_material = nullptr;  // Closed-set fast path (null for extensions)
     
     /**
      * Determine which side of the surface we hit and set the normal accordingly.
      * Normals always point "outward" from the surface, but we need to know
      * if the ray came from outside or inside the object.
+     * Also builds the shading frame, once per resolved hit.
      * 
      * @param ray The ray that hit this surface
      * @param outward_normal The normal pointing away from the object's center
@@ -39,27 +58,65 @@ struct HitRecord {
         
         // Make the normal always point against the ray direction
         surface_normal = is_front_face ? outward_normal : -outward_normal;
+        shading_frame = ShadingFrame::from_normal(surface_normal);
     }
 };
 
 /**
  * Base class for anything that can be hit by a ray.
  * This could be a sphere, plane, triangle, etc.
+ *
+ * Intersection is split into two phases:
+ * 1. intersect() finds the distance and the leaf primitive, nothing more.
+ *    It runs for every candidate, so it must stay cheap.
+ * 2. fill_hit_record() computes hit point, normal, face orientation and
+ *    material, and is only invoked on the closest candidate.
  */
 class Hittable {
 public:
     virtual ~Hittable() = default;
-    
+
     /**
-     * Check if a ray hits this object.
-     * 
+     * Traversal phase: check if a ray hits this object.
+     *
+     * @param ray The ray to test
+     * @param min_distance Don't count hits closer than this (avoids self-intersection)
+     * @param max_distance Don't count hits farther than this (optimization)
+     * @param candidate Output: distance, leaf primitive and scratch coordinates
+     * @return true if the ray hit this object, false otherwise
+     */
+    virtual bool intersect(const Ray& ray, double min_distance, double max_distance,
+                           HitCandidate& candidate) const = 0;
+
+    /**
+     * Resolve phase: compute the surface attributes for a candidate
+     * previously produced by this primitive's intersect().
+     *
+     * @param ray The ray that produced the candidate
+     * @param candidate Result of the traversal phase
+     * @param record Output: full surface interaction
+     */
+    virtual void fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                                 HitRecord& record) const = 0;
+
+    /**
+     * Check if a ray hits this object and resolve the closest hit.
+     * Convenience wrapper running both phases.
+     *
      * @param ray The ray to test
      * @param min_distance Don't count hits closer than this (avoids self-intersection)
      * @param max_distance Don't count hits farther than this (optimization)
      * @param record Where to store information about the hit (if it happens)
      * @return true if the ray hit this object, false otherwise
      */
-    virtual bool hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const = 0;
+    bool hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const {
+        HitCandidate candidate;
+        if (!intersect(ray, min_distance, max_distance, candidate)) {
+            return false;
+        }
+        candidate.primitive->fill_hit_record(ray, candidate, record);
+        return true;
+    }
 };
 
 #endif
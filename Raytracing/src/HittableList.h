@@ -38,31 +38,38 @@ public:
     
     /**
      * Check if a ray hits any object in the scene.
-     * Returns information about the CLOSEST hit.
+     * Records only the CLOSEST candidate; attributes are resolved later.
      * 
      * @param ray The ray to test
      * @param min_distance Ignore hits closer than this
      * @param max_distance Ignore hits farther than this
-     * @param record Store hit information here
+     * @param candidate Store the closest candidate here
      * @return true if ray hit something, false if it hit nothing
      */
-    bool hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const override {
-        HitRecord temp_record;
+    bool intersect(const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override {
         bool hit_anything = false;
         double closest_so_far = max_distance;
         
-        // Check every object in the scene
+        // Check every object in the scene; each hit narrows the search range,
+        // so the candidate left behind is always the closest one
         for (const auto& object : objects) {
-            // Did the ray hit this object?
-            if (object->hit(ray, min_distance, closest_so_far, temp_record)) {
+            if (object->intersect(ray, min_distance, closest_so_far, candidate)) {
                 hit_anything = true;
-                closest_so_far = temp_record.distance_from_ray;
-                record = temp_record;
+                closest_so_far = candidate.distance_from_ray;
             }
         }
         
         return hit_anything;
     }
+
+    /**
+     * Candidates always name the leaf primitive, so resolving is delegated to it.
+     */
+    void fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                         HitRecord& record) const override {
+        candidate.primitive->fill_hit_record(ray, candidate, record);
+    }
 };
 
 #endif
@@ -0,0 +1,55 @@
+#include "ImageWriter.h"
+
+#include "JpegWriter.h"
+#include "PngWriter.h"
+#include "QoiWriter.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace image_writer {
+
+bool format_for_path(const std::string& path, ImageFormat& format) {
+    const std::size_t dot = path.find_last_of('.');
+    const std::size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return false;
+    }
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == "png") {
+        format = ImageFormat::Png;
+    } else if (extension == "qoi") {
+        format = ImageFormat::Qoi;
+    } else if (extension == "jpg" || extension == "jpeg") {
+        format = ImageFormat::Jpeg;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* format_name(ImageFormat format) {
+    switch (format) {
+    case ImageFormat::Png: return "png";
+    case ImageFormat::Qoi: return "qoi";
+    case ImageFormat::Jpeg: return "jpg";
+    }
+    return "png";
+}
+
+bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb) {
+    ImageFormat format = ImageFormat::Png;
+    if (!format_for_path(filename, format)) {
+        return false;
+    }
+    switch (format) {
+    case ImageFormat::Png: return png_writer::write_rgb(filename, width, height, rgb);
+    case ImageFormat::Qoi: return qoi_writer::write_rgb(filename, width, height, rgb);
+    case ImageFormat::Jpeg: return jpeg_writer::write_rgb(filename, width, height, rgb);
+    }
+    return false;
+}
+
+} // namespace image_writer
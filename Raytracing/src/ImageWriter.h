@@ -0,0 +1,46 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+/**
+ * @file ImageWriter.h
+ * @brief Output format chosen by file extension.
+ *
+ * `.png` goes through png_writer, `.qoi` through qoi_writer and `.jpg` or
+ * `.jpeg` through jpeg_writer (case-insensitive). PNG stays the default for
+ * final frames; QOI and JPEG are for previews, where encoding speed and
+ * size matter more than an exact, widely supported file.
+ */
+
+#include <string>
+#include <vector>
+
+enum class ImageFormat {
+    Png,
+    Qoi,
+    Jpeg
+};
+
+namespace image_writer {
+
+/**
+ * Format named by the extension of `path`.
+ *
+ * @return false if the extension is not one of the above
+ */
+bool format_for_path(const std::string& path, ImageFormat& format);
+
+/**
+ * Lower-case name of a format, as in its usual extension.
+ */
+const char* format_name(ImageFormat format);
+
+/**
+ * Write packed top-to-bottom RGB in the format `filename` names.
+ *
+ * @return false for an unknown extension or if the encoder fails
+ */
+bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb);
+
+} // namespace image_writer
+
+#endif
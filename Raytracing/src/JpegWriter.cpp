@@ -0,0 +1,465 @@
+#include "JpegWriter.h"
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <utility>
+
+namespace jpeg_writer {
+namespace {
+
+constexpr int kBlock = 64;
+constexpr int kMcu = 16;  // 4:2:0: four luma blocks and one block per chroma channel
+
+// Natural (row-major) index of the k-th coefficient in zigzag order
+constexpr std::array<std::uint8_t, kBlock> kZigzag = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// Annex K.1 tables for quality 50, natural order
+constexpr std::array<std::uint8_t, kBlock> kLumaQuant = {
+    16, 11, 10, 16, 24,  40,  51,  61,  12, 12, 14, 19, 26,  58,  60,  55,
+    14, 13, 16, 24, 40,  57,  69,  56,  14, 17, 22, 29, 51,  87,  80,  62,
+    18, 22, 37, 56, 68,  109, 103, 77,  24, 35, 55, 64, 81,  104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99};
+constexpr std::array<std::uint8_t, kBlock> kChromaQuant = {
+    17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99};
+
+// Annex K.3 Huffman tables: code counts per length 1..16, then symbols
+constexpr std::array<std::uint8_t, 16> kLumaDcBits = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+constexpr std::array<std::uint8_t, 16> kChromaDcBits = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+constexpr std::array<std::uint8_t, 12> kDcValues = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+constexpr std::array<std::uint8_t, 16> kLumaAcBits = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+constexpr std::array<std::uint8_t, 162> kLumaAcValues = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa};
+constexpr std::array<std::uint8_t, 16> kChromaAcBits = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+constexpr std::array<std::uint8_t, 162> kChromaAcValues = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa};
+
+// Scale of the AAN DCT's outputs relative to the orthonormal DCT, per frequency
+constexpr std::array<float, 8> kAanScale = {1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+                                            1.0f, 0.785694958f, 0.541196100f, 0.275899379f};
+
+/**
+ * Code and length of every symbol of one Huffman table.
+ */
+struct HuffmanTable {
+    std::array<std::uint16_t, 256> code{};
+    std::array<std::uint8_t, 256> length{};
+};
+
+template <std::size_t N>
+HuffmanTable build_huffman(const std::array<std::uint8_t, 16>& bits, const std::array<std::uint8_t, N>& values) {
+    // Canonical codes, Annex C
+    HuffmanTable table;
+    std::uint16_t code = 0;
+    std::size_t next = 0;
+    for (int length = 1; length <= 16; ++length) {
+        for (int count = 0; count < bits[static_cast<std::size_t>(length - 1)]; ++count) {
+            table.code[values[next]] = code++;
+            table.length[values[next]] = static_cast<std::uint8_t>(length);
+            ++next;
+        }
+        code = static_cast<std::uint16_t>(code << 1);
+    }
+    return table;
+}
+
+/**
+ * Annex K table scaled to `quality` like libjpeg's jpeg_quality_scaling().
+ */
+std::array<std::uint8_t, kBlock> scaled_quant(const std::array<std::uint8_t, kBlock>& base, int quality) {
+    const int scale = quality < 50 ? 5000 / quality : 200 - 2 * quality;
+    std::array<std::uint8_t, kBlock> table{};
+    for (int index = 0; index < kBlock; ++index) {
+        const int value = (base[static_cast<std::size_t>(index)] * scale + 50) / 100;
+        table[static_cast<std::size_t>(index)] = static_cast<std::uint8_t>(std::clamp(value, 1, 255));
+    }
+    return table;
+}
+
+/**
+ * Reciprocal divisors that fold the AAN output scale into quantization.
+ */
+std::array<float, kBlock> divisors(const std::array<std::uint8_t, kBlock>& quant) {
+    std::array<float, kBlock> result{};
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            const std::size_t index = static_cast<std::size_t>(row * 8 + col);
+            result[index] = 1.0f / (static_cast<float>(quant[index]) * kAanScale[static_cast<std::size_t>(row)]
+                                    * kAanScale[static_cast<std::size_t>(col)] * 8.0f);
+        }
+    }
+    return result;
+}
+
+// ---------- Kernels ----------
+
+/**
+ * Convert `count` RGB pixels to level-shifted Y, Cb and Cr (JFIF equations).
+ */
+RAYTRACER_FORCE_INLINE void rgb_to_ycbcr_body(const unsigned char* rgb, std::size_t count, float* y, float* cb,
+                                              float* cr) {
+    for (std::size_t index = 0; index < count; ++index) {
+        const float r = rgb[3 * index];
+        const float g = rgb[3 * index + 1];
+        const float b = rgb[3 * index + 2];
+        y[index] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+        cb[index] = -0.168736f * r - 0.331264f * g + 0.5f * b;
+        cr[index] = 0.5f * r - 0.418688f * g - 0.081312f * b;
+    }
+}
+
+/**
+ * One AAN pass down the columns of an 8x8 block: every statement is eight
+ * independent lanes, one per column.
+ */
+RAYTRACER_FORCE_INLINE void fdct_columns(float* block) {
+    for (int col = 0; col < 8; ++col) {
+        float* d = block + col;
+        const float tmp0 = d[0] + d[56];
+        const float tmp7 = d[0] - d[56];
+        const float tmp1 = d[8] + d[48];
+        const float tmp6 = d[8] - d[48];
+        const float tmp2 = d[16] + d[40];
+        const float tmp5 = d[16] - d[40];
+        const float tmp3 = d[24] + d[32];
+        const float tmp4 = d[24] - d[32];
+
+        // Even part
+        const float tmp10 = tmp0 + tmp3;
+        const float tmp13 = tmp0 - tmp3;
+        const float tmp11 = tmp1 + tmp2;
+        const float tmp12 = tmp1 - tmp2;
+        d[0] = tmp10 + tmp11;
+        d[32] = tmp10 - tmp11;
+        const float z1 = (tmp12 + tmp13) * 0.707106781f;
+        d[16] = tmp13 + z1;
+        d[48] = tmp13 - z1;
+
+        // Odd part
+        const float odd10 = tmp4 + tmp5;
+        const float odd11 = tmp5 + tmp6;
+        const float odd12 = tmp6 + tmp7;
+        const float z5 = (odd10 - odd12) * 0.382683433f;
+        const float z2 = 0.541196100f * odd10 + z5;
+        const float z4 = 1.306562965f * odd12 + z5;
+        const float z3 = odd11 * 0.707106781f;
+        const float z11 = tmp7 + z3;
+        const float z13 = tmp7 - z3;
+        d[40] = z13 + z2;
+        d[24] = z13 - z2;
+        d[8] = z11 + z4;
+        d[56] = z11 - z4;
+    }
+}
+
+RAYTRACER_FORCE_INLINE void transpose(float* block) {
+    for (int row = 0; row < 8; ++row) {
+        for (int col = row + 1; col < 8; ++col) {
+            std::swap(block[row * 8 + col], block[col * 8 + row]);
+        }
+    }
+}
+
+/**
+ * Forward DCT of a level-shifted 8x8 block and quantization with
+ * `divisors` (see divisors()), in natural order. Clobbers `block`.
+ */
+RAYTRACER_FORCE_INLINE void fdct_quantize_body(float* block, const float* divisors, std::int16_t* out) {
+    fdct_columns(block);
+    transpose(block);
+    fdct_columns(block);
+    transpose(block);
+    for (int index = 0; index < kBlock; ++index) {
+        // Round half away from zero without a branch, like libjpeg's float path
+        const float value = block[index] * divisors[index];
+        out[index] = static_cast<std::int16_t>(static_cast<int>(value + 16384.5f) - 16384);
+    }
+}
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, rgb_to_ycbcr, rgb_to_ycbcr_body,
+                              (const unsigned char* rgb, std::size_t count, float* y, float* cb, float* cr),
+                              (rgb, count, y, cb, cr))
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, fdct_quantize, fdct_quantize_body,
+                              (float* block, const float* divisors, std::int16_t* out), (block, divisors, out))
+
+using ColorKernel = void (*)(const unsigned char*, std::size_t, float*, float*, float*);
+using DctKernel = void (*)(float*, const float*, std::int16_t*);
+
+const cpu_features::IsaVariants<ColorKernel> color_kernels = RAYTRACER_ISA_VARIANT_TABLE(rgb_to_ycbcr);
+const cpu_features::IsaVariants<DctKernel> dct_kernels = RAYTRACER_ISA_VARIANT_TABLE(fdct_quantize);
+
+// ---------- Entropy coding ----------
+
+/**
+ * Huffman bit stream with 0xFF byte stuffing.
+ */
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<unsigned char>& out_in)
+        : out(out_in) {}
+
+    void put(std::uint32_t code, int length) {
+        accumulator = (accumulator << length) | code;
+        count += length;
+        while (count >= 8) {
+            count -= 8;
+            const unsigned char byte = static_cast<unsigned char>(accumulator >> count);
+            out.push_back(byte);
+            if (byte == 0xFF) {
+                out.push_back(0x00);
+            }
+        }
+    }
+
+    /// Pad the last byte with one bits
+    void flush() {
+        if (count > 0) {
+            put((1u << (8 - count)) - 1u, 8 - count);
+        }
+    }
+
+private:
+    std::vector<unsigned char>& out;
+    std::uint64_t accumulator = 0;
+    int count = 0;
+};
+
+/**
+ * Magnitude category of a coefficient and its extra bits (one's complement
+ * for negative values), F.1.2.1.
+ */
+inline int category(int value, std::uint32_t& bits) {
+    const int magnitude = value < 0 ? -value : value;
+    int size = 0;
+    while ((magnitude >> size) != 0) {
+        ++size;
+    }
+    bits = static_cast<std::uint32_t>(value < 0 ? value - 1 : value) & ((1u << size) - 1u);
+    return size;
+}
+
+void encode_block(BitWriter& writer, const std::int16_t* coefficients, int& previous_dc, const HuffmanTable& dc,
+                  const HuffmanTable& ac) {
+    std::uint32_t bits = 0;
+    const int dc_value = coefficients[0];
+    const int dc_size = category(dc_value - previous_dc, bits);
+    previous_dc = dc_value;
+    writer.put(dc.code[static_cast<std::size_t>(dc_size)], dc.length[static_cast<std::size_t>(dc_size)]);
+    if (dc_size > 0) {
+        writer.put(bits, dc_size);
+    }
+
+    int zeros = 0;
+    for (int k = 1; k < kBlock; ++k) {
+        const int value = coefficients[kZigzag[static_cast<std::size_t>(k)]];
+        if (value == 0) {
+            ++zeros;
+            continue;
+        }
+        while (zeros > 15) {
+            writer.put(ac.code[0xF0], ac.length[0xF0]);
+            zeros -= 16;
+        }
+        const int size = category(value, bits);
+        const std::size_t symbol = static_cast<std::size_t>((zeros << 4) | size);
+        writer.put(ac.code[symbol], ac.length[symbol]);
+        writer.put(bits, size);
+        zeros = 0;
+    }
+    if (zeros > 0) {
+        writer.put(ac.code[0x00], ac.length[0x00]);
+    }
+}
+
+// ---------- Markers ----------
+
+void put_uint16(std::vector<unsigned char>& out, int value) {
+    out.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
+    out.push_back(static_cast<unsigned char>(value & 0xFF));
+}
+
+template <std::size_t N>
+void put_huffman(std::vector<unsigned char>& out, int table_class_and_id, const std::array<std::uint8_t, 16>& bits,
+                 const std::array<std::uint8_t, N>& values) {
+    out.push_back(static_cast<unsigned char>(table_class_and_id));
+    out.insert(out.end(), bits.begin(), bits.end());
+    out.insert(out.end(), values.begin(), values.end());
+}
+
+void write_headers(std::vector<unsigned char>& out, int width, int height,
+                   const std::array<std::uint8_t, kBlock>& luma, const std::array<std::uint8_t, kBlock>& chroma) {
+    static const unsigned char kJfif[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00,
+                                          0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00};
+    out.insert(out.end(), std::begin(kJfif), std::end(kJfif));
+
+    // DQT: both tables in zigzag order
+    out.push_back(0xFF);
+    out.push_back(0xDB);
+    put_uint16(out, 2 + 2 * (1 + kBlock));
+    for (int id = 0; id < 2; ++id) {
+        const std::array<std::uint8_t, kBlock>& table = id == 0 ? luma : chroma;
+        out.push_back(static_cast<unsigned char>(id));
+        for (const std::uint8_t natural : kZigzag) {
+            out.push_back(table[natural]);
+        }
+    }
+
+    // SOF0: Y sampled 2x2, Cb and Cr 1x1
+    static const unsigned char kComponents[] = {3, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+    out.push_back(0xFF);
+    out.push_back(0xC0);
+    put_uint16(out, 8 + 3 * 3);
+    out.push_back(8);
+    put_uint16(out, height);
+    put_uint16(out, width);
+    out.insert(out.end(), std::begin(kComponents), std::end(kComponents));
+
+    out.push_back(0xFF);
+    out.push_back(0xC4);
+    put_uint16(out, 2 + 4 * (1 + 16) + 2 * static_cast<int>(kDcValues.size() + kLumaAcValues.size()));
+    put_huffman(out, 0x00, kLumaDcBits, kDcValues);
+    put_huffman(out, 0x10, kLumaAcBits, kLumaAcValues);
+    put_huffman(out, 0x01, kChromaDcBits, kDcValues);
+    put_huffman(out, 0x11, kChromaAcBits, kChromaAcValues);
+
+    static const unsigned char kScan[] = {0xFF, 0xDA, 0x00, 0x0C, 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0};
+    out.insert(out.end(), std::begin(kScan), std::end(kScan));
+}
+
+} // namespace
+
+bool encode_rgb(int width, int height, const std::vector<unsigned char>& rgb, int quality,
+                std::vector<unsigned char>& jpeg) {
+    if (width <= 0 || height <= 0 || width > 65535 || height > 65535
+        || static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 3 != rgb.size()) {
+        return false;
+    }
+    quality = std::clamp(quality, 1, 100);
+
+    static const HuffmanTable luma_dc = build_huffman(kLumaDcBits, kDcValues);
+    static const HuffmanTable luma_ac = build_huffman(kLumaAcBits, kLumaAcValues);
+    static const HuffmanTable chroma_dc = build_huffman(kChromaDcBits, kDcValues);
+    static const HuffmanTable chroma_ac = build_huffman(kChromaAcBits, kChromaAcValues);
+    const std::array<std::uint8_t, kBlock> luma_quant = scaled_quant(kLumaQuant, quality);
+    const std::array<std::uint8_t, kBlock> chroma_quant = scaled_quant(kChromaQuant, quality);
+    const std::array<float, kBlock> luma_divisors = divisors(luma_quant);
+    const std::array<float, kBlock> chroma_divisors = divisors(chroma_quant);
+    const ColorKernel convert = color_kernels.active();
+    const DctKernel transform = dct_kernels.active();
+
+    jpeg.clear();
+    jpeg.reserve(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) / 4 + 1024);
+    write_headers(jpeg, width, height, luma_quant, chroma_quant);
+    BitWriter writer(jpeg);
+
+    // One MCU row at a time: full-resolution Y and chroma, edges replicated
+    // out to whole MCUs, then chroma averaged over 2x2 pixels
+    const std::size_t padded = static_cast<std::size_t>((width + kMcu - 1) / kMcu * kMcu);
+    std::vector<float> y_plane(padded * kMcu);
+    std::vector<float> cb_full(padded * kMcu);
+    std::vector<float> cr_full(padded * kMcu);
+    std::vector<float> cb_plane(padded / 2 * 8);
+    std::vector<float> cr_plane(padded / 2 * 8);
+    alignas(64) std::array<float, kBlock> block{};
+    alignas(64) std::array<std::int16_t, kBlock> coefficients{};
+    int dc_y = 0;
+    int dc_cb = 0;
+    int dc_cr = 0;
+
+    const auto load_block = [&block](const std::vector<float>& plane, std::size_t stride, std::size_t col) {
+        for (std::size_t row = 0; row < 8; ++row) {
+            std::copy_n(plane.data() + row * stride + col, 8, block.data() + row * 8);
+        }
+    };
+
+    for (int mcu_row = 0; mcu_row < height; mcu_row += kMcu) {
+        for (int row = 0; row < kMcu; ++row) {
+            const int source_row = std::min(mcu_row + row, height - 1);
+            const std::size_t offset = static_cast<std::size_t>(row) * padded;
+            convert(rgb.data() + static_cast<std::size_t>(source_row) * static_cast<std::size_t>(width) * 3,
+                    static_cast<std::size_t>(width), y_plane.data() + offset, cb_full.data() + offset,
+                    cr_full.data() + offset);
+            for (std::size_t col = static_cast<std::size_t>(width); col < padded; ++col) {
+                y_plane[offset + col] = y_plane[offset + col - 1];
+                cb_full[offset + col] = cb_full[offset + col - 1];
+                cr_full[offset + col] = cr_full[offset + col - 1];
+            }
+        }
+        const std::size_t half = padded / 2;
+        for (std::size_t row = 0; row < 8; ++row) {
+            const float* cb_top = cb_full.data() + 2 * row * padded;
+            const float* cr_top = cr_full.data() + 2 * row * padded;
+            for (std::size_t col = 0; col < half; ++col) {
+                cb_plane[row * half + col] = 0.25f * (cb_top[2 * col] + cb_top[2 * col + 1] + cb_top[padded + 2 * col]
+                                                      + cb_top[padded + 2 * col + 1]);
+                cr_plane[row * half + col] = 0.25f * (cr_top[2 * col] + cr_top[2 * col + 1] + cr_top[padded + 2 * col]
+                                                      + cr_top[padded + 2 * col + 1]);
+            }
+        }
+
+        for (std::size_t col = 0; col < padded; col += kMcu) {
+            for (const std::size_t y_offset : {std::size_t{0}, std::size_t{8}, 8 * padded, 8 * padded + 8}) {
+                load_block(y_plane, padded, y_offset + col);
+                transform(block.data(), luma_divisors.data(), coefficients.data());
+                encode_block(writer, coefficients.data(), dc_y, luma_dc, luma_ac);
+            }
+            load_block(cb_plane, half, col / 2);
+            transform(block.data(), chroma_divisors.data(), coefficients.data());
+            encode_block(writer, coefficients.data(), dc_cb, chroma_dc, chroma_ac);
+            load_block(cr_plane, half, col / 2);
+            transform(block.data(), chroma_divisors.data(), coefficients.data());
+            encode_block(writer, coefficients.data(), dc_cr, chroma_dc, chroma_ac);
+        }
+    }
+
+    writer.flush();
+    jpeg.push_back(0xFF);
+    jpeg.push_back(0xD9);
+    return true;
+}
+
+bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb,
+               int quality) {
+    std::vector<unsigned char> jpeg;
+    if (!encode_rgb(width, height, rgb, quality, jpeg)) {
+        return false;
+    }
+    std::ofstream out(filename, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(jpeg.data()), static_cast<std::streamsize>(jpeg.size()));
+    return static_cast<bool>(out);
+}
+
+} // namespace jpeg_writer
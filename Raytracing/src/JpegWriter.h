@@ -0,0 +1,40 @@
+#ifndef JPEG_WRITER_H
+#define JPEG_WRITER_H
+
+/**
+ * @file JpegWriter.h
+ * @brief Baseline JPEG encoder for 8-bit RGB previews.
+ *
+ * Writes baseline sequential JFIF with 4:2:0 chroma subsampling, the Annex K
+ * quantization tables scaled by quality as libjpeg does, and the Annex K
+ * Huffman tables, so no optimisation pass over the image is needed.
+ *
+ * Colour conversion and the forward DCT with quantization (the separable
+ * AAN float DCT, as libjpeg's jfdctflt) are written as loops over 8 lanes
+ * and compiled per ISA level (see CpuFeatures.h); every variant produces
+ * the same bytes. Huffman coding is scalar.
+ */
+
+#include <string>
+#include <vector>
+
+namespace jpeg_writer {
+
+/// Quality used when none is given: small files with no visible blocking on renders
+constexpr int kDefaultQuality = 90;
+
+/**
+ * Encode packed top-to-bottom RGB into a JPEG stream.
+ *
+ * @param quality 1 (smallest) to 100 (best), clamped
+ * @return false if the size is not positive, above 65535 or does not match `rgb`
+ */
+bool encode_rgb(int width, int height, const std::vector<unsigned char>& rgb, int quality,
+                std::vector<unsigned char>& jpeg);
+
+bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb,
+               int quality = kDefaultQuality);
+
+} // namespace jpeg_writer
+
+#endif
@@ -0,0 +1,272 @@
+#include "LightVisibilityGrid.h"
+
+#include "Light.h"
+#include "Parallel.h"
+#include "PrimitiveTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr std::size_t kBuildGrain = 256;
+// Shadow rays leave the surface 0.001 along the normal and stop 0.001 short
+// of the light, so they end within 0.002 of it; treat the light as a box
+constexpr double kLightRadius = 0.005;
+// Full occlusion needs the rectangle this far from the voxel and the light,
+// well past the renderer's 0.001 ray-distance bias
+constexpr double kOcclusionMargin = 0.01;
+// Slack on projected bounds for rounding in the voxel lookup
+constexpr double kTolerance = 1e-7;
+
+struct CellBox {
+    std::array<double, 3> lo;
+    std::array<double, 3> hi;
+};
+
+enum class Coverage {
+    Clear,    ///< Cannot cross any voxel-to-light segment
+    Partial,  ///< May cross some
+    Full      ///< Crosses every one
+};
+
+std::array<double, 3> to_array(const Vec3& value) {
+    return {{value.x(), value.y(), value.z()}};
+}
+
+/**
+ * Segments from the voxel to the light cross a rectangle's plane only from
+ * the part of the voxel on the far side of it. That part and the light box
+ * are convex and on opposite sides, so the crossing points are bounded by
+ * the crossings of their 8 x 8 corner pairs.
+ */
+Coverage rect_coverage(const RectPrimitive& rect, const CellBox& cell, const std::array<double, 3>& light) {
+    const int a = static_cast<int>(rect.orientation.normal_axis);
+    const int u = static_cast<int>(rect.orientation.tangent_u);
+    const int v = static_cast<int>(rect.orientation.tangent_v);
+    const double light_offset = light[a] - rect.k;
+    if (std::fabs(light_offset) <= kLightRadius) {
+        // The light touches the plane; only rule out rectangles far from it
+        const bool near_light = light[u] >= rect.u0 - kLightRadius && light[u] <= rect.u1 + kLightRadius
+                             && light[v] >= rect.v0 - kLightRadius && light[v] <= rect.v1 + kLightRadius;
+        return near_light ? Coverage::Partial : Coverage::Clear;
+    }
+
+    double far_lo = cell.lo[a];
+    double far_hi = cell.hi[a];
+    if (light_offset > 0.0) {
+        if (!(far_lo < rect.k)) {
+            return Coverage::Clear;
+        }
+        far_hi = std::min(far_hi, rect.k);
+    } else {
+        if (!(far_hi > rect.k)) {
+            return Coverage::Clear;
+        }
+        far_lo = std::max(far_lo, rect.k);
+    }
+
+    double u_min = std::numeric_limits<double>::infinity();
+    double u_max = -u_min;
+    double v_min = u_min;
+    double v_max = -u_min;
+    for (int corner = 0; corner < 8; ++corner) {
+        const double qa = (corner & 1) ? far_hi : far_lo;
+        const double qu = (corner & 2) ? cell.hi[u] : cell.lo[u];
+        const double qv = (corner & 4) ? cell.hi[v] : cell.lo[v];
+        for (int light_corner = 0; light_corner < 8; ++light_corner) {
+            const double la = light[a] + ((light_corner & 1) ? kLightRadius : -kLightRadius);
+            const double lu = light[u] + ((light_corner & 2) ? kLightRadius : -kLightRadius);
+            const double lv = light[v] + ((light_corner & 4) ? kLightRadius : -kLightRadius);
+            const double s = (la - rect.k) / (la - qa);
+            const double cu = lu + (qu - lu) * s;
+            const double cv = lv + (qv - lv) * s;
+            u_min = std::min(u_min, cu);
+            u_max = std::max(u_max, cu);
+            v_min = std::min(v_min, cv);
+            v_max = std::max(v_max, cv);
+        }
+    }
+
+    if (u_max < rect.u0 - kTolerance || u_min > rect.u1 + kTolerance
+        || v_max < rect.v0 - kTolerance || v_min > rect.v1 + kTolerance) {
+        return Coverage::Clear;
+    }
+
+    const bool whole_cell_beyond = light_offset > 0.0 ? cell.hi[a] <= rect.k - kOcclusionMargin
+                                                      : cell.lo[a] >= rect.k + kOcclusionMargin;
+    if (whole_cell_beyond && std::fabs(light_offset) >= kLightRadius + kOcclusionMargin
+        && u_min >= rect.u0 + kTolerance && u_max <= rect.u1 - kTolerance
+        && v_min >= rect.v0 + kTolerance && v_max <= rect.v1 - kTolerance) {
+        return Coverage::Full;
+    }
+    return Coverage::Partial;
+}
+
+/**
+ * The voxel-to-light hull lies within a capsule around the segment from the
+ * voxel centre to the light, as wide as the voxel's half diagonal.
+ */
+Coverage sphere_coverage(const SpherePrimitive& sphere, const CellBox& cell, const Point3& light) {
+    const Point3 center(0.5 * (cell.lo[0] + cell.hi[0]), 0.5 * (cell.lo[1] + cell.hi[1]),
+                        0.5 * (cell.lo[2] + cell.hi[2]));
+    const Vec3 half_diagonal(0.5 * (cell.hi[0] - cell.lo[0]), 0.5 * (cell.hi[1] - cell.lo[1]),
+                             0.5 * (cell.hi[2] - cell.lo[2]));
+    const double capsule_radius = half_diagonal.length() + std::sqrt(3.0) * kLightRadius + kTolerance;
+
+    const Vec3 axis = light - center;
+    const double axis_length_squared = axis.length_squared();
+    const double along = axis_length_squared > 0.0
+        ? std::clamp(dot(sphere.center - center, axis) / axis_length_squared, 0.0, 1.0)
+        : 0.0;
+    const double distance = (sphere.center - (center + along * axis)).length();
+    return distance > sphere.radius + capsule_radius ? Coverage::Clear : Coverage::Partial;
+}
+
+/**
+ * Segments between points of the closed room box and a light strictly
+ * inside it never leave the box, so they cannot cross its shell.
+ */
+Coverage enclosure_coverage(const EnclosurePrimitive& enclosure, const CellBox& cell,
+                            const std::array<double, 3>& light) {
+    const std::array<double, 3> lo = to_array(enclosure.lo);
+    const std::array<double, 3> hi = to_array(enclosure.hi);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (cell.lo[axis] < lo[axis] || cell.hi[axis] > hi[axis]
+            || light[axis] - kLightRadius <= lo[axis] || light[axis] + kLightRadius >= hi[axis]) {
+            return Coverage::Partial;
+        }
+    }
+    return Coverage::Clear;
+}
+
+LightVisibility classify_cell(const std::vector<PackedPrimitive>& primitives, const CellBox& cell,
+                              const Point3& light) {
+    const std::array<double, 3> light_coordinates = to_array(light);
+    bool may_block = false;
+    for (const PackedPrimitive& primitive : primitives) {
+        Coverage coverage = Coverage::Partial;
+        if (const auto* rect = std::get_if<RectPrimitive>(&primitive.shape)) {
+            coverage = rect_coverage(*rect, cell, light_coordinates);
+        } else if (const auto* sphere = std::get_if<SpherePrimitive>(&primitive.shape)) {
+            coverage = sphere_coverage(*sphere, cell, light);
+        } else if (const auto* enclosure = std::get_if<EnclosurePrimitive>(&primitive.shape)) {
+            coverage = enclosure_coverage(*enclosure, cell, light_coordinates);
+        }
+        if (coverage == Coverage::Full) {
+            return LightVisibility::Occluded;
+        }
+        may_block = may_block || coverage == Coverage::Partial;
+    }
+    return may_block ? LightVisibility::Mixed : LightVisibility::Visible;
+}
+
+bool primitive_bounds(const PackedPrimitive& primitive, std::array<double, 3>& lo, std::array<double, 3>& hi) {
+    if (const auto* sphere = std::get_if<SpherePrimitive>(&primitive.shape)) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const double center = to_array(sphere->center)[axis];
+            lo[axis] = center - sphere->radius;
+            hi[axis] = center + sphere->radius;
+        }
+        return true;
+    }
+    if (const auto* rect = std::get_if<RectPrimitive>(&primitive.shape)) {
+        const int a = static_cast<int>(rect->orientation.normal_axis);
+        const int u = static_cast<int>(rect->orientation.tangent_u);
+        const int v = static_cast<int>(rect->orientation.tangent_v);
+        lo[a] = hi[a] = rect->k;
+        lo[u] = rect->u0;
+        hi[u] = rect->u1;
+        lo[v] = rect->v0;
+        hi[v] = rect->v1;
+        return true;
+    }
+    if (const auto* enclosure = std::get_if<EnclosurePrimitive>(&primitive.shape)) {
+        lo = to_array(enclosure->lo);
+        hi = to_array(enclosure->hi);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void LightVisibilityGrid::build(const PrimitiveTable& table, const std::vector<Light>& scene_lights,
+                                const LightVisibilitySettings& settings) {
+    states.clear();
+    resolution = {{0, 0, 0}};
+    lights = scene_lights.size();
+    const std::vector<PackedPrimitive>& primitives = table.primitives();
+    if (primitives.empty() || scene_lights.empty()) {
+        return;
+    }
+
+    std::array<double, 3> lo{{std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(),
+                              std::numeric_limits<double>::infinity()}};
+    std::array<double, 3> hi{{-lo[0], -lo[1], -lo[2]}};
+    for (const PackedPrimitive& primitive : primitives) {
+        std::array<double, 3> primitive_lo;
+        std::array<double, 3> primitive_hi;
+        if (!primitive_bounds(primitive, primitive_lo, primitive_hi)) {
+            return;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            lo[axis] = std::min(lo[axis], primitive_lo[axis]);
+            hi[axis] = std::max(hi[axis], primitive_hi[axis]);
+        }
+    }
+
+    double cell_size = std::max(settings.cell_size, 1e-3);
+    std::array<double, 3> extent;
+    for (int axis = 0; axis < 3; ++axis) {
+        // A flat scene still needs a slab one voxel thick
+        extent[axis] = std::max(hi[axis] - lo[axis], 1e-6);
+    }
+    for (;;) {
+        std::size_t cells = lights;
+        for (int axis = 0; axis < 3; ++axis) {
+            resolution[axis] = std::max(1, static_cast<int>(std::ceil(extent[axis] / cell_size)));
+            cells *= static_cast<std::size_t>(resolution[axis]);
+        }
+        if (cells <= std::max<std::size_t>(settings.max_cells, 1) * lights) {
+            break;
+        }
+        cell_size *= 1.25;
+    }
+
+    bounds_min = Point3(lo[0], lo[1], lo[2]);
+    for (int axis = 0; axis < 3; ++axis) {
+        cell_extent[axis] = extent[axis] / resolution[axis];
+        inverse_cell[axis] = resolution[axis] / extent[axis];
+    }
+
+    const std::size_t cell_total = static_cast<std::size_t>(resolution[0]) * static_cast<std::size_t>(resolution[1])
+                                 * static_cast<std::size_t>(resolution[2]);
+    states.assign(cell_total * lights, static_cast<std::uint8_t>(LightVisibility::Mixed));
+    parallel_for(0, cell_total, kBuildGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t cell = first; cell < last; ++cell) {
+            const std::size_t index[3] = {
+                cell % static_cast<std::size_t>(resolution[0]),
+                (cell / static_cast<std::size_t>(resolution[0])) % static_cast<std::size_t>(resolution[1]),
+                cell / (static_cast<std::size_t>(resolution[0]) * static_cast<std::size_t>(resolution[1]))
+            };
+            CellBox box;
+            for (int axis = 0; axis < 3; ++axis) {
+                box.lo[axis] = lo[axis] + static_cast<double>(index[axis]) * cell_extent[axis];
+                // The last voxel ends exactly on the bounds, so boundary planes stay outside it
+                box.hi[axis] = index[axis] + 1 == static_cast<std::size_t>(resolution[axis])
+                    ? lo[axis] + extent[axis]
+                    : lo[axis] + static_cast<double>(index[axis] + 1) * cell_extent[axis];
+            }
+            for (std::size_t light = 0; light < lights; ++light) {
+                states[cell * lights + light] = static_cast<std::uint8_t>(
+                    classify_cell(primitives, box, scene_lights[light].position));
+            }
+        }
+    });
+}
+
+std::size_t LightVisibilityGrid::count(LightVisibility state) const {
+    return static_cast<std::size_t>(std::count(states.begin(), states.end(), static_cast<std::uint8_t>(state)));
+}
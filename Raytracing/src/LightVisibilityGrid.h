@@ -0,0 +1,103 @@
+#ifndef LIGHT_VISIBILITY_GRID_H
+#define LIGHT_VISIBILITY_GRID_H
+
+/**
+ * @file LightVisibilityGrid.h
+ * @brief Precomputed per-cell shadow classification for static point lights.
+ *
+ * The scene bounds are cut into voxels and every (voxel, light) pair is
+ * classified once:
+ * - Visible: no primitive can cross a segment from any point of the voxel
+ *   to the light,
+ * - Occluded: a single rectangle crosses every such segment,
+ * - Mixed: anything else.
+ * Both definite answers are conservative, so skipping the shadow ray in
+ * those cells gives exactly the answer the ray would have. The grid only
+ * depends on geometry and lights, so one build serves every frame and
+ * camera until the scene changes.
+ */
+
+#include "Vec3.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PrimitiveTable;
+struct Light;
+
+/**
+ * Shadow state of one light as seen from one voxel.
+ */
+enum class LightVisibility : std::uint8_t {
+    Mixed = 0,     ///< Trace the shadow ray
+    Visible = 1,   ///< Every shadow ray from the voxel reaches the light
+    Occluded = 2   ///< Every shadow ray from the voxel is blocked
+};
+
+/**
+ * Voxel size and memory cap.
+ */
+struct LightVisibilitySettings {
+    bool enabled = false;               ///< Build a grid for the scene before rendering
+    double cell_size = 0.25;            ///< Target voxel edge in world units
+    std::size_t max_cells = 1u << 20;   ///< Cells grow past cell_size until the grid fits
+};
+
+/**
+ * Dense voxel grid over the primitive bounds with one LightVisibility per
+ * voxel and light.
+ */
+class LightVisibilityGrid {
+public:
+    /**
+     * Classify every voxel against every light, in parallel. Scenes with
+     * extension primitives (unknown shape) get an empty grid, which
+     * answers Mixed everywhere.
+     */
+    void build(const PrimitiveTable& table, const std::vector<Light>& lights,
+               const LightVisibilitySettings& settings);
+
+    /**
+     * Shadow state for a shadow ray starting at `point` toward light
+     * `light_index`. Points outside the grid are Mixed.
+     */
+    LightVisibility classify(const Point3& point, std::size_t light_index) const {
+        if (states.empty()) {
+            return LightVisibility::Mixed;
+        }
+        const double fx = (point.x() - bounds_min.x()) * inverse_cell[0];
+        const double fy = (point.y() - bounds_min.y()) * inverse_cell[1];
+        const double fz = (point.z() - bounds_min.z()) * inverse_cell[2];
+        // Negated comparisons also reject NaN
+        if (!(fx >= 0.0 && fy >= 0.0 && fz >= 0.0 && fx < resolution[0] && fy < resolution[1]
+              && fz < resolution[2])) {
+            return LightVisibility::Mixed;
+        }
+        const std::size_t cell = (static_cast<std::size_t>(fz) * static_cast<std::size_t>(resolution[1])
+                                  + static_cast<std::size_t>(fy)) * static_cast<std::size_t>(resolution[0])
+                               + static_cast<std::size_t>(fx);
+        return static_cast<LightVisibility>(states[cell * lights + light_index]);
+    }
+
+    bool empty() const { return states.empty(); }
+    std::size_t light_count() const { return lights; }
+    std::size_t cell_count() const { return states.size() / (lights == 0 ? 1 : lights); }
+    const std::array<int, 3>& dimensions() const { return resolution; }
+
+    /**
+     * Number of (voxel, light) pairs in `state`.
+     */
+    std::size_t count(LightVisibility state) const;
+
+private:
+    Point3 bounds_min;
+    std::array<double, 3> cell_extent{{0.0, 0.0, 0.0}};
+    std::array<double, 3> inverse_cell{{0.0, 0.0, 0.0}};
+    std::array<int, 3> resolution{{0, 0, 0}};
+    std::size_t lights = 0;
+    std::vector<std::uint8_t> states;  ///< LightVisibility per (cell, light), light fastest
+};
+
+#endif
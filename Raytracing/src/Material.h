@@ -6,6 +6,7 @@
  * @brief Surface interaction models for the ray tracer.
  */
 
+#include "FastMath.h"
 #include "Ray.h"
 #include "Vec3.h"
 #include "Utils.h"
@@ -20,6 +21,93 @@ struct ScatterRecord {
     bool did_scatter;       // Did the ray scatter or was it absorbed?
 };
 
+// ========== Scatter Kernels ==========
+// Shared by the virtual Material classes below and by the packed material
+// table (PackedMaterial.h), so both dispatch paths run identical math.
+
+/**
+ * Lambertian scatter: cosine-weighted hemisphere sampling around the normal.
+ */
+inline bool scatter_matte(const Color& albedo, const HitRecord& hit_info,
+                          ScatterRecord& scatter_record) {
+    // Use cosine-weighted hemisphere sampling for better quality
+    // This significantly reduces noise compared to random_unit_vector()
+    // Sampled in the hit's local frame: the result is already unit length,
+    // so no normalization or degenerate-direction check is needed
+    const Vec3 scatter_direction = hit_info.shading_frame.to_world(random_cosine_direction_local());
+    
+    scatter_record.scattered_ray = Ray(hit_info.hit_point, scatter_direction);
+    scatter_record.attenuation = albedo;
+    scatter_record.did_scatter = true;
+    
+    return true;
+}
+
+/**
+ * Mirror reflection perturbed by a fuzz sphere.
+ */
+inline bool scatter_reflective(const Color& albedo, double fuzziness, const Ray& ray_in,
+                               const HitRecord& hit_info, ScatterRecord& scatter_record) {
+    // Reflect the ray direction around the surface normal
+    Vec3 reflected_direction = reflect(unit_vector(ray_in.direction()), 
+                                      hit_info.surface_normal);
+    
+    // Add fuzziness by randomly perturbing the reflection
+    reflected_direction = reflected_direction + fuzziness * random_unit_vector();
+    
+    scatter_record.scattered_ray = Ray(hit_info.hit_point, reflected_direction);
+    scatter_record.attenuation = albedo;
+    scatter_record.did_scatter = dot(reflected_direction, hit_info.surface_normal) > 0;
+    
+    return scatter_record.did_scatter;
+}
+
+/**
+ * Schlick's approximation for reflectance.
+ * Calculates how much light is reflected vs refracted at different angles.
+ */
+inline double schlick_reflectance(double cosine, double refraction_index) {
+    double r0 = (1 - refraction_index) / (1 + refraction_index);
+    r0 = r0 * r0;
+    return r0 + (1 - r0) * fast_math::pow5(1 - cosine);
+}
+
+/**
+ * Dielectric scatter: Fresnel-weighted choice between reflection and refraction.
+ */
+inline bool scatter_transparent(double refractive_index, const Ray& ray_in,
+                                const HitRecord& hit_info, ScatterRecord& scatter_record) {
+    scatter_record.attenuation = Color(1.0, 1.0, 1.0);  // Glass doesn't absorb light
+    
+    // Calculate the ratio of refractive indices
+    double refraction_ratio = hit_info.is_front_face 
+        ? (1.0 / refractive_index)  // Air to glass
+        : refractive_index;          // Glass to air
+    
+    Vec3 unit_direction = unit_vector(ray_in.direction());
+    
+    // Calculate cosine of angle between ray and normal
+    double cos_theta = std::fmin(dot(-unit_direction, hit_info.surface_normal), 1.0);
+    double sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
+    
+    // Check if refraction is possible (or if we should reflect instead)
+    bool cannot_refract = refraction_ratio * sin_theta > 1.0;
+    Vec3 direction;
+    
+    if (cannot_refract || schlick_reflectance(cos_theta, refraction_ratio) > random_double()) {
+        // Must reflect (total internal reflection or Fresnel reflection)
+        direction = reflect(unit_direction, hit_info.surface_normal);
+    } else {
+        // Can refract
+        direction = refract(unit_direction, hit_info.surface_normal, refraction_ratio);
+    }
+    
+    scatter_record.scattered_ray = Ray(hit_info.hit_point, direction);
+    scatter_record.did_scatter = true;
+    
+    return true;
+}
+
 /**
  * Base class for different material types.
  * Materials define how rays interact with surfaces.
@@ -64,21 +152,7 @@ public:
     bool scatter(const Ray& ray_in, const HitRecord& hit_info, 
                 ScatterRecord& scatter_record) const override {
         (void)ray_in;  // Not used for matte materials
-        
-        // Use cosine-weighted hemisphere sampling for better quality
-        // This significantly reduces noise compared to random_unit_vector()
-        Vec3 scatter_direction = random_cosine_direction(hit_info.surface_normal);
-        
-        // Catch degenerate scatter direction
-        if (is_near_zero(scatter_direction)) {
-            scatter_direction = hit_info.surface_normal;
-        }
-        
-        scatter_record.scattered_ray = Ray(hit_info.hit_point, scatter_direction);
-        scatter_record.attenuation = surface_color;
-        scatter_record.did_scatter = true;
-        
-        return true;
+        return scatter_matte(surface_color, hit_info, scatter_record);
     }
 
     Color base_color() const override {
@@ -104,18 +178,7 @@ public:
     
     bool scatter(const Ray& ray_in, const HitRecord& hit_info, 
                 ScatterRecord& scatter_record) const override {
-        // Reflect the ray direction around the surface normal
-        Vec3 reflected_direction = reflect(unit_vector(ray_in.direction()), 
-                                          hit_info.surface_normal);
-        
-        // Add fuzziness by randomly perturbing the reflection
-        reflected_direction = reflected_direction + fuzziness * random_unit_vector();
-        
-        scatter_record.scattered_ray = Ray(hit_info.hit_point, reflected_direction);
-        scatter_record.attenuation = surface_color;
-        scatter_record.did_scatter = dot(reflected_direction, hit_info.surface_normal) > 0;
-        
-        return scatter_record.did_scatter;
+        return scatter_reflective(surface_color, fuzziness, ray_in, hit_info, scatter_record);
     }
 
     Color base_color() const override {
@@ -135,49 +198,9 @@ public:
     
     bool scatter(const Ray& ray_in, const HitRecord& hit_info, 
                 ScatterRecord& scatter_record) const override {
-        scatter_record.attenuation = Color(1.0, 1.0, 1.0);  // Glass doesn't absorb light
-        
-        // Calculate the ratio of refractive indices
-        double refraction_ratio = hit_info.is_front_face 
-            ? (1.0 / refractive_index)  // Air to glass
-            : refractive_index;          // Glass to air
-        
-        Vec3 unit_direction = unit_vector(ray_in.direction());
-        
-        // Calculate cosine of angle between ray and normal
-        double cos_theta = std::fmin(dot(-unit_direction, hit_info.surface_normal), 1.0);
-        double sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
-        
-        // Check if refraction is possible (or if we should reflect instead)
-        bool cannot_refract = refraction_ratio * sin_theta > 1.0;
-        Vec3 direction;
-        
-        if (cannot_refract || reflectance(cos_theta, refraction_ratio) > random_double()) {
-            // Must reflect (total internal reflection or Fresnel reflection)
-            direction = reflect(unit_direction, hit_info.surface_normal);
-        } else {
-            // Can refract
-            direction = refract(unit_direction, hit_info.surface_normal, refraction_ratio);
-        }
-        
-        scatter_record.scattered_ray = Ray(hit_info.hit_point, direction);
-        scatter_record.did_scatter = true;
-        
-        return true;
-    }
-
-private:
-    /**
-     * Schlick's approximation for reflectance.
-     * Calculates how much light is reflected vs refracted at different angles.
-     */
-    static double reflectance(double cosine, double refraction_index) {
-        double r0 = (1 - refraction_index) / (1 + refraction_index);
-        r0 = r0 * r0;
-        return r0 + (1 - r0) * std::pow((1 - cosine), 5);
+        return scatter_transparent(refractive_index, ray_in, hit_info, scatter_record);
     }
 
-public:
     Color base_color() const override {
         return Color(1.0, 1.0, 1.0);
     }
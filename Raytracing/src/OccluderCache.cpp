@@ -0,0 +1,74 @@
+#include "OccluderCache.h"
+
+#include "RayStatistics.h"
+#include "Scene.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace occluder_cache {
+
+namespace {
+
+constexpr std::uint32_t kNoOccluder = 0xFFFFFFFFu;
+
+/**
+ * Last blocking primitive per light for the table it was recorded against.
+ * Indices are re-checked against the table size, so a table rebuilt in
+ * place only costs a wasted test, never a wrong answer.
+ */
+struct ThreadCache {
+    const PrimitiveTable* table = nullptr;
+    std::vector<std::uint32_t> last_occluder;
+
+    std::uint32_t& slot(const PrimitiveTable& current, std::size_t light_index) {
+        if (table != &current) {
+            table = &current;
+            last_occluder.assign(last_occluder.size(), kNoOccluder);
+        }
+        if (light_index >= last_occluder.size()) {
+            last_occluder.resize(light_index + 1, kNoOccluder);
+        }
+        return last_occluder[light_index];
+    }
+};
+
+thread_local ThreadCache thread_cache;
+
+} // namespace
+
+bool occluded(const Scene& scene, std::size_t light_index, const Ray& ray,
+              double min_distance, double max_distance) {
+    ray_statistics::add(ray_statistics::ShadowRays);
+    HitCandidate candidate;
+
+    if (!enabled()) {
+        const bool blocked = scene.intersect(ray, min_distance, max_distance, candidate);
+        if (blocked) {
+            ray_statistics::add(ray_statistics::ShadowRaysOccluded);
+        }
+        return blocked;
+    }
+
+    const PrimitiveTable& table = scene.dispatch_table;
+    std::uint32_t& cached = thread_cache.slot(table, light_index);
+    if (cached < table.primitive_count()) {
+        ray_statistics::add(ray_statistics::OccluderCacheTests);
+        if (table.intersect_primitive(cached, ray, min_distance, max_distance, candidate)) {
+            ray_statistics::add(ray_statistics::OccluderCacheHits);
+            ray_statistics::add(ray_statistics::ShadowRaysOccluded);
+            return true;
+        }
+    }
+
+    if (!scene.intersect(ray, min_distance, max_distance, candidate)) {
+        // Lit points come in runs too; don't make each of them pay for a stale test
+        cached = kNoOccluder;
+        return false;
+    }
+    cached = candidate.primitive_index;
+    ray_statistics::add(ray_statistics::ShadowRaysOccluded);
+    return true;
+}
+
+} // namespace occluder_cache
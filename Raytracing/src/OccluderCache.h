@@ -0,0 +1,83 @@
+#ifndef OCCLUDER_CACHE_H
+#define OCCLUDER_CACHE_H
+
+/**
+ * @file OccluderCache.h
+ * @brief Per-thread "last occluder" memory for point-light shadow rays.
+ *
+ * Shadow rays from neighbouring diffuse hits toward the same light are
+ * usually blocked by the same primitive (the table top over the floor, a
+ * cabinet side). Each thread remembers, per light, the primitive that last
+ * blocked its previous shadow ray and tests that primitive alone before
+ * running the full traversal; an unblocked ray clears the slot, so lit
+ * regions pay nothing. Occlusion is a yes/no answer, so any blocker
+ * will do and the image is unchanged; only the cost of shadowed rays drops.
+ * Tests and hits are counted in ray_statistics.
+ */
+
+#include "Ray.h"
+
+#include <atomic>
+#include <cstddef>
+
+struct Scene;
+
+namespace occluder_cache {
+
+/**
+ * Process-wide default of whether occluded() consults the cache
+ * (RenderConfig::occluder_cache); renders override it per thread with
+ * ScopedEnabled.
+ */
+inline std::atomic<bool> enabled_flag{true};
+
+/**
+ * This thread's setting while a ScopedEnabled is alive: 0 or 1, else -1.
+ */
+inline thread_local signed char thread_enabled = -1;
+
+inline void set_enabled(bool enabled) {
+    enabled_flag.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * Setting in effect on the calling thread.
+ */
+inline bool enabled() {
+    const signed char local = thread_enabled;
+    return local >= 0 ? local != 0 : enabled_flag.load(std::memory_order_relaxed);
+}
+
+/**
+ * Sets the switch on the calling thread only, for the object's lifetime.
+ */
+class ScopedEnabled {
+public:
+    explicit ScopedEnabled(bool enabled)
+        : previous(thread_enabled) {
+        thread_enabled = enabled ? 1 : 0;
+    }
+    ~ScopedEnabled() { thread_enabled = previous; }
+
+    ScopedEnabled(const ScopedEnabled&) = delete;
+    ScopedEnabled& operator=(const ScopedEnabled&) = delete;
+
+private:
+    signed char previous;
+};
+
+/**
+ * Is anything hit by `ray` between `min_distance` and `max_distance`?
+ *
+ * @param scene Committed scene
+ * @param light_index Index of the light the ray points at, selects the cache slot
+ * @param ray Shadow ray
+ * @param min_distance Ignore hits closer than this
+ * @param max_distance Ignore hits at or beyond the light
+ */
+bool occluded(const Scene& scene, std::size_t light_index, const Ray& ray,
+              double min_distance, double max_distance);
+
+} // namespace occluder_cache
+
+#endif
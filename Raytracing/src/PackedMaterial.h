@@ -0,0 +1,118 @@
+#ifndef PACKED_MATERIAL_H
+#define PACKED_MATERIAL_H
+
+/**
+ * @file PackedMaterial.h
+ * @brief Tagged-union representation of the built-in materials.
+ */
+
+#include "Hittable.h"
+#include "Material.h"
+#include "Ray.h"
+#include "Vec3.h"
+
+#include <cstdint>
+#include <typeinfo>
+
+/**
+ * Closed set of material models known to the renderer.
+ * Anything else is an extension and goes through the virtual Material API.
+ */
+enum class MaterialKind : std::uint8_t {
+    Matte,
+    Reflective,
+    Transparent,
+    Extension
+};
+
+/**
+ * Flat material entry stored contiguously in the PrimitiveTable.
+ * The meaning of `parameter` depends on `kind`:
+ * - Reflective: fuzziness
+ * - Transparent: refractive index
+ */
+struct PackedMaterial {
+    MaterialKind kind = MaterialKind::Extension;
+    Color albedo;
+    double parameter = 0.0;
+    const Material* source = nullptr;  // Original object, used for extensions
+};
+
+/**
+ * Build the packed form of a material, recognising the built-in types by
+ * exact type; subclasses may override scatter() and stay extensions.
+ */
+inline PackedMaterial pack_material(const Material* material) {
+    PackedMaterial packed;
+    packed.source = material;
+    if (material == nullptr) {
+        return packed;
+    }
+    const std::type_info& type = typeid(*material);
+    if (type == typeid(Matte)) {
+        const auto* matte = static_cast<const Matte*>(material);
+        packed.kind = MaterialKind::Matte;
+        packed.albedo = matte->surface_color;
+    } else if (type == typeid(Reflective)) {
+        const auto* reflective = static_cast<const Reflective*>(material);
+        packed.kind = MaterialKind::Reflective;
+        packed.albedo = reflective->surface_color;
+        packed.parameter = reflective->fuzziness;
+    } else if (type == typeid(Transparent)) {
+        const auto* transparent = static_cast<const Transparent*>(material);
+        packed.kind = MaterialKind::Transparent;
+        packed.albedo = Color(1.0, 1.0, 1.0);
+        packed.parameter = transparent->refractive_index;
+    }
+    return packed;
+}
+
+// ========== Surface Dispatch ==========
+// The renderer calls these instead of the virtual Material methods.
+// Built-in materials are handled by a switch on the tag; only hits whose
+// material is an extension fall back to virtual calls.
+
+/**
+ * Scatter a ray at a surface interaction.
+ */
+inline bool surface_scatter(const Ray& ray_in, const HitRecord& hit_info,
+                            ScatterRecord& scatter_record) {
+    const PackedMaterial* packed = hit_info.packed_material;
+    if (packed != nullptr) {
+        switch (packed->kind) {
+        case MaterialKind::Matte:
+            return scatter_matte(packed->albedo, hit_info, scatter_record);
+        case MaterialKind::Reflective:
+            return scatter_reflective(packed->albedo, packed->parameter, ray_in, hit_info, scatter_record);
+        case MaterialKind::Transparent:
+            return scatter_transparent(packed->parameter, ray_in, hit_info, scatter_record);
+        case MaterialKind::Extension:
+            break;
+        }
+    }
+    return hit_info.material_ptr->scatter(ray_in, hit_info, scatter_record);
+}
+
+/**
+ * Base surface color used for direct lighting computations.
+ */
+inline Color surface_base_color(const HitRecord& hit_info) {
+    const PackedMaterial* packed = hit_info.packed_material;
+    if (packed != nullptr && packed->kind != MaterialKind::Extension) {
+        return packed->albedo;
+    }
+    return hit_info.material_ptr->base_color();
+}
+
+/**
+ * Whether the surface responds to direct diffuse lighting.
+ */
+inline bool surface_is_diffuse(const HitRecord& hit_info) {
+    const PackedMaterial* packed = hit_info.packed_material;
+    if (packed != nullptr && packed->kind != MaterialKind::Extension) {
+        return packed->kind == MaterialKind::Matte;
+    }
+    return hit_info.material_ptr->is_diffuse();
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include "PageCache.h"
+
+#include <algorithm>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RAYTRACER_PAGE_CACHE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define RAYTRACER_PAGE_CACHE_MMAP 0
+#endif
+
+PageCache::Page::~Page() {
+#if RAYTRACER_PAGE_CACHE_MMAP
+    if (mapping != nullptr) {
+        munmap(mapping, mapping_bytes);
+    }
+#endif
+}
+
+PageCache::~PageCache() {
+    close();
+}
+
+void PageCache::close() {
+    slots.clear();
+    recency.clear();
+    ranges.clear();
+#if RAYTRACER_PAGE_CACHE_MMAP
+    if (descriptor >= 0) {
+        ::close(descriptor);
+    }
+#endif
+    descriptor = -1;
+    counters = PageCacheStats();
+}
+
+bool PageCache::open(const std::string& path, const std::vector<PageRange>& pages, std::size_t byte_budget) {
+    std::lock_guard<std::mutex> lock(mutex);
+    close();
+    std::uint64_t file_bytes = 0;
+#if RAYTRACER_PAGE_CACHE_MMAP
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+        close();
+        return false;
+    }
+    file_bytes = static_cast<std::uint64_t>(status.st_size);
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return false;
+    }
+    file_bytes = static_cast<std::uint64_t>(in.tellg());
+#endif
+    for (const PageRange& range : pages) {
+        if (range.bytes == 0 || range.offset > file_bytes || range.bytes > file_bytes - range.offset) {
+            close();
+            return false;
+        }
+    }
+    file_path = path;
+    ranges = pages;
+    slots.assign(pages.size(), Slot());
+    budget_bytes = byte_budget;
+    return true;
+}
+
+std::shared_ptr<const PageCache::Page> PageCache::load(std::uint32_t page) const {
+    const PageRange& range = ranges[page];
+    auto loaded = std::make_shared<Page>();
+    loaded->byte_count = static_cast<std::size_t>(range.bytes);
+#if RAYTRACER_PAGE_CACHE_MMAP
+    // Map from the enclosing system page; MAP_POPULATE reads it all in now,
+    // elsewhere the first traversal faults it in
+    const std::uint64_t system_page = static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+    const std::uint64_t start = range.offset - range.offset % system_page;
+    int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    flags |= MAP_POPULATE;
+#endif
+    loaded->mapping_bytes = static_cast<std::size_t>(range.offset - start + range.bytes);
+    void* mapping = mmap(nullptr, loaded->mapping_bytes, PROT_READ, flags, descriptor, static_cast<off_t>(start));
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    loaded->mapping = mapping;
+    loaded->bytes = static_cast<const unsigned char*>(mapping) + (range.offset - start);
+#else
+    std::ifstream in(file_path, std::ios::binary);
+    loaded->buffer.resize(loaded->byte_count);
+    in.seekg(static_cast<std::streamoff>(range.offset));
+    if (!in.read(reinterpret_cast<char*>(loaded->buffer.data()), static_cast<std::streamsize>(range.bytes))) {
+        return nullptr;
+    }
+    loaded->bytes = loaded->buffer.data();
+#endif
+    return loaded;
+}
+
+void PageCache::touch(std::uint32_t page) {
+    recency.splice(recency.begin(), recency, slots[page].position);
+}
+
+std::shared_ptr<const PageCache::Page> PageCache::acquire_if_resident(std::uint32_t page) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!slots[page].page) {
+        return nullptr;
+    }
+    ++counters.hits;
+    touch(page);
+    return slots[page].page;
+}
+
+std::shared_ptr<const PageCache::Page> PageCache::acquire(std::uint32_t page) {
+    // Loads happen under the lock: with a budget that fits the working set
+    // misses are rare, and a second thread wanting the same page waits for
+    // it instead of reading it twice
+    std::lock_guard<std::mutex> lock(mutex);
+    Slot& slot = slots[page];
+    if (slot.page) {
+        ++counters.hits;
+        touch(page);
+        return slot.page;
+    }
+    ++counters.misses;
+    const std::size_t bytes = static_cast<std::size_t>(ranges[page].bytes);
+    while (!recency.empty() && counters.resident_bytes + bytes > budget_bytes) {
+        const std::uint32_t victim = recency.back();
+        recency.pop_back();
+        slots[victim].page.reset();
+        counters.resident_bytes -= static_cast<std::size_t>(ranges[victim].bytes);
+        ++counters.evictions;
+    }
+    std::shared_ptr<const Page> loaded = load(page);
+    if (!loaded) {
+        return nullptr;
+    }
+    slot.page = loaded;
+    recency.push_front(page);
+    slot.position = recency.begin();
+    counters.resident_bytes += bytes;
+    counters.peak_bytes = std::max(counters.peak_bytes, counters.resident_bytes);
+    return loaded;
+}
+
+PageCacheStats PageCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void PageCache::reset_stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::size_t resident = counters.resident_bytes;
+    counters = PageCacheStats();
+    counters.resident_bytes = resident;
+    counters.peak_bytes = resident;
+}
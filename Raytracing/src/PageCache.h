@@ -0,0 +1,124 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+/**
+ * @file PageCache.h
+ * @brief Least-recently-used cache of read-only file pages under a byte budget.
+ *
+ * A page is a byte range of one file, listed when the cache is opened.
+ * acquire() maps a page into memory on first use, reading it in completely,
+ * and keeps it mapped until room is needed: before a load would push the
+ * mapped bytes over the budget, the least recently used pages are unmapped.
+ * A page handed out stays valid while the caller holds it, even if the cache
+ * evicts it meanwhile, so the budget can be exceeded by the pages in use at
+ * that moment. All members are thread-safe.
+ *
+ * Pages are mapped with mmap where POSIX is available and read into heap
+ * buffers elsewhere.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Byte range of one page in the file.
+ */
+struct PageRange {
+    std::uint64_t offset;
+    std::uint64_t bytes;
+};
+
+/**
+ * Counters since open() or the last reset_stats().
+ */
+struct PageCacheStats {
+    std::uint64_t hits = 0;        ///< acquire() calls served from memory
+    std::uint64_t misses = 0;      ///< acquire() calls that loaded the page
+    std::uint64_t evictions = 0;   ///< Pages unmapped to make room
+    std::size_t resident_bytes = 0;
+    std::size_t peak_bytes = 0;    ///< Highest resident_bytes seen
+};
+
+class PageCache {
+public:
+    /**
+     * One mapped page; unmapped when the last holder lets go.
+     */
+    class Page {
+    public:
+        Page() = default;
+        Page(const Page&) = delete;
+        Page& operator=(const Page&) = delete;
+        ~Page();
+
+        const unsigned char* data() const { return bytes; }
+        std::size_t size() const { return byte_count; }
+
+    private:
+        friend class PageCache;
+
+        void* mapping = nullptr;          ///< Start of the mmap region, if mapped
+        std::size_t mapping_bytes = 0;
+        std::vector<unsigned char> buffer; ///< Page contents where mmap is not used
+        const unsigned char* bytes = nullptr;
+        std::size_t byte_count = 0;
+    };
+
+    PageCache() = default;
+    PageCache(const PageCache&) = delete;
+    PageCache& operator=(const PageCache&) = delete;
+    ~PageCache();
+
+    /**
+     * Open `path` with the given pages, dropping any previous file and
+     * counters. Nothing is loaded yet.
+     *
+     * @return false if the file cannot be opened or a page lies beyond its end
+     */
+    bool open(const std::string& path, const std::vector<PageRange>& pages, std::size_t byte_budget);
+
+    /**
+     * Page `page`, loaded first if it is not resident.
+     *
+     * @return null only if the page cannot be read
+     */
+    std::shared_ptr<const Page> acquire(std::uint32_t page);
+
+    /**
+     * Page `page` if it is resident (counted as a hit), otherwise null
+     * (counted as nothing; the later acquire() counts the miss).
+     */
+    std::shared_ptr<const Page> acquire_if_resident(std::uint32_t page);
+
+    std::size_t page_count() const { return ranges.size(); }
+    std::size_t budget() const { return budget_bytes; }
+
+    PageCacheStats stats() const;
+    void reset_stats();
+
+private:
+    struct Slot {
+        std::shared_ptr<const Page> page;
+        std::list<std::uint32_t>::iterator position;  ///< Entry in `recency` while resident
+    };
+
+    std::shared_ptr<const Page> load(std::uint32_t page) const;
+    void touch(std::uint32_t page);
+    void close();
+
+    mutable std::mutex mutex;
+    std::string file_path;
+    int descriptor = -1;
+    std::vector<PageRange> ranges;
+    std::vector<Slot> slots;
+    std::list<std::uint32_t> recency;  ///< Resident pages, most recently used first
+    std::size_t budget_bytes = 0;
+    PageCacheStats counters;
+};
+
+#endif
@@ -0,0 +1,337 @@
+#include "PagedBvh.h"
+
+#include "AcceleratorKernels.h"
+#include "PrimitiveTable.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+static_assert(std::is_trivially_copyable<PackedPrimitive>::value,
+              "paged primitives are written and mapped as raw bytes");
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'T', 'P', 'B', 'V', 'H', '0', '1'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint64_t kPageAlignment = 4096;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t primitive_bytes;   ///< sizeof(PackedPrimitive) of the writing build
+    std::uint32_t node_bytes;        ///< sizeof(BvhQuantizedNode) of the writing build
+    std::uint32_t page_count;
+    std::uint64_t table_primitives;  ///< Size of the table the file was written from
+    std::uint64_t directory_offset;  ///< Page entries, then the always-tested table indices
+    std::uint64_t unbounded_count;
+};
+
+struct DirectoryEntry {
+    std::uint64_t offset;
+    std::uint64_t bytes;
+    double lo[3];
+    double hi[3];
+};
+
+/**
+ * Start of every page; nodes follow directly, root first.
+ */
+struct PageHeader {
+    std::uint32_t node_count;
+    std::uint32_t primitive_count;
+    std::uint32_t primitive_offset;  ///< Byte offset of the primitives, in leaf order
+    std::uint32_t id_offset;         ///< Byte offset of their table indices
+};
+
+static_assert(sizeof(PageHeader) % alignof(BvhQuantizedNode) == 0, "page nodes must stay aligned");
+
+/**
+ * Split `boxes[begin, end)` at the centroid median of the widest axis until
+ * every range holds at most `limit` boxes; append the ranges to `pages`.
+ */
+void split_pages(std::vector<BvhBox>& boxes, std::size_t begin, std::size_t end, std::size_t limit,
+                 std::vector<std::pair<std::size_t, std::size_t>>& pages) {
+    if (end - begin <= limit) {
+        pages.emplace_back(begin, end);
+        return;
+    }
+    std::array<double, 3> lo;
+    std::array<double, 3> hi;
+    lo.fill(std::numeric_limits<double>::max());
+    hi.fill(-std::numeric_limits<double>::max());
+    for (std::size_t index = begin; index < end; ++index) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const double centroid = boxes[index].lo[axis] + boxes[index].hi[axis];
+            lo[axis] = std::min(lo[axis], centroid);
+            hi[axis] = std::max(hi[axis], centroid);
+        }
+    }
+    int widest = 0;
+    for (int axis = 1; axis < 3; ++axis) {
+        if (hi[axis] - lo[axis] > hi[widest] - lo[widest]) {
+            widest = axis;
+        }
+    }
+    const std::size_t middle = begin + (end - begin) / 2;
+    std::nth_element(boxes.begin() + static_cast<std::ptrdiff_t>(begin),
+                     boxes.begin() + static_cast<std::ptrdiff_t>(middle),
+                     boxes.begin() + static_cast<std::ptrdiff_t>(end), [widest](const BvhBox& a, const BvhBox& b) {
+                         return a.lo[widest] + a.hi[widest] < b.lo[widest] + b.hi[widest];
+                     });
+    split_pages(boxes, begin, middle, limit, pages);
+    split_pages(boxes, middle, end, limit, pages);
+}
+
+template <typename T>
+void write_raw(std::ofstream& out, const T* values, std::size_t count) {
+    out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template <typename T>
+bool read_raw(std::ifstream& in, T* values, std::size_t count) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(sizeof(T) * count)));
+}
+
+void traverse_page(const PageCache::Page& page, const PrimitiveTable& table, const Ray& ray, double min_distance,
+                   ClosestHit& closest) {
+    const unsigned char* data = page.data();
+    PageHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    traverse_quantized_nodes(reinterpret_cast<const BvhQuantizedNode*>(data + sizeof(PageHeader)),
+                             reinterpret_cast<const PackedPrimitive*>(data + header.primitive_offset),
+                             reinterpret_cast<const std::uint32_t*>(data + header.id_offset), table, ray,
+                             min_distance, closest);
+}
+
+/**
+ * Test the always-tested primitives, then list the pages the ray reaches
+ * before the closest hit so far, nearest first.
+ */
+void start_query(const PrimitiveTable& table, const std::vector<std::uint32_t>& unbounded, const WideBvh& top,
+                 const Ray& ray, double min_distance, ClosestHit& closest, std::vector<BvhBoxHit>& reached) {
+    const PackedPrimitive* entries = table.primitives().data();
+    for (const std::uint32_t index : unbounded) {
+        test_accelerated_primitive(&table, entries[index], index, ray, min_distance, closest);
+    }
+    reached.clear();
+    top.collect_boxes(ray, min_distance, closest.distance, reached);
+    std::sort(reached.begin(), reached.end(),
+              [](const BvhBoxHit& a, const BvhBoxHit& b) { return a.distance < b.distance; });
+}
+
+thread_local std::vector<BvhBoxHit> reached_pages;
+
+} // namespace
+
+bool PagedBvh::write(const PrimitiveTable& table, const std::string& path, std::size_t page_primitives) {
+    const std::vector<PackedPrimitive>& entries = table.primitives();
+    std::vector<BvhBox> boxes;
+    std::vector<std::uint32_t> always_tested;
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        BvhBox box;
+        box.id = static_cast<std::uint32_t>(index);
+        if (accelerator_primitive_bounds(entries[index], box.lo, box.hi)) {
+            boxes.push_back(box);
+        } else {
+            always_tested.push_back(box.id);
+        }
+    }
+    std::vector<std::pair<std::size_t, std::size_t>> pages;
+    if (!boxes.empty()) {
+        split_pages(boxes, 0, boxes.size(), std::max<std::size_t>(page_primitives, 1), pages);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.primitive_bytes = sizeof(PackedPrimitive);
+    header.node_bytes = sizeof(BvhQuantizedNode);
+    header.page_count = static_cast<std::uint32_t>(pages.size());
+    header.table_primitives = entries.size();
+    header.unbounded_count = always_tested.size();
+    write_raw(out, &header, 1);
+
+    WideBvhSettings settings;
+    settings.format = BvhNodeFormat::Quantized;
+    std::vector<DirectoryEntry> directory;
+    std::vector<PackedPrimitive> primitives;
+    const char padding[kPageAlignment] = {};
+    for (const auto& [begin, end] : pages) {
+        const std::vector<BvhBox> page_boxes(boxes.begin() + static_cast<std::ptrdiff_t>(begin),
+                                             boxes.begin() + static_cast<std::ptrdiff_t>(end));
+        WideBvh tree;
+        tree.build(page_boxes, settings);
+        const std::vector<BvhQuantizedNode>& nodes = tree.quantized_node_list();
+        const std::vector<std::uint32_t>& order = tree.leaf_order();
+        primitives.clear();
+        for (const std::uint32_t index : order) {
+            primitives.push_back(entries[index]);
+        }
+
+        const std::uint64_t position = static_cast<std::uint64_t>(out.tellp());
+        out.write(padding, static_cast<std::streamsize>((kPageAlignment - position % kPageAlignment) % kPageAlignment));
+        PageHeader page{};
+        page.node_count = static_cast<std::uint32_t>(nodes.size());
+        page.primitive_count = static_cast<std::uint32_t>(order.size());
+        page.primitive_offset = static_cast<std::uint32_t>(sizeof(PageHeader) + nodes.size() * sizeof(BvhQuantizedNode));
+        page.id_offset = static_cast<std::uint32_t>(page.primitive_offset + order.size() * sizeof(PackedPrimitive));
+
+        DirectoryEntry entry{};
+        entry.offset = static_cast<std::uint64_t>(out.tellp());
+        entry.bytes = page.id_offset + order.size() * sizeof(std::uint32_t);
+        for (int axis = 0; axis < 3; ++axis) {
+            entry.lo[axis] = std::numeric_limits<double>::max();
+            entry.hi[axis] = -std::numeric_limits<double>::max();
+            for (const BvhBox& box : page_boxes) {
+                entry.lo[axis] = std::min(entry.lo[axis], box.lo[axis]);
+                entry.hi[axis] = std::max(entry.hi[axis], box.hi[axis]);
+            }
+        }
+        directory.push_back(entry);
+
+        write_raw(out, &page, 1);
+        write_raw(out, nodes.data(), nodes.size());
+        write_raw(out, primitives.data(), primitives.size());
+        write_raw(out, order.data(), order.size());
+    }
+
+    header.directory_offset = static_cast<std::uint64_t>(out.tellp());
+    write_raw(out, directory.data(), directory.size());
+    write_raw(out, always_tested.data(), always_tested.size());
+    out.seekp(0);
+    write_raw(out, &header, 1);
+    return static_cast<bool>(out);
+}
+
+bool PagedBvh::open(const PrimitiveTable& table, const std::string& path, std::size_t cache_bytes) {
+    std::ifstream in(path, std::ios::binary);
+    FileHeader header;
+    if (!in || !read_raw(in, &header, 1) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+        || header.version != kVersion || header.primitive_bytes != sizeof(PackedPrimitive)
+        || header.node_bytes != sizeof(BvhQuantizedNode) || header.table_primitives != table.primitive_count()) {
+        return false;
+    }
+    std::vector<DirectoryEntry> directory(header.page_count);
+    std::vector<std::uint32_t> always_tested(static_cast<std::size_t>(header.unbounded_count));
+    in.seekg(static_cast<std::streamoff>(header.directory_offset));
+    if (!read_raw(in, directory.data(), directory.size())
+        || !read_raw(in, always_tested.data(), always_tested.size())) {
+        return false;
+    }
+    for (const std::uint32_t index : always_tested) {
+        if (index >= table.primitive_count()) {
+            return false;
+        }
+    }
+
+    std::vector<BvhBox> page_boxes;
+    std::vector<PageRange> ranges;
+    for (std::size_t page = 0; page < directory.size(); ++page) {
+        const DirectoryEntry& entry = directory[page];
+        BvhBox box;
+        box.id = static_cast<std::uint32_t>(page);
+        std::copy(entry.lo, entry.lo + 3, box.lo.begin());
+        std::copy(entry.hi, entry.hi + 3, box.hi.begin());
+        page_boxes.push_back(box);
+        ranges.push_back(PageRange{entry.offset, entry.bytes});
+    }
+    if (!cache.open(path, ranges, cache_bytes)) {
+        return false;
+    }
+    WideBvhSettings settings;
+    settings.format = BvhNodeFormat::Quantized;
+    settings.max_leaf_size = 1;
+    top.build(page_boxes, settings);
+    unbounded = std::move(always_tested);
+    total_bytes = header.directory_offset + directory.size() * sizeof(DirectoryEntry)
+                + unbounded.size() * sizeof(std::uint32_t);
+    deferred.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool PagedBvh::intersect(const PrimitiveTable& table, const Ray& ray, double min_distance, double max_distance,
+                         HitCandidate& candidate) const {
+    ClosestHit closest{max_distance, false, &candidate};
+    std::vector<BvhBoxHit>& reached = reached_pages;
+    start_query(table, unbounded, top, ray, min_distance, closest, reached);
+    for (const BvhBoxHit& hit : reached) {
+        if (static_cast<double>(hit.distance) > closest.distance) {
+            break;
+        }
+        if (const std::shared_ptr<const PageCache::Page> page = cache.acquire(hit.id)) {
+            traverse_page(*page, table, ray, min_distance, closest);
+        }
+    }
+    return closest.found;
+}
+
+std::size_t PagedBvh::intersect_batch(const PrimitiveTable& table, const Ray* rays, std::size_t count,
+                                      double min_distance, double max_distance, HitCandidate* candidates) const {
+    struct Deferred {
+        std::uint32_t ray;
+        float distance;
+    };
+    std::vector<ClosestHit> closest(count);
+    std::vector<std::vector<Deferred>> queues(page_count());
+    std::vector<std::uint32_t> queued_pages;
+    std::vector<BvhBoxHit>& reached = reached_pages;
+    std::uint64_t deferred_count = 0;
+
+    // Resident pages now, the others queued
+    for (std::size_t index = 0; index < count; ++index) {
+        candidates[index] = HitCandidate();
+        closest[index] = ClosestHit{max_distance, false, &candidates[index]};
+        start_query(table, unbounded, top, rays[index], min_distance, closest[index], reached);
+        for (const BvhBoxHit& hit : reached) {
+            if (static_cast<double>(hit.distance) > closest[index].distance) {
+                break;
+            }
+            if (const std::shared_ptr<const PageCache::Page> page = cache.acquire_if_resident(hit.id)) {
+                traverse_page(*page, table, rays[index], min_distance, closest[index]);
+                continue;
+            }
+            if (queues[hit.id].empty()) {
+                queued_pages.push_back(hit.id);
+            }
+            queues[hit.id].push_back(Deferred{static_cast<std::uint32_t>(index), hit.distance});
+            ++deferred_count;
+        }
+    }
+    deferred.fetch_add(deferred_count, std::memory_order_relaxed);
+
+    // Then each queued page once, in the order rays first asked for them.
+    // Hits in pages visited later may be nearer; ClosestHit keeps the
+    // scan's answer in any order
+    for (const std::uint32_t page_index : queued_pages) {
+        const std::shared_ptr<const PageCache::Page> page = cache.acquire(page_index);
+        if (!page) {
+            continue;
+        }
+        for (const Deferred& visit : queues[page_index]) {
+            if (static_cast<double>(visit.distance) <= closest[visit.ray].distance) {
+                traverse_page(*page, table, rays[visit.ray], min_distance, closest[visit.ray]);
+            }
+        }
+    }
+
+    std::size_t hits = 0;
+    for (const ClosestHit& result : closest) {
+        hits += result.found ? 1 : 0;
+    }
+    return hits;
+}
+
+void PagedBvh::reset_stats() const {
+    cache.reset_stats();
+    deferred.store(0, std::memory_order_relaxed);
+}
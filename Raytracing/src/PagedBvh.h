@@ -0,0 +1,121 @@
+#ifndef PAGED_BVH_H
+#define PAGED_BVH_H
+
+/**
+ * @file PagedBvh.h
+ * @brief Two-level BVH whose bottom-level subtrees live in a file and are
+ * mapped in on demand under a memory budget.
+ *
+ * write() splits the bounded primitives of a table into spatially compact
+ * pages of at most `page_primitives` primitives. Each page holds a
+ * quantized 8-wide BVH over its primitives (see WideBvh), a copy of those
+ * primitives in leaf order and their table indices, and starts on a 4 KiB
+ * boundary of the file. A directory of page boxes closes the file.
+ *
+ * open() reads only the header and the directory and builds a small
+ * resident BVH over the page boxes. Page contents stay on disk until a ray
+ * reaches them, then stay mapped through a PageCache, which evicts the least
+ * recently used pages to keep within `cache_bytes`:
+ * - intersect() visits the pages a ray reaches nearest first and loads each
+ *   one it needs on the spot;
+ * - intersect_batch() traces a batch of rays through the resident pages and
+ *   queues each ray that reaches a page that is not resident on that page;
+ *   it then loads the queued pages one by one and drains their queues, so a
+ *   batch loads each page at most once whatever the budget.
+ * Both return exactly what the full table scan returns.
+ *
+ * The file stores raw in-memory structures, so it belongs to the build that
+ * wrote it and to the table it was written from. That table stays resident:
+ * it holds the materials, the room enclosures and extension primitives
+ * (which every query tests, as with WideBvh), and resolves hit records.
+ *
+ * This is not an out-of-core mode. The scene and its table stay in memory
+ * and the pages hold a second copy of the primitives, so paging adds the
+ * mapped pages to peak memory rather than bounding it. The renderer calls
+ * intersect() one ray at a time; only batch callers (the paged benchmark)
+ * use intersect_batch(). It is a testbed for page layout and cache policy.
+ */
+
+#include "Accelerator.h"
+#include "Hittable.h"
+#include "PageCache.h"
+#include "Ray.h"
+#include "WideBvh.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class PrimitiveTable;
+
+/**
+ * Controls for writing and opening a paged BVH.
+ */
+struct PagedBvhSettings {
+    bool enabled = false;                          ///< Page the scene's BVH out before rendering
+    std::string path = "scene.pbvh";               ///< File to write and map
+    std::size_t page_primitives = 4096;            ///< Most primitives per page
+    std::size_t cache_bytes = std::size_t{64} << 20; ///< Budget for mapped pages
+};
+
+class PagedBvh : public Accelerator {
+public:
+    /**
+     * Write the paged BVH of `table` to `path`.
+     *
+     * @return false if the file cannot be written
+     */
+    static bool write(const PrimitiveTable& table, const std::string& path, std::size_t page_primitives);
+
+    /**
+     * Open a file written by write() for `table`, with `cache_bytes` for
+     * mapped pages. No page is loaded yet.
+     *
+     * @return false if the file is missing, from another build or for
+     *         another table
+     */
+    bool open(const PrimitiveTable& table, const std::string& path, std::size_t cache_bytes);
+
+    bool intersect(const PrimitiveTable& table, const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override;
+
+    /**
+     * Closest-hit queries for `count` rays, deferring rays that reach pages
+     * that are not resident until those pages are loaded (see above).
+     * `candidates[i].primitive` stays null when ray `i` misses.
+     *
+     * @return Number of rays that hit
+     */
+    std::size_t intersect_batch(const PrimitiveTable& table, const Ray* rays, std::size_t count, double min_distance,
+                                double max_distance, HitCandidate* candidates) const;
+
+    std::size_t page_count() const { return cache.page_count(); }
+
+    /**
+     * Size of the file, of which all but the header and directory is paged.
+     */
+    std::uint64_t file_bytes() const { return total_bytes; }
+
+    /**
+     * Page cache counters; hits and misses count page visits.
+     */
+    PageCacheStats cache_stats() const { return cache.stats(); }
+
+    /**
+     * Page visits intersect_batch() put off because the page was not resident.
+     */
+    std::uint64_t deferred_visits() const { return deferred.load(std::memory_order_relaxed); }
+
+    void reset_stats() const;
+
+private:
+    WideBvh top;                              ///< Over the page boxes; leaves hold page numbers
+    std::vector<std::uint32_t> unbounded;     ///< Enclosures and extensions, tested by every query
+    std::uint64_t total_bytes = 0;
+    mutable PageCache cache;
+    mutable std::atomic<std::uint64_t> deferred{0};
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "Parallel.h"
+
+#include "FastMath.h"
+#include "OccluderCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Set while this thread runs a chunk; nested calls then run inline
+thread_local bool in_parallel_body = false;
+
+/**
+ * One parallel_for call: its chunks, claimed by index from any thread.
+ * Lives on the caller's stack until no helper refers to it.
+ */
+struct Batch {
+    const std::function<void(std::size_t, std::size_t)>* body = nullptr;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    std::size_t chunk = 0;
+    std::size_t chunk_count = 0;
+    unsigned kernels = fast_math::kDefaultKernels;  ///< The caller's per-thread render switches
+    bool occluder_cache = true;
+    std::atomic<std::size_t> next_chunk{0};
+    unsigned users = 0;  ///< Helpers working on it (pool mutex)
+
+    void work() {
+        const fast_math::ScopedKernels kernel_scope(kernels);
+        const occluder_cache::ScopedEnabled occluder_scope(occluder_cache);
+        const bool outer = in_parallel_body;
+        in_parallel_body = true;
+        for (std::size_t index = next_chunk.fetch_add(1); index < chunk_count; index = next_chunk.fetch_add(1)) {
+            const std::size_t chunk_begin = begin + index * chunk;
+            (*body)(chunk_begin, std::min(end, chunk_begin + chunk));
+        }
+        in_parallel_body = outer;
+    }
+};
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned helper_count) {
+        helpers.reserve(helper_count);
+        for (unsigned index = 0; index < helper_count; ++index) {
+            helpers.emplace_back([this] { serve(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& helper : helpers) {
+            helper.join();
+        }
+    }
+
+    void run(Batch& batch) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(&batch);
+        }
+        wake.notify_all();
+        batch.work();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        retire(batch);
+        idle.wait(lock, [&batch] { return batch.users == 0; });
+    }
+
+private:
+    void serve() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || !batches.empty(); });
+            if (stopping) {
+                return;
+            }
+            Batch& batch = *batches.front();
+            ++batch.users;
+            lock.unlock();
+            batch.work();
+            lock.lock();
+            // Every chunk is claimed; keep other helpers from picking it up again
+            retire(batch);
+            if (--batch.users == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+
+    void retire(Batch& batch) {
+        const auto found = std::find(batches.begin(), batches.end(), &batch);
+        if (found != batches.end()) {
+            batches.erase(found);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Batch*> batches;
+    bool stopping = false;
+    std::vector<std::thread> helpers;
+};
+
+ThreadPool& shared_pool() {
+    static ThreadPool pool(worker_count() - 1);
+    return pool;
+}
+
+} // namespace
+
+unsigned worker_count() {
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1u : hardware;
+}
+
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& body) {
+    if (end <= begin) {
+        return;
+    }
+
+    const std::size_t total = end - begin;
+    const std::size_t min_chunk = std::max<std::size_t>(grain, 1);
+    const unsigned threads = worker_count();
+    if (threads == 1 || total <= min_chunk || in_parallel_body) {
+        body(begin, end);
+        return;
+    }
+
+    // A few chunks per thread so uneven chunks still balance out
+    const std::size_t target_chunks = static_cast<std::size_t>(threads) * 4;
+    Batch batch;
+    batch.body = &body;
+    batch.begin = begin;
+    batch.end = end;
+    batch.chunk = std::max(min_chunk, (total + target_chunks - 1) / target_chunks);
+    batch.chunk_count = (total + batch.chunk - 1) / batch.chunk;
+    batch.kernels = fast_math::enabled_kernels();
+    batch.occluder_cache = occluder_cache::enabled();
+    shared_pool().run(batch);
+}
@@ -0,0 +1,37 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+/**
+ * @file Parallel.h
+ * @brief Minimal fork-join helper for data-parallel loops.
+ *
+ * Chunks are shared with one process-wide pool of worker_count() - 1 helper
+ * threads, started on first use. Concurrent callers (several RenderEngine
+ * jobs in setup, say) queue their chunks on the same helpers instead of
+ * starting threads of their own, and a parallel_for called from inside a
+ * body runs inline on that thread.
+ */
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Number of worker threads used by parallel_for (hardware concurrency, at least 1).
+ */
+unsigned worker_count();
+
+/**
+ * Split [begin, end) into contiguous chunks of at least `grain` items and run
+ * `body(chunk_begin, chunk_end)` on them concurrently. Blocks until all
+ * chunks are done; the calling thread processes chunks too, so a call
+ * always makes progress even while the pool helpers serve other callers.
+ *
+ * @param begin First index
+ * @param end One past the last index
+ * @param grain Minimum chunk size; small ranges run inline on the caller
+ * @param body Callback invoked once per chunk
+ */
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& body);
+
+#endif
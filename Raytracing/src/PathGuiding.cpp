@@ -0,0 +1,349 @@
+#include "PathGuiding.h"
+
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kInverseFourPi = 1.0 / (4.0 * kPi);
+constexpr int kMaxSpatialDepth = 30;
+
+/**
+ * Equal-area map from a unit direction to [0, 1]^2: x = (cos theta + 1) / 2
+ * along world +Z, y = phi / 2pi. A uniform density on the square is
+ * 1 / 4pi per steradian.
+ */
+void direction_to_square(const Vec3& direction, double& x, double& y) {
+    x = std::clamp(0.5 * (direction.z() + 1.0), 0.0, 1.0);
+    double phi = std::atan2(direction.y(), direction.x());
+    if (phi < 0.0) {
+        phi += 2.0 * kPi;
+    }
+    y = std::clamp(phi / (2.0 * kPi), 0.0, 1.0);
+}
+
+Vec3 square_to_direction(double x, double y) {
+    const double cos_theta = 2.0 * x - 1.0;
+    const double sin_theta = std::sqrt(std::max(0.0, 1.0 - cos_theta * cos_theta));
+    const double phi = 2.0 * kPi * y;
+    return Vec3(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+}
+
+/**
+ * Step into the quadrant holding (x, y) and rescale both to its [0, 1]^2.
+ */
+int descend(double& x, double& y) {
+    const int x_bit = x >= 0.5 ? 1 : 0;
+    const int y_bit = y >= 0.5 ? 1 : 0;
+    x = std::min(2.0 * x - x_bit, 1.0);
+    y = std::min(2.0 * y - y_bit, 1.0);
+    return x_bit + 2 * y_bit;
+}
+
+void atomic_add(std::atomic<double>& target, double value) {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+// ========== DirectionalTree ==========
+
+DirectionalTree::Node::Node() : child{{0, 0, 0, 0}} {
+    for (auto& value : sum) {
+        value.store(0.0, std::memory_order_relaxed);
+    }
+}
+
+DirectionalTree::Node::Node(const Node& other) : child(other.child) {
+    for (int quadrant = 0; quadrant < 4; ++quadrant) {
+        sum[quadrant].store(other.sum[quadrant].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+DirectionalTree::Node& DirectionalTree::Node::operator=(const Node& other) {
+    child = other.child;
+    for (int quadrant = 0; quadrant < 4; ++quadrant) {
+        sum[quadrant].store(other.sum[quadrant].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    return *this;
+}
+
+double DirectionalTree::Node::total() const {
+    return sum[0].load(std::memory_order_relaxed) + sum[1].load(std::memory_order_relaxed)
+         + sum[2].load(std::memory_order_relaxed) + sum[3].load(std::memory_order_relaxed);
+}
+
+DirectionalTree::DirectionalTree() : nodes(1) {}
+
+void DirectionalTree::record(const Vec3& direction, double value) {
+    if (!(value > 0.0) || !std::isfinite(value)) {
+        return;
+    }
+    double x = 0.0;
+    double y = 0.0;
+    direction_to_square(direction, x, y);
+
+    std::uint32_t node = 0;
+    for (;;) {
+        const int quadrant = descend(x, y);
+        atomic_add(nodes[node].sum[quadrant], value);
+        node = nodes[node].child[quadrant];
+        if (node == 0) {
+            return;
+        }
+    }
+}
+
+Vec3 DirectionalTree::sample(double u1, double u2) const {
+    double x0 = 0.0;
+    double y0 = 0.0;
+    double size = 1.0;
+    std::uint32_t node = 0;
+    for (;;) {
+        const Node& current = nodes[node];
+        double sum[4];
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            sum[quadrant] = current.sum[quadrant].load(std::memory_order_relaxed);
+        }
+        const double total = sum[0] + sum[1] + sum[2] + sum[3];
+        if (!(total > 0.0)) {
+            break;  // Nothing recorded below here: uniform over this square
+        }
+
+        // Pick the column (x half), then the quadrant within it, reusing
+        // the rescaled uniforms for the next level
+        const double left = (sum[0] + sum[2]) / total;
+        int x_bit = 0;
+        if (u1 < left) {
+            u1 /= left;
+        } else {
+            x_bit = 1;
+            u1 = (u1 - left) / (1.0 - left);
+        }
+        const double lower = sum[x_bit] / (sum[x_bit] + sum[x_bit + 2]);
+        int y_bit = 0;
+        if (u2 < lower) {
+            u2 /= lower;
+        } else {
+            y_bit = 1;
+            u2 = (u2 - lower) / (1.0 - lower);
+        }
+
+        size *= 0.5;
+        x0 += x_bit * size;
+        y0 += y_bit * size;
+        node = current.child[x_bit + 2 * y_bit];
+        if (node == 0) {
+            break;
+        }
+    }
+    return square_to_direction(x0 + std::min(u1, 1.0) * size, y0 + std::min(u2, 1.0) * size);
+}
+
+double DirectionalTree::pdf(const Vec3& direction) const {
+    double x = 0.0;
+    double y = 0.0;
+    direction_to_square(direction, x, y);
+
+    double density = 1.0;
+    std::uint32_t node = 0;
+    for (;;) {
+        const Node& current = nodes[node];
+        const double total = current.total();
+        if (!(total > 0.0)) {
+            break;
+        }
+        const int quadrant = descend(x, y);
+        density *= 4.0 * current.sum[quadrant].load(std::memory_order_relaxed) / total;
+        node = current.child[quadrant];
+        if (node == 0 || density == 0.0) {
+            break;
+        }
+    }
+    return density * kInverseFourPi;
+}
+
+double DirectionalTree::total() const {
+    return nodes[0].total();
+}
+
+DirectionalTree DirectionalTree::refined(double fraction, int max_depth) const {
+    DirectionalTree result;
+    const double total_energy = total();
+    if (!(total_energy > 0.0)) {
+        return result;
+    }
+
+    struct Pending {
+        std::uint32_t target;
+        std::uint32_t source;  ///< Matching node of this tree, kNoSource once past its leaves
+        double energy;
+        int depth;
+    };
+    constexpr std::uint32_t kNoSource = ~std::uint32_t{0};
+    std::vector<Pending> stack{{0, 0, total_energy, 1}};
+    while (!stack.empty()) {
+        const Pending pending = stack.back();
+        stack.pop_back();
+        const bool has_source = pending.source != kNoSource;
+
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            const double energy = has_source
+                ? nodes[pending.source].sum[quadrant].load(std::memory_order_relaxed)
+                : 0.25 * pending.energy;
+            if (pending.depth >= max_depth || !(energy > fraction * total_energy)) {
+                continue;
+            }
+            const std::uint32_t child = static_cast<std::uint32_t>(result.nodes.size());
+            result.nodes.emplace_back();
+            result.nodes[pending.target].child[quadrant] = child;
+            const std::uint32_t source_child = has_source ? nodes[pending.source].child[quadrant] : 0;
+            stack.push_back(Pending{child, source_child != 0 ? source_child : kNoSource, energy, pending.depth + 1});
+        }
+    }
+    return result;
+}
+
+// ========== GuidingField ==========
+
+GuidingField::GuidingField(const PathGuidingSettings& settings, const Point3& bounds_min, const Point3& bounds_max)
+    : field_settings(settings)
+    , origin(bounds_min)
+    , nodes(1) {
+    const Vec3 extent = bounds_max - bounds_min;
+    inverse_extent = Vec3(1.0 / std::max(extent.x(), 1e-9),
+                          1.0 / std::max(extent.y(), 1e-9),
+                          1.0 / std::max(extent.z(), 1e-9));
+    for (std::uint32_t bin = 0; bin < kNormalBins; ++bin) {
+        regions.push_back(std::make_unique<GuidingRegion>());
+    }
+}
+
+GuidingRegion& GuidingField::region(const Point3& point, const Vec3& normal) {
+    double t[3] = {
+        std::clamp((point.x() - origin.x()) * inverse_extent.x(), 0.0, 1.0),
+        std::clamp((point.y() - origin.y()) * inverse_extent.y(), 0.0, 1.0),
+        std::clamp((point.z() - origin.z()) * inverse_extent.z(), 0.0, 1.0)
+    };
+    std::uint32_t node = 0;
+    // Inner nodes halve their box along x, y, z in turn
+    for (int depth = 0; nodes[node].child[0] != 0; ++depth) {
+        double& coordinate = t[depth % 3];
+        if (coordinate < 0.5) {
+            coordinate *= 2.0;
+            node = nodes[node].child[0];
+        } else {
+            coordinate = 2.0 * coordinate - 1.0;
+            node = nodes[node].child[1];
+        }
+    }
+
+    const double magnitude[3] = {std::fabs(normal.x()), std::fabs(normal.y()), std::fabs(normal.z())};
+    int axis = magnitude[1] > magnitude[0] ? 1 : 0;
+    axis = magnitude[2] > magnitude[axis] ? 2 : axis;
+    const std::uint32_t bin = static_cast<std::uint32_t>(2 * axis) + (normal.component(static_cast<Axis>(axis)) < 0.0 ? 1 : 0);
+    return *regions[nodes[node].first_region + bin];
+}
+
+bool GuidingField::sample(const GuidingRegion& region, const ShadingFrame& frame, GuidedDirection& out) const {
+    const bool trained = region.sampling.total() > 0.0;
+    const double bsdf_fraction = trained ? field_settings.bsdf_sampling_fraction : 1.0;
+
+    if (random_double() < bsdf_fraction) {
+        out.direction = frame.to_world(random_cosine_direction_local());
+    } else {
+        const double u1 = random_double();
+        out.direction = region.sampling.sample(u1, random_double());
+    }
+    out.cos_theta = frame.cos_theta(out.direction);
+    if (!(out.cos_theta > 0.0)) {
+        return false;
+    }
+
+    out.pdf = bsdf_fraction * out.cos_theta / kPi;
+    if (trained) {
+        out.pdf += (1.0 - bsdf_fraction) * region.sampling.pdf(out.direction);
+    }
+    return true;
+}
+
+void GuidingField::record(GuidingRegion& region, const GuidedDirection& sampled, double luminance) {
+    region.building.record(sampled.direction, luminance / sampled.pdf);
+    region.record_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void GuidingField::split(std::uint32_t node, int depth, double records, double threshold) {
+    if (records <= threshold || depth >= kMaxSpatialDepth) {
+        return;
+    }
+    // Both halves start from the parent's distributions; records are
+    // assumed to fall evenly on either side
+    const std::uint32_t parent_regions = nodes[node].first_region;
+    const std::uint32_t sibling_regions = static_cast<std::uint32_t>(regions.size());
+    for (std::uint32_t bin = 0; bin < kNormalBins; ++bin) {
+        auto sibling = std::make_unique<GuidingRegion>();
+        sibling->sampling = regions[parent_regions + bin]->sampling;
+        sibling->building = regions[parent_regions + bin]->building;
+        regions.push_back(std::move(sibling));
+    }
+
+    const std::uint32_t first = static_cast<std::uint32_t>(nodes.size());
+    nodes.emplace_back();
+    nodes.emplace_back();
+    nodes[first].first_region = parent_regions;
+    nodes[first + 1].first_region = sibling_regions;
+    nodes[node].child = {{first, first + 1}};
+
+    split(first, depth + 1, 0.5 * records, threshold);
+    split(first + 1, depth + 1, 0.5 * records, threshold);
+}
+
+void GuidingField::refine(int samples_per_pixel) {
+    // Müller's schedule: the split threshold grows with sqrt(spp) so the
+    // tree deepens as training passes double in length
+    const double threshold = field_settings.spatial_split_threshold
+                           * std::sqrt(static_cast<double>(std::max(samples_per_pixel, 1)));
+
+    std::vector<std::pair<std::uint32_t, int>> leaves;
+    std::vector<std::pair<std::uint32_t, int>> stack{{0, 0}};
+    while (!stack.empty()) {
+        const auto [node, depth] = stack.back();
+        stack.pop_back();
+        if (nodes[node].child[0] == 0) {
+            leaves.emplace_back(node, depth);
+        } else {
+            stack.emplace_back(nodes[node].child[0], depth + 1);
+            stack.emplace_back(nodes[node].child[1], depth + 1);
+        }
+    }
+    for (const auto& [node, depth] : leaves) {
+        double records = 0.0;
+        for (std::uint32_t bin = 0; bin < kNormalBins; ++bin) {
+            records += regions[nodes[node].first_region + bin]->record_count.load(std::memory_order_relaxed);
+        }
+        split(node, depth, records, threshold);
+    }
+
+    for (auto& region : regions) {
+        region->record_count.store(0, std::memory_order_relaxed);
+        if (!(region->building.total() > 0.0)) {
+            continue;  // Nothing new landed here: keep sampling what was learned before
+        }
+        region->sampling = region->building;
+        region->building = region->sampling.refined(field_settings.directional_split_fraction,
+                                                    field_settings.max_directional_depth);
+    }
+}
+
+std::size_t GuidingField::directional_node_count() const {
+    std::size_t count = 0;
+    for (const auto& region : regions) {
+        count += region->sampling.node_count();
+    }
+    return count;
+}
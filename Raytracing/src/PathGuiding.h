@@ -0,0 +1,174 @@
+#ifndef PATH_GUIDING_H
+#define PATH_GUIDING_H
+
+/**
+ * @file PathGuiding.h
+ * @brief Online-learned directional guiding for diffuse bounces.
+ *
+ * When most indirect light reaches a surface through a small opening (a lamp
+ * in a shade lighting one patch of ceiling), cosine sampling rarely finds
+ * it. Following Müller et al., "Practical Path Guiding" (EGSR 2017), a
+ * spatial binary tree over the room holds a directional quadtree per leaf
+ * that learns incident radiance from progressive render passes. Diffuse
+ * bounces then pick cosine sampling or the learned distribution at random
+ * (one-sample MIS with the mixture pdf), so the estimate stays unbiased
+ * however poorly the field has been trained.
+ */
+
+#include "ShadingFrame.h"
+#include "Vec3.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Training schedule and mixing knobs.
+ */
+struct PathGuidingSettings {
+    bool enabled = false;                       ///< Off: plain cosine sampling, single pass
+    int training_passes = 5;                    ///< Passes of 1, 2, 4, ... spp that train the field
+    double bsdf_sampling_fraction = 0.5;        ///< Probability of cosine sampling once a region is trained
+    double spatial_split_threshold = 4'000.0;   ///< Records c * sqrt(spp) that split a region
+    double directional_split_fraction = 0.05;   ///< Energy share that subdivides a quadrant
+    int max_directional_depth = 16;             ///< Quadtree depth limit
+};
+
+/**
+ * Quadtree over the equal-area cylindrical square (cos theta, phi) of
+ * world-space directions. Each node stores the energy of its four
+ * quadrants; a zero child index marks a leaf quadrant.
+ */
+class DirectionalTree {
+public:
+    DirectionalTree();
+
+    /**
+     * Add `value` to every quadrant containing `direction`, root to leaf.
+     * Safe to call concurrently with other record() calls.
+     */
+    void record(const Vec3& direction, double value);
+
+    /**
+     * Draw a unit direction proportional to the recorded energy.
+     *
+     * @param u1 Uniform sample in [0, 1)
+     * @param u2 Uniform sample in [0, 1)
+     */
+    Vec3 sample(double u1, double u2) const;
+
+    /**
+     * Solid-angle density of sample() for `direction`.
+     */
+    double pdf(const Vec3& direction) const;
+
+    /**
+     * Total recorded energy; zero means the tree has nothing to sample.
+     */
+    double total() const;
+
+    /**
+     * Empty tree for the next pass: quadrants holding more than `fraction`
+     * of this tree's energy are subdivided (up to `max_depth` levels), the
+     * rest are merged back into leaves.
+     */
+    DirectionalTree refined(double fraction, int max_depth) const;
+
+    std::size_t node_count() const { return nodes.size(); }
+
+private:
+    struct Node {
+        std::array<std::atomic<double>, 4> sum;
+        std::array<std::uint32_t, 4> child;
+
+        Node();
+        Node(const Node& other);
+        Node& operator=(const Node& other);
+        double total() const;
+    };
+
+    std::vector<Node> nodes;
+};
+
+/**
+ * One spatial leaf: the distribution sampled during the current pass and
+ * the histogram the pass records into.
+ */
+struct GuidingRegion {
+    DirectionalTree sampling;
+    DirectionalTree building;
+    std::atomic<std::uint32_t> record_count{0};
+};
+
+/**
+ * Direction chosen for a guided diffuse bounce.
+ */
+struct GuidedDirection {
+    Vec3 direction;
+    double cos_theta = 0.0;  ///< Cosine to the shading normal (> 0)
+    double pdf = 0.0;        ///< Mixture solid-angle density
+};
+
+/**
+ * Spatial binary tree of GuidingRegions over an axis-aligned box.
+ *
+ * During a pass region(), sample() and record() may run on many threads;
+ * refine() rebuilds the structure and must run between passes.
+ */
+class GuidingField {
+public:
+    GuidingField(const PathGuidingSettings& settings, const Point3& bounds_min, const Point3& bounds_max);
+
+    /**
+     * Region for a surface point: the spatial leaf containing `point`
+     * (points outside the box clamp to its faces), then the dominant axis
+     * and sign of `normal`, so a leaf spanning a room corner keeps floor
+     * and wall distributions apart.
+     */
+    GuidingRegion& region(const Point3& point, const Vec3& normal);
+
+    /**
+     * Pick a cosine-weighted or a learned direction (one-sample MIS).
+     *
+     * @return false if the direction lies below the surface
+     */
+    bool sample(const GuidingRegion& region, const ShadingFrame& frame, GuidedDirection& out) const;
+
+    /**
+     * Record incident radiance `luminance` arriving along a sampled direction.
+     */
+    void record(GuidingRegion& region, const GuidedDirection& sampled, double luminance);
+
+    /**
+     * Close a training pass that used `samples_per_pixel`: split regions
+     * that received enough records, then make each region's histogram its
+     * sampling distribution and start a fresh, refined histogram.
+     */
+    void refine(int samples_per_pixel);
+
+    std::size_t region_count() const { return regions.size(); }
+    std::size_t spatial_leaf_count() const { return regions.size() / kNormalBins; }
+    std::size_t directional_node_count() const;
+    const PathGuidingSettings& settings() const { return field_settings; }
+
+private:
+    static constexpr std::uint32_t kNormalBins = 6;
+
+    struct SpatialNode {
+        std::array<std::uint32_t, 2> child{{0, 0}};  ///< Both zero for a leaf
+        std::uint32_t first_region = 0;              ///< Leaf payload: kNormalBins consecutive regions
+    };
+
+    void split(std::uint32_t node, int depth, double records, double threshold);
+
+    PathGuidingSettings field_settings;
+    Point3 origin;
+    Vec3 inverse_extent;
+    std::vector<SpatialNode> nodes;
+    std::vector<std::unique_ptr<GuidingRegion>> regions;
+};
+
+#endif
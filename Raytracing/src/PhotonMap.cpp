@@ -0,0 +1,305 @@
+#include "PhotonMap.h"
+
+#include "PackedMaterial.h"
+#include "Parallel.h"
+#include "Random.h"
+#include "Scene.h"
+#include "ShadingFrame.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kMinHitDistance = 0.001;
+constexpr double kMaxHitDistance = 1'000'000.0;
+constexpr std::size_t kTraceGrain = 1024;
+constexpr std::size_t kGridGrain = 1 << 14;
+constexpr std::uint64_t kPhotonSeed = 0xD1B54A32D192ED03ull;  // Odd, so photon streams never share a seed
+// Photons farther than this fraction of the radius from the tangent plane
+// belong to another surface (room corners, thin boxes)
+constexpr double kPlaneTolerance = 0.25;
+
+/**
+ * Photons aimed from one light at the bounding sphere of one specular
+ * primitive. Directions are drawn uniformly inside the cone the sphere
+ * subtends, so each photon carries intensity * solid_angle / count.
+ */
+struct EmissionTarget {
+    std::size_t light_index;
+    std::uint32_t primitive_index;
+    Vec3 axis;
+    double cos_max;
+    double solid_angle;
+    std::size_t first_photon;
+    std::size_t photon_count;
+};
+
+bool bounding_sphere(const PackedPrimitive& primitive, Point3& center, double& radius) {
+    if (const auto* sphere = std::get_if<SpherePrimitive>(&primitive.shape)) {
+        center = sphere->center;
+        radius = sphere->radius;
+        return true;
+    }
+    if (const auto* rect = std::get_if<RectPrimitive>(&primitive.shape)) {
+        double mid[3] = {0.0, 0.0, 0.0};
+        mid[static_cast<int>(rect->orientation.tangent_u)] = 0.5 * (rect->u0 + rect->u1);
+        mid[static_cast<int>(rect->orientation.tangent_v)] = 0.5 * (rect->v0 + rect->v1);
+        mid[static_cast<int>(rect->orientation.normal_axis)] = rect->k;
+        center = Point3(mid[0], mid[1], mid[2]);
+        radius = 0.5 * std::sqrt((rect->u1 - rect->u0) * (rect->u1 - rect->u0)
+                                 + (rect->v1 - rect->v0) * (rect->v1 - rect->v0));
+        return true;
+    }
+    return false;
+}
+
+bool is_specular(const PackedMaterial& material) {
+    return material.kind == MaterialKind::Reflective || material.kind == MaterialKind::Transparent;
+}
+
+double luminance(const Color& color) {
+    return 0.2126 * color.x() + 0.7152 * color.y() + 0.0722 * color.z();
+}
+
+std::vector<EmissionTarget> plan_emission(const Scene& scene, std::size_t photon_budget) {
+    const PrimitiveTable& table = scene.dispatch_table;
+    std::vector<EmissionTarget> targets;
+    std::vector<double> weights;
+
+    for (std::size_t light_index = 0; light_index < scene.lights.size(); ++light_index) {
+        const Light& light = scene.lights[light_index];
+        for (std::size_t index = 0; index < table.primitive_count(); ++index) {
+            const PackedPrimitive& primitive = table.primitives()[index];
+            if (primitive.material_index == PrimitiveTable::kNoMaterial
+                || !is_specular(table.materials()[primitive.material_index])) {
+                continue;
+            }
+            Point3 center;
+            double radius = 0.0;
+            if (!bounding_sphere(primitive, center, radius)) {
+                continue;
+            }
+
+            const Vec3 to_center = center - light.position;
+            const double distance = to_center.length();
+            EmissionTarget target{};
+            target.light_index = light_index;
+            target.primitive_index = static_cast<std::uint32_t>(index);
+            if (distance <= radius) {
+                // Light inside the bounds: emit over the full sphere
+                target.axis = Vec3(0.0, 1.0, 0.0);
+                target.cos_max = -1.0;
+            } else {
+                target.axis = to_center / distance;
+                const double sin_max = radius / distance;
+                target.cos_max = std::sqrt(std::max(0.0, 1.0 - sin_max * sin_max));
+            }
+            target.solid_angle = 2.0 * kPi * (1.0 - target.cos_max);
+            targets.push_back(target);
+            weights.push_back(luminance(light.intensity) * target.solid_angle);
+        }
+    }
+
+    // Split the budget by the flux each cone carries
+    double total_weight = 0.0;
+    for (const double weight : weights) {
+        total_weight += weight;
+    }
+    std::size_t next_photon = 0;
+    for (std::size_t index = 0; index < targets.size(); ++index) {
+        const double share = total_weight > 0.0 ? weights[index] / total_weight : 0.0;
+        targets[index].first_photon = next_photon;
+        targets[index].photon_count = std::max<std::size_t>(
+            1, static_cast<std::size_t>(std::llround(share * static_cast<double>(photon_budget))));
+        next_photon += targets[index].photon_count;
+    }
+    return targets;
+}
+
+/**
+ * Follow one photon through specular bounces; store it at the first diffuse
+ * hit if it really went through the target primitive first.
+ */
+void trace_photon(const Scene& scene, const EmissionTarget& target, int max_bounces,
+                  std::vector<Photon>& out) {
+    const Light& light = scene.lights[target.light_index];
+
+    const double cos_theta = 1.0 - random_double() * (1.0 - target.cos_max);
+    const double sin_theta = std::sqrt(std::max(0.0, 1.0 - cos_theta * cos_theta));
+    const double phi = 2.0 * kPi * random_double();
+    const Vec3 local(sin_theta * std::cos(phi), sin_theta * std::sin(phi), cos_theta);
+    Ray ray(light.position, ShadingFrame::from_normal(target.axis).to_world(local));
+    Color power = light.intensity * (target.solid_angle / static_cast<double>(target.photon_count));
+
+    for (int bounce = 0; bounce <= max_bounces; ++bounce) {
+        HitCandidate candidate;
+        if (!scene.intersect(ray, kMinHitDistance, kMaxHitDistance, candidate)) {
+            return;
+        }
+        // Directions whose first hit is another object belong to that object's cone
+        if (bounce == 0 && (candidate.primitive != &scene.dispatch_table
+                            || candidate.primitive_index != target.primitive_index)) {
+            return;
+        }
+
+        HitRecord record;
+        candidate.primitive->fill_hit_record(ray, candidate, record);
+        if (surface_is_diffuse(record)) {
+            if (bounce > 0) {
+                out.push_back(Photon{record.hit_point, unit_vector(ray.direction()), power});
+            }
+            return;
+        }
+
+        ScatterRecord scatter_record;
+        if (!surface_scatter(ray, record, scatter_record)) {
+            return;
+        }
+        power = power * scatter_record.attenuation;
+        ray = scatter_record.scattered_ray;
+    }
+}
+
+} // namespace
+
+std::int64_t PhotonMap::cell_coordinate(double value) const {
+    return static_cast<std::int64_t>(std::floor(value * inverse_radius));
+}
+
+std::uint32_t PhotonMap::bucket_of(std::int64_t x, std::int64_t y, std::int64_t z) const {
+    const std::uint64_t hash = (static_cast<std::uint64_t>(x) * 73856093ull)
+                             ^ (static_cast<std::uint64_t>(y) * 19349663ull)
+                             ^ (static_cast<std::uint64_t>(z) * 83492791ull);
+    return static_cast<std::uint32_t>(hash) & bucket_mask;
+}
+
+void PhotonMap::build(const Scene& scene, const PhotonMapSettings& settings) {
+    photons.clear();
+    bucket_start.clear();
+    bucket_mask = 0;
+    emitted = 0;
+    map_settings = settings;
+    radius = settings.gather_radius;
+    inverse_radius = 1.0 / settings.gather_radius;
+
+    const std::vector<EmissionTarget> targets = plan_emission(scene, settings.photon_count);
+    if (targets.empty()) {
+        return;
+    }
+    emitted = targets.back().first_photon + targets.back().photon_count;
+
+    // ---------- Trace ----------
+    std::vector<Photon> traced;
+    std::mutex traced_mutex;
+    parallel_for(0, emitted, kTraceGrain, [&](std::size_t first, std::size_t last) {
+        std::vector<Photon> local;
+        auto target = std::upper_bound(targets.begin(), targets.end(), first,
+                                       [](std::size_t photon, const EmissionTarget& t) { return photon < t.first_photon; }) - 1;
+        for (std::size_t photon = first; photon < last; ++photon) {
+            while (photon >= target->first_photon + target->photon_count) {
+                ++target;
+            }
+            // Per-photon streams make the map the same whichever helper traces what
+            seed_thread_uniforms(kPhotonSeed * (photon + 1));
+            trace_photon(scene, *target, settings.max_bounces, local);
+        }
+        std::lock_guard<std::mutex> lock(traced_mutex);
+        traced.insert(traced.end(), local.begin(), local.end());
+    });
+    if (traced.empty()) {
+        return;
+    }
+
+    double lower[3] = {traced[0].position.x(), traced[0].position.y(), traced[0].position.z()};
+    double upper[3] = {lower[0], lower[1], lower[2]};
+    for (const Photon& photon : traced) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const double value = photon.position.component(static_cast<Axis>(axis));
+            lower[axis] = std::min(lower[axis], value);
+            upper[axis] = std::max(upper[axis], value);
+        }
+    }
+    bounds_min = Point3(lower[0] - radius, lower[1] - radius, lower[2] - radius);
+    bounds_max = Point3(upper[0] + radius, upper[1] + radius, upper[2] + radius);
+
+    // ---------- Counting sort into hashed buckets ----------
+    std::size_t bucket_count = 1;
+    while (bucket_count < 2 * traced.size()) {
+        bucket_count <<= 1;
+    }
+    bucket_mask = static_cast<std::uint32_t>(bucket_count - 1);
+
+    std::vector<std::uint32_t> buckets(traced.size());
+    std::unique_ptr<std::atomic<std::uint32_t>[]> counts(new std::atomic<std::uint32_t>[bucket_count]);
+    for (std::size_t index = 0; index < bucket_count; ++index) {
+        counts[index].store(0, std::memory_order_relaxed);
+    }
+    parallel_for(0, traced.size(), kGridGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t index = first; index < last; ++index) {
+            const Point3& p = traced[index].position;
+            buckets[index] = bucket_of(cell_coordinate(p.x()), cell_coordinate(p.y()), cell_coordinate(p.z()));
+            counts[buckets[index]].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    bucket_start.assign(bucket_count + 1, 0);
+    for (std::size_t index = 0; index < bucket_count; ++index) {
+        bucket_start[index + 1] = bucket_start[index] + counts[index].load(std::memory_order_relaxed);
+        counts[index].store(bucket_start[index], std::memory_order_relaxed);
+    }
+
+    photons.resize(traced.size());
+    parallel_for(0, traced.size(), kGridGrain, [&](std::size_t first, std::size_t last) {
+        for (std::size_t index = first; index < last; ++index) {
+            photons[counts[buckets[index]].fetch_add(1, std::memory_order_relaxed)] = traced[index];
+        }
+    });
+}
+
+Color PhotonMap::irradiance(const Point3& point, const Vec3& normal) const {
+    Color flux(0.0, 0.0, 0.0);
+    if (photons.empty()
+        || point.x() < bounds_min.x() || point.y() < bounds_min.y() || point.z() < bounds_min.z()
+        || point.x() > bounds_max.x() || point.y() > bounds_max.y() || point.z() > bounds_max.z()) {
+        return flux;
+    }
+
+    const std::int64_t cx = cell_coordinate(point.x());
+    const std::int64_t cy = cell_coordinate(point.y());
+    const std::int64_t cz = cell_coordinate(point.z());
+    const double radius_squared = radius * radius;
+    const double plane_tolerance = kPlaneTolerance * radius;
+
+    // Neighbouring cells may hash to the same bucket; visit each bucket once
+    std::uint32_t visited[27];
+    int visited_count = 0;
+    for (std::int64_t dz = -1; dz <= 1; ++dz) {
+        for (std::int64_t dy = -1; dy <= 1; ++dy) {
+            for (std::int64_t dx = -1; dx <= 1; ++dx) {
+                const std::uint32_t bucket = bucket_of(cx + dx, cy + dy, cz + dz);
+                if (std::find(visited, visited + visited_count, bucket) != visited + visited_count) {
+                    continue;
+                }
+                visited[visited_count++] = bucket;
+
+                for (std::uint32_t index = bucket_start[bucket]; index < bucket_start[bucket + 1]; ++index) {
+                    const Photon& photon = photons[index];
+                    const Vec3 offset = photon.position - point;
+                    if (offset.length_squared() < radius_squared
+                        && dot(photon.direction, normal) < 0.0
+                        && std::fabs(dot(offset, normal)) < plane_tolerance) {
+                        flux += photon.power;
+                    }
+                }
+            }
+        }
+    }
+
+    return flux / (kPi * radius_squared);
+}
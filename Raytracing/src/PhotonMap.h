@@ -0,0 +1,85 @@
+#ifndef PHOTON_MAP_H
+#define PHOTON_MAP_H
+
+/**
+ * @file PhotonMap.h
+ * @brief Caustic photon map: light -> specular -> diffuse paths.
+ *
+ * Scene lights are points, so a backward path that leaves a diffuse surface
+ * through glass or off a mirror can never reach one; those caustics are
+ * simply missing from the path tracer, and shadow rays make glass cast a
+ * black shadow. This pre-pass shoots photons from every light toward the
+ * bounding sphere of each Reflective/Transparent primitive, follows them
+ * through specular bounces and stores them at the first diffuse surface.
+ * The integrator adds the density estimate at the first diffuse hit(s) of
+ * each camera path. No path is counted twice because the path tracer never
+ * produces these paths.
+ */
+
+#include "Vec3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Scene;
+
+/**
+ * Photon budget and density-estimation kernel.
+ */
+struct PhotonMapSettings {
+    bool enabled = true;                 ///< Skip the pre-pass entirely when false
+    std::size_t photon_count = 50'000;   ///< Photons emitted per frame, split across light/object pairs
+    double gather_radius = 0.15;         ///< Density-estimation radius in world units
+    int max_bounces = 8;                 ///< Specular bounces followed per photon
+    int lookup_diffuse_hits = 1;         ///< Diffuse hits per camera path that gather photons (0 = every hit)
+};
+
+/**
+ * One photon stored at a diffuse surface.
+ */
+struct Photon {
+    Point3 position;
+    Vec3 direction;  ///< Unit direction of travel when it landed
+    Color power;     ///< Flux carried, in the renderer's intensity units
+};
+
+/**
+ * Caustic photons in a hashed uniform grid with cells of one gather radius.
+ */
+class PhotonMap {
+public:
+    /**
+     * Trace and store caustic photons for `scene` (in parallel), replacing
+     * any previous contents. `scene` must be committed.
+     */
+    void build(const Scene& scene, const PhotonMapSettings& settings);
+
+    /**
+     * Caustic irradiance arriving at a diffuse point from the front side of
+     * `normal`: the flux of photons within the gather radius (and close to
+     * the tangent plane) divided by the disk area.
+     */
+    Color irradiance(const Point3& point, const Vec3& normal) const;
+
+    bool empty() const { return photons.empty(); }
+    std::size_t photon_count() const { return photons.size(); }
+    std::size_t emitted_count() const { return emitted; }
+    const PhotonMapSettings& settings() const { return map_settings; }
+
+private:
+    std::uint32_t bucket_of(std::int64_t x, std::int64_t y, std::int64_t z) const;
+    std::int64_t cell_coordinate(double value) const;
+
+    PhotonMapSettings map_settings;
+    std::vector<Photon> photons;              ///< Sorted by bucket
+    std::vector<std::uint32_t> bucket_start;  ///< bucket_mask + 2 prefix offsets into photons
+    std::uint32_t bucket_mask = 0;
+    Point3 bounds_min;  ///< Photon bounding box grown by the radius, for early rejection
+    Point3 bounds_max;
+    double radius = 0.0;
+    double inverse_radius = 0.0;
+    std::size_t emitted = 0;
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "PngWriter.h"
 
+#include "Checksum.h"
+
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <fstream>
@@ -7,6 +10,9 @@
 namespace png_writer {
 namespace detail {
 
+constexpr std::size_t kMaxStoredBlock = 65535;
+constexpr std::size_t kStoredHeaderBytes = 5;
+
 void write_uint32(std::ofstream& out, std::uint32_t value) {
     const unsigned char buffer[4] = {
         static_cast<unsigned char>((value >> 24) & 0xFF),
@@ -17,36 +23,6 @@ void write_uint32(std::ofstream& out, std::uint32_t value) {
     out.write(reinterpret_cast<const char*>(buffer), sizeof(buffer));
 }
 
-std::uint32_t crc32(const unsigned char* data, std::size_t length) {
-    std::uint32_t crc = 0xFFFFFFFFu;
-    for (std::size_t i = 0; i < length; ++i) {
-        crc ^= data[i];
-        for (int k = 0; k < 8; ++k) {
-            const std::uint32_t mask = static_cast<std::uint32_t>(-(crc & 1u));
-            crc = (crc >> 1) ^ (0xEDB88320u & mask);
-        }
-    }
-    return ~crc;
-}
-
-std::uint32_t adler32(const unsigned char* data, std::size_t len) {
-    constexpr std::uint32_t MOD_ADLER = 65521u;
-    std::uint32_t a = 1;
-    std::uint32_t b = 0;
-
-    while (len > 0) {
-        const std::size_t tlen = len > 5552 ? 5552 : len;
-        len -= tlen;
-        for (std::size_t i = 0; i < tlen; ++i) {
-            a = (a + data[i]) % MOD_ADLER;
-            b = (b + a) % MOD_ADLER;
-        }
-        data += tlen;
-    }
-
-    return (b << 16) | a;
-}
-
 void write_chunk(std::ofstream& out, const char type[4], const std::vector<unsigned char>& data) {
     const std::array<unsigned char, 4> chunk_type = {
         static_cast<unsigned char>(type[0]),
@@ -61,106 +37,127 @@ void write_chunk(std::ofstream& out, const char type[4], const std::vector<unsig
         out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
     }
 
-    std::vector<unsigned char> crc_input;
-    crc_input.reserve(chunk_type.size() + data.size());
-    crc_input.insert(crc_input.end(), chunk_type.begin(), chunk_type.end());
-    crc_input.insert(crc_input.end(), data.begin(), data.end());
-
-    const std::uint32_t crc = crc32(crc_input.data(), crc_input.size());
-    write_uint32(out, crc);
+    // The CRC covers type and data; continue it rather than concatenating them
+    const std::uint32_t type_crc = checksum::crc32(chunk_type.data(), chunk_type.size());
+    write_uint32(out, checksum::crc32(data.data(), data.size(), type_crc));
 }
 
-void append_uncompressed_block(std::vector<unsigned char>& zlib_data,
-                               const unsigned char* block_data,
-                               std::size_t block_size,
-                               bool is_final_block) {
-    const unsigned char bfinal = is_final_block ? 1u : 0u;
-    zlib_data.push_back(bfinal);
-
-    const std::uint16_t len = static_cast<std::uint16_t>(block_size);
-    const std::uint16_t nlen = static_cast<std::uint16_t>(~len);
-
-    zlib_data.push_back(static_cast<unsigned char>(len & 0xFF));
-    zlib_data.push_back(static_cast<unsigned char>((len >> 8) & 0xFF));
-    zlib_data.push_back(static_cast<unsigned char>(nlen & 0xFF));
-    zlib_data.push_back(static_cast<unsigned char>((nlen >> 8) & 0xFF));
-
-    zlib_data.insert(zlib_data.end(), block_data, block_data + block_size);
-}
-
-std::vector<unsigned char> make_zlib_stream(const std::vector<unsigned char>& raw) {
-    std::vector<unsigned char> zlib_data;
-    zlib_data.reserve(raw.size() + 6 + (raw.size() / 65535 + 1) * 5);
-
-    zlib_data.push_back(0x78);
-    zlib_data.push_back(0x01);
-
-    const std::size_t max_block_size = 65535;
-    std::size_t offset = 0;
-    while (offset < raw.size()) {
-        const std::size_t remaining = raw.size() - offset;
-        const std::size_t chunk_size = remaining > max_block_size ? max_block_size : remaining;
-        const bool is_final_block = (offset + chunk_size) >= raw.size();
-        append_uncompressed_block(zlib_data, raw.data() + offset, chunk_size, is_final_block);
-        offset += chunk_size;
-    }
-
-    const std::uint32_t adler = adler32(raw.data(), raw.size());
-    zlib_data.push_back(static_cast<unsigned char>((adler >> 24) & 0xFF));
-    zlib_data.push_back(static_cast<unsigned char>((adler >> 16) & 0xFF));
-    zlib_data.push_back(static_cast<unsigned char>((adler >> 8) & 0xFF));
-    zlib_data.push_back(static_cast<unsigned char>(adler & 0xFF));
-
-    return zlib_data;
+void append_uint32(std::vector<unsigned char>& bytes, std::uint32_t value) {
+    bytes.push_back(static_cast<unsigned char>((value >> 24) & 0xFF));
+    bytes.push_back(static_cast<unsigned char>((value >> 16) & 0xFF));
+    bytes.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
+    bytes.push_back(static_cast<unsigned char>(value & 0xFF));
 }
 
 } // namespace detail
 
-bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb) {
-    if (width <= 0 || height <= 0 || static_cast<std::size_t>(width * height * 3) != rgb.size()) {
+bool RowWriter::open(const std::string& filename, int width_in, int height_in) {
+    if (width_in <= 0 || height_in <= 0) {
         return false;
     }
-
-    std::ofstream out(filename, std::ios::binary);
+    out = std::ofstream(filename, std::ios::binary);
     if (!out) {
         return false;
     }
+    width = width_in;
+    height = height_in;
+    rows_done = 0;
+    adler = 1;
 
     const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
     out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
 
-    std::vector<unsigned char> ihdr(13);
-    ihdr[0] = static_cast<unsigned char>((width >> 24) & 0xFF);
-    ihdr[1] = static_cast<unsigned char>((width >> 16) & 0xFF);
-    ihdr[2] = static_cast<unsigned char>((width >> 8) & 0xFF);
-    ihdr[3] = static_cast<unsigned char>(width & 0xFF);
-    ihdr[4] = static_cast<unsigned char>((height >> 24) & 0xFF);
-    ihdr[5] = static_cast<unsigned char>((height >> 16) & 0xFF);
-    ihdr[6] = static_cast<unsigned char>((height >> 8) & 0xFF);
-    ihdr[7] = static_cast<unsigned char>(height & 0xFF);
-    ihdr[8] = 8;
-    ihdr[9] = 2;
-    ihdr[10] = 0;
-    ihdr[11] = 0;
-    ihdr[12] = 0;
-
+    std::vector<unsigned char> ihdr;
+    detail::append_uint32(ihdr, static_cast<std::uint32_t>(width));
+    detail::append_uint32(ihdr, static_cast<std::uint32_t>(height));
+    ihdr.push_back(8);   // Bit depth
+    ihdr.push_back(2);   // Truecolor
+    ihdr.push_back(0);   // Deflate
+    ihdr.push_back(0);   // Adaptive filtering (every row uses filter 0)
+    ihdr.push_back(0);   // Not interlaced
     detail::write_chunk(out, "IHDR", ihdr);
 
-    std::vector<unsigned char> raw;
-    raw.reserve(static_cast<std::size_t>(height) * (static_cast<std::size_t>(width) * 3 + 1));
+    pending.clear();
+    pending.reserve(kChunkBytes + detail::kMaxStoredBlock + detail::kStoredHeaderBytes);
+    pending.push_back(0x78);
+    pending.push_back(0x01);
+    block_start = pending.size();
+    block_fill = 0;
+    pending.resize(block_start + detail::kStoredHeaderBytes);
+    return static_cast<bool>(out);
+}
+
+void RowWriter::close_block(bool is_final_block) {
+    const std::uint16_t len = static_cast<std::uint16_t>(block_fill);
+    const std::uint16_t nlen = static_cast<std::uint16_t>(~len);
+    pending[block_start] = is_final_block ? 1u : 0u;
+    pending[block_start + 1] = static_cast<unsigned char>(len & 0xFF);
+    pending[block_start + 2] = static_cast<unsigned char>((len >> 8) & 0xFF);
+    pending[block_start + 3] = static_cast<unsigned char>(nlen & 0xFF);
+    pending[block_start + 4] = static_cast<unsigned char>((nlen >> 8) & 0xFF);
+}
+
+void RowWriter::flush_chunk() {
+    detail::write_chunk(out, "IDAT", pending);
+    pending.clear();
+}
+
+void RowWriter::append_raw(const unsigned char* data, std::size_t length) {
+    adler = checksum::adler32(data, length, adler);
+    while (length > 0) {
+        // A full block is closed only once more data arrives, so the last
+        // block is never empty and can still be marked final
+        if (block_fill == detail::kMaxStoredBlock) {
+            close_block(false);
+            if (pending.size() >= kChunkBytes) {
+                flush_chunk();
+            }
+            block_start = pending.size();
+            block_fill = 0;
+            pending.resize(block_start + detail::kStoredHeaderBytes);
+        }
+        const std::size_t take = std::min(length, detail::kMaxStoredBlock - block_fill);
+        pending.insert(pending.end(), data, data + take);
+        block_fill += take;
+        data += take;
+        length -= take;
+    }
+}
+
+bool RowWriter::write_rows(const unsigned char* rgb, int rows) {
+    if (!out || rows < 0 || rows > height - rows_done) {
+        return false;
+    }
     const std::size_t row_stride = static_cast<std::size_t>(width) * 3;
-    for (int y = 0; y < height; ++y) {
-        raw.push_back(0);
-        const unsigned char* row_ptr = rgb.data() + static_cast<std::size_t>(y) * row_stride;
-        raw.insert(raw.end(), row_ptr, row_ptr + row_stride);
+    const unsigned char filter = 0;
+    for (int row = 0; row < rows; ++row) {
+        append_raw(&filter, 1);
+        append_raw(rgb + static_cast<std::size_t>(row) * row_stride, row_stride);
     }
+    rows_done += rows;
+    return static_cast<bool>(out);
+}
 
-    const std::vector<unsigned char> zlib_data = detail::make_zlib_stream(raw);
-    detail::write_chunk(out, "IDAT", zlib_data);
+bool RowWriter::finish() {
+    if (!out || rows_done != height) {
+        return false;
+    }
+    close_block(true);
+    detail::append_uint32(pending, adler);
+    flush_chunk();
     detail::write_chunk(out, "IEND", {});
+    out.close();
+    return !out.fail();
+}
 
-    return true;
+bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb) {
+    if (width <= 0 || height <= 0
+        || static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 3 != rgb.size()) {
+        return false;
+    }
+
+    RowWriter writer;
+    return writer.open(filename, width, height) && writer.write_rows(rgb.data(), height) && writer.finish();
 }
 
 } // namespace png_writer
-
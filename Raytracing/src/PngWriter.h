@@ -6,6 +6,9 @@
  * @brief Interface for writing RGB buffers to PNG files.
  */
 
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -13,6 +16,59 @@ namespace png_writer {
 
 bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb);
 
+/**
+ * PNG encoder fed a few rows at a time, for images that never exist in
+ * memory as a whole.
+ *
+ * Rows go into stored deflate blocks as they arrive and leave in IDAT chunks
+ * of about kChunkBytes, so the writer holds one chunk whatever the image
+ * size. The Adler-32 trailer is carried across calls. The bytes written
+ * depend only on the pixels, not on how the rows were split into calls;
+ * write_rgb() is this writer fed the whole image at once.
+ */
+class RowWriter {
+public:
+    /// IDAT payload collected before a chunk is written out
+    static constexpr std::size_t kChunkBytes = std::size_t{1} << 20;
+
+    /**
+     * Create `filename` and write the signature and header.
+     *
+     * @return false if the size is not positive or the file cannot be created
+     */
+    bool open(const std::string& filename, int width, int height);
+
+    /**
+     * Append `rows` rows of packed 8-bit RGB, top to bottom.
+     *
+     * @return false on a write error or more rows than the image has
+     */
+    bool write_rows(const unsigned char* rgb, int rows);
+
+    /**
+     * Close the stream after the last row.
+     *
+     * @return false unless every row was written and the file is intact
+     */
+    bool finish();
+
+    int rows_written() const { return rows_done; }
+
+private:
+    void append_raw(const unsigned char* data, std::size_t length);
+    void close_block(bool is_final_block);
+    void flush_chunk();
+
+    std::ofstream out;
+    int width = 0;
+    int height = 0;
+    int rows_done = 0;
+    std::vector<unsigned char> pending;   ///< IDAT payload not yet written
+    std::size_t block_start = 0;          ///< Header offset of the open stored block in `pending`
+    std::size_t block_fill = 0;           ///< Raw bytes in the open block
+    std::uint32_t adler = 1;
+};
+
 } // namespace png_writer
 
 #endif
@@ -0,0 +1,270 @@
+#include "PrimitiveTable.h"
+
+#include "Box.h"
+#include "CpuFeatures.h"
+#include "Sphere.h"
+
+#include <type_traits>
+#include <typeinfo>
+
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(PrimitiveKind::Sphere), PrimitiveShape>,
+                             SpherePrimitive>, "PrimitiveKind::Sphere out of sync with PrimitiveShape");
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(PrimitiveKind::Rect), PrimitiveShape>,
+                             RectPrimitive>, "PrimitiveKind::Rect out of sync with PrimitiveShape");
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(PrimitiveKind::Extension), PrimitiveShape>,
+                             ExtensionPrimitive>, "PrimitiveKind::Extension out of sync with PrimitiveShape");
+static_assert(std::is_same_v<std::variant_alternative_t<static_cast<std::size_t>(PrimitiveKind::Enclosure), PrimitiveShape>,
+                             EnclosurePrimitive>, "PrimitiveKind::Enclosure out of sync with PrimitiveShape");
+
+namespace {
+
+// Only the exact built-in types are packed: a subclass may override hit()
+// or intersect(), so it stays an extension with virtual dispatch
+template <typename T>
+const T* exactly(const Hittable& object) {
+    return typeid(object) == typeid(T) ? static_cast<const T*>(&object) : nullptr;
+}
+
+const AxisAlignedRect* built_in_rect(const Hittable& object) {
+    const std::type_info& type = typeid(object);
+    return type == typeid(AxisAlignedRect) || type == typeid(XYRect) || type == typeid(XZRect)
+            || type == typeid(YZRect)
+        ? static_cast<const AxisAlignedRect*>(&object)
+        : nullptr;
+}
+
+} // namespace
+
+void PrimitiveTable::clear() {
+    primitive_entries.clear();
+    material_entries.clear();
+}
+
+void PrimitiveTable::build(const HittableList& objects) {
+    clear();
+    for (const auto& object : objects.objects) {
+        append(*object);
+    }
+}
+
+std::uint32_t PrimitiveTable::material_slot(const Material* material) {
+    if (material == nullptr) {
+        return kNoMaterial;
+    }
+
+    // Scenes share a handful of materials, a linear scan is cheapest here
+    for (std::size_t index = 0; index < material_entries.size(); ++index) {
+        if (material_entries[index].source == material) {
+            return static_cast<std::uint32_t>(index);
+        }
+    }
+
+    material_entries.push_back(pack_material(material));
+    return static_cast<std::uint32_t>(material_entries.size() - 1);
+}
+
+void PrimitiveTable::append(const Hittable& object) {
+    if (const auto* sphere = exactly<Sphere>(object)) {
+        primitive_entries.push_back(PackedPrimitive{
+            SpherePrimitive{sphere->center_position, sphere->radius},
+            material_slot(sphere->material_ptr.get())
+        });
+    } else if (const auto* rect = built_in_rect(object)) {
+        primitive_entries.push_back(PackedPrimitive{
+            RectPrimitive{
+                rect->orientation,
+                rect->u0, rect->u1,
+                rect->v0, rect->v1,
+                rect->k,
+                rect->orientation.outward_normal(rect->flip_normal)
+            },
+            material_slot(rect->material_ptr.get())
+        });
+    } else if (const auto* room = exactly<RoomEnclosure>(object)) {
+        EnclosurePrimitive enclosure{room->lo, room->hi, room->open_faces, {}};
+        for (int face = 0; face < kEnclosureFaces; ++face) {
+            enclosure.face_materials[face] = material_slot(room->face_materials[face].get());
+        }
+        primitive_entries.push_back(PackedPrimitive{enclosure, kNoMaterial});
+    } else if (const auto* box = exactly<Box>(object)) {
+        for (const auto& side : box->sides.objects) {
+            append(*side);
+        }
+    } else if (const auto* list = exactly<HittableList>(object)) {
+        for (const auto& child : list->objects) {
+            append(*child);
+        }
+    } else {
+        primitive_entries.push_back(PackedPrimitive{ExtensionPrimitive{&object}, kNoMaterial});
+    }
+}
+
+namespace {
+
+// Linear closest-hit scan over the packed entries, shared by every ISA variant.
+// `index_of` maps a loop position to a table index (identity for the full
+// table, an index list for subsets) so both scans run the same arithmetic.
+template <typename IndexOf>
+RAYTRACER_FORCE_INLINE bool scan_entries(const PrimitiveTable* table, const PackedPrimitive* entries,
+                                         std::size_t count, IndexOf index_of, const Ray& ray, double min_distance,
+                                         double max_distance, HitCandidate& candidate) {
+    bool hit_anything = false;
+    double closest_so_far = max_distance;
+
+    for (std::size_t position = 0; position < count; ++position) {
+        const std::uint32_t index = index_of(position);
+        const PrimitiveShape& shape = entries[index].shape;
+        double t = 0.0;
+        double u_coord = 0.0;
+        double v_coord = 0.0;
+        bool hit_this = false;
+
+        switch (primitive_kind(shape)) {
+        case PrimitiveKind::Sphere: {
+            const auto& sphere = *std::get_if<SpherePrimitive>(&shape);
+            hit_this = intersect_sphere(sphere.center, sphere.radius, ray, min_distance, closest_so_far, t);
+            break;
+        }
+        case PrimitiveKind::Rect: {
+            const auto& rect = *std::get_if<RectPrimitive>(&shape);
+            hit_this = intersect_axis_aligned_rect(rect.orientation, rect.u0, rect.u1, rect.v0, rect.v1, rect.k,
+                                                   ray, min_distance, closest_so_far, t, u_coord, v_coord);
+            break;
+        }
+        case PrimitiveKind::Extension: {
+            // Extensions fill the candidate themselves (primitive = their leaf)
+            const auto& extension = *std::get_if<ExtensionPrimitive>(&shape);
+            if (extension.object->intersect(ray, min_distance, closest_so_far, candidate)) {
+                hit_anything = true;
+                closest_so_far = candidate.distance_from_ray;
+                candidate.primitive_index = index;
+            }
+            continue;
+        }
+        case PrimitiveKind::Enclosure: {
+            const auto& enclosure = *std::get_if<EnclosurePrimitive>(&shape);
+            int face = 0;
+            hit_this = intersect_room_enclosure(enclosure.lo, enclosure.hi, enclosure.open_faces, ray,
+                                                min_distance, closest_so_far, t, face);
+            u_coord = face;
+            break;
+        }
+        }
+
+        if (hit_this) {
+            hit_anything = true;
+            closest_so_far = t;
+            candidate.distance_from_ray = t;
+            candidate.primitive = table;
+            candidate.primitive_index = index;
+            candidate.u = u_coord;
+            candidate.v = v_coord;
+        }
+    }
+
+    return hit_anything;
+}
+
+RAYTRACER_FORCE_INLINE bool intersect_entries_body(const PrimitiveTable* table, const PackedPrimitive* entries,
+                                                   std::size_t count, const Ray& ray, double min_distance,
+                                                   double max_distance, HitCandidate& candidate) {
+    return scan_entries(table, entries, count,
+                        [](std::size_t position) { return static_cast<std::uint32_t>(position); },
+                        ray, min_distance, max_distance, candidate);
+}
+
+RAYTRACER_FORCE_INLINE bool intersect_indexed_body(const PrimitiveTable* table, const PackedPrimitive* entries,
+                                                   const std::uint32_t* indices, std::size_t count, const Ray& ray,
+                                                   double min_distance, double max_distance,
+                                                   HitCandidate& candidate) {
+    return scan_entries(table, entries, count, [indices](std::size_t position) { return indices[position]; },
+                        ray, min_distance, max_distance, candidate);
+}
+
+RAYTRACER_DEFINE_ISA_VARIANTS(bool, intersect_entries, intersect_entries_body,
+                              (const PrimitiveTable* table, const PackedPrimitive* entries, std::size_t count,
+                               const Ray& ray, double min_distance, double max_distance, HitCandidate& candidate),
+                              (table, entries, count, ray, min_distance, max_distance, candidate))
+
+using IntersectKernel = bool (*)(const PrimitiveTable*, const PackedPrimitive*, std::size_t, const Ray&,
+                                 double, double, HitCandidate&);
+
+const cpu_features::IsaVariants<IntersectKernel> intersect_kernels = RAYTRACER_ISA_VARIANT_TABLE(intersect_entries);
+
+RAYTRACER_DEFINE_ISA_VARIANTS(bool, intersect_indexed, intersect_indexed_body,
+                              (const PrimitiveTable* table, const PackedPrimitive* entries,
+                               const std::uint32_t* indices, std::size_t count, const Ray& ray,
+                               double min_distance, double max_distance, HitCandidate& candidate),
+                              (table, entries, indices, count, ray, min_distance, max_distance, candidate))
+
+using IndexedIntersectKernel = bool (*)(const PrimitiveTable*, const PackedPrimitive*, const std::uint32_t*,
+                                        std::size_t, const Ray&, double, double, HitCandidate&);
+
+const cpu_features::IsaVariants<IndexedIntersectKernel> indexed_intersect_kernels =
+    RAYTRACER_ISA_VARIANT_TABLE(intersect_indexed);
+
+} // namespace
+
+bool PrimitiveTable::intersect(const Ray& ray, double min_distance, double max_distance,
+                               HitCandidate& candidate) const {
+    return intersect_kernels.active()(this, primitive_entries.data(), primitive_entries.size(),
+                                      ray, min_distance, max_distance, candidate);
+}
+
+bool PrimitiveTable::intersect_primitive(std::uint32_t index, const Ray& ray, double min_distance,
+                                         double max_distance, HitCandidate& candidate) const {
+    return indexed_intersect_kernels.active()(this, primitive_entries.data(), &index, 1,
+                                              ray, min_distance, max_distance, candidate);
+}
+
+bool PrimitiveTable::intersect_subset(const std::uint32_t* indices, std::size_t count, const Ray& ray,
+                                      double min_distance, double max_distance, HitCandidate& candidate) const {
+    return indexed_intersect_kernels.active()(this, primitive_entries.data(), indices, count,
+                                              ray, min_distance, max_distance, candidate);
+}
+
+bool PrimitiveTable::hit_subset(const std::uint32_t* indices, std::size_t count, const Ray& ray,
+                                double min_distance, double max_distance, HitRecord& record) const {
+    HitCandidate candidate;
+    if (!intersect_subset(indices, count, ray, min_distance, max_distance, candidate)) {
+        return false;
+    }
+    candidate.primitive->fill_hit_record(ray, candidate, record);
+    return true;
+}
+
+void PrimitiveTable::fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                                     HitRecord& record) const {
+    const PackedPrimitive& primitive = primitive_entries[candidate.primitive_index];
+
+    if (primitive_kind(primitive.shape) == PrimitiveKind::Extension) {
+        candidate.primitive->fill_hit_record(ray, candidate, record);
+        record.packed_material = nullptr;
+        return;
+    }
+
+    record.distance_from_ray = candidate.distance_from_ray;
+    record.hit_point = ray.at(candidate.distance_from_ray);
+
+    Vec3 outward_normal;
+    std::uint32_t material_index = primitive.material_index;
+    if (const auto* sphere = std::get_if<SpherePrimitive>(&primitive.shape)) {
+        outward_normal = (record.hit_point - sphere->center) / sphere->radius;
+    } else if (const auto* rect = std::get_if<RectPrimitive>(&primitive.shape)) {
+        outward_normal = rect->outward_normal;
+    } else {
+        const int face = static_cast<int>(candidate.u);
+        outward_normal = enclosure_inward_normal(face);
+        material_index = std::get_if<EnclosurePrimitive>(&primitive.shape)->face_materials[face];
+    }
+    record.set_face_normal(ray, outward_normal);
+
+    if (material_index == kNoMaterial) {
+        record.material_ptr = nullptr;
+        record.packed_material = nullptr;
+    } else {
+        const PackedMaterial& material = material_entries[material_index];
+        record.material_ptr = material.source;
+        record.packed_material = &material;
+    }
+}
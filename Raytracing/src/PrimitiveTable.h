@@ -0,0 +1,158 @@
+#ifndef PRIMITIVE_TABLE_H
+#define PRIMITIVE_TABLE_H
+
+/**
+ * @file PrimitiveTable.h
+ * @brief Contiguous tagged-union storage for the built-in primitives.
+ */
+
+#include "AxisAlignedRect.h"
+#include "Hittable.h"
+#include "HittableList.h"
+#include "PackedMaterial.h"
+#include "Ray.h"
+#include "RoomEnclosure.h"
+#include "Vec3.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+/**
+ * Sphere stored by value inside the table.
+ */
+struct SpherePrimitive {
+    Point3 center;
+    double radius;
+};
+
+/**
+ * Axis-aligned rectangle stored by value; the normal is pre-flipped.
+ */
+struct RectPrimitive {
+    RectOrientation orientation;
+    double u0;
+    double u1;
+    double v0;
+    double v1;
+    double k;
+    Vec3 outward_normal;
+};
+
+/**
+ * Room shell stored by value: box bounds, open-face mask and one material
+ * slot per face (the entry's own material_index is kNoMaterial).
+ */
+struct EnclosurePrimitive {
+    Point3 lo;
+    Point3 hi;
+    unsigned open_faces;
+    std::array<std::uint32_t, kEnclosureFaces> face_materials;
+};
+
+/**
+ * User-defined geometry that is not part of the closed set.
+ * Intersected through the virtual Hittable interface.
+ */
+struct ExtensionPrimitive {
+    const Hittable* object;
+};
+
+using PrimitiveShape = std::variant<SpherePrimitive, RectPrimitive, ExtensionPrimitive, EnclosurePrimitive>;
+
+/**
+ * Names for the PrimitiveShape alternatives, usable in a switch on index().
+ */
+enum class PrimitiveKind : std::size_t {
+    Sphere = 0,
+    Rect = 1,
+    Extension = 2,
+    Enclosure = 3
+};
+
+/**
+ * Tag of a primitive shape.
+ */
+inline PrimitiveKind primitive_kind(const PrimitiveShape& shape) {
+    return static_cast<PrimitiveKind>(shape.index());
+}
+
+/**
+ * One slot of the table: shape plus index into the packed material array.
+ */
+struct PackedPrimitive {
+    PrimitiveShape shape;
+    std::uint32_t material_index;
+};
+
+/**
+ * Flattened, closed-set view of a HittableList.
+ *
+ * Spheres, rectangles, room enclosures and boxes (expanded to their six
+ * faces) are copied by value into one contiguous array and dispatched with
+ * a switch on the variant tag instead of a virtual call through shared_ptr.
+ * Their materials
+ * are packed the same way (see PackedMaterial). Objects are matched by their
+ * exact type: other Hittable classes, including subclasses of the built-in
+ * ones, are kept as ExtensionPrimitive entries and still use virtual dispatch.
+ *
+ * The table references the materials and extension objects of the list it
+ * was built from, so that list must outlive it.
+ */
+class PrimitiveTable : public Hittable {
+public:
+    static constexpr std::uint32_t kNoMaterial = 0xFFFFFFFFu;
+
+    /**
+     * Rebuild the table from a scene object list.
+     */
+    void build(const HittableList& objects);
+
+    /**
+     * Remove all primitives and materials.
+     */
+    void clear();
+
+    bool intersect(const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override;
+
+    /**
+     * Closest-hit test against the single primitive at `index`, with the
+     * same kernel as intersect() so both agree bit for bit.
+     */
+    bool intersect_primitive(std::uint32_t index, const Ray& ray, double min_distance, double max_distance,
+                             HitCandidate& candidate) const;
+
+    /**
+     * Closest-hit test restricted to the primitives listed in `indices`
+     * (table indices, any order), e.g. those a culling pass kept.
+     */
+    bool intersect_subset(const std::uint32_t* indices, std::size_t count, const Ray& ray,
+                          double min_distance, double max_distance, HitCandidate& candidate) const;
+
+    /**
+     * Both phases of intersect_subset(), like Hittable::hit().
+     */
+    bool hit_subset(const std::uint32_t* indices, std::size_t count, const Ray& ray,
+                    double min_distance, double max_distance, HitRecord& record) const;
+
+    void fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                         HitRecord& record) const override;
+
+    const std::vector<PackedPrimitive>& primitives() const { return primitive_entries; }
+    const std::vector<PackedMaterial>& materials() const { return material_entries; }
+
+    std::size_t primitive_count() const { return primitive_entries.size(); }
+    std::size_t material_count() const { return material_entries.size(); }
+
+private:
+    void append(const Hittable& object);
+    std::uint32_t material_slot(const Material* material);
+
+    std::vector<PackedPrimitive> primitive_entries;
+    std::vector<PackedMaterial> material_entries;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "QoiWriter.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace qoi_writer {
+namespace {
+
+constexpr std::size_t kHeaderBytes = 14;
+constexpr unsigned char kEndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+constexpr unsigned char kOpIndex = 0x00;
+constexpr unsigned char kOpDiff = 0x40;
+constexpr unsigned char kOpLuma = 0x80;
+constexpr unsigned char kOpRun = 0xC0;
+constexpr unsigned char kOpRgb = 0xFE;
+constexpr int kMaxRun = 62;
+
+/// Pixel packed as 0xRRGGBBAA; alpha is always opaque here
+inline std::uint32_t pack(unsigned char r, unsigned char g, unsigned char b) {
+    return (static_cast<std::uint32_t>(r) << 24) | (static_cast<std::uint32_t>(g) << 16)
+         | (static_cast<std::uint32_t>(b) << 8) | 0xFFu;
+}
+
+inline unsigned char* put_uint32(unsigned char* out, std::uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+    return out + 4;
+}
+
+} // namespace
+
+bool encode_rgb(int width, int height, const std::vector<unsigned char>& rgb, std::vector<unsigned char>& qoi) {
+    const std::size_t pixels = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    if (width <= 0 || height <= 0 || pixels * 3 != rgb.size()) {
+        return false;
+    }
+
+    // Worst case is a literal per pixel; trimmed at the end
+    qoi.resize(kHeaderBytes + pixels * 4 + sizeof(kEndMarker));
+    unsigned char* out = qoi.data();
+    std::memcpy(out, "qoif", 4);
+    out = put_uint32(out + 4, static_cast<std::uint32_t>(width));
+    out = put_uint32(out, static_cast<std::uint32_t>(height));
+    *out++ = 3;  // Channels
+    *out++ = 0;  // sRGB with linear alpha
+
+    std::array<std::uint32_t, 64> seen{};
+    const unsigned char* in = rgb.data();
+    unsigned char pr = 0;
+    unsigned char pg = 0;
+    unsigned char pb = 0;
+    int run = 0;
+    for (std::size_t index = 0; index < pixels; ++index, in += 3) {
+        const unsigned char r = in[0];
+        const unsigned char g = in[1];
+        const unsigned char b = in[2];
+        if (r == pr && g == pg && b == pb) {
+            if (++run == kMaxRun) {
+                *out++ = static_cast<unsigned char>(kOpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *out++ = static_cast<unsigned char>(kOpRun | (run - 1));
+            run = 0;
+        }
+
+        const std::uint32_t pixel = pack(r, g, b);
+        const unsigned slot = (r * 3u + g * 5u + b * 7u + 255u * 11u) % 64u;
+        if (seen[slot] == pixel) {
+            *out++ = static_cast<unsigned char>(kOpIndex | slot);
+        } else {
+            seen[slot] = pixel;
+            // Differences wrap around like the decoder's 8-bit arithmetic
+            const int dr = static_cast<signed char>(static_cast<unsigned char>(r - pr));
+            const int dg = static_cast<signed char>(static_cast<unsigned char>(g - pg));
+            const int db = static_cast<signed char>(static_cast<unsigned char>(b - pb));
+            const int dr_dg = dr - dg;
+            const int db_dg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                *out++ = static_cast<unsigned char>(kOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                *out++ = static_cast<unsigned char>(kOpLuma | (dg + 32));
+                *out++ = static_cast<unsigned char>(((dr_dg + 8) << 4) | (db_dg + 8));
+            } else {
+                out[0] = kOpRgb;
+                out[1] = r;
+                out[2] = g;
+                out[3] = b;
+                out += 4;
+            }
+        }
+        pr = r;
+        pg = g;
+        pb = b;
+    }
+    if (run > 0) {
+        *out++ = static_cast<unsigned char>(kOpRun | (run - 1));
+    }
+    std::memcpy(out, kEndMarker, sizeof(kEndMarker));
+    out += sizeof(kEndMarker);
+    qoi.resize(static_cast<std::size_t>(out - qoi.data()));
+    return true;
+}
+
+bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb) {
+    std::vector<unsigned char> qoi;
+    if (!encode_rgb(width, height, rgb, qoi)) {
+        return false;
+    }
+    std::ofstream out(filename, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(qoi.data()), static_cast<std::streamsize>(qoi.size()));
+    return static_cast<bool>(out);
+}
+
+} // namespace qoi_writer
@@ -0,0 +1,31 @@
+#ifndef QOI_WRITER_H
+#define QOI_WRITER_H
+
+/**
+ * @file QoiWriter.h
+ * @brief Lossless QOI encoder for 8-bit RGB previews.
+ *
+ * QOI ("Quite OK Image", qoiformat.org) codes each pixel as a run, an index
+ * into the 64 most recently hashed colours, a small difference to the
+ * previous pixel or a literal. One pass with no entropy coder: an order of
+ * magnitude faster to write than a compressed PNG, at a similar size on
+ * smooth renders.
+ */
+
+#include <string>
+#include <vector>
+
+namespace qoi_writer {
+
+/**
+ * Encode packed top-to-bottom RGB into a QOI stream (sRGB colour space tag).
+ *
+ * @return false if the size is not positive or does not match `rgb`
+ */
+bool encode_rgb(int width, int height, const std::vector<unsigned char>& rgb, std::vector<unsigned char>& qoi);
+
+bool write_rgb(const std::string& filename, int width, int height, const std::vector<unsigned char>& rgb);
+
+} // namespace qoi_writer
+
+#endif
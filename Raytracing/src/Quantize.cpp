@@ -0,0 +1,322 @@
+#include "Quantize.h"
+
+#include "CpuFeatures.h"
+#include "FastMath.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace {
+
+// ---------- Gamma table ----------
+// Index = float bits >> 14 (exponent + 9 mantissa bits), rebased so that
+// 2^-20 maps to entry 0 and the largest float below 1 to the last entry.
+// Values below 2^-20 encode to < 0.25 of a code value and share entry 0.
+constexpr int kMantissaBits = 9;
+constexpr int kExponentRange = 20;
+constexpr int kIndexShift = 23 - kMantissaBits;
+constexpr std::uint32_t kIndexBase = static_cast<std::uint32_t>(127 - kExponentRange) << kMantissaBits;
+constexpr std::size_t kLutSize = static_cast<std::size_t>(kExponentRange) << kMantissaBits;
+constexpr float kLargestBelowOne = 0.99999994f;
+
+// Encoded values are stored as 8.8 fixed point so dither thresholds can be
+// added with integer math before the final shift.
+std::uint32_t encode_fixed(double linear) {
+    const double encoded = std::clamp(std::sqrt(std::max(linear, 0.0)), 0.0, 0.999) * 256.0;
+    return static_cast<std::uint32_t>(encoded * 256.0);
+}
+
+float float_from_bits(std::uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+const std::vector<std::uint32_t>& gamma_table() {
+    static const std::vector<std::uint32_t> table = [] {
+        std::vector<std::uint32_t> entries(kLutSize);
+        for (std::size_t index = 0; index < kLutSize; ++index) {
+            const auto bits = static_cast<std::uint32_t>(index + kIndexBase) << kIndexShift;
+            const double low = float_from_bits(bits);
+            const double high = float_from_bits(bits + (1u << kIndexShift));
+            entries[index] = encode_fixed(0.5 * (low + high));
+        }
+        return entries;
+    }();
+    return table;
+}
+
+// ---------- Dither thresholds ----------
+// 64x64 tiles of thresholds in [0, 256): added to the 8.8 value, they
+// shift it by (t + 0.5) / 256 of a code value before truncation.
+constexpr int kMaskSize = 64;
+constexpr int kMaskCells = kMaskSize * kMaskSize;
+
+std::array<std::uint8_t, kMaskCells> make_bayer_thresholds() {
+    std::array<std::uint8_t, kMaskCells> thresholds{};
+    for (int y = 0; y < kMaskSize; ++y) {
+        for (int x = 0; x < kMaskSize; ++x) {
+            // Bit-interleave x ^ y and y, lowest bits most significant, to get the 8x8 Bayer rank
+            int rank = 0;
+            const int xy = (x ^ y) & 7;
+            const int yy = y & 7;
+            for (int bit = 0; bit < 3; ++bit) {
+                rank = (rank << 2) | (((xy >> bit) & 1) << 1) | ((yy >> bit) & 1);
+            }
+            thresholds[static_cast<std::size_t>(y * kMaskSize + x)] = static_cast<std::uint8_t>(rank * 4 + 2);
+        }
+    }
+    return thresholds;
+}
+
+const std::array<std::uint8_t, kMaskCells>& thresholds_for(DitherMode dither) {
+    static const std::array<std::uint8_t, kMaskCells> none{};
+    static const std::array<std::uint8_t, kMaskCells> bayer = make_bayer_thresholds();
+    static const std::array<std::uint8_t, kMaskCells> blue = [] {
+        std::array<std::uint8_t, kMaskCells> thresholds{};
+        const std::vector<std::uint16_t>& ranks = blue_noise_ranks();
+        for (std::size_t cell = 0; cell < kMaskCells; ++cell) {
+            thresholds[cell] = static_cast<std::uint8_t>(ranks[cell] / (kMaskCells / 256));
+        }
+        return thresholds;
+    }();
+
+    switch (dither) {
+    case DitherMode::Ordered:
+        return bayer;
+    case DitherMode::BlueNoise:
+        return blue;
+    case DitherMode::None:
+        break;
+    }
+    return none;
+}
+
+// ---------- Void-and-cluster (Ulichney 1993) ----------
+
+class EnergyField {
+public:
+    EnergyField() : energy(kMaskCells, 0.0), kernel(kMaskCells) {
+        constexpr double sigma = 1.5;
+        for (int dy = 0; dy < kMaskSize; ++dy) {
+            for (int dx = 0; dx < kMaskSize; ++dx) {
+                const int wrapped_x = std::min(dx, kMaskSize - dx);
+                const int wrapped_y = std::min(dy, kMaskSize - dy);
+                kernel[static_cast<std::size_t>(dy * kMaskSize + dx)] =
+                    std::exp(-(wrapped_x * wrapped_x + wrapped_y * wrapped_y) / (2.0 * sigma * sigma));
+            }
+        }
+    }
+
+    // Add (sign = +1) or remove (sign = -1) a point's toroidal Gaussian
+    void splat(int cell, double sign) {
+        const int px = cell % kMaskSize;
+        const int py = cell / kMaskSize;
+        for (int y = 0; y < kMaskSize; ++y) {
+            const int dy = (y - py + kMaskSize) % kMaskSize;
+            for (int x = 0; x < kMaskSize; ++x) {
+                const int dx = (x - px + kMaskSize) % kMaskSize;
+                energy[static_cast<std::size_t>(y * kMaskSize + x)] +=
+                    sign * kernel[static_cast<std::size_t>(dy * kMaskSize + dx)];
+            }
+        }
+    }
+
+    // Tightest cluster (max energy) or largest void (min energy) among cells whose pattern value is `value`
+    int extreme(const std::vector<char>& pattern, char value, bool want_max) const {
+        int best = -1;
+        for (int cell = 0; cell < kMaskCells; ++cell) {
+            if (pattern[static_cast<std::size_t>(cell)] != value) {
+                continue;
+            }
+            const double e = energy[static_cast<std::size_t>(cell)];
+            if (best < 0 || (want_max ? e > energy[static_cast<std::size_t>(best)]
+                                      : e < energy[static_cast<std::size_t>(best)])) {
+                best = cell;
+            }
+        }
+        return best;
+    }
+
+    std::vector<double> energy;
+
+private:
+    std::vector<double> kernel;
+};
+
+std::vector<std::uint16_t> generate_blue_noise() {
+    std::vector<char> pattern(kMaskCells, 0);
+    EnergyField field;
+
+    // Initial random pattern with ~10% minority pixels (fixed seed: the mask is a constant)
+    std::mt19937 generator(0x5EED);
+    int ones = 0;
+    while (ones < kMaskCells / 10) {
+        const int cell = static_cast<int>(generator() % kMaskCells);
+        if (!pattern[static_cast<std::size_t>(cell)]) {
+            pattern[static_cast<std::size_t>(cell)] = 1;
+            field.splat(cell, 1.0);
+            ++ones;
+        }
+    }
+
+    // Relax into the prototype: move the tightest cluster into the largest void until stable
+    while (true) {
+        const int cluster = field.extreme(pattern, 1, true);
+        pattern[static_cast<std::size_t>(cluster)] = 0;
+        field.splat(cluster, -1.0);
+        const int void_cell = field.extreme(pattern, 0, false);
+        pattern[static_cast<std::size_t>(void_cell)] = 1;
+        field.splat(void_cell, 1.0);
+        if (void_cell == cluster) {
+            break;
+        }
+    }
+
+    std::vector<std::uint16_t> ranks(kMaskCells, 0);
+
+    // Phase 1: rank the prototype's points by removing tightest clusters
+    {
+        std::vector<char> working = pattern;
+        EnergyField working_field = field;
+        for (int rank = ones - 1; rank >= 0; --rank) {
+            const int cluster = working_field.extreme(working, 1, true);
+            working[static_cast<std::size_t>(cluster)] = 0;
+            working_field.splat(cluster, -1.0);
+            ranks[static_cast<std::size_t>(cluster)] = static_cast<std::uint16_t>(rank);
+        }
+    }
+
+    // Phase 2: fill the largest voids up to half coverage
+    int rank = ones;
+    for (; rank < kMaskCells / 2; ++rank) {
+        const int void_cell = field.extreme(pattern, 0, false);
+        pattern[static_cast<std::size_t>(void_cell)] = 1;
+        field.splat(void_cell, 1.0);
+        ranks[static_cast<std::size_t>(void_cell)] = static_cast<std::uint16_t>(rank);
+    }
+
+    // Phase 3: zeros are now the minority; rank their tightest clusters
+    EnergyField zero_field;
+    for (int cell = 0; cell < kMaskCells; ++cell) {
+        if (!pattern[static_cast<std::size_t>(cell)]) {
+            zero_field.splat(cell, 1.0);
+        }
+    }
+    for (; rank < kMaskCells; ++rank) {
+        const int cluster = zero_field.extreme(pattern, 0, true);
+        pattern[static_cast<std::size_t>(cluster)] = 1;
+        zero_field.splat(cluster, -1.0);
+        ranks[static_cast<std::size_t>(cluster)] = static_cast<std::uint16_t>(rank);
+    }
+
+    return ranks;
+}
+
+// ---------- Row kernels ----------
+
+RAYTRACER_FORCE_INLINE std::uint32_t lut_index(float linear) {
+    // Negative and NaN inputs clamp to 0, the comparison fails for NaN
+    const float clamped = std::min(linear > 0.0f ? linear : 0.0f, kLargestBelowOne);
+    std::uint32_t bits;
+    std::memcpy(&bits, &clamped, sizeof(bits));
+    const std::int32_t index = static_cast<std::int32_t>(bits >> kIndexShift) - static_cast<std::int32_t>(kIndexBase);
+    return static_cast<std::uint32_t>(std::max(index, 0));
+}
+
+// Thresholds for one image row, repeated per channel: 64 pixels x 3 channels
+constexpr int kRowPattern = kMaskSize * 3;
+
+RAYTRACER_FORCE_INLINE void quantize_row_lut_body(const float* in, unsigned char* out, std::size_t count,
+                                                  const std::uint8_t* row_thresholds,
+                                                  const std::uint32_t* table) {
+    for (std::size_t start = 0; start < count; start += kRowPattern) {
+        const std::size_t span = std::min<std::size_t>(kRowPattern, count - start);
+        for (std::size_t j = 0; j < span; ++j) {
+            const std::uint32_t fixed = table[lut_index(in[start + j])] + row_thresholds[j];
+            out[start + j] = static_cast<unsigned char>(std::min<std::uint32_t>(fixed >> 8, 255u));
+        }
+    }
+}
+
+RAYTRACER_FORCE_INLINE void quantize_row_approx_body(const float* in, unsigned char* out, std::size_t count,
+                                                     const std::uint8_t* row_thresholds) {
+    for (std::size_t start = 0; start < count; start += kRowPattern) {
+        const std::size_t span = std::min<std::size_t>(kRowPattern, count - start);
+        for (std::size_t j = 0; j < span; ++j) {
+            const double encoded = std::min(fast_math::gamma_encode(in[start + j]), 0.999);
+            const auto fixed = static_cast<std::uint32_t>(encoded * 65536.0) + row_thresholds[j];
+            out[start + j] = static_cast<unsigned char>(std::min<std::uint32_t>(fixed >> 8, 255u));
+        }
+    }
+}
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, quantize_row_lut, quantize_row_lut_body,
+                              (const float* in, unsigned char* out, std::size_t count,
+                               const std::uint8_t* row_thresholds, const std::uint32_t* table),
+                              (in, out, count, row_thresholds, table))
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, quantize_row_approx, quantize_row_approx_body,
+                              (const float* in, unsigned char* out, std::size_t count,
+                               const std::uint8_t* row_thresholds),
+                              (in, out, count, row_thresholds))
+
+using LutRowKernel = void (*)(const float*, unsigned char*, std::size_t, const std::uint8_t*, const std::uint32_t*);
+using ApproxRowKernel = void (*)(const float*, unsigned char*, std::size_t, const std::uint8_t*);
+
+const cpu_features::IsaVariants<LutRowKernel> lut_row_kernels = RAYTRACER_ISA_VARIANT_TABLE(quantize_row_lut);
+const cpu_features::IsaVariants<ApproxRowKernel> approx_row_kernels = RAYTRACER_ISA_VARIANT_TABLE(quantize_row_approx);
+
+} // namespace
+
+const std::vector<std::uint16_t>& blue_noise_ranks() {
+    static const std::vector<std::uint16_t> ranks = generate_blue_noise();
+    return ranks;
+}
+
+void quantize_row(const float* in, int width, int row, DitherMode dither, unsigned char* out) {
+    const std::array<std::uint8_t, kMaskCells>& thresholds = thresholds_for(dither);
+    const std::size_t row_values = static_cast<std::size_t>(width) * 3;
+
+    std::array<std::uint8_t, kRowPattern> row_thresholds{};
+    const std::uint8_t* mask_row = thresholds.data() + static_cast<std::size_t>(row % kMaskSize) * kMaskSize;
+    for (int x = 0; x < kMaskSize; ++x) {
+        row_thresholds[static_cast<std::size_t>(x * 3 + 0)] = mask_row[x];
+        row_thresholds[static_cast<std::size_t>(x * 3 + 1)] = mask_row[x];
+        row_thresholds[static_cast<std::size_t>(x * 3 + 2)] = mask_row[x];
+    }
+
+    if (fast_math::enabled(fast_math::Gamma)) {
+        approx_row_kernels.active()(in, out, row_values, row_thresholds.data());
+    } else {
+        lut_row_kernels.active()(in, out, row_values, row_thresholds.data(), gamma_table().data());
+    }
+}
+
+void quantize_rows(const Framebuffer& framebuffer, DitherMode dither,
+                   int row_begin, int row_end, unsigned char* out) {
+    const std::size_t row_values = static_cast<std::size_t>(framebuffer.width) * 3;
+    for (int row = row_begin; row < row_end; ++row) {
+        quantize_row(framebuffer.pixels.data() + static_cast<std::size_t>(row) * row_values, framebuffer.width,
+                     row, dither, out + static_cast<std::size_t>(row - row_begin) * row_values);
+    }
+}
+
+std::vector<unsigned char> quantize_framebuffer(const Framebuffer& framebuffer, DitherMode dither) {
+    std::vector<unsigned char> bytes(framebuffer.pixel_count() * 3);
+    // Warm the lazily built tables once, outside the parallel region
+    thresholds_for(dither);
+    gamma_table();
+
+    const std::size_t row_bytes = static_cast<std::size_t>(framebuffer.width) * 3;
+    parallel_for(0, static_cast<std::size_t>(framebuffer.height), 16,
+                 [&](std::size_t first, std::size_t last) {
+                     quantize_rows(framebuffer, dither, static_cast<int>(first), static_cast<int>(last),
+                                   bytes.data() + first * row_bytes);
+                 });
+    return bytes;
+}
@@ -0,0 +1,60 @@
+#ifndef QUANTIZE_H
+#define QUANTIZE_H
+
+/**
+ * @file Quantize.h
+ * @brief Post-processing stage converting a float framebuffer to 8-bit RGB.
+ */
+
+#include "Framebuffer.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Dither applied before truncating to 8 bits.
+ * Without dither the slow sky gradient shows visible bands; a threshold
+ * pattern below one code value trades them for fine, even noise.
+ */
+enum class DitherMode {
+    None,       ///< Plain truncation (matches convert_to_byte)
+    Ordered,    ///< 8x8 Bayer matrix
+    BlueNoise   ///< 64x64 void-and-cluster mask
+};
+
+/**
+ * Quantize a linear framebuffer to packed 8-bit RGB.
+ *
+ * Gamma-2 encoding goes through a 10K-entry table indexed by the float's
+ * exponent and top 9 mantissa bits (constant relative resolution, so dark
+ * values are as accurate as bright ones), or through
+ * fast_math::gamma_encode when the Gamma fast-math kernel is enabled. Both
+ * paths are branch-free integer/float loops over whole rows and run across
+ * rows in parallel.
+ *
+ * @param framebuffer Linear RGB input
+ * @param dither Dither pattern to add before truncation
+ * @return width * height * 3 bytes, rows top to bottom
+ */
+std::vector<unsigned char> quantize_framebuffer(const Framebuffer& framebuffer, DitherMode dither);
+
+/**
+ * Quantize rows [row_begin, row_end) into `out` (which points at row_begin's
+ * first byte). Single-threaded building block of quantize_framebuffer.
+ */
+void quantize_rows(const Framebuffer& framebuffer, DitherMode dither,
+                   int row_begin, int row_end, unsigned char* out);
+
+/**
+ * Quantize one row of `width` interleaved RGB floats into `out`. `row` is
+ * the row's index in the image, which picks the dither pattern row, so an
+ * image quantized a row at a time matches quantize_framebuffer.
+ */
+void quantize_row(const float* in, int width, int row, DitherMode dither, unsigned char* out);
+
+/**
+ * 64x64 blue-noise ranks (0..4095), generated once on first use.
+ */
+const std::vector<std::uint16_t>& blue_noise_ranks();
+
+#endif
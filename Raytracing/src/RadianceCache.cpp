@@ -0,0 +1,81 @@
+#include "RadianceCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 19 bits per cell coordinate (offset binary) and 7 bits of normal bin
+constexpr int kCoordinateBits = 19;
+constexpr std::int64_t kCoordinateOffset = std::int64_t{1} << (kCoordinateBits - 1);
+constexpr std::int64_t kCoordinateMax = (std::int64_t{1} << kCoordinateBits) - 1;
+constexpr int kMaxNormalBins = 11;  // 11^2 = 121 < 2^7
+
+std::uint64_t grid_coordinate(double value) {
+    const auto cell = static_cast<std::int64_t>(std::floor(value)) + kCoordinateOffset;
+    return static_cast<std::uint64_t>(std::clamp<std::int64_t>(cell, 0, kCoordinateMax));
+}
+
+// Octahedral map of a unit vector to [0, 1]^2, so bins cover roughly equal solid angles
+void octahedral(const Vec3& normal, double& u, double& v) {
+    const double inverse_l1 = 1.0 / (std::fabs(normal.x()) + std::fabs(normal.y()) + std::fabs(normal.z()));
+    double x = normal.x() * inverse_l1;
+    double y = normal.y() * inverse_l1;
+    if (normal.z() < 0.0) {
+        const double folded_x = (1.0 - std::fabs(y)) * (x >= 0.0 ? 1.0 : -1.0);
+        const double folded_y = (1.0 - std::fabs(x)) * (y >= 0.0 ? 1.0 : -1.0);
+        x = folded_x;
+        y = folded_y;
+    }
+    u = 0.5 * (x + 1.0);
+    v = 0.5 * (y + 1.0);
+}
+
+} // namespace
+
+RadianceCache::RadianceCache(const RadianceCacheSettings& settings)
+    : cache_settings(settings)
+    , inverse_cell_size(1.0 / settings.cell_size)
+{
+    cache_settings.normal_bins = std::clamp(cache_settings.normal_bins, 1, kMaxNormalBins);
+    cache_settings.min_samples = std::max(cache_settings.min_samples, 1);
+}
+
+std::uint64_t RadianceCache::key(const Point3& point, const Vec3& normal) const {
+    double u = 0.0;
+    double v = 0.0;
+    octahedral(normal, u, v);
+    const int bins = cache_settings.normal_bins;
+    const int bin_u = std::min(static_cast<int>(u * bins), bins - 1);
+    const int bin_v = std::min(static_cast<int>(v * bins), bins - 1);
+    const auto normal_bin = static_cast<std::uint64_t>(bin_v * bins + bin_u);
+
+    return (grid_coordinate(point.x() * inverse_cell_size) << (2 * kCoordinateBits + 7))
+         | (grid_coordinate(point.y() * inverse_cell_size) << (kCoordinateBits + 7))
+         | (grid_coordinate(point.z() * inverse_cell_size) << 7)
+         | normal_bin;
+}
+
+void RadianceCache::record(const Point3& point, const Vec3& normal, const Color& radiance) {
+    const std::uint64_t cell_key = key(point, normal);
+    std::lock_guard<std::mutex> lock(record_mutex);
+    Cell& cell = cells[cell_key];
+    cell.sum += radiance;
+    ++cell.count;
+    ++records;
+}
+
+bool RadianceCache::lookup(const Point3& point, const Vec3& normal, Color& radiance) const {
+    const auto found = cells.find(key(point, normal));
+    if (found == cells.end() || found->second.count < static_cast<std::uint32_t>(cache_settings.min_samples)) {
+        return false;
+    }
+    radiance = found->second.sum / static_cast<double>(found->second.count);
+    return true;
+}
+
+void RadianceCache::clear() {
+    std::lock_guard<std::mutex> lock(record_mutex);
+    cells.clear();
+    records = 0;
+}
@@ -0,0 +1,87 @@
+#ifndef RADIANCE_CACHE_H
+#define RADIANCE_CACHE_H
+
+/**
+ * @file RadianceCache.h
+ * @brief World-space cache of outgoing radiance at diffuse surfaces.
+ *
+ * Lambertian surfaces reflect the same radiance in every direction, and in
+ * the room scenes it varies slowly across a wall. A short warm-up pass
+ * records full path estimates into a hashed grid of cells keyed on position
+ * and normal; the main pass then ends paths at their secondary diffuse hits
+ * with the cell average instead of tracing on. This trades noise and time
+ * for bias (light leaking across a cell), so it is meant for previews.
+ */
+
+#include "Vec3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * Whether the renderer uses the radiance cache.
+ */
+enum class RadianceCacheMode {
+    Off,     ///< Unbiased: every path is traced in full (final-quality frames)
+    Preview  ///< Warm up the cache, then terminate secondary diffuse paths in it
+};
+
+/**
+ * Bias and cost knobs of the radiance cache.
+ */
+struct RadianceCacheSettings {
+    RadianceCacheMode mode = RadianceCacheMode::Off;
+    double cell_size = 0.25;            ///< Grid cell edge in world units; larger = smoother and more biased
+    int normal_bins = 4;                ///< Octahedral normal bins per axis (bins^2 directions, at most 11)
+    int min_samples = 8;                ///< Records a cell needs before lookups trust it
+    int lookup_bounce = 1;              ///< Diffuse hits traced exactly before lookups (1 = first secondary hit)
+    int warmup_samples_per_pixel = 4;   ///< Full paths per pixel traced to populate the cache
+};
+
+/**
+ * Hashed grid of averaged outgoing radiance.
+ *
+ * record() may be called from several threads; lookup() is lock-free and
+ * must not overlap with record() (the renderer warms the cache first and
+ * only reads it afterwards).
+ */
+class RadianceCache {
+public:
+    explicit RadianceCache(const RadianceCacheSettings& settings = RadianceCacheSettings());
+
+    /**
+     * Add one radiance estimate leaving `point` along hemisphere `normal`.
+     */
+    void record(const Point3& point, const Vec3& normal, const Color& radiance);
+
+    /**
+     * Average radiance of the cell containing `point` / `normal`.
+     *
+     * @return false if the cell has fewer than settings().min_samples records
+     */
+    bool lookup(const Point3& point, const Vec3& normal, Color& radiance) const;
+
+    void clear();
+
+    std::size_t cell_count() const { return cells.size(); }
+    std::size_t record_count() const { return records; }
+    const RadianceCacheSettings& settings() const { return cache_settings; }
+
+private:
+    struct Cell {
+        Color sum;
+        std::uint32_t count = 0;
+    };
+
+    std::uint64_t key(const Point3& point, const Vec3& normal) const;
+
+    RadianceCacheSettings cache_settings;
+    double inverse_cell_size;
+    std::unordered_map<std::uint64_t, Cell> cells;
+    std::size_t records = 0;
+    std::mutex record_mutex;
+};
+
+#endif
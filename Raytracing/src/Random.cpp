@@ -0,0 +1,131 @@
+#include "Random.h"
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t kBaseSeed = 0x853C49E6748FEA9Bull;
+constexpr std::uint64_t kStreamStride = 0x9E3779B97F4A7C15ull;
+
+std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+RAYTRACER_FORCE_INLINE std::uint64_t rotate_left(std::uint64_t value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+// Put the top 52 random bits in the mantissa of a double in [1, 2) and
+// subtract one. Pure integer ops plus one subtract, so it vectorizes on
+// targets without a 64-bit int-to-double conversion.
+RAYTRACER_FORCE_INLINE double to_unit_double(std::uint64_t bits) {
+    const std::uint64_t mantissa = (bits >> 12) | 0x3FF0000000000000ull;
+    double value;
+    std::memcpy(&value, &mantissa, sizeof(value));
+    return value - 1.0;
+}
+
+// Lane state is passed as raw arrays so the ISA variants can be free functions
+RAYTRACER_FORCE_INLINE void fill_uniform_body(std::uint64_t* __restrict s0, std::uint64_t* __restrict s1,
+                                              std::uint64_t* __restrict s2, std::uint64_t* __restrict s3,
+                                              double* out, std::size_t count) {
+    constexpr std::size_t kLanes = XoshiroLanes::kLanes;
+    alignas(64) double block[kLanes];
+    std::size_t written = 0;
+    while (written < count) {
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            const std::uint64_t result = s0[lane] + s3[lane];
+            const std::uint64_t t = s1[lane] << 17;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = rotate_left(s3[lane], 45);
+            block[lane] = to_unit_double(result);
+        }
+        const std::size_t take = std::min(kLanes, count - written);
+        std::copy(block, block + take, out + written);
+        written += take;
+    }
+}
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, fill_uniform, fill_uniform_body,
+                              (std::uint64_t* s0, std::uint64_t* s1, std::uint64_t* s2, std::uint64_t* s3,
+                               double* out, std::size_t count),
+                              (s0, s1, s2, s3, out, count))
+
+using FillKernel = void (*)(std::uint64_t*, std::uint64_t*, std::uint64_t*, std::uint64_t*, double*, std::size_t);
+
+const cpu_features::IsaVariants<FillKernel> fill_kernels = RAYTRACER_ISA_VARIANT_TABLE(fill_uniform);
+
+std::atomic<std::uint64_t> next_stream{0};
+
+} // namespace
+
+XoshiroLanes::XoshiroLanes(std::uint64_t seed) {
+    std::uint64_t state = seed;
+    for (std::size_t lane = 0; lane < kLanes; ++lane) {
+        s0[lane] = splitmix64(state);
+        s1[lane] = splitmix64(state);
+        s2[lane] = splitmix64(state);
+        s3[lane] = splitmix64(state);
+    }
+}
+
+void XoshiroLanes::fill_uniform(double* out, std::size_t count) {
+    fill_kernels.active()(s0.data(), s1.data(), s2.data(), s3.data(), out, count);
+}
+
+UniformBuffer::UniformBuffer(std::uint64_t seed)
+    : generator(seed)
+    , values()
+    , cursor(kCapacity)
+{}
+
+void UniformBuffer::refill() {
+    generator.fill_uniform(values.data(), kCapacity);
+    cursor = 0;
+}
+
+void UniformBuffer::fill(double* out, std::size_t count) {
+    // Drain what is buffered first so scalar and batched draws stay one stream
+    const std::size_t buffered = std::min(count, kCapacity - cursor);
+    std::copy(values.begin() + static_cast<std::ptrdiff_t>(cursor),
+              values.begin() + static_cast<std::ptrdiff_t>(cursor + buffered),
+              out);
+    cursor += buffered;
+    if (buffered < count) {
+        generator.fill_uniform(out + buffered, count - buffered);
+    }
+}
+
+void UniformBuffer::reseed(std::uint64_t seed) {
+    generator = XoshiroLanes(seed);
+    // Whole lane groups, so the stream reads the same as one long fill
+    cursor = kCapacity - kFirstBlock;
+    generator.fill_uniform(values.data() + cursor, kFirstBlock);
+}
+
+UniformBuffer& thread_uniforms() {
+    thread_local UniformBuffer buffer(kBaseSeed + kStreamStride * next_stream.fetch_add(1));
+    return buffer;
+}
+
+void seed_thread_uniforms(std::uint64_t seed) {
+    thread_uniforms().reseed(seed);
+}
+
+void seed_sample_uniforms(std::uint64_t frame_seed, std::uint64_t pixel, std::uint64_t sample) {
+    std::uint64_t state = kBaseSeed + kStreamStride * frame_seed;
+    state = splitmix64(state) ^ pixel;
+    state = splitmix64(state) ^ sample;
+    thread_uniforms().reseed(splitmix64(state));
+}
@@ -0,0 +1,105 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+/**
+ * @file Random.h
+ * @brief Lane-parallel xoshiro256+ generator and per-thread uniform buffers.
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Several independent xoshiro256+ streams advanced in lock-step.
+ *
+ * The state is stored as structure-of-arrays, one array per state word, so
+ * the per-lane update loop is plain integer arithmetic that the compiler
+ * turns into SIMD (SSE2 = 2 lanes, AVX2 = 4, AVX-512 = 8 per instruction).
+ */
+class XoshiroLanes {
+public:
+    static constexpr std::size_t kLanes = 8;
+
+    /**
+     * Seed all lanes from one 64-bit value (expanded with splitmix64).
+     */
+    explicit XoshiroLanes(std::uint64_t seed);
+
+    /**
+     * Write `count` uniform doubles in [0, 1) to `out`.
+     * Whole groups of kLanes are produced per step; a trailing partial group
+     * is still drawn in full and the surplus values discarded.
+     */
+    void fill_uniform(double* out, std::size_t count);
+
+private:
+    alignas(64) std::array<std::uint64_t, kLanes> s0;
+    alignas(64) std::array<std::uint64_t, kLanes> s1;
+    alignas(64) std::array<std::uint64_t, kLanes> s2;
+    alignas(64) std::array<std::uint64_t, kLanes> s3;
+};
+
+/**
+ * Buffer of pre-generated uniforms, refilled a block at a time.
+ * Scalar consumers call next(); batched consumers call fill().
+ */
+class UniformBuffer {
+public:
+    static constexpr std::size_t kCapacity = 512;
+
+    explicit UniformBuffer(std::uint64_t seed);
+
+    /**
+     * Next uniform double in [0, 1).
+     */
+    double next() {
+        if (cursor == kCapacity) {
+            refill();
+        }
+        return values[cursor++];
+    }
+
+    /**
+     * Write `count` uniform doubles in [0, 1) to `out`.
+     */
+    void fill(double* out, std::size_t count);
+
+    /**
+     * Restart the stream from a new seed and drop buffered values.
+     * Only a short first block is drawn, since streams reseeded per sample
+     * rarely use a whole buffer.
+     */
+    void reseed(std::uint64_t seed);
+
+private:
+    static constexpr std::size_t kFirstBlock = 64;
+
+    void refill();
+
+    XoshiroLanes generator;
+    alignas(64) std::array<double, kCapacity> values;
+    std::size_t cursor;
+};
+
+/**
+ * Uniform buffer owned by the calling thread.
+ * Each thread gets its own stream (seeded from a global stream counter), so
+ * sampling needs no locks and threads never share random sequences.
+ */
+UniformBuffer& thread_uniforms();
+
+/**
+ * Reseed the calling thread's uniform buffer, e.g. for reproducible tests.
+ */
+void seed_thread_uniforms(std::uint64_t seed);
+
+/**
+ * Reseed the calling thread's uniform buffer with the stream of sample
+ * `sample` of `pixel` in frames seeded with `frame_seed`. A sample draws the
+ * same numbers whichever thread renders it and whether it is rendered fresh
+ * or on top of stored samples.
+ */
+void seed_sample_uniforms(std::uint64_t frame_seed, std::uint64_t pixel, std::uint64_t sample);
+
+#endif
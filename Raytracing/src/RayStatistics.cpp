@@ -0,0 +1,96 @@
+#include "RayStatistics.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ray_statistics {
+
+namespace {
+
+struct CounterBlock {
+    std::array<std::atomic<std::uint64_t>, kCounterCount> values{};
+};
+
+/**
+ * Owns every block ever handed out. Blocks of exited threads are recycled
+ * but never freed, so their counts stay in the totals.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<CounterBlock>> blocks;
+    std::vector<CounterBlock*> idle;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+struct ThreadSlot {
+    CounterBlock* block;
+
+    ThreadSlot() {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (shared.idle.empty()) {
+            shared.blocks.push_back(std::make_unique<CounterBlock>());
+            block = shared.blocks.back().get();
+        } else {
+            block = shared.idle.back();
+            shared.idle.pop_back();
+        }
+    }
+
+    ~ThreadSlot() {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.idle.push_back(block);
+    }
+};
+
+thread_local ThreadSlot thread_slot;
+
+} // namespace
+
+void add(Counter counter, std::uint64_t amount) {
+    // Only this thread writes the block, so no read-modify-write is needed
+    std::atomic<std::uint64_t>& value = thread_slot.block->values[counter];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+RayStatistics snapshot() {
+    std::array<std::uint64_t, kCounterCount> totals{};
+    Registry& shared = registry();
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (const std::unique_ptr<CounterBlock>& block : shared.blocks) {
+            for (std::size_t counter = 0; counter < kCounterCount; ++counter) {
+                totals[counter] += block->values[counter].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    RayStatistics statistics;
+    statistics.shadow_rays = totals[ShadowRays];
+    statistics.shadow_rays_occluded = totals[ShadowRaysOccluded];
+    statistics.occluder_cache_tests = totals[OccluderCacheTests];
+    statistics.occluder_cache_hits = totals[OccluderCacheHits];
+    statistics.light_grid_visible = totals[LightGridVisible];
+    statistics.light_grid_occluded = totals[LightGridOccluded];
+    return statistics;
+}
+
+void reset() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for (const std::unique_ptr<CounterBlock>& block : shared.blocks) {
+        for (std::atomic<std::uint64_t>& value : block->values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace ray_statistics
@@ -0,0 +1,71 @@
+#ifndef RAY_STATISTICS_H
+#define RAY_STATISTICS_H
+
+/**
+ * @file RayStatistics.h
+ * @brief Per-thread ray counters summed on demand.
+ *
+ * Each thread increments its own block of counters (a relaxed load and
+ * store, no shared cache line), so counting stays cheap inside traversal
+ * loops. snapshot() sums every block, including those of worker threads
+ * that have already exited.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Totals over all threads since the last reset().
+ */
+struct RayStatistics {
+    std::uint64_t shadow_rays = 0;           ///< Shadow rays toward point lights
+    std::uint64_t shadow_rays_occluded = 0;  ///< Of those, rays that found a blocker
+    std::uint64_t occluder_cache_tests = 0;  ///< Shadow rays that tested a cached occluder first
+    std::uint64_t occluder_cache_hits = 0;   ///< Of those, rays the cached occluder blocked
+    std::uint64_t light_grid_visible = 0;    ///< Shadow rays skipped, light grid says visible
+    std::uint64_t light_grid_occluded = 0;   ///< Shadow rays skipped, light grid says occluded
+
+    /**
+     * Share of cached-occluder tests that made full traversal unnecessary.
+     */
+    double occluder_cache_hit_rate() const {
+        return occluder_cache_tests == 0
+            ? 0.0
+            : static_cast<double>(occluder_cache_hits) / static_cast<double>(occluder_cache_tests);
+    }
+};
+
+namespace ray_statistics {
+
+/**
+ * Counter slots, one per RayStatistics field.
+ */
+enum Counter : std::size_t {
+    ShadowRays,
+    ShadowRaysOccluded,
+    OccluderCacheTests,
+    OccluderCacheHits,
+    LightGridVisible,
+    LightGridOccluded,
+    kCounterCount
+};
+
+/**
+ * Add `amount` to the calling thread's `counter`.
+ */
+void add(Counter counter, std::uint64_t amount = 1);
+
+/**
+ * Sum of all threads' counters.
+ */
+RayStatistics snapshot();
+
+/**
+ * Zero every counter. Increments racing with a reset may be lost, so call
+ * it between renders.
+ */
+void reset();
+
+} // namespace ray_statistics
+
+#endif
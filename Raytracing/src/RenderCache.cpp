@@ -0,0 +1,204 @@
+#include "RenderCache.h"
+
+#include "Camera.h"
+#include "ContentHash.h"
+#include "RenderConfig.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include <variant>
+
+namespace {
+
+/// Part of every key; bump when a change to the renderer changes what images converge to
+constexpr std::uint64_t kRendererRevision = 1;
+
+constexpr char kMagic[8] = {'R', 'T', 'C', 'A', 'C', 'H', 'E', '\0'};
+constexpr std::uint32_t kVersion = 1;
+
+struct EntryHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::int32_t width;
+    std::int32_t height;
+    std::uint32_t reserved;
+};
+
+bool hash_scene(const Scene& scene, ContentHash& hash) {
+    const PrimitiveTable& table = scene.dispatch_table;
+    hash.add(static_cast<std::uint64_t>(table.material_count()));
+    for (const PackedMaterial& material : table.materials()) {
+        if (material.kind == MaterialKind::Extension) {
+            return false;
+        }
+        hash.add(static_cast<unsigned>(material.kind)).add(material.albedo).add(material.parameter);
+    }
+
+    hash.add(static_cast<std::uint64_t>(table.primitive_count()));
+    for (const PackedPrimitive& primitive : table.primitives()) {
+        hash.add(static_cast<std::uint64_t>(primitive.shape.index())).add(primitive.material_index);
+        switch (primitive_kind(primitive.shape)) {
+        case PrimitiveKind::Sphere: {
+            const SpherePrimitive& sphere = std::get<SpherePrimitive>(primitive.shape);
+            hash.add(sphere.center).add(sphere.radius);
+            break;
+        }
+        case PrimitiveKind::Rect: {
+            const RectPrimitive& rect = std::get<RectPrimitive>(primitive.shape);
+            hash.add(static_cast<int>(rect.orientation.tangent_u)).add(static_cast<int>(rect.orientation.tangent_v))
+                .add(static_cast<int>(rect.orientation.normal_axis)).add(rect.u0).add(rect.u1).add(rect.v0).add(rect.v1)
+                .add(rect.k).add(rect.outward_normal);
+            break;
+        }
+        case PrimitiveKind::Enclosure: {
+            const EnclosurePrimitive& enclosure = std::get<EnclosurePrimitive>(primitive.shape);
+            hash.add(enclosure.lo).add(enclosure.hi).add(enclosure.open_faces);
+            for (const std::uint32_t face_material : enclosure.face_materials) {
+                hash.add(face_material);
+            }
+            break;
+        }
+        case PrimitiveKind::Extension:
+            return false;
+        }
+    }
+
+    hash.add(static_cast<std::uint64_t>(scene.lights.size()));
+    for (const Light& light : scene.lights) {
+        hash.add(light.position).add(light.intensity);
+    }
+    const RoomLayout& layout = scene.layout;
+    hash.add(layout.half_width).add(layout.half_depth).add(layout.floor_y).add(layout.ceiling_y)
+        .add(layout.back_wall_z).add(layout.front_opening_z);
+    return true;
+}
+
+void hash_config(const RenderConfig& config, ContentHash& hash) {
+    hash.add(config.image_width).add(config.image_height).add(config.sample_seed).add(config.fast_math_kernels);
+
+    const PhotonMapSettings& caustics = config.caustics;
+    hash.add(caustics.enabled);
+    if (caustics.enabled) {
+        hash.add(static_cast<std::uint64_t>(caustics.photon_count)).add(caustics.gather_radius)
+            .add(caustics.max_bounces).add(caustics.lookup_diffuse_hits);
+    }
+
+    const RadianceCacheSettings& radiance = config.radiance_cache;
+    hash.add(static_cast<int>(radiance.mode));
+    if (radiance.mode != RadianceCacheMode::Off) {
+        hash.add(radiance.cell_size).add(radiance.normal_bins).add(radiance.min_samples).add(radiance.lookup_bounce)
+            .add(radiance.warmup_samples_per_pixel);
+    }
+
+    const PathGuidingSettings& guiding = config.path_guiding;
+    hash.add(guiding.enabled);
+    if (guiding.enabled) {
+        hash.add(guiding.training_passes).add(guiding.bsdf_sampling_fraction).add(guiding.spatial_split_threshold)
+            .add(guiding.directional_split_fraction).add(guiding.max_directional_depth);
+    }
+
+    hash.add(config.raster_primary.enabled);
+    if (config.raster_primary.enabled) {
+        hash.add(config.raster_primary.subsamples);
+    }
+}
+
+} // namespace
+
+RenderCache::RenderCache(std::string directory)
+    : root(std::move(directory)) {}
+
+bool RenderCache::key(const Scene& scene, const Camera& camera, const RenderConfig& config, int max_depth,
+                      std::string& key) {
+    ContentHash hash;
+    hash.add(std::string("raytracer render")).add(kRendererRevision);
+    if (!hash_scene(scene, hash)) {
+        return false;
+    }
+    hash.add(camera.origin).add(camera.horizontal).add(camera.vertical).add(camera.lower_left_corner);
+    hash.add(max_depth);
+    hash_config(config, hash);
+    key = hash.hex();
+    return true;
+}
+
+std::string RenderCache::path(const std::string& key) const {
+    return (std::filesystem::path(root) / (key + ".samples")).string();
+}
+
+CacheLookup RenderCache::lookup(const std::string& key, int samples_per_pixel, FrameSamples& samples) const {
+    const std::string entry_path = path(key);
+    std::ifstream in(entry_path, std::ios::binary);
+    EntryHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.width <= 0 || header.height <= 0) {
+        return CacheLookup::Miss;
+    }
+    // The header must describe exactly the bytes on disk before it sizes an allocation, so a
+    // truncated or corrupt entry is a miss rather than a huge buffer
+    std::error_code error;
+    const std::uintmax_t file_size = std::filesystem::file_size(entry_path, error);
+    const std::uint64_t pixels = static_cast<std::uint64_t>(header.width) * static_cast<std::uint64_t>(header.height);
+    if (error || file_size != sizeof(header) + pixels * (sizeof(std::uint32_t) + 3 * sizeof(float))) {
+        return CacheLookup::Miss;
+    }
+
+    FrameSamples entry;
+    entry.image = Framebuffer(header.width, header.height);
+    entry.counts.resize(entry.image.pixel_count());
+    if (!in.read(reinterpret_cast<char*>(entry.counts.data()),
+                 static_cast<std::streamsize>(entry.counts.size() * sizeof(std::uint32_t)))
+        || !in.read(reinterpret_cast<char*>(entry.image.pixels.data()),
+                    static_cast<std::streamsize>(entry.image.pixels.size() * sizeof(float)))) {
+        return CacheLookup::Miss;
+    }
+
+    const std::uint32_t fewest = entry.counts.empty() ? 0 : *std::min_element(entry.counts.begin(), entry.counts.end());
+    samples = std::move(entry);
+    return fewest >= static_cast<std::uint32_t>(std::max(samples_per_pixel, 0)) ? CacheLookup::Hit
+                                                                                 : CacheLookup::Partial;
+}
+
+bool RenderCache::store(const std::string& key, const FrameSamples& samples) const {
+    if (samples.counts.size() != samples.image.pixel_count()) {
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(root, error);
+    const std::string final_path = path(key);
+    const std::string temporary_path = final_path + ".tmp";
+    {
+        std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        EntryHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.width = samples.image.width;
+        header.height = samples.image.height;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(samples.counts.data()),
+                  static_cast<std::streamsize>(samples.counts.size() * sizeof(std::uint32_t)));
+        out.write(reinterpret_cast<const char*>(samples.image.pixels.data()),
+                  static_cast<std::streamsize>(samples.image.pixels.size() * sizeof(float)));
+        if (!out) {
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+    }
+    // Readers see the old entry or the new one, never half of one
+    std::filesystem::rename(temporary_path, final_path, error);
+    if (error) {
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+/**
+ * @file RenderCache.h
+ * @brief On-disk cache of rendered samples, addressed by what the image
+ * depends on.
+ *
+ * key() hashes everything that decides what a render converges to: the
+ * committed primitives and packed materials, the lights, the room layout,
+ * the camera, the bounce limit and the RenderConfig settings that change
+ * pixels (resolution, fast-math kernels, caustics, radiance cache, path
+ * guiding, rasterized first hits). It leaves out what only changes speed
+ * or output: samples per pixel, accelerators, tile culling, the light grid
+ * and occluder cache (all exact), dither and output paths.
+ *
+ * Samples per pixel are left out because an entry stores per-pixel
+ * averages and sample counts (FrameSamples), not a finished image. A
+ * request for at most the stored samples is a hit; a request for more, or
+ * an entry left by a cancelled render, is a partial hit whose samples a
+ * RenderJob can start from (RenderJob::start_from), so only the missing
+ * ones are rendered.
+ *
+ * Entries are raw native-endian files named after the key, written to a
+ * temporary name and renamed into place. They belong to the machine and the
+ * renderer version that wrote them; bump kRendererRevision in
+ * RenderCache.cpp when the integrator changes what images converge to.
+ */
+
+#include "Framebuffer.h"
+
+#include <string>
+
+class Camera;
+struct RenderConfig;
+struct Scene;
+
+/**
+ * Controls for the command line's use of the cache.
+ */
+struct RenderCacheSettings {
+    bool enabled = false;
+    std::string directory = ".render-cache";
+};
+
+/**
+ * What RenderCache::lookup() found.
+ */
+enum class CacheLookup {
+    Miss,      ///< No usable entry
+    Partial,   ///< An entry with fewer samples than asked for somewhere
+    Hit        ///< Every pixel has at least the samples asked for
+};
+
+class RenderCache {
+public:
+    explicit RenderCache(std::string directory);
+
+    /**
+     * Key of the image `config` renders of `scene` through `camera`: 32 hex digits.
+     *
+     * @return false if the scene holds extension primitives or materials,
+     *         whose contents cannot be hashed
+     */
+    static bool key(const Scene& scene, const Camera& camera, const RenderConfig& config, int max_depth,
+                    std::string& key);
+
+    /**
+     * Read the entry for `key` into `samples` and compare it with
+     * `samples_per_pixel`. An entry whose size does not match its header is
+     * a Miss.
+     */
+    CacheLookup lookup(const std::string& key, int samples_per_pixel, FrameSamples& samples) const;
+
+    /**
+     * Store `samples` under `key`, replacing any entry; creates the directory.
+     *
+     * @return false if the entry cannot be written
+     */
+    bool store(const std::string& key, const FrameSamples& samples) const;
+
+    const std::string& directory() const { return root; }
+
+private:
+    std::string path(const std::string& key) const;
+
+    std::string root;
+};
+
+#endif
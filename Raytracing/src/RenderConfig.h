@@ -6,6 +6,20 @@
  * @brief Render resolution and quality controls.
  */
 
+#include "FastMath.h"
+#include "LightVisibilityGrid.h"
+#include "PagedBvh.h"
+#include "PathGuiding.h"
+#include "PhotonMap.h"
+#include "Quantize.h"
+#include "RadianceCache.h"
+#include "RenderCache.h"
+#include "TiledFramebuffer.h"
+#include "UniformGrid.h"
+#include "VisibilityBuffer.h"
+#include "WideBvh.h"
+
+#include <cstdint>
 #include <string>
 
 /**
@@ -16,7 +30,22 @@ struct RenderConfig {
     int image_width;
     int image_height;
     int samples_per_pixel;
+    std::uint64_t sample_seed;   // Seeds every pixel sample's random stream; other seeds give independent noise
     std::string output_path;
+    unsigned fast_math_kernels;  // Bitmask of fast_math::Kernel (0 = precise libm everywhere)
+    DitherMode dither;           // Dither applied when quantizing to 8 bits
+    RadianceCacheSettings radiance_cache;  // Off by default; Preview trades bias for speed
+    PhotonMapSettings caustics;            // Caustic photon pre-pass (on; no-op without specular objects)
+    PathGuidingSettings path_guiding;      // Off by default; learns where indirect light comes from
+    bool occluder_cache;                   // Test each light's last shadow blocker first (exact, on by default)
+    LightVisibilitySettings light_visibility;  // Off by default; the caller builds it once per scene
+    int primary_tile_size;                 // Pixel tile edge for frustum culling of camera rays (0 = off)
+    RasterSettings raster_primary;         // Off by default; rasterizes camera-ray first hits
+    UniformGridSettings uniform_grid;      // Off by default; the caller builds it once per scene
+    WideBvhSettings wide_bvh;              // Off by default; the caller builds it once per scene
+    PagedBvhSettings paged_bvh;            // Off by default; the caller writes and opens it once per scene
+    TiledOutputSettings tiled_output;      // Off by default; renders into a mapped file for frames beyond RAM
+    RenderCacheSettings render_cache;      // Off by default; the command line reuses stored samples through it
     
     /**
      * Create a render configuration.
@@ -31,7 +60,22 @@ struct RenderConfig {
         , image_width(width)
         , image_height(static_cast<int>(width / ratio))
         , samples_per_pixel(samples)
+        , sample_seed(0)
         , output_path("render.png")
+        , fast_math_kernels(fast_math::kDefaultKernels)
+        , dither(DitherMode::None)
+        , radiance_cache()
+        , caustics()
+        , path_guiding()
+        , occluder_cache(true)
+        , light_visibility()
+        , primary_tile_size(16)
+        , raster_primary()
+        , uniform_grid()
+        , wide_bvh()
+        , paged_bvh()
+        , tiled_output()
+        , render_cache()
     {}
 };
 
@@ -0,0 +1,341 @@
+#include "RenderEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+RenderEngine::RenderEngine(unsigned threads)
+    : queue(std::make_shared<RenderQueue>()) {
+    const unsigned count = std::max(threads, 1u);
+    workers.reserve(count);
+    for (unsigned index = 0; index < count; ++index) {
+        workers.emplace_back([this] { work(); });
+    }
+}
+
+RenderEngine::~RenderEngine() {
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        // Stop this engine's jobs without cancelling tokens other jobs may share
+        queue->stopping = true;
+        for (const std::shared_ptr<RenderHandle>& job : queue->jobs) {
+            job->interrupt.cancel();
+        }
+        queue->wake.notify_all();
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::shared_ptr<RenderHandle> RenderEngine::submit(RenderJob job) {
+    std::shared_ptr<RenderHandle> handle(new RenderHandle(std::move(job)));
+    handle->queue = queue;
+    // Wake the workers to end the job even if nothing of it is running; the
+    // interrupt is set under the queue's lock, which orders it against resume()
+    const std::weak_ptr<RenderHandle> weak_handle = handle;
+    const std::weak_ptr<RenderQueue> weak_queue = queue;
+    handle->token_listener = handle->token->subscribe([weak_handle, weak_queue] {
+        const std::shared_ptr<RenderQueue> shared = weak_queue.lock();
+        if (!shared) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (const std::shared_ptr<RenderHandle> job = weak_handle.lock()) {
+            job->interrupt.cancel();
+        }
+        shared->wake.notify_all();
+    });
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    handle->id = next_id++;
+    scheduler.add(handle->id, handle->spec.schedule);
+    queue->jobs.push_back(handle);
+    queue->wake.notify_one();
+    return handle;
+}
+
+void RenderEngine::work() {
+    std::vector<std::shared_ptr<RenderHandle>> ended;
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    for (;;) {
+        Task task;
+        const bool found = next_task(task, ended);
+        if (!ended.empty()) {
+            lock.unlock();
+            for (const std::shared_ptr<RenderHandle>& job : ended) {
+                publish_end(*job);
+            }
+            ended.clear();
+            lock.lock();
+            if (!found) {
+                // A job submitted while the lock was released woke nobody; look again
+                continue;
+            }
+        }
+        if (!found) {
+            if (queue->stopping && queue->jobs.empty()) {
+                return;
+            }
+            queue->wake.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        bool finished = true;
+        if (task.setup) {
+            run_setup(*task.job);
+        } else {
+            finished = run_tile(*task.job, task.progress);
+        }
+        const std::chrono::duration<double, std::milli> spent = std::chrono::steady_clock::now() - started;
+        lock.lock();
+        const bool job_ended = complete(task, spent.count(), finished);
+        if (job_ended || (!task.setup && task.job->spec.on_progress)) {
+            lock.unlock();
+            if (job_ended) {
+                publish_end(*task.job);
+            } else {
+                task.job->spec.on_progress(task.job->progress());
+            }
+            lock.lock();
+        }
+    }
+}
+
+bool RenderEngine::next_task(Task& task, std::vector<std::shared_ptr<RenderHandle>>& ended) {
+    // Cancelled jobs end once nothing of theirs is running
+    for (const std::shared_ptr<RenderHandle>& job : queue->jobs) {
+        if (stopped(*job) && job->setup != RenderHandle::Setup::Running
+            && job->tiles_in_flight == 0) {
+            ended.push_back(job);
+        }
+    }
+    for (const std::shared_ptr<RenderHandle>& job : ended) {
+        end_job(*job, RenderStatus::Cancelled);
+    }
+
+    std::vector<std::uint64_t> runnable;
+    for (const std::shared_ptr<RenderHandle>& job : queue->jobs) {
+        // pause() and resume() set the flag under the queue's lock, held here
+        scheduler.set_paused(job->id, job->paused);
+        if (!stopped(*job) && !job->paused
+            && (job->setup == RenderHandle::Setup::Pending
+                || (job->setup == RenderHandle::Setup::Ready
+                    && (job->next_tile < job->tile_count || !job->parked.empty())))) {
+            runnable.push_back(job->id);
+        }
+    }
+    if (runnable.empty()) {
+        return false;
+    }
+
+    const std::uint64_t chosen = scheduler.pick(runnable);
+    for (const std::shared_ptr<RenderHandle>& job : queue->jobs) {
+        if (job->id != chosen) {
+            continue;
+        }
+        task.job = job;
+        task.setup = job->setup == RenderHandle::Setup::Pending;
+        if (task.setup) {
+            job->setup = RenderHandle::Setup::Running;
+        } else if (!job->parked.empty()) {
+            task.progress = std::move(job->parked.back());
+            job->parked.pop_back();
+            ++job->tiles_in_flight;
+        } else {
+            task.progress = RenderHandle::TileProgress();
+            task.progress.tile = job->next_tile++;
+            ++job->tiles_in_flight;
+        }
+        break;
+    }
+    return true;
+}
+
+void RenderEngine::run_setup(RenderHandle& job) {
+    const RenderJob& spec = job.spec;
+    const RenderConfig& config = spec.config;
+    const FrameSettingsScope settings(config);
+    {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (job.state == RenderStatus::Queued) {
+            job.state = RenderStatus::Running;
+        }
+        job.start_time = std::chrono::steady_clock::now();
+    }
+    begin_frame(config, *spec.scene, spec.max_depth, spec.log);
+    job.frame = std::make_unique<FrameCaches>();
+    prepare_frame_caches(config, spec.camera, *spec.scene, spec.max_depth, spec.tiled_target == nullptr, *job.frame,
+                         spec.log);
+    if (spec.tiled_target == nullptr) {
+        Framebuffer image(config.image_width, config.image_height);
+        std::vector<std::uint32_t> samples(image.pixel_count(), 0);
+        if (resumes(job)) {
+            image = spec.start_from->image;
+            samples = spec.start_from->counts;
+        }
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.image = std::move(image);
+        job.samples = std::move(samples);
+    }
+}
+
+bool RenderEngine::run_tile(RenderHandle& job, RenderHandle::TileProgress& progress) {
+    const RenderJob& spec = job.spec;
+    const RenderConfig& config = spec.config;
+    const FrameSettingsScope settings(config);
+    if (config.path_guiding.enabled && spec.tiled_target == nullptr) {
+        // The interrupt covers cancel(), pause() and the engine stopping; a
+        // paused guided frame is parked like a tile and starts over on resume
+        Framebuffer guided(config.image_width, config.image_height);
+        if (!render_guided(config, spec.camera, *spec.scene, spec.max_depth, job.frame->caches, guided, nullptr,
+                           &job.interrupt)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(job.mutex);
+        job.image = std::move(guided);
+        std::fill(job.samples.begin(), job.samples.end(), static_cast<std::uint32_t>(config.samples_per_pixel));
+        return true;
+    }
+
+    const int tile_x = static_cast<int>(progress.tile % static_cast<std::size_t>(job.tiles_x));
+    const int tile_y = static_cast<int>(progress.tile / static_cast<std::size_t>(job.tiles_x));
+    const int col_begin = tile_x * job.tile_edge;
+    const int col_end = std::min(col_begin + job.tile_edge, config.image_width);
+    const int row_begin = tile_y * job.tile_edge;
+    const int row_end = std::min(row_begin + job.tile_edge, config.image_height);
+    const std::size_t width = static_cast<std::size_t>(col_end - col_begin);
+    const std::size_t pixels = width * static_cast<std::size_t>(row_end - row_begin);
+    if (progress.counts.empty()) {
+        progress.sums.assign(pixels * 3, 0.0);
+        progress.counts.assign(pixels, 0);
+        if (resumes(job)) {
+            const FrameSamples& start = *spec.start_from;
+            for (std::size_t index = 0; index < pixels; ++index) {
+                const std::size_t pixel = static_cast<std::size_t>(row_begin + static_cast<int>(index / width))
+                        * static_cast<std::size_t>(config.image_width)
+                    + static_cast<std::size_t>(col_begin) + index % width;
+                progress.counts[index] = start.counts[pixel];
+                for (std::size_t channel = 0; channel < 3; ++channel) {
+                    progress.sums[3 * index + channel] =
+                        static_cast<double>(start.image.pixels[3 * pixel + channel]) * start.counts[pixel];
+                }
+            }
+        }
+    }
+
+    // Accumulate off to the side so snapshot() never sees a tile half written
+    const bool finished = accumulate_tile(config, spec.camera, *spec.scene, spec.max_depth, job.frame->caches,
+                                          col_begin, col_end, row_begin, row_end, progress.sums.data(),
+                                          progress.counts.data(), &job.interrupt);
+
+    const auto average = [&progress](std::size_t index, float* out) {
+        const std::uint32_t count = progress.counts[index];
+        const double scale = count == 0 ? 0.0 : 1.0 / static_cast<double>(count);
+        for (int channel = 0; channel < 3; ++channel) {
+            out[channel] = static_cast<float>(scale * progress.sums[3 * index + static_cast<std::size_t>(channel)]);
+        }
+    };
+
+    if (spec.tiled_target != nullptr) {
+        float* tile = spec.tiled_target->tile(tile_x, tile_y);
+        for (std::size_t index = 0; index < pixels; ++index) {
+            average(index, tile + (index / width) * static_cast<std::size_t>(job.tile_edge) * 3 + (index % width) * 3);
+        }
+        if (finished && job.band_tiles_left[static_cast<std::size_t>(tile_y)].fetch_sub(1) == 1) {
+            spec.tiled_target->release_band(tile_y);
+        }
+        return finished;
+    }
+
+    std::lock_guard<std::mutex> lock(job.mutex);
+    for (std::size_t index = 0; index < pixels; ++index) {
+        const std::size_t pixel = static_cast<std::size_t>(row_begin + static_cast<int>(index / width))
+                * static_cast<std::size_t>(config.image_width)
+            + static_cast<std::size_t>(col_begin) + index % width;
+        average(index, job.image.pixels.data() + pixel * 3);
+        job.samples[pixel] = progress.counts[index];
+    }
+    return finished;
+}
+
+bool RenderEngine::resumes(const RenderHandle& job) {
+    const RenderJob& spec = job.spec;
+    const FrameSamples* start = spec.start_from.get();
+    return start != nullptr && spec.tiled_target == nullptr && !spec.config.path_guiding.enabled
+        && start->image.width == spec.config.image_width && start->image.height == spec.config.image_height
+        && start->counts.size() == start->image.pixel_count();
+}
+
+bool RenderEngine::stopped(const RenderHandle& job) const {
+    return queue->stopping || job.token->cancelled();
+}
+
+bool RenderEngine::complete(Task& task, double worker_ms, bool finished) {
+    RenderHandle& job = *task.job;
+    std::size_t done = 0;
+    scheduler.charge(job.id, worker_ms);
+    if (task.setup) {
+        job.setup = RenderHandle::Setup::Ready;
+        queue->wake.notify_all();
+    } else {
+        --job.tiles_in_flight;
+        if (!finished && !stopped(job)) {
+            job.parked.push_back(std::move(task.progress));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (!task.setup && finished) {
+            ++job.tiles_done;
+        }
+        job.worker_ms += worker_ms;
+        done = job.tiles_done;
+    }
+
+    if (done == job.tile_count) {
+        end_job(job, RenderStatus::Completed);
+        return true;
+    }
+    if (stopped(job) && job.tiles_in_flight == 0) {
+        end_job(job, RenderStatus::Cancelled);
+        return true;
+    }
+    return false;
+}
+
+void RenderEngine::end_job(RenderHandle& job, RenderStatus status) {
+    const auto position = std::find_if(queue->jobs.begin(), queue->jobs.end(),
+                                       [&job](const std::shared_ptr<RenderHandle>& queued) {
+                                           return queued.get() == &job;
+                                       });
+    if (position != queue->jobs.end()) {
+        queue->jobs.erase(position);
+    }
+    scheduler.remove(job.id);
+    // Workers waiting to stop may be waiting for this
+    queue->wake.notify_all();
+    job.frame.reset();
+    job.final_status = status;
+}
+
+void RenderEngine::publish_end(RenderHandle& job) {
+    job.token->unsubscribe(job.token_listener);
+
+    // The last progress call comes before wait() returns
+    if (job.spec.on_progress) {
+        RenderProgress last = job.progress();
+        last.status = job.final_status;
+        job.spec.on_progress(last);
+    }
+
+    std::lock_guard<std::mutex> lock(job.mutex);
+    if (job.start_time == std::chrono::steady_clock::time_point()) {
+        job.start_time = std::chrono::steady_clock::now();
+    }
+    job.state = job.final_status;
+    job.end_time = std::chrono::steady_clock::now();
+    job.ended.notify_all();
+}
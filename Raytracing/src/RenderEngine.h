@@ -0,0 +1,112 @@
+#ifndef RENDER_ENGINE_H
+#define RENDER_ENGINE_H
+
+/**
+ * @file RenderEngine.h
+ * @brief In-process renderer service: a pool of worker threads rendering
+ * submitted jobs tile by tile.
+ *
+ * submit() queues a RenderJob and returns its RenderHandle at once. A worker
+ * first builds the job's per-frame caches (see prepare_frame_caches), then
+ * all workers take its tiles, top band first, until none are left.
+ *
+ * Several jobs share the workers. Each time a worker is free, a
+ * TileScheduler picks which job's task it runs: preview jobs earliest
+ * deadline first, batch jobs by weighted fair share of worker time. A job
+ * never holds a worker beyond its current tile, so an urgent job submitted
+ * mid-render takes over at the next tile boundary. Each job's progress
+ * reports its queueing latency and the worker time it received.
+ *
+ * Tiles are rendered with accumulate_tile, which checks the job's interrupt
+ * before every sample: cancel() and pause() take the workers off a job
+ * within one sample. A paused tile keeps its sums and sample counts and is
+ * handed out again first on resume(). Whenever a worker leaves a tile,
+ * finished or not, its averages are copied into the handle's framebuffer,
+ * where RenderHandle::snapshot() can read them, together with the per-pixel
+ * sample counts; with a tiled target they go straight to the mapped file,
+ * and each band is released once its last tile is done. Path-guided jobs
+ * render as a single task (render_guided), since each training pass covers
+ * the whole frame; cancel(), pause() and destroying the engine stop them
+ * between scanlines, and a paused one renders its frame again from the
+ * start on resume(), since its guiding field is not kept.
+ *
+ * A job given `start_from` begins with those samples in its framebuffer and
+ * its tiles, so it only renders what is missing up to samples_per_pixel.
+ *
+ * Results match render_framebuffer up to noise: pixels are visited in a
+ * different order, and by several threads.
+ */
+
+#include "Parallel.h"
+#include "RenderHandle.h"
+#include "RenderJob.h"
+#include "TileScheduler.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Jobs shared by the engine's workers and woken by RenderHandle::cancel().
+ */
+struct RenderQueue {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::shared_ptr<RenderHandle>> jobs;  ///< Not yet ended, in submission order
+    bool stopping = false;
+};
+
+class RenderEngine {
+public:
+    /**
+     * Start `threads` workers (at least one).
+     */
+    explicit RenderEngine(unsigned threads = worker_count());
+    RenderEngine(const RenderEngine&) = delete;
+    RenderEngine& operator=(const RenderEngine&) = delete;
+
+    /**
+     * Cancel every job that has not ended, wait for the tiles in flight and
+     * stop the workers.
+     */
+    ~RenderEngine();
+
+    /**
+     * Queue `job` and return its handle; never blocks on rendering.
+     */
+    std::shared_ptr<RenderHandle> submit(RenderJob job);
+
+    unsigned thread_count() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    /**
+     * One unit of work: a job's setup, or one of its tiles.
+     */
+    struct Task {
+        std::shared_ptr<RenderHandle> job;
+        bool setup = false;
+        RenderHandle::TileProgress progress;   ///< Tile number and, for a resumed tile, its samples so far
+    };
+
+    void work();
+    bool next_task(Task& task, std::vector<std::shared_ptr<RenderHandle>>& ended);
+    void run_setup(RenderHandle& job);
+    bool run_tile(RenderHandle& job, RenderHandle::TileProgress& progress);
+    static bool resumes(const RenderHandle& job);
+    bool stopped(const RenderHandle& job) const;
+    bool complete(Task& task, double worker_ms, bool finished);
+    void end_job(RenderHandle& job, RenderStatus status);
+    void publish_end(RenderHandle& job);
+
+    std::shared_ptr<RenderQueue> queue;
+    // Guarded by the queue's mutex
+    TileScheduler scheduler;
+    std::uint64_t next_id = 0;
+    std::vector<std::thread> workers;
+};
+
+#endif
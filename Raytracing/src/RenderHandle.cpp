@@ -0,0 +1,114 @@
+#include "RenderHandle.h"
+
+#include "RenderEngine.h"
+
+#include <algorithm>
+#include <utility>
+
+RenderHandle::RenderHandle(RenderJob job)
+    : spec(std::move(job)),
+      submit_time(std::chrono::steady_clock::now()),
+      token(spec.cancel_token ? spec.cancel_token : std::make_shared<CancellationToken>()) {
+    const RenderConfig& config = spec.config;
+    tile_edge = spec.tiled_target != nullptr ? spec.tiled_target->tile_size() : std::max(spec.tile_size, 1);
+    tiles_x = (config.image_width + tile_edge - 1) / tile_edge;
+    const int bands = (config.image_height + tile_edge - 1) / tile_edge;
+    if (config.path_guiding.enabled && spec.tiled_target == nullptr) {
+        tile_count = 1;
+    } else {
+        tile_count = static_cast<std::size_t>(tiles_x) * static_cast<std::size_t>(bands);
+    }
+    if (spec.tiled_target != nullptr) {
+        band_tiles_left = std::make_unique<std::atomic<int>[]>(static_cast<std::size_t>(bands));
+        for (int band = 0; band < bands; ++band) {
+            band_tiles_left[static_cast<std::size_t>(band)].store(tiles_x, std::memory_order_relaxed);
+        }
+    }
+}
+
+RenderStatus RenderHandle::status() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state;
+}
+
+RenderProgress RenderHandle::progress() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    RenderProgress snapshot;
+    snapshot.status = state;
+    snapshot.tiles_done = tiles_done;
+    snapshot.tile_count = tile_count;
+    snapshot.worker_ms = worker_ms;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (start_time == std::chrono::steady_clock::time_point()) {
+        snapshot.queued_ms = std::chrono::duration<double, std::milli>(now - submit_time).count();
+    } else {
+        const bool over = state == RenderStatus::Completed || state == RenderStatus::Cancelled;
+        snapshot.elapsed_ms = std::chrono::duration<double, std::milli>((over ? end_time : now) - start_time).count();
+        snapshot.queued_ms = std::chrono::duration<double, std::milli>(start_time - submit_time).count();
+    }
+    return snapshot;
+}
+
+void RenderHandle::cancel() {
+    // The engine's listener interrupts the tiles in flight and wakes the workers
+    token->cancel();
+}
+
+void RenderHandle::pause() {
+    const std::shared_ptr<RenderQueue> shared = queue.lock();
+    if (!shared) {
+        return;
+    }
+    std::lock_guard<std::mutex> queue_lock(shared->mutex);
+    if (paused) {
+        return;
+    }
+    paused = true;
+    interrupt.cancel();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (state == RenderStatus::Queued || state == RenderStatus::Running) {
+        state = RenderStatus::Paused;
+    }
+}
+
+void RenderHandle::resume() {
+    const std::shared_ptr<RenderQueue> shared = queue.lock();
+    if (!shared) {
+        return;
+    }
+    std::lock_guard<std::mutex> queue_lock(shared->mutex);
+    if (!paused) {
+        return;
+    }
+    paused = false;
+    if (!token->cancelled() && !shared->stopping) {
+        interrupt.reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (state == RenderStatus::Paused) {
+            state = setup == Setup::Pending ? RenderStatus::Queued : RenderStatus::Running;
+        }
+    }
+    shared->wake.notify_all();
+}
+
+void RenderHandle::wait() const {
+    std::unique_lock<std::mutex> lock(mutex);
+    ended.wait(lock, [this] { return state == RenderStatus::Completed || state == RenderStatus::Cancelled; });
+}
+
+bool RenderHandle::wait_for(std::chrono::milliseconds timeout) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    return ended.wait_for(lock, timeout, [this] {
+        return state == RenderStatus::Completed || state == RenderStatus::Cancelled;
+    });
+}
+
+Framebuffer RenderHandle::snapshot(std::vector<std::uint32_t>* counts) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (counts != nullptr) {
+        *counts = samples;
+    }
+    return image;
+}
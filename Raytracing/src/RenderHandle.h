@@ -0,0 +1,142 @@
+#ifndef RENDER_HANDLE_H
+#define RENDER_HANDLE_H
+
+/**
+ * @file RenderHandle.h
+ * @brief Caller's side of a job submitted to a RenderEngine: status,
+ * progress, cancellation, pausing, waiting and access to the pixels.
+ *
+ * Tiles are rendered a sample per pixel per pass and check for cancellation
+ * and pauses before every sample, so both take effect within one sample of
+ * one pixel per worker, not at the end of a tile. Whatever has been sampled
+ * is kept: the framebuffer holds each pixel's average so far and
+ * sample_counts() how many samples it is made of.
+ */
+
+#include "CancellationToken.h"
+#include "Framebuffer.h"
+#include "RenderJob.h"
+#include "Renderer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct RenderQueue;
+
+class RenderHandle {
+public:
+    RenderHandle(const RenderHandle&) = delete;
+    RenderHandle& operator=(const RenderHandle&) = delete;
+
+    RenderStatus status() const;
+    RenderProgress progress() const;
+
+    /**
+     * Ask the job to stop, by cancelling its token (see
+     * RenderJob::cancel_token). Workers leave their tiles at the next sample
+     * boundary and the job ends as Cancelled, with the samples taken so far,
+     * unless it had already completed.
+     */
+    void cancel();
+    bool cancel_requested() const { return token->cancelled(); }
+
+    /**
+     * Take the job's workers away at the next sample boundary, keeping every
+     * tile's samples, and hand them to other jobs until resume(). Cache
+     * setup and path-guided jobs, which run as one task, finish first.
+     */
+    void pause();
+    void resume();
+
+    /**
+     * Block until the job is Completed or Cancelled (a paused job has not ended).
+     */
+    void wait() const;
+
+    /**
+     * wait() for at most `timeout`.
+     *
+     * @return true if the job has ended
+     */
+    bool wait_for(std::chrono::milliseconds timeout) const;
+
+    /**
+     * Copy of the image so far: each pixel is the average of the samples it
+     * has, black without any. Empty before the job starts and for jobs with
+     * a tiled target.
+     *
+     * @param counts If given, receives sample_counts() as of the same moment
+     */
+    Framebuffer snapshot(std::vector<std::uint32_t>* counts = nullptr) const;
+
+    /**
+     * The image itself, once wait() has returned (partial if cancelled).
+     * Empty for jobs with a tiled target, whose pixels are in the target.
+     */
+    const Framebuffer& framebuffer() const { return image; }
+
+    /**
+     * Samples behind each pixel of framebuffer(), rows top to bottom, once
+     * wait() has returned: samples_per_pixel everywhere for a completed job,
+     * fewer (down to 0) where a cancelled job stopped. Empty for jobs with a
+     * tiled target.
+     */
+    const std::vector<std::uint32_t>& sample_counts() const { return samples; }
+
+    const RenderJob& job() const { return spec; }
+
+private:
+    friend class RenderEngine;
+
+    /// How far the per-frame caches are
+    enum class Setup { Pending, Running, Ready };
+
+    /// Samples of a tile that was paused before it was done
+    struct TileProgress {
+        std::size_t tile = 0;
+        std::vector<double> sums;
+        std::vector<std::uint32_t> counts;
+    };
+
+    explicit RenderHandle(RenderJob job);
+
+    RenderJob spec;
+    std::uint64_t id = 0;                 ///< Submission number, the job's key in the TileScheduler
+    std::chrono::steady_clock::time_point submit_time;
+    std::unique_ptr<FrameCaches> frame;   ///< Built by the setup task
+    int tile_edge = 0;
+    int tiles_x = 0;
+    std::size_t tile_count = 0;           ///< 1 for path-guided jobs, which render as one task
+    std::weak_ptr<RenderQueue> queue;     ///< Woken by cancel() and resume()
+    std::shared_ptr<CancellationToken> token;
+    std::size_t token_listener = 0;
+    CancellationToken interrupt;          ///< Stops the tiles in flight: cancelled by the token and by pause()
+    std::unique_ptr<std::atomic<int>[]> band_tiles_left;  ///< Per band of a tiled target; released at 0
+
+    // Guarded by the queue's mutex
+    Setup setup = Setup::Pending;
+    std::size_t next_tile = 0;
+    std::vector<TileProgress> parked;     ///< Paused tiles, handed out again before new ones
+    std::size_t tiles_in_flight = 0;
+    bool paused = false;
+    RenderStatus final_status = RenderStatus::Completed;  ///< Set when the job leaves the queue
+
+    // Guarded by `mutex`
+    mutable std::mutex mutex;
+    mutable std::condition_variable ended;
+    RenderStatus state = RenderStatus::Queued;
+    std::size_t tiles_done = 0;
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point end_time;
+    double worker_ms = 0.0;
+    Framebuffer image;
+    std::vector<std::uint32_t> samples;
+};
+
+#endif
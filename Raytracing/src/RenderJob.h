@@ -0,0 +1,74 @@
+#ifndef RENDER_JOB_H
+#define RENDER_JOB_H
+
+/**
+ * @file RenderJob.h
+ * @brief Description of one frame to render through a RenderEngine, and
+ * the progress reported for it.
+ */
+
+#include "Camera.h"
+#include "CancellationToken.h"
+#include "Framebuffer.h"
+#include "RenderConfig.h"
+#include "Scene.h"
+#include "TiledFramebuffer.h"
+#include "TileScheduler.h"
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+
+/**
+ * Where a job is in its life; Completed and Cancelled are final.
+ */
+enum class RenderStatus {
+    Queued,     ///< Submitted, not picked up yet
+    Running,    ///< Caches being built or tiles being rendered
+    Paused,     ///< Set aside by RenderHandle::pause(); keeps its samples until resume()
+    Completed,  ///< Every tile rendered
+    Cancelled   ///< Stopped early; the samples taken before that are kept
+};
+
+/**
+ * Snapshot of a job's progress.
+ */
+struct RenderProgress {
+    RenderStatus status = RenderStatus::Queued;
+    std::size_t tiles_done = 0;
+    std::size_t tile_count = 0;
+    double elapsed_ms = 0.0;   ///< Since the job started running (0 while queued)
+    double queued_ms = 0.0;    ///< Queueing latency: from submit() until a worker first took the job
+    double worker_ms = 0.0;    ///< Worker time spent on the job so far, summed over threads
+
+    double fraction() const {
+        return tile_count == 0 ? 0.0 : static_cast<double>(tiles_done) / static_cast<double>(tile_count);
+    }
+};
+
+/**
+ * One frame: what to render and how, where the pixels go and who to tell.
+ *
+ * The scene is shared, not copied, and must not change while the job runs;
+ * build its accelerators before submitting.
+ */
+struct RenderJob {
+    std::shared_ptr<const Scene> scene;
+    Camera camera = Camera(16.0 / 9.0);
+    RenderConfig config;
+    int max_depth = 50;
+    JobSchedule schedule;                        ///< Preview or batch, weight, deadline (see TileScheduler)
+    int tile_size = 32;                          ///< Tile edge in pixels (a tiled target's own size wins)
+    TiledFramebuffer* tiled_target = nullptr;    ///< Render into this mapped file instead of memory; created at
+                                                 ///< the config's size by the caller, who keeps it alive
+    std::function<void(const RenderProgress&)> on_progress;  ///< Called on a worker thread after each tile and
+                                                             ///< once more when the job ends
+    std::ostream* log = nullptr;                 ///< Setup summary as render_framebuffer prints it; null keeps quiet
+    std::shared_ptr<CancellationToken> cancel_token;  ///< Share one between jobs to cancel them together; the
+                                                      ///< engine makes one per job if null
+    std::shared_ptr<const FrameSamples> start_from;   ///< Samples of an earlier render of the same image to add to
+                                                      ///< (e.g. from a RenderCache); in-memory, unguided jobs only
+};
+
+#endif
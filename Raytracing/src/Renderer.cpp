@@ -1,6 +1,15 @@
 #include "Renderer.h"
 
+#include "CpuFeatures.h"
+#include "OccluderCache.h"
+#include "Random.h"
+#include "RayStatistics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 
 Color calculate_sky_color(const Ray& ray) {
     const Vec3 unit_direction = unit_vector(ray.direction());
@@ -17,24 +26,40 @@ Color compute_diffuse_lighting(const Scene& scene, const HitRecord& hit_info) {
 
     Color accumulated_light(0.0, 0.0, 0.0);
     constexpr double shadow_bias = 0.001;
+    const LightVisibilityGrid* visibility = scene.visibility_grid();
 
-    for (const auto& light : scene.lights) {
+    for (std::size_t light_index = 0; light_index < scene.lights.size(); ++light_index) {
+        const Light& light = scene.lights[light_index];
         const Vec3 to_light = light.position - hit_info.hit_point;
         const double distance_squared = to_light.length_squared();
         if (distance_squared <= 0.0) {
             continue;
         }
 
-        const Vec3 light_direction = unit_vector(to_light);
-        const double n_dot_l = dot(hit_info.surface_normal, light_direction);
-        if (n_dot_l <= 0.0) {
+        // Cull lights below the surface before paying for the normalization
+        const double unnormalized_cos = hit_info.shading_frame.cos_theta(to_light);
+        if (unnormalized_cos <= 0.0) {
             continue;
         }
 
         const double distance_to_light = std::sqrt(distance_squared);
+        const double inverse_distance = 1.0 / distance_to_light;
+        const Vec3 light_direction = inverse_distance * to_light;
+        const double n_dot_l = unnormalized_cos * inverse_distance;
+
         const Ray shadow_ray(hit_info.hit_point + shadow_bias * hit_info.surface_normal, light_direction);
-        HitRecord shadow_hit;
-        if (scene.objects.hit(shadow_ray, shadow_bias, distance_to_light - shadow_bias, shadow_hit)) {
+        // Voxels the light grid settled need no ray at all
+        const LightVisibility known = visibility != nullptr ? visibility->classify(shadow_ray.origin(), light_index)
+                                                            : LightVisibility::Mixed;
+        if (known == LightVisibility::Occluded) {
+            ray_statistics::add(ray_statistics::LightGridOccluded);
+            continue;
+        }
+        if (known == LightVisibility::Visible) {
+            ray_statistics::add(ray_statistics::LightGridVisible);
+        } else if (occluder_cache::occluded(scene, light_index, shadow_ray, shadow_bias,
+                                            distance_to_light - shadow_bias)) {
+            // Occlusion only needs the traversal phase; the light's last blocker is tried first
             continue;
         }
 
@@ -45,82 +70,503 @@ Color compute_diffuse_lighting(const Scene& scene, const HitRecord& hit_info) {
     return accumulated_light;
 }
 
-Color calculate_ray_color(const Ray& ray, const Scene& scene, int depth) {
+namespace {
+
+constexpr double kMinHitDistance = 0.001;
+constexpr double kMaxHitDistance = 1'000'000.0;
+
+/**
+ * Cache roles for one path: warm-up paths record into the radiance cache,
+ * preview paths read from it, and any path may add caustic photons or
+ * sample (and train) the guiding field.
+ */
+struct CacheAccess {
+    RadianceCache* record_into = nullptr;
+    const RadianceCache* lookup_from = nullptr;
+    const PhotonMap* caustics = nullptr;
+    GuidingField* guiding = nullptr;
+    bool train_guiding = false;
+};
+
+constexpr double kPi = 3.14159265358979323846;
+
+double luminance(const Color& color) {
+    return 0.2126 * color.x() + 0.7152 * color.y() + 0.0722 * color.z();
+}
+
+Color trace_path(const Ray& ray, const Scene& scene, int depth, int diffuse_hits, const CacheAccess& cache);
+
+/**
+ * Indirect light of a Matte hit through a guided bounce: the Lambertian
+ * weight albedo * cos / (pi * pdf) with the one-sample MIS mixture pdf.
+ */
+Color trace_guided_bounce(const HitRecord& hit_info, const Scene& scene, int depth, int diffuse_hits,
+                          const CacheAccess& cache) {
+    GuidingRegion& region = cache.guiding->region(hit_info.hit_point, hit_info.surface_normal);
+    GuidedDirection sampled;
+    if (!cache.guiding->sample(region, hit_info.shading_frame, sampled)) {
+        return Color(0.0, 0.0, 0.0);
+    }
+
+    const Color incoming = trace_path(Ray(hit_info.hit_point, sampled.direction), scene, depth - 1,
+                                      diffuse_hits + 1, cache);
+    if (cache.train_guiding) {
+        cache.guiding->record(region, sampled, luminance(incoming));
+    }
+    return hit_info.packed_material->albedo * incoming * (sampled.cos_theta / (kPi * sampled.pdf));
+}
+
+bool is_packed_matte(const HitRecord& hit_info) {
+    return hit_info.packed_material != nullptr && hit_info.packed_material->kind == MaterialKind::Matte;
+}
+
+/**
+ * Radiance leaving `hit_info` back along `ray`: direct light, caustics and
+ * the scattered bounce.
+ */
+Color shade_hit(const Ray& ray, const HitRecord& hit_info, const Scene& scene, int depth, int diffuse_hits,
+                const CacheAccess& cache) {
+    const bool is_diffuse = surface_is_diffuse(hit_info);
+    if (is_diffuse && cache.lookup_from != nullptr
+        && diffuse_hits >= cache.lookup_from->settings().lookup_bounce) {
+        Color cached;
+        if (cache.lookup_from->lookup(hit_info.hit_point, hit_info.surface_normal, cached)) {
+            return cached;
+        }
+    }
+
+    Color outgoing(0.0, 0.0, 0.0);
+    if (is_diffuse) {
+        Color incoming_light = compute_diffuse_lighting(scene, hit_info);
+        if (cache.caustics != nullptr
+            && (cache.caustics->settings().lookup_diffuse_hits == 0
+                || diffuse_hits < cache.caustics->settings().lookup_diffuse_hits)) {
+            incoming_light += cache.caustics->irradiance(hit_info.hit_point, hit_info.surface_normal);
+        }
+        outgoing = surface_base_color(hit_info) * incoming_light;
+    }
+
+    ScatterRecord scatter_record;
+    if (cache.guiding != nullptr && is_packed_matte(hit_info)) {
+        outgoing += trace_guided_bounce(hit_info, scene, depth, diffuse_hits, cache);
+    } else if (surface_scatter(ray, hit_info, scatter_record)) {
+        outgoing += scatter_record.attenuation
+            * trace_path(scatter_record.scattered_ray, scene, depth - 1, diffuse_hits + (is_diffuse ? 1 : 0), cache);
+    }
+
+    if (is_diffuse && cache.record_into != nullptr) {
+        cache.record_into->record(hit_info.hit_point, hit_info.surface_normal, outgoing);
+    }
+    return outgoing;
+}
+
+Color trace_path(const Ray& ray, const Scene& scene, int depth, int diffuse_hits, const CacheAccess& cache) {
     if (depth <= 0) {
         return Color(0, 0, 0);
     }
 
     HitRecord hit_info;
-    constexpr double min_hit_distance = 0.001;
-    constexpr double max_hit_distance = 1'000'000.0;
+    if (!scene.hit(ray, kMinHitDistance, kMaxHitDistance, hit_info)) {
+        return calculate_sky_color(ray);
+    }
+    return shade_hit(ray, hit_info, scene, depth, diffuse_hits, cache);
+}
 
-    if (scene.objects.hit(ray, min_hit_distance, max_hit_distance, hit_info)) {
-        const Material& material = *hit_info.material_ptr;
-        Color direct_component(0.0, 0.0, 0.0);
+/**
+ * trace_path for a camera ray whose first hit can only be one of `visible`.
+ */
+Color trace_camera_path(const Ray& ray, const PrimitiveSubset& visible, const Scene& scene, int depth,
+                        const CacheAccess& cache) {
+    if (depth <= 0) {
+        return Color(0, 0, 0);
+    }
 
-        if (material.is_diffuse()) {
-            const Color incoming_light = compute_diffuse_lighting(scene, hit_info);
-            direct_component = material.base_color() * incoming_light;
-        }
+    HitRecord hit_info;
+    if (!scene.dispatch_table.hit_subset(visible.indices, visible.count, ray, kMinHitDistance, kMaxHitDistance,
+                                         hit_info)) {
+        return calculate_sky_color(ray);
+    }
+    return shade_hit(ray, hit_info, scene, depth, 0, cache);
+}
 
-        ScatterRecord scatter_record;
-        if (material.scatter(ray, hit_info, scatter_record)) {
-            return direct_component
-                + scatter_record.attenuation * calculate_ray_color(scatter_record.scattered_ray, scene, depth - 1);
-        }
+/**
+ * trace_path for a camera ray whose first hit was rasterized: only the
+ * recorded primitive is intersected, to recover the exact hit attributes.
+ */
+Color trace_rasterized_path(const Ray& ray, const VisibilitySample& first_hit, const Scene& scene, int depth,
+                            const CacheAccess& cache) {
+    if (depth <= 0) {
+        return Color(0, 0, 0);
+    }
+    if (first_hit.primitive == VisibilityBuffer::kNoPrimitive) {
+        return calculate_sky_color(ray);
+    }
 
-        return direct_component;
+    HitCandidate candidate;
+    if (!scene.dispatch_table.intersect_primitive(first_hit.primitive, ray, kMinHitDistance, kMaxHitDistance,
+                                                  candidate)) {
+        // Cannot happen for a buffer built from this table; trace normally if it does
+        return trace_path(ray, scene, depth, 0, cache);
     }
+    HitRecord hit_info;
+    candidate.primitive->fill_hit_record(ray, candidate, hit_info);
+    return shade_hit(ray, hit_info, scene, depth, 0, cache);
+}
 
-    return calculate_sky_color(ray);
+CacheAccess access_for(const IntegratorCaches& caches) {
+    CacheAccess access;
+    access.lookup_from = caches.radiance;
+    access.caustics = caches.caustics;
+    access.guiding = caches.guiding;
+    access.train_guiding = caches.train_guiding;
+    return access;
 }
 
-Color render_pixel(int col, int row, const RenderConfig& config,
-                   const Camera& camera, const Scene& scene, int max_depth) {
-    Color accumulated_color(0, 0, 0);
+Ray primary_ray(int col, int row, const RenderConfig& config, const Camera& camera) {
+    const double horizontal_coord = (col + random_double()) / (config.image_width - 1);
+    const double vertical_coord = (row + random_double()) / (config.image_height - 1);
+
+    const Vec3 ray_direction = camera.lower_left_corner
+        + horizontal_coord * camera.horizontal
+        + vertical_coord * camera.vertical
+        - camera.origin;
+    return Ray(camera.origin, ray_direction);
+}
+
+} // namespace
 
-    for (int sample = 0; sample < config.samples_per_pixel; ++sample) {
-        const double horizontal_coord = (col + random_double()) / (config.image_width - 1);
-        const double vertical_coord = (row + random_double()) / (config.image_height - 1);
+Color calculate_ray_color(const Ray& ray, const Scene& scene, int depth) {
+    return trace_path(ray, scene, depth, 0, CacheAccess());
+}
+
+Color calculate_ray_color(const Ray& ray, const Scene& scene, int depth, const IntegratorCaches& caches) {
+    return trace_path(ray, scene, depth, 0, access_for(caches));
+}
 
-        const Vec3 ray_direction = camera.lower_left_corner
-            + horizontal_coord * camera.horizontal
-            + vertical_coord * camera.vertical
-            - camera.origin;
-        const Ray ray(camera.origin, ray_direction);
+Color sum_pixel_samples(int col, int row, int first_sample, int sample_count, const RenderConfig& config,
+                        const Camera& camera, const Scene& scene, int max_depth, const IntegratorCaches& caches) {
+    Color accumulated_color(0, 0, 0);
+    const int end_sample = first_sample + sample_count;
+    const std::uint64_t pixel = static_cast<std::uint64_t>(row) * static_cast<std::uint64_t>(config.image_width)
+        + static_cast<std::uint64_t>(col);
+    // Each sample draws from its own stream, so sample n is the same fresh or resumed
+    const auto seed = [&config, pixel](int sample) {
+        seed_sample_uniforms(config.sample_seed, pixel, static_cast<std::uint64_t>(sample));
+    };
 
-        accumulated_color += calculate_ray_color(ray, scene, max_depth);
+    if (caches.first_hits != nullptr) {
+        const int subsamples = caches.first_hits->subsample_count();
+        const CacheAccess access = access_for(caches);
+        for (int sample = first_sample; sample < end_sample; ++sample) {
+            seed(sample);
+            const int subsample = sample % subsamples;
+            accumulated_color += trace_rasterized_path(caches.first_hits->camera_ray(col, row, subsample),
+                                                       caches.first_hits->at(col, row, subsample), scene,
+                                                       max_depth, access);
+        }
+    } else if (caches.primary_culling != nullptr) {
+        const PrimitiveSubset visible = caches.primary_culling->tile_primitives(col, row);
+        const CacheAccess access = access_for(caches);
+        for (int sample = first_sample; sample < end_sample; ++sample) {
+            seed(sample);
+            const Ray ray = primary_ray(col, row, config, camera);
+            accumulated_color += trace_camera_path(ray, visible, scene, max_depth, access);
+        }
+    } else {
+        for (int sample = first_sample; sample < end_sample; ++sample) {
+            seed(sample);
+            const Ray ray = primary_ray(col, row, config, camera);
+            accumulated_color += calculate_ray_color(ray, scene, max_depth, caches);
+        }
     }
+    return accumulated_color;
+}
 
+Color render_pixel(int col, int row, const RenderConfig& config,
+                   const Camera& camera, const Scene& scene, int max_depth,
+                   const IntegratorCaches& caches) {
+    const Color accumulated_color =
+        sum_pixel_samples(col, row, 0, config.samples_per_pixel, config, camera, scene, max_depth, caches);
     const double scale = 1.0 / config.samples_per_pixel;
     return scale * accumulated_color;
 }
 
-std::vector<unsigned char> render_image(const RenderConfig& config,
-                                        const Camera& camera,
-                                        const Scene& scene,
-                                        int max_depth) {
-    std::vector<unsigned char> image_data;
-    const std::size_t total_pixels =
-        static_cast<std::size_t>(config.image_width) * static_cast<std::size_t>(config.image_height);
-    image_data.reserve(total_pixels * 3);
+void warm_radiance_cache(const RenderConfig& config, const Camera& camera,
+                         const Scene& scene, int max_depth, RadianceCache& cache,
+                         const PhotonMap* caustics) {
+    CacheAccess access;
+    access.record_into = &cache;
+    access.caustics = caustics;
+    const int samples = cache.settings().warmup_samples_per_pixel;
+    for (int row = 0; row < config.image_height; ++row) {
+        for (int col = 0; col < config.image_width; ++col) {
+            for (int sample = 0; sample < samples; ++sample) {
+                trace_path(primary_ray(col, row, config, camera), scene, max_depth, 0, access);
+            }
+        }
+    }
+}
+
+bool render_guided(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                   IntegratorCaches caches, Framebuffer& framebuffer, std::ostream* log,
+                   const CancellationToken* stop) {
+    const RoomLayout& layout = scene.layout;
+    GuidingField guiding(config.path_guiding,
+                         Point3(-layout.half_width, layout.floor_y, layout.back_wall_z),
+                         Point3(layout.half_width, layout.ceiling_y, layout.front_opening_z));
+    caches.guiding = &guiding;
+
+    std::vector<Color> sums(framebuffer.pixel_count(), Color(0.0, 0.0, 0.0));
+    int remaining = config.samples_per_pixel;
+    int training_samples = 1;
+    for (int pass = 0; remaining > 0; ++pass) {
+        caches.train_guiding = pass < config.path_guiding.training_passes;
+        const int first_sample = config.samples_per_pixel - remaining;
+        const int pass_samples = caches.train_guiding ? std::min(training_samples, remaining) : remaining;
 
-    std::cerr << "Rendering scene with " << scene.object_count() << " objects and "
-              << scene.light_count() << " lights...\n";
-    std::cerr << "Image size: " << config.image_width << "x" << config.image_height << "\n";
-    std::cerr << "Using " << config.samples_per_pixel << " samples per pixel for antialiasing\n";
-    std::cerr << "Maximum ray bounce depth: " << max_depth << "\n";
+        for (int row = config.image_height - 1; row >= 0; --row) {
+            if (stop != nullptr && stop->cancelled()) {
+                return false;
+            }
+            if (log != nullptr) {
+                *log << "\rGuiding pass " << pass + 1 << " (" << pass_samples
+                     << " spp), scanlines remaining: " << row << ' ' << std::flush;
+            }
+            const std::size_t image_row = static_cast<std::size_t>(config.image_height - 1 - row);
+            for (int col = 0; col < config.image_width; ++col) {
+                sums[image_row * static_cast<std::size_t>(config.image_width) + static_cast<std::size_t>(col)]
+                    += sum_pixel_samples(col, row, first_sample, pass_samples, config, camera, scene, max_depth,
+                                         caches);
+            }
+        }
 
-    for (int row = config.image_height - 1; row >= 0; --row) {
-        std::cerr << "\rScanlines remaining: " << row << ' ' << std::flush;
+        remaining -= pass_samples;
+        if (caches.train_guiding) {
+            guiding.refine(pass_samples);
+            training_samples *= 2;
+            if (log != nullptr) {
+                *log << "\nGuiding field: " << guiding.spatial_leaf_count() << " spatial leaves, "
+                     << guiding.directional_node_count() << " directional nodes";
+            }
+        }
+        if (log != nullptr) {
+            *log << "\n";
+        }
+    }
 
+    const double scale = 1.0 / config.samples_per_pixel;
+    for (int row = 0; row < config.image_height; ++row) {
         for (int col = 0; col < config.image_width; ++col) {
-            const Color pixel_color = render_pixel(col, row, config, camera, scene, max_depth);
-            write_color(image_data, pixel_color);
+            framebuffer.set(col, row, scale * sums[static_cast<std::size_t>(row) * static_cast<std::size_t>(config.image_width)
+                                                   + static_cast<std::size_t>(col)]);
+        }
+    }
+    return true;
+}
+
+void report_ray_statistics(std::ostream& log) {
+    const RayStatistics statistics = ray_statistics::snapshot();
+    const std::uint64_t skipped = statistics.light_grid_visible + statistics.light_grid_occluded;
+    if (statistics.shadow_rays == 0 && skipped == 0) {
+        return;
+    }
+    log << "Shadow rays: " << statistics.shadow_rays << " (" << statistics.shadow_rays_occluded
+        << " occluded)";
+    if (skipped > 0) {
+        log << ", light grid skipped: " << statistics.light_grid_visible << " visible + "
+            << statistics.light_grid_occluded << " occluded";
+    }
+    if (statistics.occluder_cache_tests > 0) {
+        log << ", occluder cache hits: " << statistics.occluder_cache_hits << " of "
+            << statistics.occluder_cache_tests << " tests ("
+            << 100.0 * statistics.occluder_cache_hit_rate() << "%)";
+    }
+    log << "\n";
+}
+
+void begin_frame(const RenderConfig& config, const Scene& scene, int max_depth, std::ostream* log) {
+    if (log == nullptr) {
+        return;
+    }
+
+    *log << "Rendering scene with " << scene.object_count() << " objects and "
+         << scene.light_count() << " lights...\n";
+    *log << "Image size: " << config.image_width << "x" << config.image_height << "\n";
+    *log << "Using " << config.samples_per_pixel << " samples per pixel for antialiasing\n";
+    *log << "Maximum ray bounce depth: " << max_depth << "\n";
+    *log << "Kernel ISA: " << cpu_features::isa_name(cpu_features::active_isa())
+         << " (detected " << cpu_features::isa_name(cpu_features::detected_isa()) << ")\n";
+    if (config.fast_math_kernels != fast_math::kPrecise) {
+        *log << "Fast math kernels enabled (mask " << config.fast_math_kernels << ")\n";
+    }
+}
+
+void prepare_frame_caches(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                          bool whole_frame_buffers, FrameCaches& frame, std::ostream* log) {
+    IntegratorCaches& caches = frame.caches;
+    if (!whole_frame_buffers && log != nullptr
+        && (config.primary_tile_size > 0 || config.raster_primary.enabled || config.path_guiding.enabled)) {
+        *log << "Tiled output: skipping tile culling, the visibility buffer and path guiding,"
+                " which keep data for the whole frame\n";
+    }
+
+    if (whole_frame_buffers && config.primary_tile_size > 0) {
+        const auto start = std::chrono::steady_clock::now();
+        frame.culling.build(scene.dispatch_table, camera, config.image_width, config.image_height,
+                            config.primary_tile_size);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (log != nullptr) {
+            *log << "Tile culling: " << frame.culling.tile_count() << " tiles of " << frame.culling.tile_size()
+                 << " px, " << frame.culling.mean_primitives() << " of " << scene.dispatch_table.primitive_count()
+                 << " primitives per tile (" << elapsed.count() << " ms)\n";
+        }
+        caches.primary_culling = &frame.culling;
+    }
+
+    if (whole_frame_buffers && config.raster_primary.enabled) {
+        const auto start = std::chrono::steady_clock::now();
+        frame.first_hits.build(scene.dispatch_table, camera, config.image_width, config.image_height,
+                               std::min(config.raster_primary.subsamples, config.samples_per_pixel),
+                               kMinHitDistance, kMaxHitDistance);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (log != nullptr) {
+            *log << "Visibility buffer: " << frame.first_hits.subsample_count() << " subsamples per pixel, "
+                 << frame.first_hits.fragment_count() << " fragments (" << elapsed.count() << " ms)\n";
         }
+        caches.first_hits = &frame.first_hits;
     }
 
-    std::cerr << "\n";
-    return image_data;
+    if (config.caustics.enabled) {
+        const auto start = std::chrono::steady_clock::now();
+        frame.caustics.build(scene, config.caustics);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (log != nullptr && frame.caustics.emitted_count() > 0) {
+            *log << "Caustic photons: " << frame.caustics.photon_count() << " stored of "
+                 << frame.caustics.emitted_count() << " emitted (" << elapsed.count() << " ms)\n";
+        }
+        caches.caustics = frame.caustics.empty() ? nullptr : &frame.caustics;
+    }
+
+    if (config.radiance_cache.mode == RadianceCacheMode::Preview) {
+        frame.radiance = std::make_unique<RadianceCache>(config.radiance_cache);
+        warm_radiance_cache(config, camera, scene, max_depth, *frame.radiance, caches.caustics);
+        if (log != nullptr) {
+            *log << "Radiance cache (preview): " << frame.radiance->cell_count() << " cells from "
+                 << frame.radiance->record_count() << " records\n";
+        }
+        caches.radiance = frame.radiance.get();
+    }
+}
+
+void render_tile(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                 const IntegratorCaches& caches, int col_begin, int col_end, int row_begin, int row_end,
+                 float* out, std::size_t row_stride) {
+    for (int image_row = row_begin; image_row < row_end; ++image_row) {
+        const int row = config.image_height - 1 - image_row;
+        float* pixel = out + static_cast<std::size_t>(image_row - row_begin) * row_stride;
+        for (int col = col_begin; col < col_end; ++col, pixel += 3) {
+            const Color color = render_pixel(col, row, config, camera, scene, max_depth, caches);
+            pixel[0] = static_cast<float>(color.x());
+            pixel[1] = static_cast<float>(color.y());
+            pixel[2] = static_cast<float>(color.z());
+        }
+    }
+}
+
+bool accumulate_tile(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                     const IntegratorCaches& caches, int col_begin, int col_end, int row_begin, int row_end,
+                     double* sums, std::uint32_t* counts, const CancellationToken* stop) {
+    const std::size_t width = static_cast<std::size_t>(col_end - col_begin);
+    const std::size_t pixels = width * static_cast<std::size_t>(row_end - row_begin);
+    const std::uint32_t target = static_cast<std::uint32_t>(config.samples_per_pixel);
+
+    // One sample per pixel per pass, so a tile stopped early is evenly noisy
+    for (std::uint32_t pass = *std::min_element(counts, counts + pixels); pass < target; ++pass) {
+        for (std::size_t index = 0; index < pixels; ++index) {
+            if (counts[index] > pass) {
+                continue;
+            }
+            if (stop != nullptr && stop->cancelled()) {
+                return false;
+            }
+            const int col = col_begin + static_cast<int>(index % width);
+            const int row = config.image_height - 1 - (row_begin + static_cast<int>(index / width));
+            const Color sample = sum_pixel_samples(col, row, static_cast<int>(counts[index]), 1, config, camera,
+                                                   scene, max_depth, caches);
+            sums[3 * index] += sample.x();
+            sums[3 * index + 1] += sample.y();
+            sums[3 * index + 2] += sample.z();
+            ++counts[index];
+        }
+    }
+    return true;
+}
+
+Framebuffer render_framebuffer(const RenderConfig& config,
+                               const Camera& camera,
+                               const Scene& scene,
+                               int max_depth) {
+    const FrameSettingsScope settings(config);
+    Framebuffer framebuffer(config.image_width, config.image_height);
+    ray_statistics::reset();
+    begin_frame(config, scene, max_depth, &std::cerr);
+    FrameCaches frame;
+    prepare_frame_caches(config, camera, scene, max_depth, true, frame, &std::cerr);
+
+    if (config.path_guiding.enabled) {
+        render_guided(config, camera, scene, max_depth, frame.caches, framebuffer, &std::cerr);
+    } else {
+        for (int row = config.image_height - 1; row >= 0; --row) {
+            std::cerr << "\rScanlines remaining: " << row << ' ' << std::flush;
+
+            const int image_row = config.image_height - 1 - row;
+            for (int col = 0; col < config.image_width; ++col) {
+                const Color pixel_color = render_pixel(col, row, config, camera, scene, max_depth, frame.caches);
+                framebuffer.set(col, image_row, pixel_color);
+            }
+        }
+        std::cerr << "\n";
+    }
+
+    report_ray_statistics(std::cerr);
+    return framebuffer;
+}
+
+void render_tiled(const RenderConfig& config,
+                  const Camera& camera,
+                  const Scene& scene,
+                  int max_depth,
+                  TiledFramebuffer& framebuffer) {
+    const FrameSettingsScope settings(config);
+    ray_statistics::reset();
+    begin_frame(config, scene, max_depth, &std::cerr);
+    FrameCaches frame;
+    prepare_frame_caches(config, camera, scene, max_depth, false, frame, &std::cerr);
+
+    const int tile_size = framebuffer.tile_size();
+    const std::size_t tile_stride = static_cast<std::size_t>(tile_size) * 3;
+    for (int band = 0; band < framebuffer.bands(); ++band) {
+        std::cerr << "\rTile rows remaining: " << framebuffer.bands() - band << ' ' << std::flush;
+        const int first_row = band * tile_size;
+        const int last_row = std::min(first_row + tile_size, config.image_height);
+        for (int tile_x = 0; tile_x < framebuffer.tiles_x(); ++tile_x) {
+            const int first_col = tile_x * tile_size;
+            const int last_col = std::min(first_col + tile_size, config.image_width);
+            render_tile(config, camera, scene, max_depth, frame.caches, first_col, last_col, first_row, last_row,
+                        framebuffer.tile(tile_x, band), tile_stride);
+        }
+        framebuffer.release_band(band);
+    }
+    std::cerr << "\rTile rows remaining: 0 \n";
+
+    report_ray_statistics(std::cerr);
 }
 
+std::vector<unsigned char> render_image(const RenderConfig& config,
+                                        const Camera& camera,
+                                        const Scene& scene,
+                                        int max_depth) {
+    const FrameSettingsScope settings(config);
+    const Framebuffer framebuffer = render_framebuffer(config, camera, scene, max_depth);
+    return quantize_framebuffer(framebuffer, config.dither);
+}
@@ -7,17 +7,31 @@
  */
 
 #include "Camera.h"
+#include "CancellationToken.h"
 #include "Color.h"
+#include "FastMath.h"
+#include "Framebuffer.h"
 #include "Hittable.h"
 #include "Material.h"
+#include "OccluderCache.h"
+#include "PackedMaterial.h"
+#include "PathGuiding.h"
+#include "PhotonMap.h"
+#include "RadianceCache.h"
 #include "Ray.h"
 #include "RenderConfig.h"
 #include "Scene.h"
+#include "TileCulling.h"
+#include "TiledFramebuffer.h"
+#include "VisibilityBuffer.h"
 #include "Utils.h"
 #include "Vec3.h"
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 /**
@@ -49,6 +63,44 @@ Color compute_diffuse_lighting(const Scene& scene, const HitRecord& hit_info);
  */
 Color calculate_ray_color(const Ray& ray, const Scene& scene, int depth);
 
+/**
+ * Precomputed lighting structures the integrator may consult; null members
+ * are skipped.
+ */
+struct IntegratorCaches {
+    /// Paths end at diffuse hits past `settings().lookup_bounce` whose cell is populated
+    const RadianceCache* radiance = nullptr;
+    /// Caustic irradiance added at the first `settings().lookup_diffuse_hits` diffuse hits
+    const PhotonMap* caustics = nullptr;
+    /// Matte bounces mix cosine and learned sampling; they also train it when `train_guiding` is set
+    GuidingField* guiding = nullptr;
+    bool train_guiding = false;
+    /// Camera rays in render_pixel scan only the primitives their tile's frustum kept
+    const TileCulling* primary_culling = nullptr;
+    /// Rasterized first hits; render_pixel starts paths from them (takes precedence over primary_culling)
+    const VisibilityBuffer* first_hits = nullptr;
+};
+
+/**
+ * calculate_ray_color with radiance-cache lookups, caustic photons and
+ * path guiding.
+ *
+ * @param ray The ray we're tracing
+ * @param scene The scene containing objects and lights
+ * @param depth Current recursion depth (prevents infinite bounces)
+ * @param caches Warmed-up radiance cache, built photon map and/or guiding field
+ * @return The color for this ray
+ */
+Color calculate_ray_color(const Ray& ray, const Scene& scene, int depth, const IntegratorCaches& caches);
+
+/**
+ * Sum (not average) of samples [first_sample, first_sample + sample_count)
+ * of pixel (col, row), as render_pixel takes them; the sample number picks
+ * the visibility-buffer subsample.
+ */
+Color sum_pixel_samples(int col, int row, int first_sample, int sample_count, const RenderConfig& config,
+                        const Camera& camera, const Scene& scene, int max_depth, const IntegratorCaches& caches);
+
 /**
  * Render a single pixel by casting multiple rays through it (antialiasing).
  * Takes multiple samples per pixel and averages them for smoother edges.
@@ -59,13 +111,164 @@ Color calculate_ray_color(const Ray& ray, const Scene& scene, int depth);
  * @param camera Camera used to spawn primary rays.
  * @param scene Scene containing geometry and lights.
  * @param max_depth Maximum recursion depth for secondary rays.
+ * @param caches Optional radiance cache, caustic photon map and guiding field.
  * @return Linear RGB color accumulated for the pixel.
  */
 Color render_pixel(int col, int row, const RenderConfig& config,
-                   const Camera& camera, const Scene& scene, int max_depth);
+                   const Camera& camera, const Scene& scene, int max_depth,
+                   const IntegratorCaches& caches = IntegratorCaches());
+
+/**
+ * Populate a radiance cache with `warmup_samples_per_pixel` full paths per
+ * pixel, recording the outgoing radiance at every diffuse hit.
+ *
+ * @param config Render configuration containing resolution.
+ * @param camera Camera used to spawn primary rays.
+ * @param scene Scene containing geometry and lights.
+ * @param max_depth Maximum recursion depth for secondary rays.
+ * @param cache Cache to record into.
+ * @param caustics Optional caustic photon map included in the recorded radiance.
+ */
+void warm_radiance_cache(const RenderConfig& config, const Camera& camera,
+                         const Scene& scene, int max_depth, RadianceCache& cache,
+                         const PhotonMap* caustics = nullptr);
+
+/**
+ * Per-frame lighting and culling structures, built once by
+ * prepare_frame_caches() and then only read, by any number of threads,
+ * through `caches`.
+ */
+struct FrameCaches {
+    TileCulling culling;
+    VisibilityBuffer first_hits;
+    PhotonMap caustics;
+    std::unique_ptr<RadianceCache> radiance;
+    IntegratorCaches caches;
+};
+
+/**
+ * The per-frame switches in a RenderConfig (fast-math kernels and the
+ * occluder cache), applied to the calling thread for the object's lifetime.
+ * parallel_for hands them on to its helpers, so frames rendered at the same
+ * time with different settings do not affect each other.
+ */
+class FrameSettingsScope {
+public:
+    explicit FrameSettingsScope(const RenderConfig& config)
+        : kernels(config.fast_math_kernels)
+        , occluders(config.occluder_cache) {}
+
+private:
+    fast_math::ScopedKernels kernels;
+    occluder_cache::ScopedEnabled occluders;
+};
+
+/**
+ * Given a `log`, print the frame summary to it. Apply the frame's switches
+ * with a FrameSettingsScope first.
+ */
+void begin_frame(const RenderConfig& config, const Scene& scene, int max_depth, std::ostream* log);
+
+/**
+ * Build what `config` asks for into `frame`: caustic photons, the warmed-up
+ * radiance cache and, with `whole_frame_buffers`, tile culling and the
+ * visibility buffer (both hold data for every pixel of the frame).
+ *
+ * @param log Receives build times and sizes; null keeps quiet
+ */
+void prepare_frame_caches(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                          bool whole_frame_buffers, FrameCaches& frame, std::ostream* log);
+
+/**
+ * Render pixels [col_begin, col_end) x [row_begin, row_end) of the image,
+ * rows counted from the top, into `out` as interleaved RGB floats, image
+ * rows top to bottom, each `row_stride` floats after the previous.
+ * Safe to call from several threads for different tiles of one frame.
+ */
+void render_tile(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                 const IntegratorCaches& caches, int col_begin, int col_end, int row_begin, int row_end,
+                 float* out, std::size_t row_stride);
+
+/**
+ * Interruptible form of render_tile: add samples to the running sums and
+ * sample counts of the tile's pixels, one sample per pixel per pass, until
+ * every pixel has config.samples_per_pixel or `stop` is cancelled, which is
+ * checked before every sample. Calling it again with the same buffers picks
+ * up where it stopped.
+ *
+ * @param sums RGB sums, tile rows top to bottom, packed (3 per pixel)
+ * @param counts Samples taken per pixel, same order; start from zeros
+ * @param stop Null runs to the end
+ * @return true once every pixel has all its samples
+ */
+bool accumulate_tile(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                     const IntegratorCaches& caches, int col_begin, int col_end, int row_begin, int row_end,
+                     double* sums, std::uint32_t* counts, const CancellationToken* stop);
+
+/**
+ * The path-guided passes of render_framebuffer: training passes of 1, 2, 4,
+ * ... spp refine a guiding field, a final pass renders the rest with it, and
+ * all passes are averaged into `framebuffer`. Each pass covers the whole
+ * frame, so this runs on one thread.
+ *
+ * @param log Receives pass progress; null keeps quiet
+ * @param stop Checked between scanlines; once it is cancelled the render is
+ *             abandoned and `framebuffer` left as it was
+ * @return false if stopped
+ */
+bool render_guided(const RenderConfig& config, const Camera& camera, const Scene& scene, int max_depth,
+                   IntegratorCaches caches, Framebuffer& framebuffer, std::ostream* log,
+                   const CancellationToken* stop = nullptr);
+
+/**
+ * Print the shadow-ray counters gathered since the last
+ * ray_statistics::reset(), if there are any.
+ */
+void report_ray_statistics(std::ostream& log);
+
+/**
+ * Render the entire image into a linear float framebuffer.
+ *
+ * With `config.path_guiding.enabled` the samples are split into training
+ * passes of 1, 2, 4, ... spp, each refining the guiding field, and a final
+ * pass with the rest; every pass is unbiased, so all are averaged.
+ *
+ * @param config Render configuration containing resolution and sampling hints.
+ * @param camera Camera used to spawn primary rays.
+ * @param scene Scene containing geometry and lights.
+ * @param max_depth Maximum recursion depth for secondary rays.
+ * @return Linear RGB framebuffer, rows top to bottom.
+ */
+Framebuffer render_framebuffer(const RenderConfig& config,
+                               const Camera& camera,
+                               const Scene& scene,
+                               int max_depth);
+
+/**
+ * Render the entire image into a tiled, file-backed framebuffer, one band
+ * of tiles at a time, releasing each band once it is done, so memory stays
+ * at about one band whatever the resolution.
+ *
+ * Tile culling, the visibility buffer and path guiding keep data for the
+ * whole frame and are skipped; caustics and the radiance cache are used as
+ * in render_framebuffer. Pixels are visited in a different order, so the
+ * noise differs from render_framebuffer's.
+ *
+ * @param config Render configuration containing resolution and sampling hints.
+ * @param camera Camera used to spawn primary rays.
+ * @param scene Scene containing geometry and lights.
+ * @param max_depth Maximum recursion depth for secondary rays.
+ * @param framebuffer Created at config.image_width x config.image_height.
+ */
+void render_tiled(const RenderConfig& config,
+                  const Camera& camera,
+                  const Scene& scene,
+                  int max_depth,
+                  TiledFramebuffer& framebuffer);
 
 /**
- * Render the entire image with antialiasing and recursive ray tracing.
+ * Render the entire image with antialiasing and recursive ray tracing,
+ * then quantize it to 8-bit RGB (see quantize_framebuffer).
  *
  * @param config Render configuration containing resolution and sampling hints.
  * @param camera Camera used to spawn primary rays.
@@ -0,0 +1,33 @@
+#include "RoomEnclosure.h"
+
+RoomEnclosure::RoomEnclosure(const RoomLayout& layout, const RoomMaterials& materials)
+    : lo(-layout.half_width, layout.floor_y, layout.back_wall_z)
+    , hi(layout.half_width, layout.ceiling_y, layout.front_opening_z)
+    , open_faces(1u << 5)
+    , face_materials{{materials.left_wall, materials.right_wall, materials.floor, materials.ceiling,
+                      materials.back_wall, nullptr}}
+{}
+
+bool RoomEnclosure::intersect(const Ray& ray, double min_distance, double max_distance,
+                              HitCandidate& candidate) const {
+    double t;
+    int face;
+    if (!intersect_room_enclosure(lo, hi, open_faces, ray, min_distance, max_distance, t, face)) {
+        return false;
+    }
+
+    candidate.distance_from_ray = t;
+    candidate.primitive = this;
+    candidate.u = face;
+    candidate.v = 0.0;
+    return true;
+}
+
+void RoomEnclosure::fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                                    HitRecord& record) const {
+    const int face = static_cast<int>(candidate.u);
+    record.distance_from_ray = candidate.distance_from_ray;
+    record.hit_point = ray.at(candidate.distance_from_ray);
+    record.material_ptr = face_materials[face].get();
+    record.set_face_normal(ray, enclosure_inward_normal(face));
+}
@@ -0,0 +1,158 @@
+#ifndef ROOM_ENCLOSURE_H
+#define ROOM_ENCLOSURE_H
+
+/**
+ * @file RoomEnclosure.h
+ * @brief Room shell (floor, ceiling, walls) as a single box primitive.
+ */
+
+#include "Hittable.h"
+#include "Material.h"
+#include "Ray.h"
+#include "RoomLayout.h"
+#include "Vec3.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+/**
+ * Number of faces of an enclosure box. Face `2 * axis` is the plane at the
+ * box minimum along `axis`, face `2 * axis + 1` the plane at the maximum.
+ */
+constexpr int kEnclosureFaces = 6;
+
+/**
+ * Normal of an enclosure face, pointing into the box. Built like a flipped
+ * AxisAlignedRect normal (negated, so zero components of the maximum faces
+ * are -0), which keeps the shading frame identical to the rectangle's.
+ */
+inline Vec3 enclosure_inward_normal(int face) {
+    const Vec3 base(face / 2 == 0 ? 1.0 : 0.0, face / 2 == 1 ? 1.0 : 0.0, face / 2 == 2 ? 1.0 : 0.0);
+    return (face & 1) ? base.negate() : base;
+}
+
+/**
+ * Ray-enclosure intersection kernel shared by RoomEnclosure and the packed
+ * primitive table.
+ *
+ * One slab test gives where the ray enters and leaves the box and through
+ * which faces. A ray from inside the room (every bounce) only leaves it, so
+ * its hit is the exit face; a ray from outside hits its entry face, or, if
+ * it enters through an open face, its exit face. Distances are computed as
+ * (plane - origin) / direction, like intersect_axis_aligned_rect, and a face
+ * the ray runs parallel to (|direction| < 1e-8 along its axis) is never hit,
+ * so the result matches the faces modelled as separate rectangles.
+ *
+ * @param lo Box minimum corner
+ * @param hi Box maximum corner
+ * @param open_faces Bit `face` set for faces without a surface
+ * @param ray The ray to test
+ * @param min_distance Ignore hits closer than this
+ * @param max_distance Ignore hits farther than this
+ * @param distance Output: ray parameter of the hit
+ * @param face Output: index of the face hit
+ * @return true if the ray crosses a closed face inside the distance range
+ */
+inline bool intersect_room_enclosure(const Point3& lo, const Point3& hi, unsigned open_faces, const Ray& ray,
+                                     double min_distance, double max_distance, double& distance, int& face) {
+    const Point3 origin = ray.origin();
+    const Vec3 direction = ray.direction();
+    // From strictly inside, the entry lies behind the origin and below any
+    // non-negative min_distance, so only the exit planes need a division
+    const bool inside = min_distance >= 0.0
+        && origin.x() > lo.x() && origin.x() < hi.x()
+        && origin.y() > lo.y() && origin.y() < hi.y()
+        && origin.z() > lo.z() && origin.z() < hi.z();
+
+    double t_enter = -std::numeric_limits<double>::infinity();
+    double t_leave = std::numeric_limits<double>::infinity();
+    int enter_face = -1;
+    int leave_face = -1;
+    for (int axis = 0; axis < 3; ++axis) {
+        const Axis component = static_cast<Axis>(axis);
+        const double along = direction.component(component);
+        const double start = origin.component(component);
+        if (std::fabs(along) < 1e-8) {
+            if (start < lo.component(component) || start > hi.component(component)) {
+                return false;
+            }
+            continue;
+        }
+        const bool forward = along > 0.0;
+        const double t_far = ((forward ? hi : lo).component(component) - start) / along;
+        if (t_far < t_leave) {
+            t_leave = t_far;
+            leave_face = 2 * axis + (forward ? 1 : 0);
+        }
+        if (inside) {
+            continue;
+        }
+        const double t_near = ((forward ? lo : hi).component(component) - start) / along;
+        if (t_near > t_enter) {
+            t_enter = t_near;
+            enter_face = 2 * axis + (forward ? 0 : 1);
+        }
+    }
+    if (t_enter > t_leave) {
+        return false;
+    }
+
+    if (enter_face >= 0 && t_enter >= min_distance && t_enter <= max_distance
+        && (open_faces & (1u << enter_face)) == 0) {
+        distance = t_enter;
+        face = enter_face;
+        return true;
+    }
+    if (leave_face >= 0 && t_leave >= min_distance && t_leave <= max_distance
+        && (open_faces & (1u << leave_face)) == 0) {
+        distance = t_leave;
+        face = leave_face;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Surfaces of a room shell; the front (camera side) stays open.
+ */
+struct RoomMaterials {
+    std::shared_ptr<Material> floor;
+    std::shared_ptr<Material> ceiling;
+    std::shared_ptr<Material> left_wall;
+    std::shared_ptr<Material> right_wall;
+    std::shared_ptr<Material> back_wall;
+};
+
+/**
+ * The floor, ceiling, side walls and back wall of a RoomLayout as one
+ * primitive, open toward the front. Nearly every path hits the room shell,
+ * and one slab test replaces five rectangle tests. Each face has its own
+ * material; normals point into the room.
+ */
+class RoomEnclosure : public Hittable {
+public:
+    RoomEnclosure(const RoomLayout& layout, const RoomMaterials& materials);
+
+    bool intersect(const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override;
+
+    void fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                         HitRecord& record) const override;
+
+    /**
+     * Material of `face` (null for the open front).
+     */
+    const std::shared_ptr<Material>& face_material(int face) const { return face_materials[face]; }
+
+protected:
+    friend class PrimitiveTable;
+
+    Point3 lo;
+    Point3 hi;
+    unsigned open_faces;
+    std::array<std::shared_ptr<Material>, kEnclosureFaces> face_materials;
+};
+
+#endif
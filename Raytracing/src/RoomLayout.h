@@ -0,0 +1,21 @@
+#ifndef ROOM_LAYOUT_H
+#define ROOM_LAYOUT_H
+
+/**
+ * @file RoomLayout.h
+ * @brief Dimensions of the Cornell-box style room.
+ */
+
+/**
+ * @brief Geometric description of the Cornell-box style room.
+ */
+struct RoomLayout {
+    double half_width;       ///< Half the room width along the X axis.
+    double half_depth;       ///< Half the room depth along the Z axis.
+    double floor_y;          ///< Y coordinate of the floor plane.
+    double ceiling_y;        ///< Y coordinate of the ceiling plane.
+    double back_wall_z;      ///< Z coordinate of the back wall.
+    double front_opening_z;  ///< Z coordinate of the open front (camera side).
+};
+
+#endif
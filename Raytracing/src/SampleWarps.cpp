@@ -0,0 +1,38 @@
+#include "SampleWarps.h"
+
+namespace sample_warps {
+
+void concentric_disk(const double* u1, const double* u2, double* x, double* y, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        concentric_disk(u1[i], u2[i], x[i], y[i]);
+    }
+}
+
+void uniform_disk(const double* u1, const double* u2, double* x, double* y, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        uniform_disk(u1[i], u2[i], x[i], y[i]);
+    }
+}
+
+void cosine_hemisphere(const double* u1, const double* u2,
+                       double* x, double* y, double* z, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        cosine_hemisphere(u1[i], u2[i], x[i], y[i], z[i]);
+    }
+}
+
+void uniform_sphere(const double* u1, const double* u2,
+                    double* x, double* y, double* z, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        uniform_sphere(u1[i], u2[i], x[i], y[i], z[i]);
+    }
+}
+
+void uniform_ball(const double* u1, const double* u2, const double* u3,
+                  double* x, double* y, double* z, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        uniform_ball(u1[i], u2[i], u3[i], x[i], y[i], z[i]);
+    }
+}
+
+} // namespace sample_warps
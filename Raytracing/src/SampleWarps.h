@@ -0,0 +1,109 @@
+#ifndef SAMPLE_WARPS_H
+#define SAMPLE_WARPS_H
+
+/**
+ * @file SampleWarps.h
+ * @brief Branch-free mappings from uniform numbers to sampling domains.
+ *
+ * Each warp exists as an inline scalar kernel and as a batched function over
+ * structure-of-arrays inputs. The batched forms simply loop over the scalar
+ * kernels; because the kernels contain no data-dependent branches or loops
+ * (no rejection sampling), the compiler can vectorize those loops, which is
+ * what a wavefront or packet integrator wants.
+ */
+
+#include "FastMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace sample_warps {
+
+constexpr double kPi = 3.14159265358979323846;
+
+/**
+ * Shirley-Chiu concentric map from [0,1)² to the unit disk.
+ * Preserves relative areas and keeps strata compact, unlike the polar map.
+ */
+inline void concentric_disk(double u1, double u2, double& x, double& y) {
+    const double a = 2.0 * u1 - 1.0;
+    const double b = 2.0 * u2 - 1.0;
+    const bool use_a = std::fabs(a) > std::fabs(b);
+    const double radius = use_a ? a : b;
+    // Guard the 0/0 at the origin without a branch; the radius is 0 there anyway
+    const double safe_a = (a == 0.0) ? 1.0 : a;
+    const double safe_b = (b == 0.0) ? 1.0 : b;
+    const double phi = use_a ? (kPi / 4.0) * (b / safe_a)
+                             : (kPi / 2.0) - (kPi / 4.0) * (a / safe_b);
+    double sine, cosine;
+    math_sincos(phi, sine, cosine);
+    x = radius * cosine;
+    y = radius * sine;
+}
+
+/**
+ * Uniform point on the unit disk via the polar map (r = sqrt(u1)).
+ */
+inline void uniform_disk(double u1, double u2, double& x, double& y) {
+    const double radius = math_sqrt(u1);
+    const double phi = 2.0 * kPi * u2;
+    double sine, cosine;
+    math_sincos(phi, sine, cosine);
+    x = radius * cosine;
+    y = radius * sine;
+}
+
+/**
+ * Cosine-weighted direction on the +Z hemisphere (Malley's method on the
+ * concentric disk). pdf = z / pi.
+ */
+inline void cosine_hemisphere(double u1, double u2, double& x, double& y, double& z) {
+    concentric_disk(u1, u2, x, y);
+    z = math_sqrt(std::max(0.0, 1.0 - x * x - y * y));
+}
+
+/**
+ * Uniform direction on the unit sphere. pdf = 1 / (4 pi).
+ */
+inline void uniform_sphere(double u1, double u2, double& x, double& y, double& z) {
+    z = 1.0 - 2.0 * u1;
+    const double radius = math_sqrt(std::max(0.0, 1.0 - z * z));
+    const double phi = 2.0 * kPi * u2;
+    double sine, cosine;
+    math_sincos(phi, sine, cosine);
+    x = radius * cosine;
+    y = radius * sine;
+}
+
+/**
+ * Uniform point inside the unit ball: uniform direction scaled by cbrt(u3).
+ * Replaces rejection sampling of the enclosing cube.
+ */
+inline void uniform_ball(double u1, double u2, double u3, double& x, double& y, double& z) {
+    uniform_sphere(u1, u2, x, y, z);
+    const double radius = std::cbrt(u3);
+    x *= radius;
+    y *= radius;
+    z *= radius;
+}
+
+// ========== Batched Warps ==========
+// Inputs and outputs are separate arrays of length `count`.
+
+void concentric_disk(const double* u1, const double* u2, double* x, double* y, std::size_t count);
+
+void uniform_disk(const double* u1, const double* u2, double* x, double* y, std::size_t count);
+
+void cosine_hemisphere(const double* u1, const double* u2,
+                       double* x, double* y, double* z, std::size_t count);
+
+void uniform_sphere(const double* u1, const double* u2,
+                    double* x, double* y, double* z, std::size_t count);
+
+void uniform_ball(const double* u1, const double* u2, const double* u3,
+                  double* x, double* y, double* z, std::size_t count);
+
+} // namespace sample_warps
+
+#endif
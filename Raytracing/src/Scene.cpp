@@ -11,16 +11,65 @@ RoomLayout default_room_layout() {
     };
 }
 
+void Scene::commit() {
+    dispatch_table.build(objects);
+    light_visibility.reset();
+    accelerator.reset();
+}
+
+void Scene::build_light_visibility(const LightVisibilitySettings& settings) {
+    auto grid = std::make_shared<LightVisibilityGrid>();
+    grid->build(dispatch_table, lights, settings);
+    light_visibility = std::move(grid);
+}
+
+const UniformGrid& Scene::build_uniform_grid(const UniformGridSettings& settings) {
+    auto grid = std::make_shared<UniformGrid>();
+    grid->build(dispatch_table, settings);
+    accelerator = grid;
+    return *grid;
+}
+
+const WideBvh& Scene::build_wide_bvh(const WideBvhSettings& settings) {
+    auto bvh = std::make_shared<WideBvh>();
+    bvh->build(dispatch_table, settings);
+    accelerator = bvh;
+    return *bvh;
+}
+
+std::shared_ptr<const PagedBvh> Scene::build_paged_bvh(const PagedBvhSettings& settings) {
+    auto bvh = std::make_shared<PagedBvh>();
+    if (!PagedBvh::write(dispatch_table, settings.path, settings.page_primitives)
+        || !bvh->open(dispatch_table, settings.path, settings.cache_bytes)) {
+        return nullptr;
+    }
+    accelerator = bvh;
+    return bvh;
+}
+
+bool Scene::intersect(const Ray& ray, double min_distance, double max_distance,
+                      HitCandidate& candidate) const {
+    if (accelerator != nullptr) {
+        return accelerator->intersect(dispatch_table, ray, min_distance, max_distance, candidate);
+    }
+    return dispatch_table.intersect(ray, min_distance, max_distance, candidate);
+}
+
+bool Scene::hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const {
+    if (accelerator != nullptr) {
+        return accelerator->hit(dispatch_table, ray, min_distance, max_distance, record);
+    }
+    return dispatch_table.hit(ray, min_distance, max_distance, record);
+}
+
 Scene create_scene(const RoomLayout& layout, std::vector<Light> lights) {
     Scene scene;
     scene.layout = layout;
 
-    const double half_room_width = layout.half_width;
     const double half_room_depth = layout.half_depth;
     const double floor_y = layout.floor_y;
     const double ceiling_y = layout.ceiling_y;
     const double back_wall_z = layout.back_wall_z;
-    const double front_opening_z = layout.front_opening_z;
     const double room_center_z = back_wall_z + half_room_depth;
 
     auto floor_material = std::make_shared<Matte>(Color(0.45, 0.38, 0.32));
@@ -36,35 +85,13 @@ Scene create_scene(const RoomLayout& layout, std::vector<Light> lights) {
     auto metal_material = std::make_shared<Reflective>(Color(0.8, 0.8, 0.8), 0.15);
     auto art_material = std::make_shared<Matte>(Color(0.25, 0.45, 0.78));
 
-    scene.objects.add(std::make_shared<XZRect>(
-        -half_room_width, half_room_width,
-        back_wall_z, front_opening_z,
-        floor_y, floor_material
-    ));
-
-    scene.objects.add(std::make_shared<XZRect>(
-        -half_room_width, half_room_width,
-        back_wall_z, front_opening_z,
-        ceiling_y, ceiling_material, true
-    ));
-
-    scene.objects.add(std::make_shared<YZRect>(
-        floor_y, ceiling_y,
-        back_wall_z, front_opening_z,
-        -half_room_width, wall_material
-    ));
-
-    scene.objects.add(std::make_shared<YZRect>(
-        floor_y, ceiling_y,
-        back_wall_z, front_opening_z,
-        half_room_width, wall_material, true
-    ));
-
-    scene.objects.add(std::make_shared<XYRect>(
-        -half_room_width, half_room_width,
-        floor_y, ceiling_y,
-        back_wall_z, accent_wall_material
-    ));
+    scene.objects.add(std::make_shared<RoomEnclosure>(layout, RoomMaterials{
+        floor_material,
+        ceiling_material,
+        wall_material,
+        wall_material,
+        accent_wall_material
+    }));
 
     const double art_offset = 0.02;
     scene.objects.add(std::make_shared<XYRect>(
@@ -156,6 +183,7 @@ Scene create_scene(const RoomLayout& layout, std::vector<Light> lights) {
     }
 
     scene.lights = std::move(lights);
+    scene.commit();
 
     return scene;
 }
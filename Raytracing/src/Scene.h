@@ -7,29 +7,25 @@
  */
 
 #include "AxisAlignedRect.h"
+#include "Accelerator.h"
 #include "Box.h"
 #include "HittableList.h"
 #include "Light.h"
+#include "LightVisibilityGrid.h"
 #include "Material.h"
+#include "PagedBvh.h"
+#include "PrimitiveTable.h"
+#include "RoomEnclosure.h"
+#include "RoomLayout.h"
 #include "Sphere.h"
+#include "UniformGrid.h"
 #include "Vec3.h"
+#include "WideBvh.h"
 #include <cstddef>
 #include <memory>
 #include <utility>
 #include <vector>
 
-/**
- * @brief Geometric description of the Cornell-box style room.
- */
-struct RoomLayout {
-    double half_width;       ///< Half the room width along the X axis.
-    double half_depth;       ///< Half the room depth along the Z axis.
-    double floor_y;          ///< Y coordinate of the floor plane.
-    double ceiling_y;        ///< Y coordinate of the ceiling plane.
-    double back_wall_z;      ///< Z coordinate of the back wall.
-    double front_opening_z;  ///< Z coordinate of the open front (camera side).
-};
-
 /**
  * @brief Return the default room layout used by the demo scene.
  *
@@ -39,14 +35,106 @@ RoomLayout default_room_layout();
 
 /**
  * @brief Full scene description with hittable geometry and analytic lights.
+ *
+ * `objects` is the editable, polymorphic description. Rendering goes through
+ * `dispatch_table`, a flattened copy built by commit(); call commit() again
+ * after changing `objects`. `light_visibility` is an optional precomputation
+ * for static geometry and lights (build_light_visibility()); commit() drops
+ * it, as does changing the number of lights. `accelerator` likewise is an
+ * optional spatial index over `dispatch_table` (build_uniform_grid(),
+ * build_wide_bvh() or build_paged_bvh()) that intersect() and hit() use
+ * instead of the linear scan; commit() drops it.
  */
 struct Scene {
     HittableList objects;
     std::vector<Light> lights;
     RoomLayout layout;
+    PrimitiveTable dispatch_table;
+    std::shared_ptr<const LightVisibilityGrid> light_visibility;
+    std::shared_ptr<const Accelerator> accelerator;
 
     std::size_t object_count() const { return objects.objects.size(); }
     std::size_t light_count() const { return lights.size(); }
+
+    /**
+     * @brief Rebuild the render-time structures from `objects`.
+     */
+    void commit();
+
+    /**
+     * @brief Classify shadow visibility per voxel and light (in parallel).
+     *
+     * Shared by every frame and camera until the next commit(). Lights must
+     * not move while the grid is in use.
+     *
+     * @param settings Voxel size and memory cap.
+     */
+    void build_light_visibility(const LightVisibilitySettings& settings = LightVisibilitySettings());
+
+    /**
+     * @brief Bin the committed primitives into a uniform grid for ray queries.
+     *
+     * Results are identical to the linear scan; only the cost changes.
+     *
+     * @param settings Resolution controls.
+     * @return The grid now installed as `accelerator`.
+     */
+    const UniformGrid& build_uniform_grid(const UniformGridSettings& settings = UniformGridSettings());
+
+    /**
+     * @brief Build an 8-wide BVH over the committed primitives for ray queries.
+     *
+     * Results are identical to the linear scan; only the cost changes.
+     *
+     * @param settings Node format and leaf size.
+     * @return The BVH now installed as `accelerator`.
+     */
+    const WideBvh& build_wide_bvh(const WideBvhSettings& settings = WideBvhSettings());
+
+    /**
+     * @brief Write a paged BVH of the committed primitives to disk and trace
+     * rays through it, mapping pages in under a page-cache budget.
+     *
+     * Results are identical to the linear scan; only the cost changes. The
+     * primitives stay resident too, so this saves no memory (see PagedBvh).
+     *
+     * @param settings File path, page size and cache budget.
+     * @return The BVH now installed as `accelerator`, or null (and no
+     *         change) if the file cannot be written or read back.
+     */
+    std::shared_ptr<const PagedBvh> build_paged_bvh(const PagedBvhSettings& settings);
+
+    /**
+     * @brief Grid to consult for shadow rays, or null if none matches the lights.
+     */
+    const LightVisibilityGrid* visibility_grid() const {
+        return light_visibility != nullptr && light_visibility->light_count() == lights.size()
+            ? light_visibility.get()
+            : nullptr;
+    }
+
+    /**
+     * @brief Traversal-only closest-hit query (no surface attributes).
+     *
+     * @param ray Ray to test.
+     * @param min_distance Ignore hits closer than this.
+     * @param max_distance Ignore hits farther than this.
+     * @param candidate Output: closest candidate.
+     * @return true if anything was hit.
+     */
+    bool intersect(const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const;
+
+    /**
+     * @brief Closest-hit query with resolved surface attributes.
+     *
+     * @param ray Ray to test.
+     * @param min_distance Ignore hits closer than this.
+     * @param max_distance Ignore hits farther than this.
+     * @param record Output: surface interaction of the closest hit.
+     * @return true if anything was hit.
+     */
+    bool hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const;
 };
 
 /**
@@ -0,0 +1,84 @@
+#ifndef SHADING_FRAME_H
+#define SHADING_FRAME_H
+
+/**
+ * @file ShadingFrame.h
+ * @brief Orthonormal tangent frame attached to a surface interaction.
+ */
+
+#include "Vec3.h"
+
+#include <cmath>
+
+/**
+ * Right-handed orthonormal basis (tangent, bitangent, normal).
+ *
+ * Local coordinates put the normal on +Z, so for a unit direction `d`
+ * expressed locally, `d.z()` is the cosine to the normal. Materials sample
+ * in this space and convert once with to_world(); the frame is built once
+ * per resolved hit instead of once per sample.
+ */
+struct ShadingFrame {
+    Vec3 tangent;
+    Vec3 bitangent;
+    Vec3 normal;
+
+    /**
+     * Build a frame around a unit normal.
+     *
+     * Branchless construction from Duff et al., "Building an Orthonormal
+     * Basis, Revisited" (JCGT 2017): no normalization, no cross products,
+     * and no axis test, and it is continuous everywhere except n.z == -0.
+     *
+     * @param n Unit-length normal
+     */
+    static ShadingFrame from_normal(const Vec3& n) {
+        const double sign = std::copysign(1.0, n.z_component);
+        const double a = -1.0 / (sign + n.z_component);
+        const double b = n.x_component * n.y_component * a;
+
+        ShadingFrame frame;
+        frame.tangent = Vec3(1.0 + sign * n.x_component * n.x_component * a,
+                             sign * b,
+                             -sign * n.x_component);
+        frame.bitangent = Vec3(b,
+                               sign + n.y_component * n.y_component * a,
+                               -n.y_component);
+        frame.normal = n;
+        return frame;
+    }
+
+    /**
+     * Convert a direction from local (tangent space) to world coordinates.
+     */
+    Vec3 to_world(const Vec3& local) const {
+        return Vec3(
+            tangent.x_component * local.x_component + bitangent.x_component * local.y_component + normal.x_component * local.z_component,
+            tangent.y_component * local.x_component + bitangent.y_component * local.y_component + normal.y_component * local.z_component,
+            tangent.z_component * local.x_component + bitangent.z_component * local.y_component + normal.z_component * local.z_component
+        );
+    }
+
+    /**
+     * Convert a direction from world to local (tangent space) coordinates.
+     */
+    Vec3 to_local(const Vec3& world) const {
+        return Vec3(
+            tangent.x_component * world.x_component + tangent.y_component * world.y_component + tangent.z_component * world.z_component,
+            bitangent.x_component * world.x_component + bitangent.y_component * world.y_component + bitangent.z_component * world.z_component,
+            normal.x_component * world.x_component + normal.y_component * world.y_component + normal.z_component * world.z_component
+        );
+    }
+
+    /**
+     * Cosine between a world direction and the normal, i.e. to_local(world).z()
+     * without computing the tangent components.
+     */
+    double cos_theta(const Vec3& world) const {
+        return normal.x_component * world.x_component
+             + normal.y_component * world.y_component
+             + normal.z_component * world.z_component;
+    }
+};
+
+#endif
@@ -9,8 +9,64 @@
 #include "Hittable.h"
 #include "Material.h"
 #include "Vec3.h"
+#include <cmath>
 #include <memory>
 
+/**
+ * Ray-sphere intersection kernel shared by Sphere and the packed primitive table.
+ *
+ * Math explanation:
+ * A sphere is all points at distance 'radius' from 'center'.
+ * A ray is: point(t) = origin + t * direction
+ * We solve: |point(t) - center|² = radius²
+ *
+ * @param center Sphere center
+ * @param radius Sphere radius
+ * @param ray The ray to test
+ * @param min_distance Ignore hits closer than this
+ * @param max_distance Ignore hits farther than this
+ * @param distance Output: closest valid root
+ * @return true if a root lies inside [min_distance, max_distance]
+ */
+inline bool intersect_sphere(const Point3& center, double radius, const Ray& ray,
+                             double min_distance, double max_distance, double& distance) {
+    // Vector from ray origin to sphere center
+    const Vec3 origin_to_center = ray.origin() - center;
+    
+    // Solve quadratic equation: at² + bt + c = 0
+    // These coefficients come from expanding the sphere equation
+    const double quadratic_a = ray.direction().length_squared();
+    const double quadratic_half_b = dot(origin_to_center, ray.direction());
+    const double quadratic_c = origin_to_center.length_squared() - radius * radius;
+    
+    // Discriminant tells us if there are solutions (intersections)
+    const double discriminant = quadratic_half_b * quadratic_half_b - quadratic_a * quadratic_c;
+    
+    // If discriminant < 0, no intersection (ray misses sphere)
+    if (discriminant < 0) {
+        return false;
+    }
+    
+    const double sqrt_discriminant = std::sqrt(discriminant);
+    
+    // Try the closer intersection point first
+    double root = (-quadratic_half_b - sqrt_discriminant) / quadratic_a;
+    
+    // Check if this intersection is in the valid range
+    if (root < min_distance || max_distance < root) {
+        // Try the farther intersection point
+        root = (-quadratic_half_b + sqrt_discriminant) / quadratic_a;
+        
+        if (root < min_distance || max_distance < root) {
+            // Both intersections are outside the valid range
+            return false;
+        }
+    }
+    
+    distance = root;
+    return true;
+}
+
 /**
  * A sphere in 3D space.
  * Defined by a center point, radius, and material.
@@ -28,57 +84,36 @@ public:
     
     /**
      * Check if a ray hits this sphere.
-     * Uses the mathematical sphere equation to solve for intersection points.
-     * 
-     * Math explanation:
-     * A sphere is all points at distance 'radius' from 'center'.
-     * A ray is: point(t) = origin + t * direction
-     * We solve: |point(t) - center|² = radius²
+     * Uses the mathematical sphere equation to solve for intersection points
+     * (see intersect_sphere).
      */
-    bool hit(const Ray& ray, double min_distance, double max_distance, HitRecord& record) const override {
-        // Vector from ray origin to sphere center
-        Vec3 origin_to_center = ray.origin() - center_position;
-        
-        // Solve quadratic equation: at² + bt + c = 0
-        // These coefficients come from expanding the sphere equation
-        double quadratic_a = ray.direction().length_squared();
-        double quadratic_half_b = dot(origin_to_center, ray.direction());
-        double quadratic_c = origin_to_center.length_squared() - radius * radius;
-        
-        // Discriminant tells us if there are solutions (intersections)
-        double discriminant = quadratic_half_b * quadratic_half_b - quadratic_a * quadratic_c;
-        
-        // If discriminant < 0, no intersection (ray misses sphere)
-        if (discriminant < 0) {
+    bool intersect(const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override {
+        double intersection_distance;
+        if (!intersect_sphere(center_position, radius, ray, min_distance, max_distance,
+                              intersection_distance)) {
             return false;
         }
         
-        double sqrt_discriminant = std::sqrt(discriminant);
-        
-        // Try the closer intersection point first
-        double intersection_distance = (-quadratic_half_b - sqrt_discriminant) / quadratic_a;
-        
-        // Check if this intersection is in the valid range
-        if (intersection_distance < min_distance || max_distance < intersection_distance) {
-            // Try the farther intersection point
-            intersection_distance = (-quadratic_half_b + sqrt_discriminant) / quadratic_a;
-            
-            if (intersection_distance < min_distance || max_distance < intersection_distance) {
-                // Both intersections are outside the valid range
-                return false;
-            }
-        }
+        // We have a valid hit! Only remember where; details come later
+        candidate.distance_from_ray = intersection_distance;
+        candidate.primitive = this;
         
-        // We have a valid hit! Record the details
-        record.distance_from_ray = intersection_distance;
-        record.hit_point = ray.at(intersection_distance);
-        record.material_ptr = material_ptr;  // Store the material pointer
+        return true;
+    }
+
+    /**
+     * Compute hit point, normal and material for the closest hit.
+     */
+    void fill_hit_record(const Ray& ray, const HitCandidate& candidate,
+                         HitRecord& record) const override {
+        record.distance_from_ray = candidate.distance_from_ray;
+        record.hit_point = ray.at(candidate.distance_from_ray);
+        record.material_ptr = material_ptr.get();
         
         // Normal points from center to hit point
         Vec3 outward_normal = (record.hit_point - center_position) / radius;
         record.set_face_normal(ray, outward_normal);
-        
-        return true;
     }
 };
 
@@ -0,0 +1,123 @@
+#include "TileCulling.h"
+
+#include "PrimitiveTable.h"
+
+#include <algorithm>
+#include <array>
+#include <variant>
+
+namespace {
+
+// Slack on the plane distances, in world units; keeps rays that graze a
+// frustum side from losing a primitive to rounding
+constexpr double kTolerance = 1e-7;
+
+struct Bounds {
+    Point3 lo;
+    Point3 hi;
+};
+
+bool primitive_bounds(const PackedPrimitive& primitive, Bounds& bounds) {
+    if (const auto* sphere = std::get_if<SpherePrimitive>(&primitive.shape)) {
+        const Vec3 extent(sphere->radius, sphere->radius, sphere->radius);
+        bounds = Bounds{sphere->center - extent, sphere->center + extent};
+        return true;
+    }
+    if (const auto* rect = std::get_if<RectPrimitive>(&primitive.shape)) {
+        double lo[3];
+        double hi[3];
+        lo[static_cast<int>(rect->orientation.normal_axis)] = rect->k;
+        hi[static_cast<int>(rect->orientation.normal_axis)] = rect->k;
+        lo[static_cast<int>(rect->orientation.tangent_u)] = rect->u0;
+        hi[static_cast<int>(rect->orientation.tangent_u)] = rect->u1;
+        lo[static_cast<int>(rect->orientation.tangent_v)] = rect->v0;
+        hi[static_cast<int>(rect->orientation.tangent_v)] = rect->v1;
+        bounds = Bounds{Point3(lo[0], lo[1], lo[2]), Point3(hi[0], hi[1], hi[2])};
+        return true;
+    }
+    if (const auto* enclosure = std::get_if<EnclosurePrimitive>(&primitive.shape)) {
+        bounds = Bounds{enclosure->lo, enclosure->hi};
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Side planes through the camera; points inside have dot(normal, p - origin) >= 0.
+ */
+struct TileFrustum {
+    Point3 origin;
+    std::array<Vec3, 4> normals;
+
+    bool may_contain(const Bounds& bounds) const {
+        for (const Vec3& normal : normals) {
+            // Box corner farthest along the normal
+            const Point3 corner(normal.x() >= 0.0 ? bounds.hi.x() : bounds.lo.x(),
+                                normal.y() >= 0.0 ? bounds.hi.y() : bounds.lo.y(),
+                                normal.z() >= 0.0 ? bounds.hi.z() : bounds.lo.z());
+            if (dot(normal, corner - origin) < -kTolerance) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+TileFrustum tile_frustum(const Camera& camera, double u0, double u1, double v0, double v1) {
+    const auto direction = [&](double u, double v) {
+        return camera.lower_left_corner + u * camera.horizontal + v * camera.vertical - camera.origin;
+    };
+    // Counter-clockwise around the view direction
+    const std::array<Vec3, 4> corners = {direction(u0, v0), direction(u1, v0), direction(u1, v1), direction(u0, v1)};
+    const Vec3 center = direction(0.5 * (u0 + u1), 0.5 * (v0 + v1));
+
+    TileFrustum frustum;
+    frustum.origin = camera.origin;
+    for (std::size_t side = 0; side < 4; ++side) {
+        Vec3 normal = unit_vector(cross(corners[side], corners[(side + 1) % 4]));
+        if (dot(normal, center) < 0.0) {
+            normal = -normal;
+        }
+        frustum.normals[side] = normal;
+    }
+    return frustum;
+}
+
+} // namespace
+
+void TileCulling::build(const PrimitiveTable& table, const Camera& camera, int width, int height, int tile_size) {
+    edge = std::max(tile_size, 1);
+    tiles_x = (width + edge - 1) / edge;
+    const int tiles_y = (height + edge - 1) / edge;
+
+    const std::vector<PackedPrimitive>& primitives = table.primitives();
+    std::vector<Bounds> bounds(primitives.size());
+    std::vector<bool> bounded(primitives.size());
+    for (std::size_t index = 0; index < primitives.size(); ++index) {
+        bounded[index] = primitive_bounds(primitives[index], bounds[index]);
+    }
+
+    // Camera rays use u = (col + jitter) / (width - 1), jitter in [0, 1)
+    const double u_scale = 1.0 / std::max(width - 1, 1);
+    const double v_scale = 1.0 / std::max(height - 1, 1);
+    tile_start.assign(1, 0);
+    indices.clear();
+    for (int tile_y = 0; tile_y < tiles_y; ++tile_y) {
+        for (int tile_x = 0; tile_x < tiles_x; ++tile_x) {
+            const int col_end = std::min((tile_x + 1) * edge, width);
+            const int row_end = std::min((tile_y + 1) * edge, height);
+            const TileFrustum frustum = tile_frustum(camera, tile_x * edge * u_scale, col_end * u_scale,
+                                                     tile_y * edge * v_scale, row_end * v_scale);
+            for (std::size_t index = 0; index < primitives.size(); ++index) {
+                if (!bounded[index] || frustum.may_contain(bounds[index])) {
+                    indices.push_back(static_cast<std::uint32_t>(index));
+                }
+            }
+            tile_start.push_back(static_cast<std::uint32_t>(indices.size()));
+        }
+    }
+}
+
+double TileCulling::mean_primitives() const {
+    return tile_count() == 0 ? 0.0 : static_cast<double>(indices.size()) / static_cast<double>(tile_count());
+}
@@ -0,0 +1,71 @@
+#ifndef TILE_CULLING_H
+#define TILE_CULLING_H
+
+/**
+ * @file TileCulling.h
+ * @brief Per-tile frustum culling of the primitive table for camera rays.
+ *
+ * Every camera ray of a pixel tile starts at the camera and passes through
+ * the tile's patch of the viewport, so all of them stay inside the pyramid
+ * spanned by the patch corners. Primitives whose bounds lie outside that
+ * pyramid can never be the first hit of those rays. Culling each tile once
+ * per frame leaves a short index list that the tile's camera rays scan
+ * instead of the whole table; bounces still use the full table. The
+ * smaller each tile's slice of the scene (high resolutions, small tiles),
+ * the shorter the lists.
+ */
+
+#include "Camera.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PrimitiveTable;
+
+/**
+ * Index list into a PrimitiveTable (see PrimitiveTable::intersect_subset).
+ */
+struct PrimitiveSubset {
+    const std::uint32_t* indices = nullptr;
+    std::size_t count = 0;
+};
+
+/**
+ * Square pixel tiles with the primitives each tile's frustum can see.
+ */
+class TileCulling {
+public:
+    /**
+     * Cull `table` against every tile of a `width` x `height` image rendered
+     * through `camera` (pixel coordinates as in render_pixel, row 0 at the
+     * bottom). Extension primitives have no known bounds and are always kept;
+     * room enclosures are culled by their box.
+     */
+    void build(const PrimitiveTable& table, const Camera& camera, int width, int height, int tile_size);
+
+    /**
+     * Primitives a camera ray through pixel (`col`, `row`) may hit first.
+     */
+    PrimitiveSubset tile_primitives(int col, int row) const {
+        const std::size_t tile = static_cast<std::size_t>(row / edge) * static_cast<std::size_t>(tiles_x)
+                               + static_cast<std::size_t>(col / edge);
+        return PrimitiveSubset{indices.data() + tile_start[tile], tile_start[tile + 1] - tile_start[tile]};
+    }
+
+    int tile_size() const { return edge; }
+    std::size_t tile_count() const { return tile_start.empty() ? 0 : tile_start.size() - 1; }
+
+    /**
+     * Mean length of the per-tile index lists.
+     */
+    double mean_primitives() const;
+
+private:
+    int edge = 1;
+    int tiles_x = 0;
+    std::vector<std::uint32_t> tile_start;  ///< tile_count() + 1 offsets into indices
+    std::vector<std::uint32_t> indices;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+double TileScheduler::batch_floor() const {
+    double floor = std::numeric_limits<double>::infinity();
+    for (const auto& entry : accounts) {
+        if (entry.second.schedule.priority == JobPriority::Batch && !entry.second.paused) {
+            floor = std::min(floor, entry.second.virtual_time);
+        }
+    }
+    return floor == std::numeric_limits<double>::infinity() ? last_floor : floor;
+}
+
+void TileScheduler::add(std::uint64_t id, const JobSchedule& schedule) {
+    Account account;
+    account.schedule = schedule;
+    if (account.schedule.weight <= 0.0) {
+        account.schedule.weight = 1.0;
+    }
+    if (schedule.priority == JobPriority::Batch) {
+        account.virtual_time = batch_floor();
+    }
+    accounts[id] = account;
+}
+
+void TileScheduler::remove(std::uint64_t id) {
+    const auto position = accounts.find(id);
+    if (position == accounts.end()) {
+        return;
+    }
+    const bool batch = position->second.schedule.priority == JobPriority::Batch;
+    if (batch) {
+        last_floor = std::max(last_floor, batch_floor());
+    }
+    accounts.erase(position);
+}
+
+void TileScheduler::set_paused(std::uint64_t id, bool paused) {
+    const auto position = accounts.find(id);
+    if (position == accounts.end() || position->second.paused == paused) {
+        return;
+    }
+    Account& account = position->second;
+    if (!paused && account.schedule.priority == JobPriority::Batch) {
+        // Still marked paused here, so the floor is over the other active jobs
+        account.virtual_time = std::max(account.virtual_time, batch_floor());
+    }
+    account.paused = paused;
+}
+
+std::uint64_t TileScheduler::pick(const std::vector<std::uint64_t>& runnable) const {
+    // Ids grow with submission order, so `<` on them breaks ties first come first served
+    const auto before = [this](std::uint64_t a, std::uint64_t b) {
+        const Account& left = accounts.at(a);
+        const Account& right = accounts.at(b);
+        if (left.schedule.priority != right.schedule.priority) {
+            return left.schedule.priority == JobPriority::Preview;
+        }
+        if (left.schedule.priority == JobPriority::Preview) {
+            if (left.schedule.deadline != right.schedule.deadline) {
+                return left.schedule.deadline < right.schedule.deadline;
+            }
+        } else if (left.virtual_time != right.virtual_time) {
+            return left.virtual_time < right.virtual_time;
+        }
+        return a < b;
+    };
+    return *std::min_element(runnable.begin(), runnable.end(), before);
+}
+
+void TileScheduler::charge(std::uint64_t id, double worker_ms) {
+    const auto position = accounts.find(id);
+    if (position != accounts.end() && position->second.schedule.priority == JobPriority::Batch) {
+        position->second.virtual_time += worker_ms / position->second.schedule.weight;
+    }
+}
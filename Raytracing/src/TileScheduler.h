@@ -0,0 +1,86 @@
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+/**
+ * @file TileScheduler.h
+ * @brief Picks whose tile a free RenderEngine worker renders next.
+ *
+ * Every time a worker is free the scheduler chooses among the jobs that have
+ * a task to hand out (cache setup or a tile), so a job that becomes more
+ * urgent takes over at the next tile boundary.
+ *
+ * Preview jobs always go first, and among them the earliest deadline wins
+ * (jobs without a deadline come after those with one, in submission order).
+ * Batch jobs share the rest by weight: each batch job has a virtual time,
+ * the worker milliseconds it has been given divided by its weight, and the
+ * job with the smallest virtual time goes next. A batch job arriving late
+ * starts at the smallest virtual time among the active batch jobs, so it gets
+ * its share from then on rather than catching up on the past. A paused job
+ * is not active; on resuming it is re-admitted the same way, at no less than
+ * that floor, so a long pause does not let it take every tile afterwards.
+ *
+ * Previews are expected to be short; a steady stream of them starves batch
+ * work.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/**
+ * Scheduling class of a job.
+ */
+enum class JobPriority {
+    Preview,   ///< Interactive: earliest deadline first, ahead of every batch job
+    Batch      ///< Background: weighted fair share of what previews leave
+};
+
+/**
+ * How a job competes for workers; part of RenderJob.
+ */
+struct JobSchedule {
+    JobPriority priority = JobPriority::Batch;
+    double weight = 1.0;   ///< Batch share relative to the other batch jobs (> 0)
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();  ///< Previews
+};
+
+class TileScheduler {
+public:
+    /**
+     * Start accounting for job `id` (ids grow with submission order).
+     */
+    void add(std::uint64_t id, const JobSchedule& schedule);
+
+    void remove(std::uint64_t id);
+
+    /**
+     * Mark job `id` paused or not; a batch job leaving a pause is clamped to
+     * the floor as on add().
+     */
+    void set_paused(std::uint64_t id, bool paused);
+
+    /**
+     * The job among `runnable` (all added) whose task should run next.
+     */
+    std::uint64_t pick(const std::vector<std::uint64_t>& runnable) const;
+
+    /**
+     * Record `worker_ms` of work done for job `id`.
+     */
+    void charge(std::uint64_t id, double worker_ms);
+
+private:
+    struct Account {
+        JobSchedule schedule;
+        double virtual_time = 0.0;   ///< Batch: worker ms / weight, offset by the arrival floor
+        bool paused = false;         ///< Left out of the floor until resumed
+    };
+
+    double batch_floor() const;
+
+    std::map<std::uint64_t, Account> accounts;
+    double last_floor = 0.0;   ///< Floor when the last batch job left, for arrivals to an idle class
+};
+
+#endif
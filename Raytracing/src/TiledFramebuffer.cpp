@@ -0,0 +1,157 @@
+#include "TiledFramebuffer.h"
+
+#include "Parallel.h"
+#include "PngWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RAYTRACER_TILED_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define RAYTRACER_TILED_MMAP 0
+#endif
+
+namespace {
+
+// Band alignment; a multiple of every common system page size
+constexpr std::uint64_t kBandAlignment = std::uint64_t{1} << 16;
+
+} // namespace
+
+TiledFramebuffer::~TiledFramebuffer() {
+    close();
+}
+
+void TiledFramebuffer::close() {
+#if RAYTRACER_TILED_MMAP
+    if (base != nullptr) {
+        munmap(base, static_cast<std::size_t>(file_bytes()));
+    }
+    if (descriptor >= 0) {
+        ::close(descriptor);
+    }
+#endif
+    base = nullptr;
+    descriptor = -1;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    image_width = image_height = tile_edge = tile_columns = band_count = 0;
+    band_stride = 0;
+}
+
+bool TiledFramebuffer::create(const std::string& path, int width, int height, int tile_size) {
+    close();
+    if (width <= 0 || height <= 0 || tile_size <= 0) {
+        return false;
+    }
+    tile_edge = tile_size;
+    tile_columns = (width + tile_size - 1) / tile_size;
+    band_count = (height + tile_size - 1) / tile_size;
+    const std::uint64_t band_bytes = static_cast<std::uint64_t>(tile_columns) * static_cast<std::uint64_t>(tile_size)
+        * static_cast<std::uint64_t>(tile_size) * 3 * sizeof(float);
+    band_stride = (band_bytes + kBandAlignment - 1) / kBandAlignment * kBandAlignment;
+    image_width = width;
+    image_height = height;
+
+#if RAYTRACER_TILED_MMAP
+    descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0 || ftruncate(descriptor, static_cast<off_t>(file_bytes())) != 0) {
+        close();
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<std::size_t>(file_bytes()), PROT_READ | PROT_WRITE, MAP_SHARED,
+                         descriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+    base = static_cast<float*>(mapping);
+#else
+    static_cast<void>(path);
+    buffer.assign(static_cast<std::size_t>(file_bytes() / sizeof(float)), 0.0f);
+    base = buffer.data();
+#endif
+    return true;
+}
+
+std::size_t TiledFramebuffer::tile_offset(int tile_x, int tile_y) const {
+    const std::size_t tile_values = static_cast<std::size_t>(tile_edge) * static_cast<std::size_t>(tile_edge) * 3;
+    return static_cast<std::size_t>(band_stride / sizeof(float)) * static_cast<std::size_t>(tile_y)
+        + tile_values * static_cast<std::size_t>(tile_x);
+}
+
+float* TiledFramebuffer::tile(int tile_x, int tile_y) {
+    return base + tile_offset(tile_x, tile_y);
+}
+
+const float* TiledFramebuffer::tile(int tile_x, int tile_y) const {
+    return base + tile_offset(tile_x, tile_y);
+}
+
+void TiledFramebuffer::set(int col, int row, const Color& color) {
+    float* pixel = tile(col / tile_edge, row / tile_edge)
+        + (static_cast<std::size_t>(row % tile_edge) * static_cast<std::size_t>(tile_edge)
+           + static_cast<std::size_t>(col % tile_edge)) * 3;
+    pixel[0] = static_cast<float>(color.x());
+    pixel[1] = static_cast<float>(color.y());
+    pixel[2] = static_cast<float>(color.z());
+}
+
+void TiledFramebuffer::read_row(int row, float* out) const {
+    const int tile_y = row / tile_edge;
+    const std::size_t row_in_tile = static_cast<std::size_t>(row % tile_edge) * static_cast<std::size_t>(tile_edge) * 3;
+    for (int tile_x = 0; tile_x < tile_columns; ++tile_x) {
+        const int first_col = tile_x * tile_edge;
+        const int cols = std::min(tile_edge, image_width - first_col);
+        std::memcpy(out + static_cast<std::size_t>(first_col) * 3, tile(tile_x, tile_y) + row_in_tile,
+                    static_cast<std::size_t>(cols) * 3 * sizeof(float));
+    }
+}
+
+void TiledFramebuffer::release_band(int band) const {
+#if RAYTRACER_TILED_MMAP
+    const std::uint64_t offset = band_stride * static_cast<std::uint64_t>(band);
+    void* start = reinterpret_cast<unsigned char*>(base) + offset;
+    const std::size_t length = static_cast<std::size_t>(band_stride);
+    // Write the dirty pages back, unmap them from this process and tell the
+    // kernel it may drop them from the page cache as well
+    msync(start, length, MS_SYNC);
+    madvise(start, length, MADV_DONTNEED);
+#if defined(POSIX_FADV_DONTNEED)
+    posix_fadvise(descriptor, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+#endif
+#else
+    static_cast<void>(band);
+#endif
+}
+
+bool TiledFramebuffer::write_png(const std::string& filename, DitherMode dither) const {
+    png_writer::RowWriter writer;
+    if (base == nullptr || !writer.open(filename, image_width, image_height)) {
+        return false;
+    }
+
+    const std::size_t row_bytes = static_cast<std::size_t>(image_width) * 3;
+    std::vector<unsigned char> band_bytes(row_bytes * static_cast<std::size_t>(tile_edge));
+    for (int band = 0; band < band_count; ++band) {
+        const int first_row = band * tile_edge;
+        const int rows = std::min(tile_edge, image_height - first_row);
+        parallel_for(0, static_cast<std::size_t>(rows), 4, [&](std::size_t first, std::size_t last) {
+            std::vector<float> linear(row_bytes);
+            for (std::size_t index = first; index < last; ++index) {
+                const int row = first_row + static_cast<int>(index);
+                read_row(row, linear.data());
+                quantize_row(linear.data(), image_width, row, dither, band_bytes.data() + index * row_bytes);
+            }
+        });
+        release_band(band);
+        if (!writer.write_rows(band_bytes.data(), rows)) {
+            return false;
+        }
+    }
+    return writer.finish();
+}
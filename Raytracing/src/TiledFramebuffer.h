@@ -0,0 +1,115 @@
+#ifndef TILED_FRAMEBUFFER_H
+#define TILED_FRAMEBUFFER_H
+
+/**
+ * @file TiledFramebuffer.h
+ * @brief Linear float image in a memory-mapped file, stored tile by tile,
+ * for frames larger than memory.
+ *
+ * The image is cut into square tiles of `tile_size` pixels. A band is one
+ * row of tiles; bands follow each other top to bottom, each starting on a
+ * 64 KiB boundary of the file, and inside a band the tiles follow left to
+ * right, each tile_size x tile_size interleaved RGB floats with its rows top
+ * to bottom (tiles on the right and bottom edges are padded to full size).
+ * A tile is therefore one contiguous block, and a band one contiguous range
+ * that can be written back and dropped from memory with release_band().
+ *
+ * Memory use is whatever bands are in use: render_tiled() fills a band,
+ * releases it and moves on, and write_png() reads one band at a time into
+ * PNG rows, so a frame of any size needs about one band of memory (plus
+ * the file on disk). Where POSIX mmap is not available the image lives in
+ * a heap buffer instead and nothing is bounded.
+ */
+
+#include "Quantize.h"
+#include "Vec3.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Controls for rendering into a tiled, file-backed framebuffer.
+ */
+struct TiledOutputSettings {
+    bool enabled = false;               ///< Render through a TiledFramebuffer and encode the PNG band by band
+    std::string path = "render.tiles";  ///< Scratch file for the linear image; removed after the PNG is written
+    int tile_size = 64;                 ///< Tile edge in pixels
+};
+
+class TiledFramebuffer {
+public:
+    TiledFramebuffer() = default;
+    TiledFramebuffer(const TiledFramebuffer&) = delete;
+    TiledFramebuffer& operator=(const TiledFramebuffer&) = delete;
+    ~TiledFramebuffer();
+
+    /**
+     * Create (or truncate) `path` with room for a width x height image and
+     * map it. The file starts sparse and all pixels read as black.
+     *
+     * @return false if the size is not positive or the file cannot be
+     *         created, sized or mapped
+     */
+    bool create(const std::string& path, int width, int height, int tile_size);
+
+    /**
+     * Unmap and close the file, which stays on disk.
+     */
+    void close();
+
+    int width() const { return image_width; }
+    int height() const { return image_height; }
+    int tile_size() const { return tile_edge; }
+    int tiles_x() const { return tile_columns; }
+    int bands() const { return band_count; }
+    std::uint64_t file_bytes() const { return band_stride * static_cast<std::uint64_t>(band_count); }
+
+    /**
+     * First float of tile (tile_x, tile_y): tile_size rows of tile_size
+     * RGB pixels each.
+     */
+    float* tile(int tile_x, int tile_y);
+    const float* tile(int tile_x, int tile_y) const;
+
+    /**
+     * Store a pixel; `row` counts from the top of the image.
+     */
+    void set(int col, int row, const Color& color);
+
+    /**
+     * Copy image row `row` (top is 0) into `out` as width interleaved RGB floats.
+     */
+    void read_row(int row, float* out) const;
+
+    /**
+     * Write band `band` back to the file and drop its pages from memory;
+     * the next access reads it back in.
+     */
+    void release_band(int band) const;
+
+    /**
+     * Encode the image as an 8-bit PNG one band at a time (see
+     * png_writer::RowWriter), releasing each band after it is encoded.
+     * Rows are quantized as quantize_framebuffer() would.
+     *
+     * @return false if the PNG cannot be written
+     */
+    bool write_png(const std::string& filename, DitherMode dither) const;
+
+private:
+    std::size_t tile_offset(int tile_x, int tile_y) const;
+
+    int image_width = 0;
+    int image_height = 0;
+    int tile_edge = 0;
+    int tile_columns = 0;
+    int band_count = 0;
+    std::uint64_t band_stride = 0;   ///< Bytes from one band to the next
+    float* base = nullptr;           ///< Mapped file, or `buffer` without mmap
+    int descriptor = -1;
+    std::vector<float> buffer;
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "UniformGrid.h"
+
+#include "AcceleratorKernels.h"
+#include "PrimitiveTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Primitive bounds grow by this share of the scene size before binning, so
+// rounding in the voxel walk can never skip a voxel that holds the hit
+constexpr double kRelativePadding = 1e-7;
+// Thinnest axis, relative to the widest, used to size voxels of flat scenes
+constexpr double kMinRelativeExtent = 1e-3;
+
+std::atomic<std::uint64_t> next_serial{1};
+
+/**
+ * Last ray that tested each primitive, per thread. A fresh ray id per query
+ * makes clearing unnecessary except when the id wraps or the grid changes.
+ */
+struct Mailbox {
+    std::uint64_t serial = 0;
+    std::uint32_t ray = 0;
+    std::vector<std::uint32_t> stamps;
+};
+
+thread_local Mailbox mailbox;
+
+} // namespace
+
+void UniformGrid::build(const PrimitiveTable& table, const UniformGridSettings& settings) {
+    const std::vector<PackedPrimitive>& entries = table.primitives();
+    primitives = entries.size();
+    serial = next_serial.fetch_add(1, std::memory_order_relaxed);
+    resolution = {{0, 0, 0}};
+    cell_start.clear();
+    indices.clear();
+    unbounded.clear();
+
+    std::vector<std::array<double, 3>> lows;
+    std::vector<std::array<double, 3>> highs;
+    std::vector<std::uint32_t> bounded;
+    lows.reserve(entries.size());
+    highs.reserve(entries.size());
+    bounded.reserve(entries.size());
+    bounds_lo = {{std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(),
+                  std::numeric_limits<double>::infinity()}};
+    bounds_hi = {{-bounds_lo[0], -bounds_lo[1], -bounds_lo[2]}};
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        std::array<double, 3> lo;
+        std::array<double, 3> hi;
+        if (!accelerator_primitive_bounds(entries[index], lo, hi)) {
+            unbounded.push_back(static_cast<std::uint32_t>(index));
+            continue;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            bounds_lo[axis] = std::min(bounds_lo[axis], lo[axis]);
+            bounds_hi[axis] = std::max(bounds_hi[axis], hi[axis]);
+        }
+        lows.push_back(lo);
+        highs.push_back(hi);
+        bounded.push_back(static_cast<std::uint32_t>(index));
+    }
+    if (bounded.empty()) {
+        return;
+    }
+
+    double widest = 0.0;
+    for (int axis = 0; axis < 3; ++axis) {
+        widest = std::max(widest, bounds_hi[axis] - bounds_lo[axis]);
+    }
+    const double padding = kRelativePadding * std::max(widest, 1.0);
+    std::array<double, 3> extent;
+    double volume = 1.0;
+    for (int axis = 0; axis < 3; ++axis) {
+        bounds_lo[axis] -= padding;
+        bounds_hi[axis] += padding;
+        extent[axis] = bounds_hi[axis] - bounds_lo[axis];
+        volume *= std::max(extent[axis], kMinRelativeExtent * std::max(widest, 1.0));
+    }
+
+    // Roughly cubic voxels, cells_per_primitive of them per primitive
+    const double cells_per_unit = std::cbrt(std::max(settings.cells_per_primitive, 1e-3)
+                                            * static_cast<double>(bounded.size()) / volume);
+    const int max_resolution = std::max(settings.max_resolution, 1);
+    for (int axis = 0; axis < 3; ++axis) {
+        resolution[axis] = std::clamp(static_cast<int>(std::lround(extent[axis] * cells_per_unit)), 1,
+                                      max_resolution);
+        cell_extent[axis] = extent[axis] / resolution[axis];
+        inverse_cell[axis] = resolution[axis] / extent[axis];
+    }
+
+    // Voxel range of each padded primitive box
+    const auto cell_range = [&](std::size_t slot, std::array<int, 3>& first, std::array<int, 3>& last) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const double lo = (lows[slot][axis] - padding - bounds_lo[axis]) * inverse_cell[axis];
+            const double hi = (highs[slot][axis] + padding - bounds_lo[axis]) * inverse_cell[axis];
+            first[axis] = std::clamp(static_cast<int>(std::floor(lo)), 0, resolution[axis] - 1);
+            last[axis] = std::clamp(static_cast<int>(std::floor(hi)), 0, resolution[axis] - 1);
+        }
+    };
+    const std::size_t row = static_cast<std::size_t>(resolution[0]);
+    const std::size_t slice = row * static_cast<std::size_t>(resolution[1]);
+
+    // Two linear passes: count per voxel, then fill in table order
+    cell_start.assign(slice * static_cast<std::size_t>(resolution[2]) + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<std::uint32_t> cursor;
+        if (pass == 1) {
+            for (std::size_t cell = 1; cell < cell_start.size(); ++cell) {
+                cell_start[cell] += cell_start[cell - 1];
+            }
+            indices.resize(cell_start.back());
+            cursor.assign(cell_start.begin(), cell_start.end() - 1);
+        }
+        for (std::size_t slot = 0; slot < bounded.size(); ++slot) {
+            std::array<int, 3> first;
+            std::array<int, 3> last;
+            cell_range(slot, first, last);
+            for (int z = first[2]; z <= last[2]; ++z) {
+                for (int y = first[1]; y <= last[1]; ++y) {
+                    for (int x = first[0]; x <= last[0]; ++x) {
+                        const std::size_t cell = static_cast<std::size_t>(z) * slice
+                                               + static_cast<std::size_t>(y) * row + static_cast<std::size_t>(x);
+                        if (pass == 0) {
+                            ++cell_start[cell + 1];
+                        } else {
+                            indices[cursor[cell]++] = bounded[slot];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+double UniformGrid::empty_fraction() const {
+    const std::size_t cells = cell_count();
+    if (cells == 0) {
+        return 0.0;
+    }
+    std::size_t empty_cells = 0;
+    for (std::size_t cell = 0; cell < cells; ++cell) {
+        empty_cells += cell_start[cell] == cell_start[cell + 1] ? 1 : 0;
+    }
+    return static_cast<double>(empty_cells) / static_cast<double>(cells);
+}
+
+bool UniformGrid::intersect(const PrimitiveTable& table, const Ray& ray, double min_distance,
+                            double max_distance, HitCandidate& candidate) const {
+    const PackedPrimitive* entries = table.primitives().data();
+    ClosestHit closest{max_distance, false, &candidate};
+    for (const std::uint32_t index : unbounded) {
+        test_accelerated_primitive(&table, entries[index], index, ray, min_distance, closest);
+    }
+    if (cell_start.empty()) {
+        return closest.found;
+    }
+
+    // Clip the ray to the grid box
+    const double origin[3] = {ray.origin().x(), ray.origin().y(), ray.origin().z()};
+    const double direction[3] = {ray.direction().x(), ray.direction().y(), ray.direction().z()};
+    double inverse_direction[3];
+    double t_enter = min_distance;
+    double t_exit = closest.found ? closest.distance : max_distance;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (direction[axis] == 0.0) {
+            if (origin[axis] < bounds_lo[axis] || origin[axis] > bounds_hi[axis]) {
+                return closest.found;
+            }
+            inverse_direction[axis] = 0.0;
+            continue;
+        }
+        inverse_direction[axis] = 1.0 / direction[axis];
+        double near = (bounds_lo[axis] - origin[axis]) * inverse_direction[axis];
+        double far = (bounds_hi[axis] - origin[axis]) * inverse_direction[axis];
+        if (near > far) {
+            std::swap(near, far);
+        }
+        t_enter = std::max(t_enter, near);
+        t_exit = std::min(t_exit, far);
+    }
+    if (!(t_enter <= t_exit)) {
+        return closest.found;
+    }
+
+    Mailbox& box = mailbox;
+    if (box.serial != serial || box.stamps.size() != primitives) {
+        box.serial = serial;
+        box.ray = 0;
+        box.stamps.assign(primitives, 0);
+    }
+    if (++box.ray == 0) {
+        std::fill(box.stamps.begin(), box.stamps.end(), 0);
+        box.ray = 1;
+    }
+    const std::uint32_t ray_id = box.ray;
+    std::uint32_t* stamps = box.stamps.data();
+
+    // 3D-DDA (Amanatides and Woo) from the voxel holding the entry point
+    int cell[3];
+    int step[3];
+    double next_crossing[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        const double entry = origin[axis] + t_enter * direction[axis];
+        cell[axis] = std::clamp(static_cast<int>(std::floor((entry - bounds_lo[axis]) * inverse_cell[axis])), 0,
+                                resolution[axis] - 1);
+        if (direction[axis] > 0.0) {
+            step[axis] = 1;
+            next_crossing[axis] = (bounds_lo[axis] + (cell[axis] + 1) * cell_extent[axis] - origin[axis])
+                                * inverse_direction[axis];
+        } else if (direction[axis] < 0.0) {
+            step[axis] = -1;
+            next_crossing[axis] = (bounds_lo[axis] + cell[axis] * cell_extent[axis] - origin[axis])
+                                * inverse_direction[axis];
+        } else {
+            step[axis] = 0;
+            next_crossing[axis] = std::numeric_limits<double>::infinity();
+        }
+    }
+
+    const std::size_t row = static_cast<std::size_t>(resolution[0]);
+    const std::size_t slice = row * static_cast<std::size_t>(resolution[1]);
+    for (;;) {
+        const std::size_t voxel = static_cast<std::size_t>(cell[2]) * slice
+                                + static_cast<std::size_t>(cell[1]) * row + static_cast<std::size_t>(cell[0]);
+        for (std::uint32_t slot = cell_start[voxel]; slot < cell_start[voxel + 1]; ++slot) {
+            const std::uint32_t index = indices[slot];
+            if (stamps[index] == ray_id) {
+                continue;
+            }
+            stamps[index] = ray_id;
+            test_accelerated_primitive(&table, entries[index], index, ray, min_distance, closest);
+        }
+
+        const int axis = next_crossing[0] < next_crossing[1]
+            ? (next_crossing[0] < next_crossing[2] ? 0 : 2)
+            : (next_crossing[1] < next_crossing[2] ? 1 : 2);
+        // A hit no farther than the voxel's exit cannot be beaten by later voxels
+        const double limit = closest.found ? std::min(closest.distance, t_exit) : t_exit;
+        if (next_crossing[axis] >= limit) {
+            break;
+        }
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= resolution[axis]) {
+            break;
+        }
+        const int boundary = step[axis] > 0 ? cell[axis] + 1 : cell[axis];
+        next_crossing[axis] = (bounds_lo[axis] + boundary * cell_extent[axis] - origin[axis])
+                            * inverse_direction[axis];
+    }
+    return closest.found;
+}
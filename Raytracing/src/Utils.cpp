@@ -1,15 +1,13 @@
 #include "Utils.h"
 
-#include <cmath>
-#include <random>
+#include "Random.h"
+#include "SampleWarps.h"
+#include "ShadingFrame.h"
 
-namespace {
-    std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    std::mt19937 generator;
-}
+#include <cmath>
 
 double random_double() {
-    return distribution(generator);
+    return thread_uniforms().next();
 }
 
 double random_double(double min, double max) {
@@ -17,34 +15,34 @@ double random_double(double min, double max) {
 }
 
 Vec3 random_in_unit_sphere() {
-    while (true) {
-        const Vec3 point(random_double(-1, 1), random_double(-1, 1), random_double(-1, 1));
-        if (point.length_squared() < 1) {
-            return point;
-        }
-    }
+    // Direct warp instead of rejection sampling: always three uniforms, no loop
+    const double u1 = random_double();
+    const double u2 = random_double();
+    const double u3 = random_double();
+    double x, y, z;
+    sample_warps::uniform_ball(u1, u2, u3, x, y, z);
+    return Vec3(x, y, z);
 }
 
 Vec3 random_unit_vector() {
-    return unit_vector(random_in_unit_sphere());
+    const double u1 = random_double();
+    const double u2 = random_double();
+    double x, y, z;
+    sample_warps::uniform_sphere(u1, u2, x, y, z);
+    return Vec3(x, y, z);
+}
+
+Vec3 random_cosine_direction_local() {
+    // Cosine-weighted point on the +Z hemisphere (concentric disk, lifted)
+    const double u1 = random_double();
+    const double u2 = random_double();
+    double x, y, z;
+    sample_warps::cosine_hemisphere(u1, u2, x, y, z);
+    return Vec3(x, y, z);
 }
 
 Vec3 random_cosine_direction(const Vec3& normal) {
-    // Generate random point on unit disk using polar coordinates
-    const double r = std::sqrt(random_double());
-    const double theta = 2 * M_PI * random_double();
-    const double x = r * std::cos(theta);
-    const double y = r * std::sin(theta);
-    const double z = std::sqrt(1 - r * r);  // Height on hemisphere
-    
-    // Build orthonormal basis around the normal
-    // Find a vector not parallel to normal
-    Vec3 a = (std::fabs(normal.x()) > 0.9) ? Vec3(0, 1, 0) : Vec3(1, 0, 0);
-    Vec3 tangent = unit_vector(cross(normal, a));
-    Vec3 bitangent = cross(normal, tangent);
-    
-    // Transform random point to world space
-    return unit_vector(tangent * x + bitangent * y + normal * z);
+    return ShadingFrame::from_normal(normal).to_world(random_cosine_direction_local());
 }
 
 bool is_near_zero(const Vec3& vector) {
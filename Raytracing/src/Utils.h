@@ -7,12 +7,11 @@
  */
 
 #include "Vec3.h"
-#include <random>
 #include <cmath>
 
 /**
  * Generate a random double in the range [0, 1).
- * Uses a static generator for efficiency.
+ * Draws from the calling thread's batched xoshiro buffer (see Random.h).
  */
 double random_double();
 
@@ -26,7 +25,7 @@ double random_double(double min, double max);
 
 /**
  * Generate a random vector inside a unit sphere.
- * Used for diffuse material scattering.
+ * Used for diffuse material scattering. Warped directly, no rejection loop.
  */
 Vec3 random_in_unit_sphere();
 
@@ -41,11 +40,21 @@ Vec3 random_unit_vector();
  * Uses cosine-weighted distribution for better importance sampling.
  * This significantly reduces noise in diffuse materials.
  * 
+ * Builds a frame on every call; shading code should prefer
+ * random_cosine_direction_local() with the hit's ShadingFrame.
+ *
  * @param normal The surface normal (should be unit length)
  * @return Random direction on the hemisphere, cosine-weighted
  */
 Vec3 random_cosine_direction(const Vec3& normal);
 
+/**
+ * Generate a cosine-weighted direction on the +Z hemisphere of a local
+ * shading frame (see ShadingFrame). The result is unit length and its z
+ * component is the cosine to the normal.
+ */
+Vec3 random_cosine_direction_local();
+
 /**
  * Check if a vector is very close to zero in all dimensions.
  * Used to catch degenerate cases.
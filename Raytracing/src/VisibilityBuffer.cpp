@@ -0,0 +1,230 @@
+#include "VisibilityBuffer.h"
+
+#include "Parallel.h"
+#include "PrimitiveTable.h"
+#include "Sphere.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <variant>
+
+namespace {
+
+constexpr std::size_t kRowGrain = 4;
+// Generalized golden ratio steps of the R2 sequence (Roberts, 2018)
+constexpr double kLatticeStepX = 0.7548776662466927;
+constexpr double kLatticeStepY = 0.5698402909980532;
+
+double hash_to_unit(std::uint64_t value) {
+    // splitmix64 finalizer
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    return static_cast<double>(value >> 11) * 0x1.0p-53;
+}
+
+/**
+ * Pixel rectangle that may hold subsamples covered by one primitive.
+ */
+struct Footprint {
+    int col_min;
+    int col_max;
+    int row_min;
+    int row_max;
+};
+
+bool bounding_corners(const PackedPrimitive& primitive, std::array<Point3, 8>& corners) {
+    Point3 lo;
+    Point3 hi;
+    if (const auto* sphere = std::get_if<SpherePrimitive>(&primitive.shape)) {
+        const Vec3 extent(sphere->radius, sphere->radius, sphere->radius);
+        lo = sphere->center - extent;
+        hi = sphere->center + extent;
+    } else if (const auto* rect = std::get_if<RectPrimitive>(&primitive.shape)) {
+        double low[3];
+        double high[3];
+        low[static_cast<int>(rect->orientation.normal_axis)] = rect->k;
+        high[static_cast<int>(rect->orientation.normal_axis)] = rect->k;
+        low[static_cast<int>(rect->orientation.tangent_u)] = rect->u0;
+        high[static_cast<int>(rect->orientation.tangent_u)] = rect->u1;
+        low[static_cast<int>(rect->orientation.tangent_v)] = rect->v0;
+        high[static_cast<int>(rect->orientation.tangent_v)] = rect->v1;
+        lo = Point3(low[0], low[1], low[2]);
+        hi = Point3(high[0], high[1], high[2]);
+    } else if (const auto* enclosure = std::get_if<EnclosurePrimitive>(&primitive.shape)) {
+        lo = enclosure->lo;
+        hi = enclosure->hi;
+    } else {
+        return false;
+    }
+    for (int corner = 0; corner < 8; ++corner) {
+        corners[corner] = Point3((corner & 1) ? hi.x() : lo.x(), (corner & 2) ? hi.y() : lo.y(),
+                                 (corner & 4) ? hi.z() : lo.z());
+    }
+    return true;
+}
+
+/**
+ * Project the primitive's bounding box through the pinhole onto the
+ * viewport (horizontal and vertical are orthogonal to the view axis, as
+ * Camera builds them). Boxes reaching behind the camera, and extensions,
+ * cover the whole image.
+ */
+Footprint footprint(const PackedPrimitive& primitive, const Camera& camera, int width, int height) {
+    const Footprint everything{0, width - 1, 0, height - 1};
+    std::array<Point3, 8> corners;
+    if (!bounding_corners(primitive, corners)) {
+        return everything;
+    }
+
+    const Vec3 corner_offset = camera.lower_left_corner - camera.origin;
+    const Vec3 forward = corner_offset + 0.5 * camera.horizontal + 0.5 * camera.vertical;
+    const double forward_squared = forward.length_squared();
+    const double horizontal_squared = camera.horizontal.length_squared();
+    const double vertical_squared = camera.vertical.length_squared();
+
+    double u_min = 1e300;
+    double u_max = -1e300;
+    double v_min = 1e300;
+    double v_max = -1e300;
+    for (const Point3& corner : corners) {
+        const Vec3 offset = corner - camera.origin;
+        const double along = dot(offset, forward);
+        if (along <= 1e-9 * forward_squared) {
+            return everything;
+        }
+        const Vec3 on_viewport = (forward_squared / along) * offset - corner_offset;
+        const double u = dot(on_viewport, camera.horizontal) / horizontal_squared;
+        const double v = dot(on_viewport, camera.vertical) / vertical_squared;
+        u_min = std::min(u_min, u);
+        u_max = std::max(u_max, u);
+        v_min = std::min(v_min, v);
+        v_max = std::max(v_max, v);
+    }
+
+    // Sample u = (col + offset) / (width - 1) with offset in [0, 1); one pixel of slack for rounding
+    const double u_scale = std::max(width - 1, 1);
+    const double v_scale = std::max(height - 1, 1);
+    const auto clamp_index = [](double value, int limit) {
+        return static_cast<int>(std::clamp(value, -1.0, static_cast<double>(limit)));
+    };
+    return Footprint{
+        std::max(clamp_index(std::floor(u_min * u_scale) - 1.0, width), 0),
+        std::min(clamp_index(std::floor(u_max * u_scale) + 1.0, width), width - 1),
+        std::max(clamp_index(std::floor(v_min * v_scale) - 1.0, height), 0),
+        std::min(clamp_index(std::floor(v_max * v_scale) + 1.0, height), height - 1)
+    };
+}
+
+/**
+ * Depth test of one fragment: the same inline kernels the table scan is
+ * built from (no FMA contraction, so every ISA variant agrees with them).
+ */
+bool intersect_fragment(const PackedPrimitive& primitive, const Ray& ray, double min_distance,
+                        double max_distance, double& depth) {
+    switch (primitive_kind(primitive.shape)) {
+    case PrimitiveKind::Sphere: {
+        const auto& sphere = *std::get_if<SpherePrimitive>(&primitive.shape);
+        return intersect_sphere(sphere.center, sphere.radius, ray, min_distance, max_distance, depth);
+    }
+    case PrimitiveKind::Rect: {
+        const auto& rect = *std::get_if<RectPrimitive>(&primitive.shape);
+        double u_coord = 0.0;
+        double v_coord = 0.0;
+        return intersect_axis_aligned_rect(rect.orientation, rect.u0, rect.u1, rect.v0, rect.v1, rect.k,
+                                           ray, min_distance, max_distance, depth, u_coord, v_coord);
+    }
+    case PrimitiveKind::Enclosure: {
+        const auto& enclosure = *std::get_if<EnclosurePrimitive>(&primitive.shape);
+        int face = 0;
+        return intersect_room_enclosure(enclosure.lo, enclosure.hi, enclosure.open_faces, ray, min_distance,
+                                        max_distance, depth, face);
+    }
+    case PrimitiveKind::Extension: {
+        HitCandidate candidate;
+        if (!std::get_if<ExtensionPrimitive>(&primitive.shape)->object->intersect(ray, min_distance, max_distance,
+                                                                                 candidate)) {
+            return false;
+        }
+        depth = candidate.distance_from_ray;
+        return true;
+    }
+    }
+    return false;
+}
+
+} // namespace
+
+Ray VisibilityBuffer::camera_ray(int col, int row, int subsample) const {
+    const std::uint64_t pixel = static_cast<std::uint64_t>(row) * static_cast<std::uint64_t>(image_width)
+                              + static_cast<std::uint64_t>(col);
+    const double step = static_cast<double>(subsample + 1);
+    const double offset_x = hash_to_unit(2 * pixel) + step * kLatticeStepX;
+    const double offset_y = hash_to_unit(2 * pixel + 1) + step * kLatticeStepY;
+    const double horizontal_coord = (col + (offset_x - std::floor(offset_x))) / (image_width - 1);
+    const double vertical_coord = (row + (offset_y - std::floor(offset_y))) / (image_height - 1);
+    return Ray(view.origin, view.lower_left_corner + horizontal_coord * view.horizontal
+                                + vertical_coord * view.vertical - view.origin);
+}
+
+void VisibilityBuffer::build(const PrimitiveTable& table, const Camera& camera, int width, int height,
+                             int subsamples, double min_distance, double max_distance) {
+    view = camera;
+    image_width = width;
+    image_height = height;
+    per_pixel = std::max(subsamples, 1);
+    samples.assign(static_cast<std::size_t>(width) * static_cast<std::size_t>(height)
+                       * static_cast<std::size_t>(per_pixel),
+                   VisibilitySample{kNoPrimitive, max_distance});
+
+    const std::size_t primitive_count = table.primitive_count();
+    std::vector<Footprint> footprints(primitive_count);
+    for (std::size_t index = 0; index < primitive_count; ++index) {
+        footprints[index] = footprint(table.primitives()[index], camera, width, height);
+    }
+
+    // Bands of rows are independent; inside a band primitives go in table
+    // order, matching the tie rule of the full scan
+    std::atomic<std::size_t> fragment_total{0};
+    parallel_for(0, static_cast<std::size_t>(height), kRowGrain, [&](std::size_t first, std::size_t last) {
+        // Camera rays of the band, generated once instead of once per covering primitive
+        const std::size_t band_stride = static_cast<std::size_t>(width) * static_cast<std::size_t>(per_pixel);
+        std::vector<Ray> rays;
+        rays.reserve((last - first) * band_stride);
+        for (std::size_t row = first; row < last; ++row) {
+            for (int col = 0; col < width; ++col) {
+                for (int subsample = 0; subsample < per_pixel; ++subsample) {
+                    rays.push_back(camera_ray(col, static_cast<int>(row), subsample));
+                }
+            }
+        }
+
+        std::size_t band_fragments = 0;
+        for (std::size_t index = 0; index < primitive_count; ++index) {
+            const Footprint& area = footprints[index];
+            const PackedPrimitive& primitive = table.primitives()[index];
+            const int row_begin = std::max(area.row_min, static_cast<int>(first));
+            const int row_end = std::min(area.row_max + 1, static_cast<int>(last));
+            for (int row = row_begin; row < row_end; ++row) {
+                for (int col = area.col_min; col <= area.col_max; ++col) {
+                    const std::size_t offset = static_cast<std::size_t>(col) * static_cast<std::size_t>(per_pixel);
+                    VisibilitySample* pixel = &samples[static_cast<std::size_t>(row) * band_stride + offset];
+                    const Ray* pixel_rays = &rays[(static_cast<std::size_t>(row) - first) * band_stride + offset];
+                    for (int subsample = 0; subsample < per_pixel; ++subsample) {
+                        double depth = 0.0;
+                        if (intersect_fragment(primitive, pixel_rays[subsample], min_distance, pixel[subsample].depth,
+                                               depth)) {
+                            pixel[subsample] = VisibilitySample{static_cast<std::uint32_t>(index), depth};
+                        }
+                    }
+                    band_fragments += static_cast<std::size_t>(per_pixel);
+                }
+            }
+        }
+        fragment_total.fetch_add(band_fragments, std::memory_order_relaxed);
+    });
+    fragments = fragment_total.load();
+}
@@ -0,0 +1,95 @@
+#ifndef VISIBILITY_BUFFER_H
+#define VISIBILITY_BUFFER_H
+
+/**
+ * @file VisibilityBuffer.h
+ * @brief Rasterized first-hit visibility (primitive id + depth) per subsample.
+ *
+ * Camera rays all leave the pinhole, so their first hits can be found in
+ * object order: each primitive's bounds are projected to the screen and
+ * only the subsamples inside that footprint are tested against it, with a
+ * depth test against the nearest primitive so far. The per-fragment test is
+ * the ray kernel for that one primitive (exact coverage and depth for
+ * rectangles and spheres, no tessellation), and primitives are visited in
+ * table order with the scan's tie rule, so every entry names exactly the
+ * primitive a full ray scan would return. The integrator then resolves the
+ * hit against that single primitive and continues the path from there.
+ *
+ * Subsample positions are fixed per frame: a rank-2 lattice (R2 sequence)
+ * with a per-pixel hashed offset. Render sample s of a pixel uses
+ * subsample s mod subsample_count(), so antialiasing sees
+ * subsample_count() distinct positions per pixel.
+ */
+
+#include "Camera.h"
+#include "Ray.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PrimitiveTable;
+
+/**
+ * Rasterizer switch and buffer size.
+ */
+struct RasterSettings {
+    bool enabled = false;  ///< Rasterize camera-ray visibility instead of tracing it
+    int subsamples = 16;   ///< Stored first hits per pixel (positions cycled by render samples)
+};
+
+/**
+ * First hit of one subsample.
+ */
+struct VisibilitySample {
+    std::uint32_t primitive;  ///< Table index, kNoPrimitive for the sky
+    double depth;             ///< Ray parameter of the hit
+};
+
+/**
+ * width x height x subsamples first hits for one camera and primitive table.
+ */
+class VisibilityBuffer {
+public:
+    static constexpr std::uint32_t kNoPrimitive = 0xFFFFFFFFu;
+
+    /**
+     * Rasterize `table` for `camera` (parallel over row bands). Pixel
+     * coordinates follow render_pixel: row 0 at the bottom.
+     *
+     * @param min_distance Ignore hits closer than this (the integrator's epsilon)
+     * @param max_distance Ignore hits farther than this
+     */
+    void build(const PrimitiveTable& table, const Camera& camera, int width, int height, int subsamples,
+               double min_distance, double max_distance);
+
+    /**
+     * Camera ray through subsample `subsample` of pixel (`col`, `row`);
+     * bit-identical to the ray the buffer was rasterized with.
+     */
+    Ray camera_ray(int col, int row, int subsample) const;
+
+    const VisibilitySample& at(int col, int row, int subsample) const {
+        return samples[(static_cast<std::size_t>(row) * static_cast<std::size_t>(image_width)
+                        + static_cast<std::size_t>(col)) * static_cast<std::size_t>(per_pixel)
+                       + static_cast<std::size_t>(subsample)];
+    }
+
+    int subsample_count() const { return per_pixel; }
+
+    /**
+     * Fragment tests performed by the last build (subsamples inside
+     * projected footprints, summed over primitives).
+     */
+    std::size_t fragment_count() const { return fragments; }
+
+private:
+    Camera view = Camera(16.0 / 9.0);
+    int image_width = 0;
+    int image_height = 0;
+    int per_pixel = 1;
+    std::size_t fragments = 0;
+    std::vector<VisibilitySample> samples;
+};
+
+#endif
@@ -0,0 +1,878 @@
+#include "WideBvh.h"
+
+#include "AcceleratorKernels.h"
+#include "CpuFeatures.h"
+#include "PrimitiveTable.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+static_assert(sizeof(BvhFullNode) == 256, "full BVH nodes should fill four cache lines");
+static_assert(sizeof(BvhQuantizedNode) == 80, "quantized BVH nodes should stay at 80 bytes");
+
+namespace {
+
+// Primitive bounds grow by this share of the scene size before they are
+// stored, far more than single-precision rounding in the slab test can move
+// a box plane, so a box that holds a hit is never culled
+constexpr double kRelativePadding = 1e-5;
+// Binary tree depth past which splits fall back to the median. Median splits
+// halve the primitive count, so no path is longer than this plus 32, and
+// neither is a wide path; each wide level adds at most 7 stack entries
+constexpr int kMaxBinaryDepth = 48;
+constexpr int kStackSize = (kBvhWidth - 1) * (kMaxBinaryDepth + 32) + 1;
+// Float conversion moves a distance by at most half an ulp (2^-24 relative);
+// scaling by this afterwards rounds the far end of the slab test up
+constexpr float kRoundUp = 1.0f + 0x1p-22f;
+constexpr double kMaxFloatDistance = 1e37;
+// Stand-in for 1 / 0 that keeps every slab distance finite under fast math
+constexpr float kMaxInverseDirection = 1e20f;
+constexpr std::size_t kCacheLine = 64;
+// Set in a leaf's stack entry once the interleaved traversal has prefetched
+// its primitives; leaf counts fit in the bits below
+constexpr std::uint32_t kLeafPrefetched = 0x100;
+constexpr std::uint32_t kLeafCountMask = 0xFF;
+
+using Bounds = std::array<double, 3>;
+
+struct BuildPrimitive {
+    Bounds lo;
+    Bounds hi;
+    Bounds centroid;
+    std::uint32_t index;
+};
+
+struct BinaryNode {
+    Bounds lo;
+    Bounds hi;
+    int left = -1;   ///< -1 for leaves
+    int right = -1;
+    std::size_t first = 0;
+    std::size_t count = 0;
+};
+
+void grow(Bounds& lo, Bounds& hi, const Bounds& other_lo, const Bounds& other_hi) {
+    for (int axis = 0; axis < 3; ++axis) {
+        lo[axis] = std::min(lo[axis], other_lo[axis]);
+        hi[axis] = std::max(hi[axis], other_hi[axis]);
+    }
+}
+
+void reset(Bounds& lo, Bounds& hi) {
+    lo.fill(std::numeric_limits<double>::max());
+    hi.fill(-std::numeric_limits<double>::max());
+}
+
+double half_area(const Bounds& lo, const Bounds& hi) {
+    const double x = std::max(hi[0] - lo[0], 0.0);
+    const double y = std::max(hi[1] - lo[1], 0.0);
+    const double z = std::max(hi[2] - lo[2], 0.0);
+    return x * y + y * z + z * x;
+}
+
+/**
+ * Top-down binned-SAH build of the binary tree that gets collapsed.
+ */
+class BinaryBuilder {
+public:
+    BinaryBuilder(std::vector<BuildPrimitive>& primitives, const WideBvhSettings& settings)
+        : primitives(primitives)
+        , max_leaf(std::clamp(settings.max_leaf_size, 1, kBvhInnerSlot - 1))
+        , bins(std::clamp(settings.sah_bins, 2, 64))
+    {}
+
+    std::vector<BinaryNode> nodes;
+
+    int build(std::size_t first, std::size_t count, int depth) {
+        const int index = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+        BinaryNode node;
+        node.first = first;
+        node.count = count;
+        reset(node.lo, node.hi);
+        Bounds centroid_lo;
+        Bounds centroid_hi;
+        reset(centroid_lo, centroid_hi);
+        for (std::size_t slot = first; slot < first + count; ++slot) {
+            grow(node.lo, node.hi, primitives[slot].lo, primitives[slot].hi);
+            grow(centroid_lo, centroid_hi, primitives[slot].centroid, primitives[slot].centroid);
+        }
+        if (count > static_cast<std::size_t>(max_leaf)) {
+            const std::size_t left_count = split(first, count, centroid_lo, centroid_hi, depth);
+            node.left = build(first, left_count, depth + 1);
+            node.right = build(first + left_count, count - left_count, depth + 1);
+        }
+        nodes[static_cast<std::size_t>(index)] = node;
+        return index;
+    }
+
+private:
+    std::vector<BuildPrimitive>& primitives;
+    int max_leaf;
+    int bins;
+
+    /**
+     * Partition [first, first + count) and return the size of the left half
+     * (always strictly between 0 and count).
+     */
+    std::size_t split(std::size_t first, std::size_t count, const Bounds& centroid_lo, const Bounds& centroid_hi,
+                      int depth) {
+        const auto begin = primitives.begin() + static_cast<std::ptrdiff_t>(first);
+        const auto end = begin + static_cast<std::ptrdiff_t>(count);
+        int widest = 0;
+        for (int axis = 1; axis < 3; ++axis) {
+            if (centroid_hi[axis] - centroid_lo[axis] > centroid_hi[widest] - centroid_lo[widest]) {
+                widest = axis;
+            }
+        }
+        const auto median = [&](int axis) {
+            const std::size_t half = count / 2;
+            std::nth_element(begin, begin + static_cast<std::ptrdiff_t>(half), end,
+                             [axis](const BuildPrimitive& a, const BuildPrimitive& b) {
+                                 return a.centroid[axis] < b.centroid[axis]
+                                     || (a.centroid[axis] == b.centroid[axis] && a.index < b.index);
+                             });
+            return half;
+        };
+        if (depth >= kMaxBinaryDepth || !(centroid_hi[widest] > centroid_lo[widest])) {
+            return median(widest);
+        }
+
+        // Cheapest plane over every axis: left area * left count + right area * right count
+        double best_cost = std::numeric_limits<double>::max();
+        int best_axis = -1;
+        int best_plane = 0;
+        std::vector<Bounds> bin_lo(static_cast<std::size_t>(bins));
+        std::vector<Bounds> bin_hi(static_cast<std::size_t>(bins));
+        std::vector<std::size_t> bin_count(static_cast<std::size_t>(bins));
+        std::vector<double> right_cost(static_cast<std::size_t>(bins));
+        for (int axis = 0; axis < 3; ++axis) {
+            const double extent = centroid_hi[axis] - centroid_lo[axis];
+            if (!(extent > 0.0)) {
+                continue;
+            }
+            const double scale = bins / extent;
+            for (int bin = 0; bin < bins; ++bin) {
+                reset(bin_lo[static_cast<std::size_t>(bin)], bin_hi[static_cast<std::size_t>(bin)]);
+                bin_count[static_cast<std::size_t>(bin)] = 0;
+            }
+            for (auto it = begin; it != end; ++it) {
+                const std::size_t bin = bin_of(it->centroid[axis], centroid_lo[axis], scale);
+                grow(bin_lo[bin], bin_hi[bin], it->lo, it->hi);
+                ++bin_count[bin];
+            }
+            Bounds lo;
+            Bounds hi;
+            reset(lo, hi);
+            std::size_t right = 0;
+            for (int bin = bins - 1; bin > 0; --bin) {
+                grow(lo, hi, bin_lo[static_cast<std::size_t>(bin)], bin_hi[static_cast<std::size_t>(bin)]);
+                right += bin_count[static_cast<std::size_t>(bin)];
+                right_cost[static_cast<std::size_t>(bin)] = half_area(lo, hi) * static_cast<double>(right);
+            }
+            reset(lo, hi);
+            std::size_t left = 0;
+            for (int plane = 1; plane < bins; ++plane) {
+                grow(lo, hi, bin_lo[static_cast<std::size_t>(plane - 1)],
+                     bin_hi[static_cast<std::size_t>(plane - 1)]);
+                left += bin_count[static_cast<std::size_t>(plane - 1)];
+                if (left == 0 || left == count) {
+                    continue;
+                }
+                const double cost = half_area(lo, hi) * static_cast<double>(left)
+                                  + right_cost[static_cast<std::size_t>(plane)];
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_plane = plane;
+                }
+            }
+        }
+        if (best_axis < 0) {
+            return median(widest);
+        }
+        const double scale = bins / (centroid_hi[best_axis] - centroid_lo[best_axis]);
+        const auto middle = std::partition(begin, end, [&](const BuildPrimitive& primitive) {
+            return bin_of(primitive.centroid[best_axis], centroid_lo[best_axis], scale)
+                 < static_cast<std::size_t>(best_plane);
+        });
+        return static_cast<std::size_t>(middle - begin);
+    }
+
+    std::size_t bin_of(double centroid, double lo, double scale) const {
+        const int bin = static_cast<int>((centroid - lo) * scale);
+        return static_cast<std::size_t>(std::clamp(bin, 0, bins - 1));
+    }
+};
+
+/**
+ * Children of one wide node: binary nodes, expanded from the binary tree by
+ * repeatedly opening the inner child with the largest surface area.
+ */
+std::vector<int> wide_children(const std::vector<BinaryNode>& binary, int root) {
+    if (binary[static_cast<std::size_t>(root)].left < 0) {
+        return {root};
+    }
+    std::vector<int> children = {binary[static_cast<std::size_t>(root)].left,
+                                 binary[static_cast<std::size_t>(root)].right};
+    while (children.size() < static_cast<std::size_t>(kBvhWidth)) {
+        int largest = -1;
+        double largest_area = -1.0;
+        for (std::size_t slot = 0; slot < children.size(); ++slot) {
+            const BinaryNode& child = binary[static_cast<std::size_t>(children[slot])];
+            const double area = half_area(child.lo, child.hi);
+            if (child.left >= 0 && area > largest_area) {
+                largest = static_cast<int>(slot);
+                largest_area = area;
+            }
+        }
+        if (largest < 0) {
+            break;
+        }
+        const BinaryNode& opened = binary[static_cast<std::size_t>(children[static_cast<std::size_t>(largest)])];
+        children[static_cast<std::size_t>(largest)] = opened.left;
+        children.push_back(opened.right);
+    }
+    return children;
+}
+
+float round_down(double value) {
+    float result = static_cast<float>(value);
+    if (static_cast<double>(result) > value) {
+        result = std::nextafter(result, -std::numeric_limits<float>::max());
+    }
+    return result;
+}
+
+float round_up(double value) {
+    float result = static_cast<float>(value);
+    if (static_cast<double>(result) < value) {
+        result = std::nextafter(result, std::numeric_limits<float>::max());
+    }
+    return result;
+}
+
+/**
+ * Smallest power-of-two exponent whose 255 steps cover `extent`.
+ */
+int quantization_exponent(double extent) {
+    int exponent = 0;
+    std::frexp(std::max(extent / 255.0, 1e-30), &exponent);
+    exponent = std::max(exponent, -100);
+    while (std::ldexp(255.0, exponent - 1) >= extent && exponent > -100) {
+        --exponent;
+    }
+    while (std::ldexp(255.0, exponent) < extent) {
+        ++exponent;
+    }
+    return exponent;
+}
+
+/**
+ * `2^exponent` as a float, built from its bits (exponent within float range).
+ */
+RAYTRACER_FORCE_INLINE float power_of_two(int exponent) {
+    const std::uint32_t bits = static_cast<std::uint32_t>(exponent + 127) << 23;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * Ray in single precision.
+ */
+struct FloatRay {
+    float origin[3];
+    float inverse[3];
+    float t_min;
+};
+
+struct StackEntry {
+    float distance;      ///< Where the ray enters the child box
+    std::uint32_t link;  ///< Node index, or first primitive_order entry for leaves
+    std::uint32_t count; ///< Leaf primitive count, 0 for inner nodes
+};
+
+/**
+ * Slab test of eight boxes. Plane `p` of box `lane` along `axis` lies at ray
+ * distance `planes[p][lane] * scale[axis] + offset[axis]`; rows 0-2 are the
+ * minima, 3-5 the maxima. One loop over the lanes with the three axes spelled
+ * out is the shape the compiler turns into full-width vector code.
+ */
+RAYTRACER_FORCE_INLINE void slab_lanes(const float (*planes)[kBvhWidth], const float* scale, const float* offset,
+                                       float t_min, float t_max, float* near, float* far) {
+    for (int lane = 0; lane < kBvhWidth; ++lane) {
+        const float x0 = planes[0][lane] * scale[0] + offset[0];
+        const float x1 = planes[3][lane] * scale[0] + offset[0];
+        const float y0 = planes[1][lane] * scale[1] + offset[1];
+        const float y1 = planes[4][lane] * scale[1] + offset[1];
+        const float z0 = planes[2][lane] * scale[2] + offset[2];
+        const float z1 = planes[5][lane] * scale[2] + offset[2];
+        near[lane] = std::max(std::max(t_min, std::min(x0, x1)), std::max(std::min(y0, y1), std::min(z0, z1)));
+        far[lane] = std::min(std::min(t_max, std::max(x0, x1)), std::min(std::max(y0, y1), std::max(z0, z1)));
+    }
+}
+
+RAYTRACER_FORCE_INLINE void child_slabs(const BvhFullNode& node, const FloatRay& ray, float t_max,
+                                        float* near, float* far) {
+    // (plane - o) / d as plane / d - o / d; the padding covers the rounding
+    const float offset[3] = {-ray.origin[0] * ray.inverse[0], -ray.origin[1] * ray.inverse[1],
+                             -ray.origin[2] * ray.inverse[2]};
+    slab_lanes(node.bounds, ray.inverse, offset, ray.t_min, t_max, near, far);
+}
+
+RAYTRACER_FORCE_INLINE void child_slabs(const BvhQuantizedNode& node, const FloatRay& ray, float t_max,
+                                        float* near, float* far) {
+    // Widen the 48 bounds 16 at a time (whole vectors at every ISA level, via
+    // int32), then decode inside the slab test: (origin + q * step - o) / d
+    alignas(32) float steps[6][kBvhWidth];
+    for (int pair = 0; pair < 3; ++pair) {
+        const std::uint8_t* bounds = node.bounds[2 * pair];
+        float* widened = steps[2 * pair];
+        for (int bound = 0; bound < 2 * kBvhWidth; ++bound) {
+            widened[bound] = static_cast<float>(static_cast<std::int32_t>(bounds[bound]));
+        }
+    }
+    float scale[3];
+    float offset[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        scale[axis] = power_of_two(node.exponent[axis]) * ray.inverse[axis];
+        offset[axis] = (node.origin[axis] - ray.origin[axis]) * ray.inverse[axis];
+    }
+    slab_lanes(steps, scale, offset, ray.t_min, t_max, near, far);
+}
+
+RAYTRACER_FORCE_INLINE std::uint32_t child_link(const BvhFullNode& node, int slot, std::uint32_t, std::uint32_t) {
+    return node.link[slot];
+}
+
+RAYTRACER_FORCE_INLINE std::uint32_t child_link(const BvhQuantizedNode& node, int slot, std::uint32_t inner_rank,
+                                                std::uint32_t leaf_offset) {
+    return node.meta[slot] == kBvhInnerSlot ? node.child_base + inner_rank : node.primitive_base + leaf_offset;
+}
+
+RAYTRACER_FORCE_INLINE FloatRay make_float_ray(const Ray& ray, double min_distance) {
+    FloatRay float_ray;
+    const double origin[3] = {ray.origin().x(), ray.origin().y(), ray.origin().z()};
+    const double direction[3] = {ray.direction().x(), ray.direction().y(), ray.direction().z()};
+    for (int axis = 0; axis < 3; ++axis) {
+        float_ray.origin[axis] = static_cast<float>(origin[axis]);
+        const double inverse = 1.0 / direction[axis];
+        float_ray.inverse[axis] = std::fabs(direction[axis]) * kMaxInverseDirection > 1.0
+            ? static_cast<float>(inverse)
+            : (direction[axis] < 0.0 ? -kMaxInverseDirection : kMaxInverseDirection);
+    }
+    float_ray.t_min = round_down(min_distance);
+    return float_ray;
+}
+
+/**
+ * Slab-test the children of `node` and push the hit ones, farthest first so
+ * the nearest is popped first.
+ */
+template <typename Node>
+RAYTRACER_FORCE_INLINE void push_hit_children(const Node& node, const FloatRay& float_ray, double closest_distance,
+                                              StackEntry* stack, int& size) {
+    alignas(32) float near[kBvhWidth];
+    alignas(32) float far[kBvhWidth];
+    child_slabs(node, float_ray, static_cast<float>(std::min(closest_distance, kMaxFloatDistance)) * kRoundUp,
+                near, far);
+
+    StackEntry hits[kBvhWidth];
+    int hit_count = 0;
+    std::uint32_t inner_rank = 0;
+    std::uint32_t leaf_offset = 0;
+    for (int slot = 0; slot < kBvhWidth; ++slot) {
+        const std::uint8_t meta = node.meta[slot];
+        if (meta == kBvhEmptySlot) {
+            break;
+        }
+        const std::uint32_t link = child_link(node, slot, inner_rank, leaf_offset);
+        const std::uint32_t count = meta == kBvhInnerSlot ? 0 : meta;
+        inner_rank += count == 0 ? 1 : 0;
+        leaf_offset += count;
+        if (!(near[slot] <= far[slot])) {
+            continue;
+        }
+        int position = hit_count++;
+        while (position > 0 && hits[position - 1].distance < near[slot]) {
+            hits[position] = hits[position - 1];
+            --position;
+        }
+        hits[position] = StackEntry{near[slot], link, count};
+    }
+    for (int hit = 0; hit < hit_count; ++hit) {
+        stack[size++] = hits[hit];
+    }
+}
+
+/**
+ * Leaf primitives reached through primitive_order, in the table.
+ */
+struct TableLeaves {
+    const PackedPrimitive* entries;
+    const std::uint32_t* order;
+
+    const PackedPrimitive& primitive(std::uint32_t slot) const { return entries[order[slot]]; }
+    std::uint32_t index(std::uint32_t slot) const { return order[slot]; }
+};
+
+/**
+ * Leaf primitives stored in leaf order next to the nodes, with their table
+ * indices alongside (see traverse_quantized_nodes()).
+ */
+struct StoredLeaves {
+    const PackedPrimitive* primitives;
+    const std::uint32_t* ids;
+
+    const PackedPrimitive& primitive(std::uint32_t slot) const { return primitives[slot]; }
+    std::uint32_t index(std::uint32_t slot) const { return ids[slot]; }
+};
+
+template <typename Leaves>
+RAYTRACER_FORCE_INLINE void test_leaf(const PrimitiveTable* table, const Leaves& leaves, std::uint32_t first,
+                                      std::uint32_t count, const Ray& ray, double min_distance, ClosestHit& closest) {
+    for (std::uint32_t slot = first; slot < first + count; ++slot) {
+        test_accelerated_primitive(table, leaves.primitive(slot), leaves.index(slot), ray, min_distance, closest);
+    }
+}
+
+/**
+ * Stack traversal shared by both node formats, both leaf layouts and every
+ * ISA variant. `closest` already holds the always-tested primitives' result.
+ */
+template <typename Node, typename Leaves>
+RAYTRACER_FORCE_INLINE void traverse_body(const Node* nodes, const Leaves& leaves, const PrimitiveTable* table,
+                                          const Ray& ray, double min_distance, ClosestHit& closest) {
+    const FloatRay float_ray = make_float_ray(ray, min_distance);
+    StackEntry stack[kStackSize];
+    int size = 0;
+    stack[size++] = StackEntry{float_ray.t_min, 0, 0};
+    while (size > 0) {
+        const StackEntry entry = stack[--size];
+        if (static_cast<double>(entry.distance) > closest.distance) {
+            continue;
+        }
+        if (entry.count > 0) {
+            test_leaf(table, leaves, entry.link, entry.count, ray, min_distance, closest);
+        } else {
+            push_hit_children(nodes[entry.link], float_ray, closest.distance, stack, size);
+        }
+    }
+}
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, traverse_full, (traverse_body<BvhFullNode, TableLeaves>),
+                              (const BvhFullNode* nodes, const TableLeaves& leaves, const PrimitiveTable* table,
+                               const Ray& ray, double min_distance, ClosestHit& closest),
+                              (nodes, leaves, table, ray, min_distance, closest))
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, traverse_quantized, (traverse_body<BvhQuantizedNode, TableLeaves>),
+                              (const BvhQuantizedNode* nodes, const TableLeaves& leaves, const PrimitiveTable* table,
+                               const Ray& ray, double min_distance, ClosestHit& closest),
+                              (nodes, leaves, table, ray, min_distance, closest))
+
+RAYTRACER_DEFINE_ISA_VARIANTS(void, traverse_stored, (traverse_body<BvhQuantizedNode, StoredLeaves>),
+                              (const BvhQuantizedNode* nodes, const StoredLeaves& leaves, const PrimitiveTable* table,
+                               const Ray& ray, double min_distance, ClosestHit& closest),
+                              (nodes, leaves, table, ray, min_distance, closest))
+
+using FullTraversal = void (*)(const BvhFullNode*, const TableLeaves&, const PrimitiveTable*, const Ray&, double,
+                               ClosestHit&);
+using QuantizedTraversal = void (*)(const BvhQuantizedNode*, const TableLeaves&, const PrimitiveTable*, const Ray&,
+                                    double, ClosestHit&);
+using StoredTraversal = void (*)(const BvhQuantizedNode*, const StoredLeaves&, const PrimitiveTable*, const Ray&,
+                                 double, ClosestHit&);
+
+const cpu_features::IsaVariants<FullTraversal> full_traversals = RAYTRACER_ISA_VARIANT_TABLE(traverse_full);
+const cpu_features::IsaVariants<QuantizedTraversal> quantized_traversals =
+    RAYTRACER_ISA_VARIANT_TABLE(traverse_quantized);
+const cpu_features::IsaVariants<StoredTraversal> stored_traversals = RAYTRACER_ISA_VARIANT_TABLE(traverse_stored);
+
+/**
+ * Touch every cache line of `*object` with a prefetch hint.
+ */
+template <typename T>
+RAYTRACER_FORCE_INLINE void prefetch_lines(const T* object) {
+    const char* bytes = reinterpret_cast<const char*>(object);
+    for (std::size_t offset = 0; offset < sizeof(T); offset += kCacheLine) {
+        RAYTRACER_PREFETCH(bytes + offset);
+    }
+    RAYTRACER_PREFETCH(bytes + sizeof(T) - 1);
+}
+
+/**
+ * One ray in flight in the interleaved traversal.
+ */
+struct InterleavedRay {
+    const Ray* ray;
+    FloatRay float_ray;
+    ClosestHit closest;
+    StackEntry* stack;
+    int size;
+};
+
+/**
+ * Query inputs shared by every ray of an interleaved batch.
+ */
+template <typename Node>
+struct InterleavedQuery {
+    const Node* nodes;
+    const std::uint32_t* order;
+    const std::uint32_t* unbounded;
+    std::size_t unbounded_count;
+    const PrimitiveTable* table;
+    double min_distance;
+    double max_distance;
+};
+
+/**
+ * Prefetch what `lane` visits next: a node's lines, or a leaf's run of
+ * primitive_order entries (its primitives follow once those have arrived).
+ */
+template <typename Node>
+RAYTRACER_FORCE_INLINE void prefetch_next(const InterleavedQuery<Node>& query, const InterleavedRay& lane) {
+    if (lane.size == 0) {
+        return;
+    }
+    const StackEntry& top = lane.stack[lane.size - 1];
+    if (top.count == 0) {
+        prefetch_lines(query.nodes + top.link);
+    } else {
+        RAYTRACER_PREFETCH(query.order + top.link);
+        RAYTRACER_PREFETCH(query.order + top.link + (top.count & kLeafCountMask) - 1);
+    }
+}
+
+template <typename Node>
+RAYTRACER_FORCE_INLINE void start_interleaved(const InterleavedQuery<Node>& query, const Ray& ray,
+                                              HitCandidate& candidate, InterleavedRay& lane) {
+    const PackedPrimitive* entries = query.table->primitives().data();
+    candidate = HitCandidate();
+    lane.ray = &ray;
+    lane.closest = ClosestHit{query.max_distance, false, &candidate};
+    for (std::size_t index = 0; index < query.unbounded_count; ++index) {
+        const std::uint32_t primitive = query.unbounded[index];
+        test_accelerated_primitive(query.table, entries[primitive], primitive, ray, query.min_distance,
+                                   lane.closest);
+    }
+    lane.float_ray = make_float_ray(ray, query.min_distance);
+    lane.stack[0] = StackEntry{lane.float_ray.t_min, 0, 0};
+    lane.size = 1;
+}
+
+/**
+ * Advance `lane` by one node or leaf.
+ *
+ * @return false once the ray's stack is exhausted
+ */
+template <typename Node>
+RAYTRACER_FORCE_INLINE bool advance_interleaved(const InterleavedQuery<Node>& query, InterleavedRay& lane) {
+    while (lane.size > 0) {
+        StackEntry& top = lane.stack[lane.size - 1];
+        if (static_cast<double>(top.distance) > lane.closest.distance) {
+            --lane.size;
+            continue;
+        }
+        if (top.count == 0) {
+            const std::uint32_t link = top.link;
+            --lane.size;
+            push_hit_children(query.nodes[link], lane.float_ray, lane.closest.distance, lane.stack, lane.size);
+        } else if ((top.count & kLeafPrefetched) == 0) {
+            // First visit: the order entries are in by now; fetch the
+            // primitives and come back to the leaf on the next round
+            const PackedPrimitive* entries = query.table->primitives().data();
+            for (std::uint32_t slot = top.link; slot < top.link + top.count; ++slot) {
+                prefetch_lines(entries + query.order[slot]);
+            }
+            top.count |= kLeafPrefetched;
+            return true;
+        } else {
+            const StackEntry leaf = lane.stack[--lane.size];
+            const TableLeaves leaves{query.table->primitives().data(), query.order};
+            test_leaf(query.table, leaves, leaf.link, leaf.count & kLeafCountMask, *lane.ray, query.min_distance,
+                      lane.closest);
+        }
+        prefetch_next(query, lane);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Round-robin over up to `group` rays at a time: each turn advances one ray
+ * by one step and prefetches its next step, then moves on to the next ray,
+ * so the loads of one ray are in flight while the others compute. A ray that
+ * finishes hands its slot to the next unstarted ray.
+ */
+template <typename Node>
+RAYTRACER_FORCE_INLINE std::size_t interleave_body(const InterleavedQuery<Node>& query, const Ray* rays,
+                                                   std::size_t count, HitCandidate* candidates, int group) {
+    StackEntry stacks[kBvhMaxInterleavedRays][kStackSize];
+    InterleavedRay lanes[kBvhMaxInterleavedRays];
+    int active = 0;
+    std::size_t next = 0;
+    std::size_t hits = 0;
+    while (active < group && next < count) {
+        lanes[active].stack = stacks[active];
+        start_interleaved(query, rays[next], candidates[next], lanes[active]);
+        ++next;
+        ++active;
+    }
+    while (active > 0) {
+        for (int slot = 0; slot < active;) {
+            InterleavedRay& lane = lanes[slot];
+            if (advance_interleaved(query, lane)) {
+                ++slot;
+                continue;
+            }
+            hits += lane.closest.found ? 1 : 0;
+            if (next < count) {
+                start_interleaved(query, rays[next], candidates[next], lane);
+                ++next;
+                ++slot;
+            } else {
+                std::swap(lane, lanes[--active]);
+            }
+        }
+    }
+    return hits;
+}
+
+RAYTRACER_DEFINE_ISA_VARIANTS(std::size_t, interleave_full, interleave_body<BvhFullNode>,
+                              (const InterleavedQuery<BvhFullNode>& query, const Ray* rays, std::size_t count,
+                               HitCandidate* candidates, int group),
+                              (query, rays, count, candidates, group))
+
+RAYTRACER_DEFINE_ISA_VARIANTS(std::size_t, interleave_quantized, interleave_body<BvhQuantizedNode>,
+                              (const InterleavedQuery<BvhQuantizedNode>& query, const Ray* rays, std::size_t count,
+                               HitCandidate* candidates, int group),
+                              (query, rays, count, candidates, group))
+
+using FullInterleave = std::size_t (*)(const InterleavedQuery<BvhFullNode>&, const Ray*, std::size_t, HitCandidate*,
+                                       int);
+using QuantizedInterleave = std::size_t (*)(const InterleavedQuery<BvhQuantizedNode>&, const Ray*, std::size_t,
+                                            HitCandidate*, int);
+
+const cpu_features::IsaVariants<FullInterleave> full_interleaves = RAYTRACER_ISA_VARIANT_TABLE(interleave_full);
+const cpu_features::IsaVariants<QuantizedInterleave> quantized_interleaves =
+    RAYTRACER_ISA_VARIANT_TABLE(interleave_quantized);
+
+/**
+ * One child slot of a wide node before encoding.
+ */
+struct WideChild {
+    Bounds lo;
+    Bounds hi;
+    std::uint32_t link;
+    std::uint8_t meta;
+};
+
+void encode(const std::vector<WideChild>& children, BvhFullNode& node) {
+    std::memset(&node, 0, sizeof(node));
+    for (std::size_t slot = 0; slot < children.size(); ++slot) {
+        for (int axis = 0; axis < 3; ++axis) {
+            node.bounds[axis][slot] = round_down(children[slot].lo[axis]);
+            node.bounds[3 + axis][slot] = round_up(children[slot].hi[axis]);
+        }
+        node.link[slot] = children[slot].link;
+        node.meta[slot] = children[slot].meta;
+    }
+}
+
+void encode(const std::vector<WideChild>& children, std::uint32_t child_base, std::uint32_t primitive_base,
+            BvhQuantizedNode& node) {
+    std::memset(&node, 0, sizeof(node));
+    node.child_base = child_base;
+    node.primitive_base = primitive_base;
+    Bounds lo;
+    Bounds hi;
+    reset(lo, hi);
+    for (const WideChild& child : children) {
+        grow(lo, hi, child.lo, child.hi);
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        node.origin[axis] = round_down(lo[axis]);
+        const int exponent = quantization_exponent(hi[axis] - static_cast<double>(node.origin[axis]));
+        node.exponent[axis] = static_cast<std::int8_t>(exponent);
+        const double step = std::ldexp(1.0, exponent);
+        for (std::size_t slot = 0; slot < children.size(); ++slot) {
+            const double low = std::floor((children[slot].lo[axis] - node.origin[axis]) / step);
+            const double high = std::ceil((children[slot].hi[axis] - node.origin[axis]) / step);
+            node.bounds[axis][slot] = static_cast<std::uint8_t>(std::clamp(low, 0.0, 255.0));
+            node.bounds[3 + axis][slot] = static_cast<std::uint8_t>(std::clamp(high, 0.0, 255.0));
+        }
+    }
+    for (std::size_t slot = 0; slot < children.size(); ++slot) {
+        node.meta[slot] = children[slot].meta;
+    }
+}
+
+} // namespace
+
+void WideBvh::build(const PrimitiveTable& table, const WideBvhSettings& settings) {
+    const std::vector<PackedPrimitive>& entries = table.primitives();
+    std::vector<BvhBox> boxes;
+    boxes.reserve(entries.size());
+    std::vector<std::uint32_t> always_tested;
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        BvhBox box;
+        box.id = static_cast<std::uint32_t>(index);
+        if (accelerator_primitive_bounds(entries[index], box.lo, box.hi)) {
+            boxes.push_back(box);
+        } else {
+            always_tested.push_back(box.id);
+        }
+    }
+    build(boxes, settings);
+    unbounded = std::move(always_tested);
+}
+
+void WideBvh::build(const std::vector<BvhBox>& boxes, const WideBvhSettings& settings) {
+    node_format = settings.format;
+    tree_depth = 0;
+    full_nodes.clear();
+    quantized_nodes.clear();
+    primitive_order.clear();
+    unbounded.clear();
+    if (boxes.empty()) {
+        return;
+    }
+
+    std::vector<BuildPrimitive> primitives;
+    primitives.reserve(boxes.size());
+    Bounds scene_lo;
+    Bounds scene_hi;
+    reset(scene_lo, scene_hi);
+    for (const BvhBox& box : boxes) {
+        primitives.push_back(BuildPrimitive{box.lo, box.hi, Bounds(), box.id});
+        grow(scene_lo, scene_hi, box.lo, box.hi);
+    }
+
+    // Pad relative to the scene size and its distance from the origin, which
+    // bound the absolute rounding error of float coordinates
+    double scale = 1.0;
+    for (int axis = 0; axis < 3; ++axis) {
+        scale = std::max({scale, scene_hi[axis] - scene_lo[axis], std::fabs(scene_lo[axis]),
+                          std::fabs(scene_hi[axis])});
+    }
+    const double padding = kRelativePadding * scale;
+    for (BuildPrimitive& primitive : primitives) {
+        for (int axis = 0; axis < 3; ++axis) {
+            primitive.lo[axis] -= padding;
+            primitive.hi[axis] += padding;
+            primitive.centroid[axis] = 0.5 * (primitive.lo[axis] + primitive.hi[axis]);
+        }
+    }
+
+    BinaryBuilder builder(primitives, settings);
+    builder.build(0, primitives.size(), 0);
+    const std::vector<BinaryNode>& binary = builder.nodes;
+
+    // Breadth-first emission keeps each node's inner children consecutive and
+    // its leaves' primitives consecutive, as the quantized links require
+    std::vector<std::vector<int>> pending = {wide_children(binary, 0)};
+    std::vector<int> level = {1};
+    for (std::size_t current = 0; current < pending.size(); ++current) {
+        const std::vector<int> slots = pending[current];
+        const std::uint32_t child_base = static_cast<std::uint32_t>(pending.size());
+        const std::uint32_t primitive_base = static_cast<std::uint32_t>(primitive_order.size());
+        std::vector<WideChild> children;
+        for (const int binary_index : slots) {
+            const BinaryNode& child = binary[static_cast<std::size_t>(binary_index)];
+            WideChild wide{child.lo, child.hi, 0, kBvhInnerSlot};
+            if (child.left < 0) {
+                wide.link = static_cast<std::uint32_t>(primitive_order.size());
+                wide.meta = static_cast<std::uint8_t>(child.count);
+                for (std::size_t slot = child.first; slot < child.first + child.count; ++slot) {
+                    primitive_order.push_back(primitives[slot].index);
+                }
+            } else {
+                wide.link = static_cast<std::uint32_t>(pending.size());
+                pending.push_back(wide_children(binary, binary_index));
+                level.push_back(level[current] + 1);
+            }
+            children.push_back(wide);
+        }
+        tree_depth = std::max(tree_depth, level[current]);
+        if (node_format == BvhNodeFormat::Full) {
+            full_nodes.emplace_back();
+            encode(children, full_nodes.back());
+        } else {
+            quantized_nodes.emplace_back();
+            encode(children, child_base, primitive_base, quantized_nodes.back());
+        }
+    }
+}
+
+bool WideBvh::intersect(const PrimitiveTable& table, const Ray& ray, double min_distance, double max_distance,
+                        HitCandidate& candidate) const {
+    const PackedPrimitive* entries = table.primitives().data();
+    ClosestHit closest{max_distance, false, &candidate};
+    for (const std::uint32_t index : unbounded) {
+        test_accelerated_primitive(&table, entries[index], index, ray, min_distance, closest);
+    }
+    const TableLeaves leaves{entries, primitive_order.data()};
+    if (!full_nodes.empty()) {
+        full_traversals.active()(full_nodes.data(), leaves, &table, ray, min_distance, closest);
+    } else if (!quantized_nodes.empty()) {
+        quantized_traversals.active()(quantized_nodes.data(), leaves, &table, ray, min_distance, closest);
+    }
+    return closest.found;
+}
+
+void WideBvh::collect_boxes(const Ray& ray, double min_distance, double max_distance,
+                            std::vector<BvhBoxHit>& hits) const {
+    if (full_nodes.empty() && quantized_nodes.empty()) {
+        return;
+    }
+    const FloatRay float_ray = make_float_ray(ray, min_distance);
+    StackEntry stack[kStackSize];
+    int size = 0;
+    stack[size++] = StackEntry{float_ray.t_min, 0, 0};
+    while (size > 0) {
+        const StackEntry entry = stack[--size];
+        if (entry.count > 0) {
+            for (std::uint32_t slot = entry.link; slot < entry.link + entry.count; ++slot) {
+                hits.push_back(BvhBoxHit{entry.distance, primitive_order[slot]});
+            }
+        } else if (!full_nodes.empty()) {
+            push_hit_children(full_nodes[entry.link], float_ray, max_distance, stack, size);
+        } else {
+            push_hit_children(quantized_nodes[entry.link], float_ray, max_distance, stack, size);
+        }
+    }
+}
+
+std::size_t WideBvh::intersect_interleaved(const PrimitiveTable& table, const Ray* rays, std::size_t count,
+                                           double min_distance, double max_distance, HitCandidate* candidates,
+                                           int group) const {
+    group = std::clamp(group, 1, kBvhMaxInterleavedRays);
+    if (!full_nodes.empty()) {
+        const InterleavedQuery<BvhFullNode> query{full_nodes.data(), primitive_order.data(), unbounded.data(),
+                                                  unbounded.size(), &table, min_distance, max_distance};
+        return full_interleaves.active()(query, rays, count, candidates, group);
+    }
+    if (!quantized_nodes.empty()) {
+        const InterleavedQuery<BvhQuantizedNode> query{quantized_nodes.data(), primitive_order.data(),
+                                                       unbounded.data(), unbounded.size(), &table, min_distance,
+                                                       max_distance};
+        return quantized_interleaves.active()(query, rays, count, candidates, group);
+    }
+    std::size_t hits = 0;
+    for (std::size_t index = 0; index < count; ++index) {
+        candidates[index] = HitCandidate();
+        hits += intersect(table, rays[index], min_distance, max_distance, candidates[index]) ? 1 : 0;
+    }
+    return hits;
+}
+
+void traverse_quantized_nodes(const BvhQuantizedNode* nodes, const PackedPrimitive* primitives,
+                              const std::uint32_t* ids, const PrimitiveTable& table, const Ray& ray,
+                              double min_distance, ClosestHit& closest) {
+    stored_traversals.active()(nodes, StoredLeaves{primitives, ids}, &table, ray, min_distance, closest);
+}
@@ -0,0 +1,223 @@
+#ifndef WIDE_BVH_H
+#define WIDE_BVH_H
+
+/**
+ * @file WideBvh.h
+ * @brief 8-wide bounding volume hierarchy over the primitive table, with an
+ * optional compressed node format.
+ *
+ * The build is a binned-SAH binary BVH collapsed into nodes of up to eight
+ * children. Traversal tests all eight child boxes of a node at once in single
+ * precision (one loop over the eight lanes, compiled per ISA level
+ * and vectorized by the compiler), then visits the hit children nearest
+ * first and skips any child that starts beyond the closest hit found so far.
+ *
+ * Nodes come in two formats with the same tree shape:
+ * - BvhFullNode keeps float child boxes and a 32-bit link per child
+ *   (256 bytes per node);
+ * - BvhQuantizedNode stores each child box as 8-bit offsets on a grid of
+ *   256 steps across the node's own box (a power-of-two step per axis,
+ *   lower bounds rounded down and upper bounds rounded up) and replaces the
+ *   per-child links by two base indices: inner children are stored
+ *   consecutively, and leaf primitives follow one another in slot order
+ *   (80 bytes per node). The decode is one multiply-add per bound, folded
+ *   into the slab test.
+ *
+ * intersect_interleaved() answers a batch of independent rays, a few at a
+ * time in round-robin, prefetching each ray's next node while the others
+ * work, so that cache misses on trees larger than the cache overlap. No
+ * render path calls it: the path tracer traces one ray at a time, and camera
+ * rays, the only ready-made batches, go through tile culling and are
+ * coherent. It is a batch entry point measured by raytracer_bench_interleave.
+ *
+ * Child boxes enclose the primitive bounds padded by a small share of the
+ * scene size, more than single-precision rounding in the slab test can
+ * remove, so no box that holds a hit is ever missed. Queries therefore
+ * return exactly what a full PrimitiveTable scan returns, including which
+ * primitive wins a tie at equal distance (the later one in the table).
+ */
+
+#include "Accelerator.h"
+#include "Hittable.h"
+#include "Ray.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PrimitiveTable;
+struct ClosestHit;
+struct PackedPrimitive;
+
+/**
+ * Children per BVH node.
+ */
+constexpr int kBvhWidth = 8;
+
+/**
+ * Child slot states in the node `meta` bytes; any other value is a leaf and
+ * gives its primitive count.
+ */
+constexpr std::uint8_t kBvhEmptySlot = 0;
+constexpr std::uint8_t kBvhInnerSlot = 0xFF;
+
+/**
+ * Most rays intersect_interleaved() keeps in flight at once.
+ */
+constexpr int kBvhMaxInterleavedRays = 16;
+
+/**
+ * How child boxes and links are stored.
+ */
+enum class BvhNodeFormat {
+    Full,       ///< Float bounds, one 32-bit link per child
+    Quantized   ///< 8-bit bounds relative to the node box, two base links
+};
+
+/**
+ * Build controls.
+ */
+struct WideBvhSettings {
+    bool enabled = false;                             ///< Build a BVH for the scene before rendering
+    BvhNodeFormat format = BvhNodeFormat::Quantized;  ///< Node format to store
+    int max_leaf_size = 4;                            ///< Split until a leaf holds at most this many primitives
+    int sah_bins = 16;                                ///< Candidate split planes per axis
+};
+
+/**
+ * Box to build over instead of table primitives (see WideBvh::build()); the
+ * leaves then list box ids.
+ */
+struct BvhBox {
+    std::array<double, 3> lo;
+    std::array<double, 3> hi;
+    std::uint32_t id;
+};
+
+/**
+ * Box reached by a ray, with the distance where the ray enters its leaf.
+ */
+struct BvhBoxHit {
+    float distance;
+    std::uint32_t id;
+};
+
+/**
+ * Uncompressed node: child boxes as floats, structure of arrays (one row of
+ * eight lanes per bound) so the slab test loads each row as one vector.
+ */
+struct alignas(32) BvhFullNode {
+    float bounds[6][kBvhWidth];     ///< Child minima per axis (rows 0-2), then maxima (rows 3-5)
+    std::uint32_t link[kBvhWidth];  ///< Node index (inner child) or first primitive_order entry (leaf)
+    std::uint8_t meta[kBvhWidth];   ///< kBvhEmptySlot, kBvhInnerSlot or the leaf's primitive count
+};
+
+/**
+ * Compressed node. Child bound `q` in row `axis` or `3 + axis` decodes to
+ * `origin[axis] + q * 2^exponent[axis]`.
+ */
+struct alignas(16) BvhQuantizedNode {
+    std::uint8_t bounds[6][kBvhWidth]; ///< Child minima in steps rounded down (rows 0-2), maxima rounded up
+    float origin[3];                   ///< Node box minimum, rounded down to float
+    std::int8_t exponent[3];           ///< Quantization step per axis, as a power of two
+    std::uint8_t meta[kBvhWidth];      ///< kBvhEmptySlot, kBvhInnerSlot or the leaf's primitive count
+    std::uint32_t child_base;          ///< Node index of the first inner child; the rest follow in slot order
+    std::uint32_t primitive_base;      ///< primitive_order entry of the first leaf child's first primitive
+};
+
+/**
+ * Wide BVH in one of the two node formats.
+ */
+class WideBvh : public Accelerator {
+public:
+    /**
+     * Build over every bounded primitive of `table`. Extension primitives
+     * (no known bounds) and room enclosures (which would enclose the whole
+     * tree) are kept aside and tested by every query, before the traversal.
+     */
+    void build(const PrimitiveTable& table, const WideBvhSettings& settings = WideBvhSettings());
+
+    /**
+     * Build over arbitrary boxes, e.g. the pages of a two-level structure.
+     * Query such a tree with collect_boxes(); intersect() treats box ids as
+     * table indices.
+     */
+    void build(const std::vector<BvhBox>& boxes, const WideBvhSettings& settings = WideBvhSettings());
+
+    /**
+     * Append every box whose leaf the ray enters between `min_distance` and
+     * `max_distance` to `hits`, in no particular order.
+     */
+    void collect_boxes(const Ray& ray, double min_distance, double max_distance, std::vector<BvhBoxHit>& hits) const;
+
+    bool intersect(const PrimitiveTable& table, const Ray& ray, double min_distance, double max_distance,
+                   HitCandidate& candidate) const override;
+
+    /**
+     * Closest-hit queries for `count` independent rays, interleaved: up to
+     * `group` rays are traversed together, each advancing by one node or
+     * leaf per turn and prefetching its next one before the next ray's turn.
+     * Every ray gets exactly the intersect() result; `candidates[i].primitive`
+     * stays null when ray `i` misses.
+     *
+     * @param group Rays in flight, 1 to kBvhMaxInterleavedRays
+     * @return Number of rays that hit
+     */
+    std::size_t intersect_interleaved(const PrimitiveTable& table, const Ray* rays, std::size_t count,
+                                      double min_distance, double max_distance, HitCandidate* candidates,
+                                      int group = 8) const;
+
+    bool empty() const { return node_count() == 0 && unbounded.empty(); }
+    BvhNodeFormat format() const { return node_format; }
+    std::size_t node_count() const { return full_nodes.size() + quantized_nodes.size(); }
+
+    /**
+     * Size of the node array in bytes.
+     */
+    std::size_t node_bytes() const {
+        return full_nodes.size() * sizeof(BvhFullNode) + quantized_nodes.size() * sizeof(BvhQuantizedNode);
+    }
+
+    /**
+     * Size of the leaf primitive index list in bytes.
+     */
+    std::size_t index_bytes() const { return primitive_order.size() * sizeof(std::uint32_t); }
+
+    /**
+     * Primitives stored in the tree (the table minus the always-tested ones).
+     */
+    std::size_t bounded_count() const { return primitive_order.size(); }
+
+    /**
+     * Depth of the tree in wide nodes (0 when empty).
+     */
+    int depth() const { return tree_depth; }
+
+    /**
+     * Quantized nodes, root first (empty for the full format), and the
+     * primitive (or box id) list their leaves index; for writing the tree out.
+     */
+    const std::vector<BvhQuantizedNode>& quantized_node_list() const { return quantized_nodes; }
+    const std::vector<std::uint32_t>& leaf_order() const { return primitive_order; }
+
+private:
+    BvhNodeFormat node_format = BvhNodeFormat::Quantized;
+    int tree_depth = 0;
+    std::vector<BvhFullNode> full_nodes;            ///< Root first; only one of the two arrays is filled
+    std::vector<BvhQuantizedNode> quantized_nodes;
+    std::vector<std::uint32_t> primitive_order;     ///< Table indices (or box ids), leaf by leaf
+    std::vector<std::uint32_t> unbounded;           ///< Extensions and enclosures, tested by every query
+};
+
+/**
+ * Closest-hit traversal of quantized nodes kept outside a WideBvh, such as
+ * a tree read back from disk. Leaf slot `i` (see leaf_order()) holds the
+ * primitive `primitives[i]`, which is entry `ids[i]` of `table`; `closest`
+ * carries the best hit so far in and out.
+ */
+void traverse_quantized_nodes(const BvhQuantizedNode* nodes, const PackedPrimitive* primitives,
+                              const std::uint32_t* ids, const PrimitiveTable& table, const Ray& ray,
+                              double min_distance, ClosestHit& closest);
+
+#endif
@@ -1,12 +1,23 @@
 #include "Camera.h"
-#include "PngWriter.h"
+#include "CpuFeatures.h"
+#include "FastMath.h"
+#include "ImageWriter.h"
+#include "OccluderCache.h"
+#include "RenderCache.h"
 #include "RenderConfig.h"
+#include "RenderEngine.h"
 #include "Renderer.h"
 #include "Scene.h"
 
+#include <algorithm>
 #include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -46,7 +57,14 @@ std::string generate_filename(const RenderConfig& config, int max_depth) {
 }
 
 /**
- * Save the rendered image to a PNG file.
+ * Where to save the image: `config.output_path` if set, else generate_filename().
+ */
+std::string output_filename(const RenderConfig& config, int max_depth) {
+    return config.output_path.empty() ? generate_filename(config, max_depth) : config.output_path;
+}
+
+/**
+ * Save the rendered image in the format its extension names (PNG, QOI or JPEG).
  * 
  * @param filepath Path where the image will be saved
  * @param config Render configuration containing image dimensions
@@ -55,20 +73,152 @@ std::string generate_filename(const RenderConfig& config, int max_depth) {
  */
 bool save_image(const std::string& filepath, const RenderConfig& config,
                 const std::vector<unsigned char>& image_data) {
-    bool success = png_writer::write_rgb(filepath, config.image_width, config.image_height, image_data);
+    bool success = image_writer::write_rgb(filepath, config.image_width, config.image_height, image_data);
     
     if (success) {
         std::cerr << "Saved image to " << filepath << "\n";
     } else {
-        std::cerr << "Failed to write PNG image.\n";
+        std::cerr << "Failed to write " << filepath << "\n";
     }
     
     return success;
 }
 
-int main() {
+/**
+ * Apply command-line options and the RAYTRACER_ISA environment variable.
+ *
+ * - `--isa=<level>` pins the kernel ISA (wins over RAYTRACER_ISA); levels
+ *   above what the CPU supports are clamped.
+ * - `--radiance-cache` renders a biased preview through the radiance cache.
+ * - `--path-guiding` trains a guiding field over progressive passes.
+ * - `--light-grid` precomputes per-voxel light visibility for the scene.
+ * - `--raster` rasterizes the camera rays' first hits into a visibility buffer.
+ * - `--grid` traces rays through a uniform grid instead of the linear scan.
+ * - `--bvh` traces rays through an 8-wide BVH with quantized nodes instead;
+ *   `--bvh=full` keeps float child bounds.
+ * - `--paged[=FILE]` writes a paged BVH to FILE (default `scene.pbvh`) and
+ *   traces rays through it, mapping pages in under the cache budget. The
+ *   scene stays in memory too, so this saves no memory.
+ * - `--tiled[=FILE]` renders into a tiled framebuffer mapped from FILE
+ *   (default `render.tiles`, removed afterwards) and encodes the PNG band
+ *   by band, for frames too large for memory.
+ * - `--cache[=DIR]` looks the image up in a render cache in DIR (default
+ *   `.render-cache`) before rendering and stores its samples afterwards;
+ *   ignored with `--tiled`.
+ * - `--output=FILE` writes the image to FILE instead of a generated name, as
+ *   PNG, QOI (`.qoi`) or JPEG (`.jpg`, `.jpeg`) by extension; `--tiled`
+ *   writes PNG only.
+ * - `--size=WxH` sets the resolution (and the aspect ratio with it);
+ *   `--spp=N` sets the samples per pixel.
+ *
+ * @param config Render configuration to update
+ * @return false on an unknown level, argument or output format
+ */
+bool parse_arguments(int argc, char** argv, RenderConfig& config) {
+    if (!cpu_features::apply_isa_from_environment()) {
+        std::cerr << "Unknown RAYTRACER_ISA value; expected scalar, sse4.2, avx2 or avx512\n";
+        return false;
+    }
+
+    const std::string isa_prefix = "--isa=";
+    const std::string paged_prefix = "--paged=";
+    const std::string tiled_prefix = "--tiled=";
+    const std::string cache_prefix = "--cache=";
+    const std::string output_prefix = "--output=";
+    const std::string size_prefix = "--size=";
+    const std::string spp_prefix = "--spp=";
+    for (int index = 1; index < argc; ++index) {
+        const std::string argument = argv[index];
+        cpu_features::IsaLevel level;
+        int width = 0;
+        int height = 0;
+        int samples = 0;
+        if (argument == "--radiance-cache") {
+            config.radiance_cache.mode = RadianceCacheMode::Preview;
+        } else if (argument == "--path-guiding") {
+            config.path_guiding.enabled = true;
+        } else if (argument == "--light-grid") {
+            config.light_visibility.enabled = true;
+        } else if (argument == "--raster") {
+            config.raster_primary.enabled = true;
+        } else if (argument == "--grid") {
+            config.uniform_grid.enabled = true;
+        } else if (argument == "--bvh" || argument == "--bvh=quantized") {
+            config.wide_bvh.enabled = true;
+            config.wide_bvh.format = BvhNodeFormat::Quantized;
+        } else if (argument == "--bvh=full") {
+            config.wide_bvh.enabled = true;
+            config.wide_bvh.format = BvhNodeFormat::Full;
+        } else if (argument == "--paged") {
+            config.paged_bvh.enabled = true;
+        } else if (argument.compare(0, paged_prefix.size(), paged_prefix) == 0
+                   && argument.size() > paged_prefix.size()) {
+            config.paged_bvh.enabled = true;
+            config.paged_bvh.path = argument.substr(paged_prefix.size());
+        } else if (argument == "--tiled") {
+            config.tiled_output.enabled = true;
+        } else if (argument.compare(0, tiled_prefix.size(), tiled_prefix) == 0
+                   && argument.size() > tiled_prefix.size()) {
+            config.tiled_output.enabled = true;
+            config.tiled_output.path = argument.substr(tiled_prefix.size());
+        } else if (argument == "--cache") {
+            config.render_cache.enabled = true;
+        } else if (argument.compare(0, cache_prefix.size(), cache_prefix) == 0
+                   && argument.size() > cache_prefix.size()) {
+            config.render_cache.enabled = true;
+            config.render_cache.directory = argument.substr(cache_prefix.size());
+        } else if (argument.compare(0, output_prefix.size(), output_prefix) == 0
+                   && argument.size() > output_prefix.size()) {
+            config.output_path = argument.substr(output_prefix.size());
+        } else if (argument.compare(0, size_prefix.size(), size_prefix) == 0
+                   && std::sscanf(argument.c_str() + size_prefix.size(), "%dx%d", &width, &height) == 2
+                   && width > 1 && height > 1) {
+            config.image_width = width;
+            config.image_height = height;
+            config.aspect_ratio = static_cast<double>(width) / height;
+        } else if (argument.compare(0, spp_prefix.size(), spp_prefix) == 0
+                   && std::sscanf(argument.c_str() + spp_prefix.size(), "%d", &samples) == 1 && samples > 0) {
+            config.samples_per_pixel = samples;
+        } else if (argument.compare(0, isa_prefix.size(), isa_prefix) == 0
+                   && cpu_features::parse_isa(argument.substr(isa_prefix.size()), level)) {
+            cpu_features::force_isa(level);
+        } else {
+            std::cerr << "Usage: raytracer [--isa=scalar|sse4.2|avx2|avx512] [--radiance-cache] [--path-guiding]"
+                         " [--light-grid] [--raster] [--grid] [--bvh[=quantized|full]]"
+                         " [--paged[=FILE]] [--tiled[=FILE]] [--cache[=DIR]] [--output=FILE] [--size=WxH] [--spp=N]\n";
+            return false;
+        }
+    }
+
+    ImageFormat format = ImageFormat::Png;
+    if (!config.output_path.empty() && !image_writer::format_for_path(config.output_path, format)) {
+        std::cerr << "Unknown image format for " << config.output_path << "; expected .png, .qoi, .jpg or .jpeg\n";
+        return false;
+    }
+    if (format != ImageFormat::Png && config.tiled_output.enabled) {
+        std::cerr << "--tiled writes PNG only\n";
+        return false;
+    }
+    return true;
+}
+
+/// Set by Ctrl-C; the main thread turns it into RenderHandle::cancel()
+volatile std::sig_atomic_t interrupt_requested = 0;
+
+void request_interrupt(int) {
+    interrupt_requested = 1;
+}
+
+int main(int argc, char** argv) {
     // ========== Configuration ==========
     RenderConfig config(16.0 / 9.0, 100, 500);  // aspect_ratio, width, samples_per_pixel
+    config.output_path.clear();  // A descriptive name unless --output is given
+    if (!parse_arguments(argc, argv, config)) {
+        return 2;
+    }
+    // Process defaults for work outside the render job (scene setup, quantization); the job carries its own
+    fast_math::set_enabled_kernels(config.fast_math_kernels);
+    occluder_cache::set_enabled(config.occluder_cache);
     const int max_depth = 100;  // Maximum number of ray bounces for reflections/refractions
     const RoomLayout room_layout = default_room_layout();
     const double ceiling_height = room_layout.ceiling_y;
@@ -87,14 +237,173 @@ int main() {
         Color(lamp_intensity, lamp_intensity, lamp_intensity)
     );
 
-    Scene scene = create_scene(room_layout, std::move(lights));
+    const std::shared_ptr<Scene> scene = std::make_shared<Scene>(create_scene(room_layout, std::move(lights)));
+
+    // ========== Render cache ==========
+    const RenderCache cache(config.render_cache.directory);
+    std::string cache_key;
+    std::shared_ptr<const FrameSamples> cached_samples;
+    if (config.render_cache.enabled && config.tiled_output.enabled) {
+        std::cerr << "Render cache: not used with --tiled\n";
+    } else if (config.render_cache.enabled) {
+        if (!RenderCache::key(*scene, camera, config, max_depth, cache_key)) {
+            std::cerr << "Render cache: the scene has extension objects and cannot be cached\n";
+        } else {
+            const std::shared_ptr<FrameSamples> samples = std::make_shared<FrameSamples>();
+            CacheLookup found = cache.lookup(cache_key, config.samples_per_pixel, *samples);
+            if (samples->image.width != config.image_width || samples->image.height != config.image_height) {
+                found = CacheLookup::Miss;  // Not the frame the key names; render afresh
+            }
+            if (found == CacheLookup::Hit) {
+                std::cerr << "Render cache: hit " << cache_key << " in " << cache.directory() << "\n";
+                return save_image(output_filename(config, max_depth), config,
+                                  quantize_framebuffer(samples->image, config.dither)) ? 0 : 1;
+            }
+            if (found == CacheLookup::Partial) {
+                std::uint64_t stored = 0;
+                for (const std::uint32_t count : samples->counts) {
+                    stored += std::min<std::uint32_t>(count, static_cast<std::uint32_t>(config.samples_per_pixel));
+                }
+                std::cerr << "Render cache: partial hit " << cache_key << ", " << 100.0 * static_cast<double>(stored)
+                        / (static_cast<double>(samples->counts.size()) * config.samples_per_pixel)
+                          << "% of the samples stored\n";
+                cached_samples = samples;
+            } else {
+                std::cerr << "Render cache: miss " << cache_key << "\n";
+            }
+        }
+    }
+    if (config.uniform_grid.enabled) {
+        const auto start = std::chrono::steady_clock::now();
+        const UniformGrid& grid = scene->build_uniform_grid(config.uniform_grid);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << "Uniform grid: " << grid.dimensions()[0] << "x" << grid.dimensions()[1] << "x"
+                  << grid.dimensions()[2] << " cells, "
+                  << static_cast<double>(grid.reference_count())
+                         / static_cast<double>(std::max<std::size_t>(scene->dispatch_table.primitive_count(), 1))
+                  << " cells per primitive, " << 100.0 * grid.empty_fraction() << "% empty ("
+                  << elapsed.count() << " ms)\n";
+    }
+    if (config.wide_bvh.enabled) {
+        const auto start = std::chrono::steady_clock::now();
+        const WideBvh& bvh = scene->build_wide_bvh(config.wide_bvh);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        std::cerr << "Wide BVH (" << (bvh.format() == BvhNodeFormat::Quantized ? "quantized" : "full")
+                  << " nodes): " << bvh.node_count() << " nodes, depth " << bvh.depth() << ", "
+                  << static_cast<double>(bvh.node_bytes() + bvh.index_bytes())
+                         / static_cast<double>(std::max<std::size_t>(bvh.bounded_count(), 1))
+                  << " bytes per primitive (" << elapsed.count() << " ms)\n";
+    }
+    std::shared_ptr<const PagedBvh> paged_bvh;
+    if (config.paged_bvh.enabled) {
+        const auto start = std::chrono::steady_clock::now();
+        paged_bvh = scene->build_paged_bvh(config.paged_bvh);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (!paged_bvh) {
+            std::cerr << "Cannot write or open " << config.paged_bvh.path << "\n";
+            return 1;
+        }
+        std::cerr << "Paged BVH: " << paged_bvh->page_count() << " pages, " << paged_bvh->file_bytes()
+                  << " bytes in " << config.paged_bvh.path << " (" << elapsed.count() << " ms)\n";
+    }
+    if (config.light_visibility.enabled) {
+        const auto start = std::chrono::steady_clock::now();
+        scene->build_light_visibility(config.light_visibility);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        const LightVisibilityGrid& grid = *scene->light_visibility;
+        const double pairs = static_cast<double>(std::max<std::size_t>(grid.cell_count() * grid.light_count(), 1));
+        std::cerr << "Light visibility grid: " << grid.dimensions()[0] << "x" << grid.dimensions()[1] << "x"
+                  << grid.dimensions()[2] << " cells, "
+                  << 100.0 * grid.count(LightVisibility::Visible) / pairs << "% visible, "
+                  << 100.0 * grid.count(LightVisibility::Occluded) / pairs << "% occluded ("
+                  << elapsed.count() << " ms)\n";
+    }
     
     // ========== Render ==========
-    std::vector<unsigned char> image_data = render_image(config, camera, scene, max_depth);
+    RenderJob job;
+    job.scene = scene;
+    job.camera = camera;
+    job.config = config;
+    job.max_depth = max_depth;
+    job.log = &std::cerr;
+    job.start_from = cached_samples;
+    std::mutex progress_mutex;
+    job.on_progress = [&progress_mutex](const RenderProgress& progress) {
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        std::cerr << "\rTiles remaining: " << progress.tile_count - progress.tiles_done << ' ' << std::flush;
+    };
+
+    TiledFramebuffer tiled;
+    if (config.tiled_output.enabled) {
+        if (!tiled.create(config.tiled_output.path, config.image_width, config.image_height,
+                          config.tiled_output.tile_size)) {
+            std::cerr << "Cannot create " << config.tiled_output.path << "\n";
+            return 1;
+        }
+        std::cerr << "Tiled framebuffer: " << tiled.tiles_x() << "x" << tiled.bands() << " tiles of "
+                  << tiled.tile_size() << " px, " << tiled.file_bytes() << " bytes in "
+                  << config.tiled_output.path << "\n";
+        job.tiled_target = &tiled;
+    }
+
+    RenderEngine engine;
+    const std::shared_ptr<RenderHandle> handle = engine.submit(std::move(job));
+    // Ctrl-C stops the render at the next sample and saves what it has
+    std::signal(SIGINT, request_interrupt);
+    while (!handle->wait_for(std::chrono::milliseconds(50))) {
+        if (interrupt_requested != 0) {
+            handle->cancel();
+        }
+    }
+    std::signal(SIGINT, SIG_DFL);
+    std::cerr << "\nRendered with " << engine.thread_count() << " worker threads in "
+              << handle->progress().elapsed_ms << " ms\n";
+    if (handle->status() == RenderStatus::Cancelled) {
+        std::uint64_t samples = 0;
+        for (const std::uint32_t count : handle->sample_counts()) {
+            samples += count;
+        }
+        const RenderProgress progress = handle->progress();
+        std::cerr << "Interrupted after " << progress.tiles_done << " of " << progress.tile_count << " tiles";
+        if (!handle->sample_counts().empty()) {
+            std::cerr << " (" << 100.0 * static_cast<double>(samples)
+                    / (static_cast<double>(handle->sample_counts().size()) * config.samples_per_pixel)
+                      << "% of the samples)";
+        }
+        std::cerr << "; saving the partial image\n";
+    }
+    report_ray_statistics(std::cerr);
+    if (paged_bvh) {
+        const PageCacheStats stats = paged_bvh->cache_stats();
+        std::cerr << "Page cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions
+                  << " evictions, peak " << stats.peak_bytes << " bytes mapped\n";
+    }
     
+    // Cancelled renders are stored too, so the next run picks up where this one stopped
+    if (!cache_key.empty()) {
+        FrameSamples samples{handle->framebuffer(), handle->sample_counts()};
+        const bool rendered = std::any_of(samples.counts.begin(), samples.counts.end(),
+                                          [](std::uint32_t count) { return count > 0; });
+        if (rendered && !cache.store(cache_key, samples)) {
+            std::cerr << "Render cache: cannot write to " << cache.directory() << "\n";
+        }
+    }
+
     // ========== Save ==========
-    std::string output_filename = generate_filename(config, max_depth);
-    bool success = save_image(output_filename, config, image_data);
+    const std::string output_path = output_filename(config, max_depth);
+    bool success = false;
+    if (config.tiled_output.enabled) {
+        success = tiled.write_png(output_path, config.dither);
+        tiled.close();
+        std::remove(config.tiled_output.path.c_str());
+        if (success) {
+            std::cerr << "Saved image to " << output_path << "\n";
+        } else {
+            std::cerr << "Failed to write PNG image.\n";
+        }
+    } else {
+        success = save_image(output_path, config, quantize_framebuffer(handle->framebuffer(), config.dither));
+    }
     
     return success ? 0 : 1;
 }